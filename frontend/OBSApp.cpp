@@ -1125,8 +1125,15 @@ static bool StartupOBS(const char *locale, profiler_name_store_t *store)
 
 	if (GetAppConfigPath(path, sizeof(path), "obs-studio/plugin_config") <= 0)
 		return false;
+	if (!obs_startup(locale, path, store))
+		return false;
+
+	if (GetAppConfigPath(path, sizeof(path), "obs-studio/effect_cache") > 0)
+		gs_effect_cache_set_path(path);
+	if (GetAppConfigPath(path, sizeof(path), "obs-studio/module_manifest.json") > 0)
+		obs_set_module_manifest_cache(path);
 
-	return obs_startup(locale, path, store);
+	return true;
 }
 
 inline void OBSApp::ResetHotkeyState(bool inFocus)
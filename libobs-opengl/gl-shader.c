@@ -22,6 +22,7 @@
 #include <graphics/vec4.h>
 #include <graphics/matrix3.h>
 #include <graphics/matrix4.h>
+#include <graphics/effect-cache.h>
 #include "gl-subsystem.h"
 #include "gl-shaderparser.h"
 
@@ -59,62 +60,19 @@ static void gl_get_shader_info(GLuint shader, const char *file, char **error_str
 		bfree(errors);
 }
 
-static bool gl_add_param(struct gs_shader *shader, struct shader_var *var, GLint *texture_id)
+static void gl_add_param(struct gl_shader_info *info, struct shader_var *var)
 {
 	struct gs_shader_param param = {0};
 
 	param.array_count = var->array_count;
 	param.name = bstrdup(var->name);
-	param.shader = shader;
 	param.type = get_shader_param_type(var->type);
 
-	if (param.type == GS_SHADER_PARAM_TEXTURE) {
+	if (param.type == GS_SHADER_PARAM_TEXTURE)
 		param.sampler_id = var->gl_sampler_id;
-		param.texture_id = (*texture_id)++;
-	} else {
-		param.changed = true;
-	}
 
 	da_move(param.def_value, var->default_val);
-	da_copy(param.cur_value, param.def_value);
-
-	da_push_back(shader->params, &param);
-	return true;
-}
-
-static inline bool gl_add_params(struct gs_shader *shader, struct gl_shader_parser *glsp)
-{
-	size_t i;
-	GLint tex_id = 0;
-
-	for (i = 0; i < glsp->parser.params.num; i++)
-		if (!gl_add_param(shader, glsp->parser.params.array + i, &tex_id))
-			return false;
-
-	shader->viewproj = gs_shader_get_param_by_name(shader, "ViewProj");
-	shader->world = gs_shader_get_param_by_name(shader, "World");
-
-	return true;
-}
-
-static inline void gl_add_sampler(struct gs_shader *shader, struct shader_sampler *sampler)
-{
-	gs_samplerstate_t *new_sampler;
-	struct gs_sampler_info info;
-
-	shader_sampler_convert(sampler, &info);
-	new_sampler = device_samplerstate_create(shader->device, &info);
-
-	da_push_back(shader->samplers, &new_sampler);
-}
-
-static inline void gl_add_samplers(struct gs_shader *shader, struct gl_shader_parser *glsp)
-{
-	size_t i;
-	for (i = 0; i < glsp->parser.samplers.num; i++) {
-		struct shader_sampler *sampler = glsp->parser.samplers.array + i;
-		gl_add_sampler(shader, sampler);
-	}
+	da_push_back(info->params, &param);
 }
 
 static void get_attrib_type(const char *mapping, enum attrib_type *type, size_t *index)
@@ -143,13 +101,13 @@ static void get_attrib_type(const char *mapping, enum attrib_type *type, size_t
 	*index = 0;
 }
 
-static inline bool gl_process_attrib(struct gs_shader *program, struct gl_parser_attrib *pa)
+static inline void gl_process_attrib(struct gl_shader_info *info, struct gl_parser_attrib *pa)
 {
 	struct shader_attrib attrib = {0};
 
 	/* don't parse output attributes */
 	if (!pa->input)
-		return true;
+		return;
 
 	get_attrib_type(pa->mapping, &attrib.type, &attrib.index);
 	attrib.name = pa->name.array;
@@ -158,24 +116,33 @@ static inline bool gl_process_attrib(struct gs_shader *program, struct gl_parser
 	pa->name.len = 0;
 	pa->name.capacity = 0;
 
-	da_push_back(program->attribs, &attrib);
-	return true;
+	da_push_back(info->attribs, &attrib);
 }
 
-static inline bool gl_process_attribs(struct gs_shader *shader, struct gl_shader_parser *glsp)
+/* takes what is needed to create the shader out of the parser, so it can be
+ * stored in the shader cache */
+static void gl_shader_get_info(struct gl_shader_info *info, struct gl_shader_parser *glsp)
 {
-	size_t i;
-	for (i = 0; i < glsp->attribs.num; i++) {
-		struct gl_parser_attrib *pa = glsp->attribs.array + i;
-		if (!gl_process_attrib(shader, pa))
-			return false;
+	dstr_move(&info->glsl, &glsp->gl_string);
+
+	for (size_t i = 0; i < glsp->parser.params.num; i++)
+		gl_add_param(info, glsp->parser.params.array + i);
+
+	/* Only vertex shaders actually require input attributes */
+	if (glsp->type == GS_SHADER_VERTEX) {
+		for (size_t i = 0; i < glsp->attribs.num; i++)
+			gl_process_attrib(info, glsp->attribs.array + i);
 	}
 
-	return true;
+	for (size_t i = 0; i < glsp->parser.samplers.num; i++) {
+		struct gs_sampler_info sampler;
+
+		shader_sampler_convert(glsp->parser.samplers.array + i, &sampler);
+		da_push_back(info->samplers, &sampler);
+	}
 }
 
-static bool gl_shader_init(struct gs_shader *shader, struct gl_shader_parser *glsp, const char *file,
-			   char **error_string)
+static bool gl_shader_compile(struct gs_shader *shader, const char *glsl, const char *file, char **error_string)
 {
 	GLenum type = convert_shader_type(shader->type);
 	int compiled = 0;
@@ -185,7 +152,7 @@ static bool gl_shader_init(struct gs_shader *shader, struct gl_shader_parser *gl
 	if (!gl_success("glCreateShader") || !shader->obj)
 		return false;
 
-	glShaderSource(shader->obj, 1, (const GLchar **)&glsp->gl_string.array, 0);
+	glShaderSource(shader->obj, 1, (const GLchar **)&glsl, 0);
 	if (!gl_success("glShaderSource"))
 		return false;
 
@@ -197,7 +164,7 @@ static bool gl_shader_init(struct gs_shader *shader, struct gl_shader_parser *gl
 	blog(LOG_DEBUG, "+++++++++++++++++++++++++++++++++++");
 	blog(LOG_DEBUG, "  GL shader string for: %s", file);
 	blog(LOG_DEBUG, "-----------------------------------");
-	blog(LOG_DEBUG, "%s", glsp->gl_string.array);
+	blog(LOG_DEBUG, "%s", glsl);
 	blog(LOG_DEBUG, "+++++++++++++++++++++++++++++++++++");
 #endif
 
@@ -223,40 +190,82 @@ static bool gl_shader_init(struct gs_shader *shader, struct gl_shader_parser *gl
 	}
 
 	gl_get_shader_info(shader->obj, file, error_string);
+	return success;
+}
 
-	if (success)
-		success = gl_add_params(shader, glsp);
-	/* Only vertex shaders actually require input attributes */
-	if (success && shader->type == GS_SHADER_VERTEX)
-		success = gl_process_attribs(shader, glsp);
-	if (success)
-		gl_add_samplers(shader, glsp);
+/* moves the parameters and attributes out of the info */
+static void gl_shader_init(struct gs_shader *shader, struct gl_shader_info *info)
+{
+	GLint tex_id = 0;
 
-	return success;
+	for (size_t i = 0; i < info->params.num; i++) {
+		struct gs_shader_param *param = info->params.array + i;
+
+		param->shader = shader;
+		if (param->type == GS_SHADER_PARAM_TEXTURE)
+			param->texture_id = tex_id++;
+		else
+			param->changed = true;
+
+		da_copy(param->cur_value, param->def_value);
+	}
+
+	da_move(shader->params, info->params);
+	da_move(shader->attribs, info->attribs);
+
+	shader->viewproj = gs_shader_get_param_by_name(shader, "ViewProj");
+	shader->world = gs_shader_get_param_by_name(shader, "World");
+
+	for (size_t i = 0; i < info->samplers.num; i++) {
+		gs_samplerstate_t *sampler = device_samplerstate_create(shader->device, info->samplers.array + i);
+		da_push_back(shader->samplers, &sampler);
+	}
 }
 
+/* bump when gl_shader_parse produces different GLSL for the same shader */
+#define GL_SHADER_TRANSLATION_VERSION "1"
+
 static struct gs_shader *shader_create(gs_device_t *device, enum gs_shader_type type, const char *shader_str,
 				       const char *file, char **error_string)
 {
 	struct gs_shader *shader = bzalloc(sizeof(struct gs_shader));
-	struct gl_shader_parser glsp;
-	bool success = true;
+	struct gl_shader_info info = {0};
+	bool cached;
+	bool success;
 
 	shader->device = device;
 	shader->type = type;
+	shader->hash = gs_effect_cache_hash(GL_SHADER_TRANSLATION_VERSION);
+	shader->hash = gs_effect_cache_hash_append(shader->hash, type == GS_SHADER_VERTEX ? "vs" : "ps");
+	shader->hash = gs_effect_cache_hash_append(shader->hash, shader_str);
 
-	gl_shader_parser_init(&glsp, type);
-	if (!gl_shader_parse(&glsp, shader_str, file))
-		success = false;
-	else
-		success = gl_shader_init(shader, &glsp, file, error_string);
+	cached = gl_shader_cache_load(&info, shader->hash);
+	if (cached) {
+		success = true;
+	} else {
+		struct gl_shader_parser glsp;
+
+		gl_shader_parser_init(&glsp, type);
+		success = gl_shader_parse(&glsp, shader_str, file);
+		if (success)
+			gl_shader_get_info(&info, &glsp);
+		gl_shader_parser_free(&glsp);
+	}
+
+	if (success)
+		success = gl_shader_compile(shader, info.glsl.array, file, error_string);
+	if (success && !cached)
+		gl_shader_cache_save(&info, shader->hash);
+	if (success)
+		gl_shader_init(shader, &info);
+
+	gl_shader_info_free(&info);
 
 	if (!success) {
 		gs_shader_destroy(shader);
 		shader = NULL;
 	}
 
-	gl_shader_parser_free(&glsp);
 	return shader;
 }
 
@@ -598,38 +607,63 @@ static inline bool assign_program_params(struct gs_program *program)
 	return true;
 }
 
-struct gs_program *gs_program_create(struct gs_device *device)
+static bool gs_program_link(struct gs_program *program)
 {
-	struct gs_program *program = bzalloc(sizeof(*program));
 	int linked = false;
 
-	program->device = device;
-	program->vertex_shader = device->cur_vertex_shader;
-	program->pixel_shader = device->cur_pixel_shader;
-
-	program->obj = glCreateProgram();
-	if (!gl_success("glCreateProgram"))
-		goto error_detach_neither;
+	/* lets the driver keep the binary around for the program cache */
+	if (program->device->program_binary) {
+		glProgramParameteri(program->obj, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+		gl_success("glProgramParameteri");
+	}
 
 	glAttachShader(program->obj, program->vertex_shader->obj);
 	if (!gl_success("glAttachShader (vertex)"))
-		goto error_detach_neither;
+		return false;
 
 	glAttachShader(program->obj, program->pixel_shader->obj);
 	if (!gl_success("glAttachShader (pixel)"))
-		goto error_detach_vertex;
+		goto detach_vertex;
 
 	glLinkProgram(program->obj);
 	if (!gl_success("glLinkProgram"))
-		goto error;
+		goto detach;
 
 	glGetProgramiv(program->obj, GL_LINK_STATUS, &linked);
 	if (!gl_success("glGetProgramiv"))
-		goto error;
+		goto detach;
 
-	if (linked == GL_FALSE) {
+	if (linked == GL_FALSE)
 		print_link_errors(program->obj);
+
+detach:
+	glDetachShader(program->obj, program->pixel_shader->obj);
+	gl_success("glDetachShader (pixel)");
+
+detach_vertex:
+	glDetachShader(program->obj, program->vertex_shader->obj);
+	gl_success("glDetachShader (vertex)");
+
+	return linked != GL_FALSE;
+}
+
+struct gs_program *gs_program_create(struct gs_device *device)
+{
+	struct gs_program *program = bzalloc(sizeof(*program));
+
+	program->device = device;
+	program->vertex_shader = device->cur_vertex_shader;
+	program->pixel_shader = device->cur_pixel_shader;
+
+	program->obj = glCreateProgram();
+	if (!gl_success("glCreateProgram"))
 		goto error;
+
+	if (!gl_program_cache_load(program)) {
+		if (!gs_program_link(program))
+			goto error;
+
+		gl_program_cache_save(program);
 	}
 
 	if (!assign_program_attribs(program))
@@ -637,12 +671,6 @@ struct gs_program *gs_program_create(struct gs_device *device)
 	if (!assign_program_params(program))
 		goto error;
 
-	glDetachShader(program->obj, program->vertex_shader->obj);
-	gl_success("glDetachShader (vertex)");
-
-	glDetachShader(program->obj, program->pixel_shader->obj);
-	gl_success("glDetachShader (pixel)");
-
 	program->next = device->first_program;
 	program->prev_next = &device->first_program;
 	device->first_program = program;
@@ -652,14 +680,6 @@ struct gs_program *gs_program_create(struct gs_device *device)
 	return program;
 
 error:
-	glDetachShader(program->obj, program->pixel_shader->obj);
-	gl_success("glDetachShader (pixel)");
-
-error_detach_vertex:
-	glDetachShader(program->obj, program->vertex_shader->obj);
-	gl_success("glDetachShader (vertex)");
-
-error_detach_neither:
 	gs_program_destroy(program);
 	return NULL;
 }
@@ -0,0 +1,328 @@
+#include <limits.h>
+
+#include <util/dstr.h>
+#include <util/array-serializer.h>
+#include <graphics/effect-cache.h>
+#include "gl-subsystem.h"
+
+/*
+ * Translated shaders and linked program binaries, stored with the effect
+ * cache (see gs_effect_cache_set_path).
+ *
+ * Shaders are keyed by their HLSL source, so a warm start compiles the cached
+ * GLSL without going through gl_shader_parse.  Program binaries are keyed by
+ * the driver and both shaders, and are only used if the driver still accepts
+ * their binary format, otherwise the program is linked as usual.
+ */
+
+#define SHADER_CACHE_MAGIC "OBSG"
+#define PROGRAM_CACHE_MAGIC "OBSB"
+#define GL_CACHE_VERSION 1
+
+void gl_shader_info_free(struct gl_shader_info *info)
+{
+	for (size_t i = 0; i < info->params.num; i++) {
+		struct gs_shader_param *param = info->params.array + i;
+
+		bfree(param->name);
+		da_free(param->cur_value);
+		da_free(param->def_value);
+	}
+
+	for (size_t i = 0; i < info->attribs.num; i++)
+		bfree(info->attribs.array[i].name);
+
+	dstr_free(&info->glsl);
+	da_free(info->params);
+	da_free(info->attribs);
+	da_free(info->samplers);
+}
+
+static void get_cache_name(struct dstr *name, const char *type, uint64_t hash)
+{
+	dstr_printf(name, "gl-%s-%016llx.bin", type, (unsigned long long)hash);
+}
+
+static bool read_header(struct gs_cache_reader *r, const char *magic, uint64_t hash)
+{
+	if ((size_t)(r->end - r->pos) < 5 || memcmp(r->pos, magic, 4) != 0)
+		return false;
+
+	r->pos += 4;
+	if (gs_cache_read_u8(r) != GL_CACHE_VERSION)
+		return false;
+
+	return gs_cache_read_u64(r) == hash && !r->error;
+}
+
+static void write_header(struct serializer *s, const char *magic, uint64_t hash)
+{
+	s_write(s, magic, 4);
+	s_w8(s, GL_CACHE_VERSION);
+	s_wl64(s, hash);
+}
+
+/* ------------------------------------------------------------------------- */
+
+static bool read_shader_info(struct gs_cache_reader *r, struct gl_shader_info *info)
+{
+	dstr_copy(&info->glsl, gs_cache_read_string(r));
+
+	size_t count = gs_cache_read_count(r);
+	for (size_t i = 0; i < count && !r->error; i++) {
+		struct gs_shader_param *param = da_push_back_new(info->params);
+
+		param->name = bstrdup(gs_cache_read_string(r));
+		param->type = (enum gs_shader_param_type)gs_cache_read_varint(r);
+		param->array_count = (int)gs_cache_read_varint(r);
+		param->sampler_id = (size_t)gs_cache_read_varint(r);
+
+		size_t size = gs_cache_read_count(r);
+		const uint8_t *data = gs_cache_read_data(r, size);
+		if (data)
+			da_push_back_array(param->def_value, data, size);
+
+		if (param->type > GS_SHADER_PARAM_TEXTURE || param->sampler_id >= GS_MAX_TEXTURES)
+			r->error = true;
+	}
+
+	count = gs_cache_read_count(r);
+	for (size_t i = 0; i < count && !r->error; i++) {
+		struct shader_attrib *attrib = da_push_back_new(info->attribs);
+
+		attrib->name = bstrdup(gs_cache_read_string(r));
+		attrib->type = (enum attrib_type)gs_cache_read_varint(r);
+		attrib->index = (size_t)gs_cache_read_varint(r);
+
+		if (attrib->type > ATTRIB_TARGET)
+			r->error = true;
+	}
+
+	count = gs_cache_read_count(r);
+	for (size_t i = 0; i < count && !r->error; i++) {
+		struct gs_sampler_info *sampler = da_push_back_new(info->samplers);
+
+		sampler->filter = (enum gs_sample_filter)gs_cache_read_varint(r);
+		sampler->address_u = (enum gs_address_mode)gs_cache_read_varint(r);
+		sampler->address_v = (enum gs_address_mode)gs_cache_read_varint(r);
+		sampler->address_w = (enum gs_address_mode)gs_cache_read_varint(r);
+		sampler->max_anisotropy = (int)gs_cache_read_varint(r);
+		sampler->border_color = (uint32_t)gs_cache_read_varint(r);
+	}
+
+	return !r->error && !dstr_is_empty(&info->glsl);
+}
+
+bool gl_shader_cache_load(struct gl_shader_info *info, uint64_t hash)
+{
+	struct dstr name = {0};
+	uint8_t *buf;
+	size_t size = 0;
+	bool success = false;
+
+	get_cache_name(&name, "shader", hash);
+	buf = gs_effect_cache_load_blob(name.array, &size);
+	dstr_free(&name);
+
+	if (buf) {
+		struct gs_cache_reader r = {buf, buf + size, false};
+		success = read_header(&r, SHADER_CACHE_MAGIC, hash) && read_shader_info(&r, info);
+		bfree(buf);
+	}
+
+	if (!success)
+		gl_shader_info_free(info);
+	return success;
+}
+
+void gl_shader_cache_save(const struct gl_shader_info *info, uint64_t hash)
+{
+	struct array_output_data output;
+	struct serializer s;
+	struct dstr name = {0};
+
+	array_output_serializer_init(&s, &output);
+	write_header(&s, SHADER_CACHE_MAGIC, hash);
+	gs_cache_write_string(&s, info->glsl.array);
+
+	gs_cache_write_varint(&s, info->params.num);
+	for (size_t i = 0; i < info->params.num; i++) {
+		const struct gs_shader_param *param = info->params.array + i;
+
+		gs_cache_write_string(&s, param->name);
+		gs_cache_write_varint(&s, param->type);
+		gs_cache_write_varint(&s, (uint64_t)param->array_count);
+		gs_cache_write_varint(&s, param->sampler_id);
+		gs_cache_write_varint(&s, param->def_value.num);
+		s_write(&s, param->def_value.array, param->def_value.num);
+	}
+
+	gs_cache_write_varint(&s, info->attribs.num);
+	for (size_t i = 0; i < info->attribs.num; i++) {
+		const struct shader_attrib *attrib = info->attribs.array + i;
+
+		gs_cache_write_string(&s, attrib->name);
+		gs_cache_write_varint(&s, attrib->type);
+		gs_cache_write_varint(&s, attrib->index);
+	}
+
+	gs_cache_write_varint(&s, info->samplers.num);
+	for (size_t i = 0; i < info->samplers.num; i++) {
+		const struct gs_sampler_info *sampler = info->samplers.array + i;
+
+		gs_cache_write_varint(&s, sampler->filter);
+		gs_cache_write_varint(&s, sampler->address_u);
+		gs_cache_write_varint(&s, sampler->address_v);
+		gs_cache_write_varint(&s, sampler->address_w);
+		gs_cache_write_varint(&s, (uint32_t)sampler->max_anisotropy);
+		gs_cache_write_varint(&s, sampler->border_color);
+	}
+
+	get_cache_name(&name, "shader", hash);
+	gs_effect_cache_save_blob(name.array, output.bytes.array, output.bytes.num);
+
+	dstr_free(&name);
+	array_output_serializer_free(&output);
+}
+
+/* ------------------------------------------------------------------------- */
+
+void gl_program_cache_init(struct gs_device *device)
+{
+	GLint num_formats = 0;
+
+	if (!GLAD_GL_VERSION_4_1 && !GLAD_GL_ARB_get_program_binary)
+		return;
+
+	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &num_formats);
+	if (!gl_success("glGetIntegerv") || num_formats <= 0)
+		return;
+
+	da_resize(device->binary_formats, (size_t)num_formats);
+	glGetIntegerv(GL_PROGRAM_BINARY_FORMATS, device->binary_formats.array);
+	if (!gl_success("glGetIntegerv")) {
+		da_free(device->binary_formats);
+		return;
+	}
+
+	/* binaries are only valid for the driver that created them */
+	uint64_t hash = gs_effect_cache_hash("gl-program");
+	hash = gs_effect_cache_hash_append(hash, (const char *)glGetString(GL_VENDOR));
+	hash = gs_effect_cache_hash_append(hash, (const char *)glGetString(GL_RENDERER));
+	hash = gs_effect_cache_hash_append(hash, (const char *)glGetString(GL_VERSION));
+	hash = gs_effect_cache_hash_append(hash, (const char *)glGetString(GL_SHADING_LANGUAGE_VERSION));
+
+	device->driver_hash = hash;
+	device->program_binary = true;
+}
+
+static uint64_t get_program_hash(const struct gs_program *program)
+{
+	struct dstr key = {0};
+	uint64_t hash;
+
+	dstr_printf(&key, "%016llx%016llx", (unsigned long long)program->vertex_shader->hash,
+		    (unsigned long long)program->pixel_shader->hash);
+	hash = gs_effect_cache_hash_append(program->device->driver_hash, key.array);
+	dstr_free(&key);
+
+	return hash;
+}
+
+static bool binary_format_supported(const struct gs_device *device, GLenum format)
+{
+	for (size_t i = 0; i < device->binary_formats.num; i++) {
+		if ((GLenum)device->binary_formats.array[i] == format)
+			return true;
+	}
+
+	return false;
+}
+
+bool gl_program_cache_load(struct gs_program *program)
+{
+	struct gs_device *device = program->device;
+	uint64_t hash;
+	struct dstr name = {0};
+	uint8_t *buf;
+	size_t size = 0;
+	int linked = false;
+
+	if (!device->program_binary)
+		return false;
+
+	hash = get_program_hash(program);
+	get_cache_name(&name, "program", hash);
+	buf = gs_effect_cache_load_blob(name.array, &size);
+	dstr_free(&name);
+
+	if (!buf)
+		return false;
+
+	struct gs_cache_reader r = {buf, buf + size, false};
+	GLenum format = 0;
+	const uint8_t *data = NULL;
+	size_t data_size = 0;
+
+	if (read_header(&r, PROGRAM_CACHE_MAGIC, hash)) {
+		format = (GLenum)gs_cache_read_varint(&r);
+		data_size = gs_cache_read_count(&r);
+		data = gs_cache_read_data(&r, data_size);
+	}
+
+	if (data && data_size <= INT_MAX && binary_format_supported(device, format)) {
+		glProgramBinary(program->obj, format, data, (GLsizei)data_size);
+		if (gl_success("glProgramBinary")) {
+			glGetProgramiv(program->obj, GL_LINK_STATUS, &linked);
+			gl_success("glGetProgramiv");
+		}
+	}
+
+	bfree(buf);
+
+	/* the driver rejects binaries it can't use anymore, such as after an
+	 * update that kept the version string, in which case we link as usual */
+	if (!linked)
+		blog(LOG_DEBUG, "Program binary %016llx not used, linking", (unsigned long long)hash);
+	return linked != GL_FALSE;
+}
+
+void gl_program_cache_save(struct gs_program *program)
+{
+	struct gs_device *device = program->device;
+	struct array_output_data output;
+	struct serializer s;
+	struct dstr name = {0};
+	GLint length = 0;
+	GLenum format = 0;
+	uint8_t *data;
+
+	if (!device->program_binary)
+		return;
+
+	glGetProgramiv(program->obj, GL_PROGRAM_BINARY_LENGTH, &length);
+	if (!gl_success("glGetProgramiv") || length <= 0)
+		return;
+
+	data = bmalloc((size_t)length);
+	glGetProgramBinary(program->obj, length, &length, &format, data);
+	if (!gl_success("glGetProgramBinary") || length <= 0) {
+		bfree(data);
+		return;
+	}
+
+	uint64_t hash = get_program_hash(program);
+
+	array_output_serializer_init(&s, &output);
+	write_header(&s, PROGRAM_CACHE_MAGIC, hash);
+	gs_cache_write_varint(&s, format);
+	gs_cache_write_varint(&s, (uint64_t)length);
+	s_write(&s, data, (size_t)length);
+
+	get_cache_name(&name, "program", hash);
+	gs_effect_cache_save_blob(name.array, output.bytes.array, output.bytes.num);
+
+	dstr_free(&name);
+	array_output_serializer_free(&output);
+	bfree(data);
+}
@@ -282,6 +282,8 @@ int device_create(gs_device_t **p_device, uint32_t adapter)
 		goto fail;
 	}
 
+	gl_program_cache_init(device);
+
 	const char *glVersion = (const char *)glGetString(GL_VERSION);
 	const char *glShadingLanguage = (const char *)glGetString(GL_SHADING_LANGUAGE_VERSION);
 
@@ -334,6 +336,7 @@ void device_destroy(gs_device_t *device)
 		gl_delete_vertex_arrays(1, &device->empty_vao);
 
 		da_free(device->proj_stack);
+		da_free(device->binary_formats);
 		gl_platform_destroy(device->plat);
 		bfree(device);
 	}
@@ -18,6 +18,7 @@
 #pragma once
 
 #include <util/darray.h>
+#include <util/dstr.h>
 #include <util/threading.h>
 #include <graphics/graphics.h>
 #include <graphics/device-exports.h>
@@ -471,6 +472,7 @@ struct gs_shader {
 	gs_device_t *device;
 	enum gs_shader_type type;
 	GLuint obj;
+	uint64_t hash;
 
 	struct gs_shader_param *viewproj;
 	struct gs_shader_param *world;
@@ -498,6 +500,24 @@ struct gs_program {
 	struct gs_program *next;
 };
 
+/* the GLSL and reflection data of a shader, either translated by
+ * gl_shader_parse or loaded from the shader cache */
+struct gl_shader_info {
+	struct dstr glsl;
+	DARRAY(struct gs_shader_param) params;
+	DARRAY(struct shader_attrib) attribs;
+	DARRAY(struct gs_sampler_info) samplers;
+};
+
+extern void gl_shader_info_free(struct gl_shader_info *info);
+
+extern bool gl_shader_cache_load(struct gl_shader_info *info, uint64_t hash);
+extern void gl_shader_cache_save(const struct gl_shader_info *info, uint64_t hash);
+
+extern void gl_program_cache_init(struct gs_device *device);
+extern bool gl_program_cache_load(struct gs_program *program);
+extern void gl_program_cache_save(struct gs_program *program);
+
 extern struct gs_program *gs_program_create(struct gs_device *device);
 extern void gs_program_destroy(struct gs_program *program);
 extern void program_update_params(struct gs_program *shader);
@@ -646,6 +666,11 @@ struct gs_device {
 
 	struct gs_program *first_program;
 
+	/* program binaries are only cached for the driver that made them */
+	bool program_binary;
+	uint64_t driver_hash;
+	DARRAY(GLint) binary_formats;
+
 	enum gs_cull_mode cur_cull_mode;
 	struct gs_rect cur_viewport;
 
@@ -236,3 +236,78 @@ bool calldata_get_string(const calldata_t *data, const char *name, const char **
 	*str = cd_serialize_string(&pos);
 	return true;
 }
+
+/* ------------------------------------------------------------------------- */
+
+static inline size_t cd_param_size(const struct calldata_param *param)
+{
+	return sizeof(size_t) * 2 + param->name_size + param->size;
+}
+
+/* the first user of a layout records where each value ends up, later users
+ * and users racing with the first one just write the names */
+static void cd_prepare_layout(struct calldata_layout *layout, size_t total)
+{
+	size_t offset = 0;
+
+	if (!os_atomic_compare_swap_long(&layout->ready, 0, -1))
+		return;
+
+	for (size_t i = 0; i < layout->num; i++) {
+		const struct calldata_param *param = layout->params + i;
+
+		offset += cd_param_size(param);
+		layout->offsets[i] = offset - param->size;
+	}
+
+	layout->size = total;
+	os_atomic_set_long(&layout->ready, 1);
+}
+
+bool calldata_init_layout(calldata_t *data, uint8_t *stack, size_t size, struct calldata_layout *layout)
+{
+	size_t total = sizeof(size_t);
+	uint8_t *pos;
+
+	for (size_t i = 0; i < layout->num; i++)
+		total += cd_param_size(layout->params + i);
+
+	calldata_init_fixed(data, stack, size);
+
+	if (layout->num > CALLDATA_LAYOUT_MAX_PARAMS) {
+		blog(LOG_ERROR, "Calldata layout has too many parameters!");
+		return false;
+	}
+	if (total > size) {
+		blog(LOG_ERROR, "Tried to go above fixed calldata stack size!");
+		return false;
+	}
+	if (!os_atomic_load_long(&layout->ready))
+		cd_prepare_layout(layout, total);
+
+	pos = data->stack;
+	for (size_t i = 0; i < layout->num; i++) {
+		const struct calldata_param *param = layout->params + i;
+
+		cd_copy_string(&pos, param->name, param->name_size);
+		memcpy(pos, &param->size, sizeof(size_t));
+		pos += sizeof(size_t);
+		memset(pos, 0, param->size);
+		pos += param->size;
+	}
+
+	memset(pos, 0, sizeof(size_t));
+	data->size = total;
+	return true;
+}
+
+void *calldata_slot_lookup(const calldata_t *data, const struct calldata_layout *layout, size_t slot)
+{
+	const struct calldata_param *param = layout->params + slot;
+	uint8_t *pos;
+
+	if (cd_getparam(data, param->name, &pos) && cd_serialize_size(&pos) == param->size)
+		return pos;
+
+	return NULL;
+}
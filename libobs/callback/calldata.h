@@ -19,6 +19,7 @@
 #include <string.h>
 #include "../util/c99defs.h"
 #include "../util/bmem.h"
+#include "../util/threading.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -190,6 +191,135 @@ static inline void calldata_set_string(calldata_t *data, const char *name, const
 		calldata_set_data(data, name, NULL, 0);
 }
 
+/* ------------------------------------------------------------------------- */
+/* Fixed layouts
+ *
+ *   For frequently emitted signals.  The parameters are declared once, and
+ * calldata_init_layout writes all of their names in one go, after which the
+ * values are set and read by slot index instead of by name.  The offset of
+ * each slot is worked out the first time the layout is used and kept in the
+ * layout, which is why it must not be const.  The result is regular calldata,
+ * callbacks still use the functions above.
+ *
+ *   Only fixed size types are supported, e.g.:
+ *
+ *   static const struct calldata_param volume_params[] = {
+ *           CALLDATA_PARAM_PTR("source"),
+ *           CALLDATA_PARAM_FLOAT("volume"),
+ *   };
+ *   static struct calldata_layout volume_layout = CALLDATA_LAYOUT(volume_params);
+ */
+
+#define CALLDATA_LAYOUT_MAX_PARAMS 8
+
+struct calldata_param {
+	const char *name;
+	size_t name_size; /* including the null terminator */
+	size_t size;
+};
+
+struct calldata_layout {
+	const struct calldata_param *params;
+	size_t num;
+
+	/* filled in by the first calldata_init_layout */
+	volatile long ready;
+	size_t size;
+	size_t offsets[CALLDATA_LAYOUT_MAX_PARAMS];
+};
+
+#define CALLDATA_PARAM(name, type) {name, sizeof(name), sizeof(type)}
+#define CALLDATA_PARAM_INT(name) CALLDATA_PARAM(name, long long)
+#define CALLDATA_PARAM_FLOAT(name) CALLDATA_PARAM(name, double)
+#define CALLDATA_PARAM_BOOL(name) CALLDATA_PARAM(name, bool)
+#define CALLDATA_PARAM_PTR(name) CALLDATA_PARAM(name, void *)
+#define CALLDATA_LAYOUT(params) {params, sizeof(params) / sizeof(params[0])}
+
+EXPORT bool calldata_init_layout(calldata_t *data, uint8_t *stack, size_t size, struct calldata_layout *layout);
+EXPORT void *calldata_slot_lookup(const calldata_t *data, const struct calldata_layout *layout, size_t slot);
+
+static inline void *calldata_slot(const calldata_t *data, const struct calldata_layout *layout, size_t slot)
+{
+	/* parameters only move when a callback adds or resizes one, which
+	 * changes the total size */
+	if (os_atomic_load_long(&layout->ready) == 1 && data->size == layout->size) {
+		uint8_t *ptr = data->stack + layout->offsets[slot];
+		size_t size;
+
+		memcpy(&size, ptr - sizeof(size_t), sizeof(size_t));
+		if (size == layout->params[slot].size)
+			return ptr;
+	}
+
+	return calldata_slot_lookup(data, layout, slot);
+}
+
+static inline void calldata_slot_set(calldata_t *data, const struct calldata_layout *layout, size_t slot,
+				     const void *in)
+{
+	void *ptr = calldata_slot(data, layout, slot);
+	if (ptr)
+		memcpy(ptr, in, layout->params[slot].size);
+}
+
+static inline void calldata_slot_set_int(calldata_t *data, const struct calldata_layout *layout, size_t slot,
+					 long long val)
+{
+	calldata_slot_set(data, layout, slot, &val);
+}
+
+static inline void calldata_slot_set_float(calldata_t *data, const struct calldata_layout *layout, size_t slot,
+					   double val)
+{
+	calldata_slot_set(data, layout, slot, &val);
+}
+
+static inline void calldata_slot_set_bool(calldata_t *data, const struct calldata_layout *layout, size_t slot, bool val)
+{
+	calldata_slot_set(data, layout, slot, &val);
+}
+
+static inline void calldata_slot_set_ptr(calldata_t *data, const struct calldata_layout *layout, size_t slot, void *ptr)
+{
+	calldata_slot_set(data, layout, slot, &ptr);
+}
+
+static inline long long calldata_slot_int(const calldata_t *data, const struct calldata_layout *layout, size_t slot)
+{
+	long long val = 0;
+	void *ptr = calldata_slot(data, layout, slot);
+	if (ptr)
+		memcpy(&val, ptr, sizeof(val));
+	return val;
+}
+
+static inline double calldata_slot_float(const calldata_t *data, const struct calldata_layout *layout, size_t slot)
+{
+	double val = 0.0;
+	void *ptr = calldata_slot(data, layout, slot);
+	if (ptr)
+		memcpy(&val, ptr, sizeof(val));
+	return val;
+}
+
+static inline bool calldata_slot_bool(const calldata_t *data, const struct calldata_layout *layout, size_t slot)
+{
+	bool val = false;
+	void *ptr = calldata_slot(data, layout, slot);
+	if (ptr)
+		memcpy(&val, ptr, sizeof(val));
+	return val;
+}
+
+static inline void *calldata_slot_ptr(const calldata_t *data, const struct calldata_layout *layout, size_t slot)
+{
+	void *val = NULL;
+	void *ptr = calldata_slot(data, layout, slot);
+	if (ptr)
+		memcpy(&val, ptr, sizeof(val));
+	return val;
+}
+
 #ifdef __cplusplus
 }
 #endif
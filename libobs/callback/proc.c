@@ -15,6 +15,7 @@
  */
 
 #include "../util/darray.h"
+#include "../util/platform.h"
 #include "../util/threading.h"
 
 #include "decl.h"
@@ -35,6 +36,7 @@ struct proc_handler {
 	/* TODO: replace with hash table lookup? */
 	pthread_mutex_t mutex;
 	DARRAY(struct proc_info) procs;
+	volatile long calls;
 };
 
 static struct proc_info *getproc(proc_handler_t *handler, const char *name)
@@ -63,6 +65,7 @@ proc_handler_t *proc_handler_create(void)
 	}
 
 	da_init(handler->procs);
+	handler->calls = 0;
 	return handler;
 }
 
@@ -116,13 +119,40 @@ bool proc_handler_call(proc_handler_t *handler, const char *name, calldata_t *pa
 	pthread_mutex_lock(&handler->mutex);
 	struct proc_info *info = getproc(handler, name);
 	struct proc_info info_copy;
-	if (info)
+	if (info) {
 		info_copy = *info;
+		os_atomic_inc_long(&handler->calls);
+	}
 	pthread_mutex_unlock(&handler->mutex);
 
 	if (!info)
 		return false;
 
 	info_copy.callback(info_copy.data, params);
+	os_atomic_dec_long(&handler->calls);
 	return true;
 }
+
+void proc_handler_remove_data(proc_handler_t *handler, void *data)
+{
+	if (!handler)
+		return;
+
+	pthread_mutex_lock(&handler->mutex);
+
+	for (size_t i = handler->procs.num; i > 0; i--) {
+		struct proc_info *info = handler->procs.array + i - 1;
+
+		if (info->data == data) {
+			proc_info_free(info);
+			da_erase(handler->procs, i - 1);
+		}
+	}
+
+	pthread_mutex_unlock(&handler->mutex);
+
+	/* calls copy the procedure before they release the mutex, so the data
+	 * can still be in use by one of them */
+	while (os_atomic_load_long(&handler->calls) > 0)
+		os_sleep_ms(1);
+}
@@ -47,6 +47,13 @@ EXPORT void proc_handler_add(proc_handler_t *handler, const char *decl_string, p
  */
 EXPORT bool proc_handler_call(proc_handler_t *handler, const char *name, calldata_t *params);
 
+/**
+ * Removes all procedures that were added with the given private data, and
+ * waits for calls that are in progress to return.  Must not be called from a
+ * procedure of the same handler.
+ */
+EXPORT void proc_handler_remove_data(proc_handler_t *handler, void *data);
+
 #ifdef __cplusplus
 }
 #endif
@@ -16,35 +16,300 @@
 
 #include "../util/darray.h"
 #include "../util/threading.h"
+#include "../util/platform.h"
+#include "../util/bmem.h"
+#include "../util/uthash.h"
 
 #include "decl.h"
 #include "signal.h"
 
+/*
+ * Callbacks are stored in immutable lists.  Connecting or disconnecting
+ * creates a new list and publishes it atomically, so emitting a signal never
+ * waits on a lock: it just takes the list that is current at that moment.
+ * Replaced lists are freed once no emitter is using any list of the set.
+ */
+
 struct signal_callback {
 	signal_callback_t callback;
+	global_signal_callback_t global_callback;
 	void *data;
-	bool remove;
 	bool keep_ref;
+
+	/* number of threads currently in (or about to enter) the callback */
+	volatile long calling;
+	volatile bool removed;
+	volatile bool remove_current;
+
+	/* set by a disconnect waiting for other threads to leave */
+	void *volatile leave_event; /* os_event_t */
+};
+
+struct callback_list {
+	size_t num;
+	struct signal_callback *callbacks[];
+};
+
+struct callback_set {
+	/* only taken by connect/disconnect, never while calling callbacks */
+	pthread_mutex_t mutex;
+	void *volatile list; /* struct callback_list */
+	volatile long readers;
+
+	volatile bool retired;
+	DARRAY(struct callback_list *) retired_lists;
+	DARRAY(struct signal_callback *) retired_callbacks;
+};
+
+/* callbacks the current thread is in, innermost first */
+struct active_callback {
+	struct signal_callback *cb;
+	struct active_callback *prev;
 };
 
+static THREAD_LOCAL struct active_callback *active_callbacks = NULL;
+
+static long callback_depth(struct signal_callback *cb)
+{
+	long depth = 0;
+
+	for (struct active_callback *active = active_callbacks; active; active = active->prev) {
+		if (active->cb == cb)
+			depth++;
+	}
+
+	return depth;
+}
+
+static void signal_callback_free(struct signal_callback *cb)
+{
+	if (cb->leave_event)
+		os_event_destroy(cb->leave_event);
+	bfree(cb);
+}
+
+static bool callback_set_init(struct callback_set *set)
+{
+	memset(set, 0, sizeof(*set));
+	return pthread_mutex_init(&set->mutex, NULL) == 0;
+}
+
+static void callback_set_free(struct callback_set *set)
+{
+	struct callback_list *list = set->list;
+
+	if (list) {
+		for (size_t i = 0; i < list->num; i++)
+			signal_callback_free(list->callbacks[i]);
+		bfree(list);
+	}
+
+	for (size_t i = 0; i < set->retired_lists.num; i++)
+		bfree(set->retired_lists.array[i]);
+	for (size_t i = 0; i < set->retired_callbacks.num; i++)
+		signal_callback_free(set->retired_callbacks.array[i]);
+
+	da_free(set->retired_lists);
+	da_free(set->retired_callbacks);
+	pthread_mutex_destroy(&set->mutex);
+}
+
+/* must be called with the mutex held */
+static void callback_set_reclaim(struct callback_set *set)
+{
+	if (!set->retired || os_atomic_load_long(&set->readers) != 0)
+		return;
+
+	for (size_t i = 0; i < set->retired_lists.num; i++)
+		bfree(set->retired_lists.array[i]);
+	for (size_t i = 0; i < set->retired_callbacks.num; i++)
+		signal_callback_free(set->retired_callbacks.array[i]);
+
+	da_resize(set->retired_lists, 0);
+	da_resize(set->retired_callbacks, 0);
+	os_atomic_store_bool(&set->retired, false);
+}
+
+/* must be called with the mutex held */
+static void callback_set_publish(struct callback_set *set, struct callback_list *list)
+{
+	struct callback_list *old = os_atomic_exchange_ptr(&set->list, list);
+
+	if (old) {
+		da_push_back(set->retired_lists, &old);
+		os_atomic_store_bool(&set->retired, true);
+	}
+}
+
+static inline struct callback_list *callback_set_acquire(struct callback_set *set)
+{
+	os_atomic_inc_long(&set->readers);
+	return os_atomic_load_ptr(&set->list);
+}
+
+static inline void callback_set_release(struct callback_set *set)
+{
+	if (os_atomic_dec_long(&set->readers) == 0 && os_atomic_load_bool(&set->retired)) {
+		pthread_mutex_lock(&set->mutex);
+		callback_set_reclaim(set);
+		pthread_mutex_unlock(&set->mutex);
+	}
+}
+
+static struct signal_callback *callback_set_find(struct callback_set *set, signal_callback_t callback,
+						 global_signal_callback_t global_callback, void *data)
+{
+	struct callback_list *list = set->list;
+
+	for (size_t i = 0; list && i < list->num; i++) {
+		struct signal_callback *cb = list->callbacks[i];
+
+		if (cb->callback == callback && cb->global_callback == global_callback && cb->data == data)
+			return cb;
+	}
+
+	return NULL;
+}
+
+/* must be called with the mutex held */
+static void callback_set_add(struct callback_set *set, struct signal_callback *cb)
+{
+	struct callback_list *old = set->list;
+	size_t num = old ? old->num : 0;
+	struct callback_list *list = bmalloc(sizeof(*list) + (num + 1) * sizeof(cb));
+
+	if (num)
+		memcpy(list->callbacks, old->callbacks, num * sizeof(cb));
+	list->callbacks[num] = cb;
+	list->num = num + 1;
+
+	callback_set_publish(set, list);
+	callback_set_reclaim(set);
+}
+
+/* must be called with the mutex held */
+static void callback_set_remove(struct callback_set *set, struct signal_callback *cb)
+{
+	struct callback_list *old = set->list;
+	struct callback_list *list = NULL;
+
+	if (old->num > 1) {
+		size_t num = 0;
+
+		list = bmalloc(sizeof(*list) + (old->num - 1) * sizeof(cb));
+		for (size_t i = 0; i < old->num; i++) {
+			if (old->callbacks[i] != cb)
+				list->callbacks[num++] = old->callbacks[i];
+		}
+		list->num = num;
+	}
+
+	os_atomic_store_bool(&cb->removed, true);
+	da_push_back(set->retired_callbacks, &cb);
+	callback_set_publish(set, list);
+}
+
+/* Removes a callback, and waits for other threads to leave it so that the
+ * data can be freed as soon as this returns (the behavior callers have always
+ * relied on).  Returns true if the callback was connected with a reference. */
+static bool callback_set_disconnect(struct callback_set *set, signal_callback_t callback,
+				    global_signal_callback_t global_callback, void *data)
+{
+	struct signal_callback *cb;
+	bool keep_ref = false;
+
+	pthread_mutex_lock(&set->mutex);
+
+	cb = callback_set_find(set, callback, global_callback, data);
+	if (cb) {
+		keep_ref = cb->keep_ref;
+		callback_set_remove(set, cb);
+
+		/* keeps cb alive while waiting */
+		os_atomic_inc_long(&set->readers);
+	}
+
+	pthread_mutex_unlock(&set->mutex);
+
+	if (cb) {
+		/* the callback may be further up this thread's stack, possibly
+		 * more than once, those calls can't be waited for */
+		long self = callback_depth(cb);
+
+		if (os_atomic_load_long(&cb->calling) > self) {
+			os_event_t *event;
+
+			os_event_init(&event, OS_EVENT_TYPE_AUTO);
+			os_atomic_exchange_ptr(&cb->leave_event, event);
+
+			while (os_atomic_load_long(&cb->calling) > self)
+				os_event_wait(event);
+		}
+
+		callback_set_release(set);
+	}
+
+	return keep_ref;
+}
+
+/* Handles signal_handler_remove_current for a callback that has returned.
+ * Returns true if the callback was connected with a reference. */
+static bool callback_set_remove_current(struct callback_set *set, struct signal_callback *cb)
+{
+	bool keep_ref = false;
+
+	pthread_mutex_lock(&set->mutex);
+
+	if (!cb->removed) {
+		keep_ref = cb->keep_ref;
+		callback_set_remove(set, cb);
+	}
+
+	pthread_mutex_unlock(&set->mutex);
+	return keep_ref;
+}
+
+static inline bool callback_enter(struct signal_callback *cb)
+{
+	/* pairs with callback_set_disconnect: either this sees the removal,
+	 * or the disconnecting thread sees this thread calling */
+	os_atomic_inc_long(&cb->calling);
+	if (os_atomic_load_bool(&cb->removed)) {
+		os_atomic_dec_long(&cb->calling);
+		return false;
+	}
+
+	return true;
+}
+
+static inline void callback_leave(struct signal_callback *cb)
+{
+	os_atomic_dec_long(&cb->calling);
+
+	/* the event stays valid until cb is freed, which can't happen while
+	 * this thread is still a reader of the set */
+	if (os_atomic_load_bool(&cb->removed)) {
+		os_event_t *event = os_atomic_load_ptr(&cb->leave_event);
+		if (event)
+			os_event_signal(event);
+	}
+}
+
+/* ------------------------------------------------------------------------- */
+
 struct signal_info {
 	struct decl_info func;
-	DARRAY(struct signal_callback) callbacks;
-	pthread_mutex_t mutex;
-	bool signalling;
+	struct callback_set callbacks;
 
-	struct signal_info *next;
+	UT_hash_handle hh;
 };
 
 static inline struct signal_info *signal_info_create(struct decl_info *info)
 {
-	struct signal_info *si = bmalloc(sizeof(struct signal_info));
+	struct signal_info *si = bzalloc(sizeof(struct signal_info));
 	si->func = *info;
-	si->next = NULL;
-	si->signalling = false;
-	da_init(si->callbacks);
 
-	if (pthread_mutex_init_recursive(&si->mutex) != 0) {
+	if (!callback_set_init(&si->callbacks)) {
 		blog(LOG_ERROR, "Could not create signal");
 
 		decl_info_free(&si->func);
@@ -58,56 +323,28 @@ static inline struct signal_info *signal_info_create(struct decl_info *info)
 static inline void signal_info_destroy(struct signal_info *si)
 {
 	if (si) {
-		pthread_mutex_destroy(&si->mutex);
+		callback_set_free(&si->callbacks);
 		decl_info_free(&si->func);
-		da_free(si->callbacks);
 		bfree(si);
 	}
 }
 
-static inline size_t signal_get_callback_idx(struct signal_info *si, signal_callback_t callback, void *data)
-{
-	for (size_t i = 0; i < si->callbacks.num; i++) {
-		struct signal_callback *sc = si->callbacks.array + i;
-
-		if (sc->callback == callback && sc->data == data)
-			return i;
-	}
-
-	return DARRAY_INVALID;
-}
-
-struct global_callback_info {
-	global_signal_callback_t callback;
-	void *data;
-	long signaling;
-	bool remove;
-};
-
 struct signal_handler {
-	struct signal_info *first;
+	struct signal_info *signals;
 	pthread_mutex_t mutex;
 	volatile long refs;
 
-	DARRAY(struct global_callback_info) global_callbacks;
-	pthread_mutex_t global_callbacks_mutex;
+	struct callback_set global_callbacks;
+	/* global callbacks see every signal of the handler, so they are still
+	 * called one at a time.  recursive for callbacks that trigger signals
+	 * on the same handler */
+	pthread_mutex_t global_emit_mutex;
 };
 
-static struct signal_info *getsignal(signal_handler_t *handler, const char *name, struct signal_info **p_last)
+static inline struct signal_info *getsignal(signal_handler_t *handler, const char *name)
 {
-	struct signal_info *signal, *last = NULL;
-
-	signal = handler->first;
-	while (signal != NULL) {
-		if (strcmp(signal->func.name, name) == 0)
-			break;
-
-		last = signal;
-		signal = signal->next;
-	}
-
-	if (p_last)
-		*p_last = last;
+	struct signal_info *signal;
+	HASH_FIND_STR(handler->signals, name, signal);
 	return signal;
 }
 
@@ -116,7 +353,6 @@ static struct signal_info *getsignal(signal_handler_t *handler, const char *name
 signal_handler_t *signal_handler_create(void)
 {
 	struct signal_handler *handler = bzalloc(sizeof(struct signal_handler));
-	handler->first = NULL;
 	handler->refs = 1;
 
 	if (pthread_mutex_init(&handler->mutex, NULL) != 0) {
@@ -124,28 +360,36 @@ signal_handler_t *signal_handler_create(void)
 		bfree(handler);
 		return NULL;
 	}
-	if (pthread_mutex_init_recursive(&handler->global_callbacks_mutex) != 0) {
+	if (!callback_set_init(&handler->global_callbacks)) {
 		blog(LOG_ERROR, "Couldn't create signal handler global "
 				"callbacks mutex!");
 		pthread_mutex_destroy(&handler->mutex);
 		bfree(handler);
 		return NULL;
 	}
+	if (pthread_mutex_init_recursive(&handler->global_emit_mutex) != 0) {
+		blog(LOG_ERROR, "Couldn't create signal handler global "
+				"emit mutex!");
+		callback_set_free(&handler->global_callbacks);
+		pthread_mutex_destroy(&handler->mutex);
+		bfree(handler);
+		return NULL;
+	}
 
 	return handler;
 }
 
 static void signal_handler_actually_destroy(signal_handler_t *handler)
 {
-	struct signal_info *sig = handler->first;
-	while (sig != NULL) {
-		struct signal_info *next = sig->next;
+	struct signal_info *sig, *temp;
+
+	HASH_ITER (hh, handler->signals, sig, temp) {
+		HASH_DELETE(hh, handler->signals, sig);
 		signal_info_destroy(sig);
-		sig = next;
 	}
 
-	da_free(handler->global_callbacks);
-	pthread_mutex_destroy(&handler->global_callbacks_mutex);
+	callback_set_free(&handler->global_callbacks);
+	pthread_mutex_destroy(&handler->global_emit_mutex);
 	pthread_mutex_destroy(&handler->mutex);
 	bfree(handler);
 }
@@ -160,7 +404,7 @@ void signal_handler_destroy(signal_handler_t *handler)
 bool signal_handler_add(signal_handler_t *handler, const char *signal_decl)
 {
 	struct decl_info func = {0};
-	struct signal_info *sig, *last;
+	struct signal_info *sig;
 	bool success = true;
 
 	if (!parse_decl_string(&func, signal_decl)) {
@@ -170,17 +414,17 @@ bool signal_handler_add(signal_handler_t *handler, const char *signal_decl)
 
 	pthread_mutex_lock(&handler->mutex);
 
-	sig = getsignal(handler, func.name, &last);
+	sig = getsignal(handler, func.name);
 	if (sig) {
 		blog(LOG_WARNING, "Signal declaration '%s' exists", func.name);
 		decl_info_free(&func);
 		success = false;
 	} else {
 		sig = signal_info_create(&func);
-		if (!last)
-			handler->first = sig;
+		if (sig)
+			HASH_ADD_KEYPTR(hh, handler->signals, sig->func.name, (unsigned)strlen(sig->func.name), sig);
 		else
-			last->next = sig;
+			success = false;
 	}
 
 	pthread_mutex_unlock(&handler->mutex);
@@ -188,20 +432,34 @@ bool signal_handler_add(signal_handler_t *handler, const char *signal_decl)
 	return success;
 }
 
+static inline struct signal_info *getsignal_locked(signal_handler_t *handler, const char *name)
+{
+	struct signal_info *sig;
+
+	if (!handler || !name)
+		return NULL;
+
+	pthread_mutex_lock(&handler->mutex);
+	sig = getsignal(handler, name);
+	pthread_mutex_unlock(&handler->mutex);
+
+	return sig;
+}
+
+signal_id_t signal_handler_get_id(signal_handler_t *handler, const char *signal)
+{
+	return getsignal_locked(handler, signal);
+}
+
 static void signal_handler_connect_internal(signal_handler_t *handler, const char *signal, signal_callback_t callback,
 					    void *data, bool keep_ref)
 {
-	struct signal_info *sig, *last;
-	struct signal_callback cb_data = {callback, data, false, keep_ref};
-	size_t idx;
+	struct signal_info *sig;
 
 	if (!handler)
 		return;
 
-	pthread_mutex_lock(&handler->mutex);
-	sig = getsignal(handler, signal, &last);
-	pthread_mutex_unlock(&handler->mutex);
-
+	sig = getsignal_locked(handler, signal);
 	if (!sig) {
 		blog(LOG_WARNING,
 		     "signal_handler_connect: "
@@ -212,16 +470,20 @@ static void signal_handler_connect_internal(signal_handler_t *handler, const cha
 
 	/* -------------- */
 
-	pthread_mutex_lock(&sig->mutex);
+	pthread_mutex_lock(&sig->callbacks.mutex);
 
 	if (keep_ref)
 		os_atomic_inc_long(&handler->refs);
 
-	idx = signal_get_callback_idx(sig, callback, data);
-	if (keep_ref || idx == DARRAY_INVALID)
-		da_push_back(sig->callbacks, &cb_data);
+	if (keep_ref || !callback_set_find(&sig->callbacks, callback, NULL, data)) {
+		struct signal_callback *cb = bzalloc(sizeof(*cb));
+		cb->callback = callback;
+		cb->data = data;
+		cb->keep_ref = keep_ref;
+		callback_set_add(&sig->callbacks, cb);
+	}
 
-	pthread_mutex_unlock(&sig->mutex);
+	pthread_mutex_unlock(&sig->callbacks.mutex);
 }
 
 void signal_handler_connect(signal_handler_t *handler, const char *signal, signal_callback_t callback, void *data)
@@ -234,158 +496,129 @@ void signal_handler_connect_ref(signal_handler_t *handler, const char *signal, s
 	signal_handler_connect_internal(handler, signal, callback, data, true);
 }
 
-static inline struct signal_info *getsignal_locked(signal_handler_t *handler, const char *name)
-{
-	struct signal_info *sig;
-
-	if (!handler)
-		return NULL;
-
-	pthread_mutex_lock(&handler->mutex);
-	sig = getsignal(handler, name, NULL);
-	pthread_mutex_unlock(&handler->mutex);
-
-	return sig;
-}
-
 void signal_handler_disconnect(signal_handler_t *handler, const char *signal, signal_callback_t callback, void *data)
 {
 	struct signal_info *sig = getsignal_locked(handler, signal);
-	bool keep_ref = false;
-	size_t idx;
+	bool keep_ref;
 
 	if (!sig)
 		return;
 
-	pthread_mutex_lock(&sig->mutex);
-
-	idx = signal_get_callback_idx(sig, callback, data);
-	if (idx != DARRAY_INVALID) {
-		if (sig->signalling) {
-			sig->callbacks.array[idx].remove = true;
-		} else {
-			keep_ref = sig->callbacks.array[idx].keep_ref;
-			da_erase(sig->callbacks, idx);
-		}
-	}
-
-	pthread_mutex_unlock(&sig->mutex);
+	keep_ref = callback_set_disconnect(&sig->callbacks, callback, NULL, data);
 
 	if (keep_ref && os_atomic_dec_long(&handler->refs) == 0) {
 		signal_handler_actually_destroy(handler);
 	}
 }
 
-static THREAD_LOCAL struct signal_callback *current_signal_cb = NULL;
-static THREAD_LOCAL struct global_callback_info *current_global_cb = NULL;
-
 void signal_handler_remove_current(void)
 {
-	if (current_signal_cb)
-		current_signal_cb->remove = true;
-	else if (current_global_cb)
-		current_global_cb->remove = true;
+	if (active_callbacks)
+		os_atomic_store_bool(&active_callbacks->cb->remove_current, true);
 }
 
-void signal_handler_signal(signal_handler_t *handler, const char *signal, calldata_t *params)
+static long signal_callbacks(struct signal_info *sig, calldata_t *params)
 {
-	struct signal_info *sig = getsignal_locked(handler, signal);
+	struct callback_list *list = callback_set_acquire(&sig->callbacks);
 	long remove_refs = 0;
 
-	if (!sig)
-		return;
+	for (size_t i = 0; list && i < list->num; i++) {
+		struct signal_callback *cb = list->callbacks[i];
+		struct active_callback active = {cb, active_callbacks};
 
-	pthread_mutex_lock(&sig->mutex);
-	sig->signalling = true;
+		if (!callback_enter(cb))
+			continue;
 
-	for (size_t i = 0; i < sig->callbacks.num; i++) {
-		struct signal_callback *cb = sig->callbacks.array + i;
-		if (!cb->remove) {
-			current_signal_cb = cb;
-			cb->callback(cb->data, params);
-			current_signal_cb = NULL;
-		}
-	}
+		active_callbacks = &active;
+		cb->callback(cb->data, params);
+		active_callbacks = active.prev;
 
-	for (size_t i = sig->callbacks.num; i > 0; i--) {
-		struct signal_callback *cb = sig->callbacks.array + i - 1;
-		if (cb->remove) {
-			if (cb->keep_ref)
-				remove_refs++;
+		callback_leave(cb);
 
-			da_erase(sig->callbacks, i - 1);
-		}
+		if (os_atomic_load_bool(&cb->remove_current) && callback_set_remove_current(&sig->callbacks, cb))
+			remove_refs++;
 	}
 
-	sig->signalling = false;
-	pthread_mutex_unlock(&sig->mutex);
+	callback_set_release(&sig->callbacks);
+	return remove_refs;
+}
 
-	pthread_mutex_lock(&handler->global_callbacks_mutex);
+static void signal_global_callbacks(signal_handler_t *handler, const char *signal, calldata_t *params)
+{
+	struct callback_list *list;
 
-	if (handler->global_callbacks.num) {
-		for (size_t i = 0; i < handler->global_callbacks.num; i++) {
-			struct global_callback_info *cb = handler->global_callbacks.array + i;
+	/* skip the lock when nobody listens, which is almost always */
+	if (!os_atomic_load_ptr(&handler->global_callbacks.list))
+		return;
 
-			if (!cb->remove) {
-				cb->signaling++;
-				current_global_cb = cb;
-				cb->callback(cb->data, signal, params);
-				current_global_cb = NULL;
-				cb->signaling--;
-			}
-		}
+	pthread_mutex_lock(&handler->global_emit_mutex);
+	list = callback_set_acquire(&handler->global_callbacks);
 
-		for (size_t i = handler->global_callbacks.num; i > 0; i--) {
-			struct global_callback_info *cb = handler->global_callbacks.array + (i - 1);
+	for (size_t i = 0; list && i < list->num; i++) {
+		struct signal_callback *cb = list->callbacks[i];
+		struct active_callback active = {cb, active_callbacks};
 
-			if (cb->remove && !cb->signaling)
-				da_erase(handler->global_callbacks, i - 1);
-		}
+		if (!callback_enter(cb))
+			continue;
+
+		active_callbacks = &active;
+		cb->global_callback(cb->data, signal, params);
+		active_callbacks = active.prev;
+
+		callback_leave(cb);
+
+		if (os_atomic_load_bool(&cb->remove_current))
+			callback_set_remove_current(&handler->global_callbacks, cb);
 	}
 
-	pthread_mutex_unlock(&handler->global_callbacks_mutex);
+	callback_set_release(&handler->global_callbacks);
+	pthread_mutex_unlock(&handler->global_emit_mutex);
+}
+
+void signal_handler_signal_id(signal_handler_t *handler, signal_id_t id, calldata_t *params)
+{
+	long remove_refs;
+
+	if (!handler || !id)
+		return;
+
+	remove_refs = signal_callbacks(id, params);
+	signal_global_callbacks(handler, id->func.name, params);
 
 	if (remove_refs) {
 		os_atomic_set_long(&handler->refs, os_atomic_load_long(&handler->refs) - remove_refs);
 	}
 }
 
+void signal_handler_signal(signal_handler_t *handler, const char *signal, calldata_t *params)
+{
+	signal_handler_signal_id(handler, getsignal_locked(handler, signal), params);
+}
+
 void signal_handler_connect_global(signal_handler_t *handler, global_signal_callback_t callback, void *data)
 {
-	struct global_callback_info cb_data = {callback, data, 0, false};
-	size_t idx;
+	struct callback_set *set;
 
 	if (!handler || !callback)
 		return;
 
-	pthread_mutex_lock(&handler->global_callbacks_mutex);
+	set = &handler->global_callbacks;
+	pthread_mutex_lock(&set->mutex);
 
-	idx = da_find(handler->global_callbacks, &cb_data, 0);
-	if (idx == DARRAY_INVALID)
-		da_push_back(handler->global_callbacks, &cb_data);
+	if (!callback_set_find(set, NULL, callback, data)) {
+		struct signal_callback *cb = bzalloc(sizeof(*cb));
+		cb->global_callback = callback;
+		cb->data = data;
+		callback_set_add(set, cb);
+	}
 
-	pthread_mutex_unlock(&handler->global_callbacks_mutex);
+	pthread_mutex_unlock(&set->mutex);
 }
 
 void signal_handler_disconnect_global(signal_handler_t *handler, global_signal_callback_t callback, void *data)
 {
-	struct global_callback_info cb_data = {callback, data, 0, false};
-	size_t idx;
-
 	if (!handler || !callback)
 		return;
 
-	pthread_mutex_lock(&handler->global_callbacks_mutex);
-
-	idx = da_find(handler->global_callbacks, &cb_data, 0);
-	if (idx != DARRAY_INVALID) {
-		struct global_callback_info *cb = handler->global_callbacks.array + idx;
-
-		if (cb->signaling)
-			cb->remove = true;
-		else
-			da_erase(handler->global_callbacks, idx);
-	}
-
-	pthread_mutex_unlock(&handler->global_callbacks_mutex);
+	callback_set_disconnect(&handler->global_callbacks, NULL, callback, data);
 }
@@ -36,6 +36,9 @@ typedef struct signal_handler signal_handler_t;
 typedef void (*global_signal_callback_t)(void *, const char *, calldata_t *);
 typedef void (*signal_callback_t)(void *, calldata_t *);
 
+/* A pre-resolved signal of a specific handler, valid as long as the handler */
+typedef struct signal_info *signal_id_t;
+
 EXPORT signal_handler_t *signal_handler_create(void);
 EXPORT void signal_handler_destroy(signal_handler_t *handler);
 
@@ -68,6 +71,9 @@ EXPORT void signal_handler_remove_current(void);
 
 EXPORT void signal_handler_signal(signal_handler_t *handler, const char *signal, calldata_t *params);
 
+EXPORT signal_id_t signal_handler_get_id(signal_handler_t *handler, const char *signal);
+EXPORT void signal_handler_signal_id(signal_handler_t *handler, signal_id_t id, calldata_t *params);
+
 #ifdef __cplusplus
 }
 #endif
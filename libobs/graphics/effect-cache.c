@@ -0,0 +1,391 @@
+#include "../util/array-serializer.h"
+#include "../util/dstr.h"
+#include "../util/platform.h"
+#include "../util/threading.h"
+#include "effect-cache.h"
+#include "effect-parser.h"
+
+#define CACHE_MAGIC "OBSE"
+#define CACHE_VERSION 1
+#define CACHE_MAX_DEPTH 4
+
+extern const char *gs_preprocessor_name(void);
+
+static pthread_mutex_t cache_mutex = PTHREAD_MUTEX_INITIALIZER;
+static char *cache_path = NULL;
+
+/* ------------------------------------------------------------------------- */
+
+static void ir_param_free(struct gs_effect_ir_param *param)
+{
+	for (size_t i = 0; i < param->annotations.num; i++)
+		ir_param_free(param->annotations.array + i);
+
+	bfree(param->name);
+	da_free(param->default_val);
+	da_free(param->annotations);
+}
+
+static void ir_shader_free(struct gs_effect_ir_shader *shader)
+{
+	for (size_t i = 0; i < shader->params.num; i++)
+		bfree(shader->params.array[i]);
+
+	bfree(shader->text);
+	da_free(shader->params);
+}
+
+void gs_effect_ir_destroy(gs_effect_ir_t *ir)
+{
+	if (!ir)
+		return;
+
+	for (size_t i = 0; i < ir->dependencies.num; i++)
+		bfree(ir->dependencies.array[i].file);
+
+	for (size_t i = 0; i < ir->params.num; i++)
+		ir_param_free(ir->params.array + i);
+
+	for (size_t i = 0; i < ir->techniques.num; i++) {
+		struct gs_effect_ir_technique *tech = ir->techniques.array + i;
+
+		for (size_t j = 0; j < tech->passes.num; j++) {
+			struct gs_effect_ir_pass *pass = tech->passes.array + j;
+
+			ir_shader_free(&pass->vertex);
+			ir_shader_free(&pass->pixel);
+			bfree(pass->name);
+		}
+
+		da_free(tech->passes);
+		bfree(tech->name);
+	}
+
+	da_free(ir->dependencies);
+	da_free(ir->params);
+	da_free(ir->techniques);
+	bfree(ir->file);
+	bfree(ir);
+}
+
+gs_effect_ir_t *gs_effect_ir_parse(const char *effect_string, const char *file, char **error_string)
+{
+	struct gs_effect_ir *ir;
+	struct effect_parser parser;
+
+	if (!effect_string)
+		return NULL;
+
+	ir = bzalloc(sizeof(struct gs_effect_ir));
+	ir->file = bstrdup(file);
+	ir->hash = gs_effect_cache_hash(effect_string);
+
+	ep_init(&parser);
+	if (!ep_parse(&parser, ir, effect_string, file)) {
+		if (error_string)
+			*error_string = error_data_buildstring(&parser.cfp.error_list);
+		gs_effect_ir_destroy(ir);
+		ir = NULL;
+	}
+
+	ep_free(&parser);
+	return ir;
+}
+
+/* ------------------------------------------------------------------------- */
+
+static void write_param(struct serializer *s, const struct gs_effect_ir_param *param)
+{
+	gs_cache_write_string(s, param->name);
+	gs_cache_write_varint(s, (uint64_t)param->type);
+	gs_cache_write_varint(s, param->default_val.num);
+	s_write(s, param->default_val.array, param->default_val.num);
+
+	gs_cache_write_varint(s, param->annotations.num);
+	for (size_t i = 0; i < param->annotations.num; i++)
+		write_param(s, param->annotations.array + i);
+}
+
+static void write_shader(struct serializer *s, const struct gs_effect_ir_shader *shader)
+{
+	gs_cache_write_string(s, shader->text);
+
+	gs_cache_write_varint(s, shader->params.num);
+	for (size_t i = 0; i < shader->params.num; i++)
+		gs_cache_write_string(s, shader->params.array[i]);
+}
+
+static void write_ir(struct serializer *s, const struct gs_effect_ir *ir)
+{
+	s_write(s, CACHE_MAGIC, 4);
+	s_w8(s, CACHE_VERSION);
+	gs_cache_write_string(s, gs_preprocessor_name());
+	s_wl64(s, ir->hash);
+
+	gs_cache_write_varint(s, ir->dependencies.num);
+	for (size_t i = 0; i < ir->dependencies.num; i++) {
+		gs_cache_write_string(s, ir->dependencies.array[i].file);
+		s_wl64(s, ir->dependencies.array[i].hash);
+	}
+
+	gs_cache_write_varint(s, ir->params.num);
+	for (size_t i = 0; i < ir->params.num; i++)
+		write_param(s, ir->params.array + i);
+
+	gs_cache_write_varint(s, ir->techniques.num);
+	for (size_t i = 0; i < ir->techniques.num; i++) {
+		const struct gs_effect_ir_technique *tech = ir->techniques.array + i;
+
+		gs_cache_write_string(s, tech->name);
+		gs_cache_write_varint(s, tech->passes.num);
+
+		for (size_t j = 0; j < tech->passes.num; j++) {
+			const struct gs_effect_ir_pass *pass = tech->passes.array + j;
+
+			gs_cache_write_string(s, pass->name);
+			write_shader(s, &pass->vertex);
+			write_shader(s, &pass->pixel);
+		}
+	}
+}
+
+/* ------------------------------------------------------------------------- */
+
+static void read_param(struct gs_cache_reader *r, struct gs_effect_ir_param *param, int depth)
+{
+	const char *name = gs_cache_read_string(r);
+	uint64_t type = gs_cache_read_varint(r);
+	size_t size = gs_cache_read_count(r);
+
+	if (r->error || depth > CACHE_MAX_DEPTH || type > GS_SHADER_PARAM_TEXTURE) {
+		r->error = true;
+		return;
+	}
+
+	param->name = bstrdup(name);
+	param->type = (enum gs_shader_param_type)type;
+	da_push_back_array(param->default_val, r->pos, size);
+	r->pos += size;
+
+	size_t count = gs_cache_read_count(r);
+	da_resize(param->annotations, count);
+
+	for (size_t i = 0; i < count && !r->error; i++)
+		read_param(r, param->annotations.array + i, depth + 1);
+}
+
+static void read_shader(struct gs_cache_reader *r, struct gs_effect_ir_shader *shader)
+{
+	shader->text = bstrdup(gs_cache_read_string(r));
+
+	size_t count = gs_cache_read_count(r);
+	da_resize(shader->params, count);
+
+	for (size_t i = 0; i < count && !r->error; i++)
+		shader->params.array[i] = bstrdup(gs_cache_read_string(r));
+}
+
+static bool dependencies_unchanged(struct gs_effect_ir *ir)
+{
+	for (size_t i = 0; i < ir->dependencies.num; i++) {
+		struct gs_effect_ir_dependency *dep = ir->dependencies.array + i;
+		char *text = os_quick_read_utf8_file(dep->file);
+		bool unchanged = text && gs_effect_cache_hash(text) == dep->hash;
+
+		bfree(text);
+		if (!unchanged)
+			return false;
+	}
+
+	return true;
+}
+
+static struct gs_effect_ir *read_ir(struct gs_cache_reader *r, const char *file, const char *effect_string)
+{
+	if ((size_t)(r->end - r->pos) < 5 || memcmp(r->pos, CACHE_MAGIC, 4) != 0)
+		return NULL;
+
+	r->pos += 4;
+	if (gs_cache_read_u8(r) != CACHE_VERSION)
+		return NULL;
+
+	const char *preprocessor = gs_cache_read_string(r);
+	uint64_t hash = gs_cache_read_u64(r);
+
+	if (r->error || strcmp(preprocessor, gs_preprocessor_name() ? gs_preprocessor_name() : "") != 0 ||
+	    hash != gs_effect_cache_hash(effect_string))
+		return NULL;
+
+	struct gs_effect_ir *ir = bzalloc(sizeof(struct gs_effect_ir));
+	ir->file = bstrdup(file);
+	ir->hash = hash;
+
+	size_t count = gs_cache_read_count(r);
+	da_resize(ir->dependencies, count);
+
+	for (size_t i = 0; i < count && !r->error; i++) {
+		ir->dependencies.array[i].file = bstrdup(gs_cache_read_string(r));
+		ir->dependencies.array[i].hash = gs_cache_read_u64(r);
+	}
+
+	if (r->error || !dependencies_unchanged(ir))
+		goto fail;
+
+	count = gs_cache_read_count(r);
+	da_resize(ir->params, count);
+
+	for (size_t i = 0; i < count && !r->error; i++)
+		read_param(r, ir->params.array + i, 0);
+
+	count = gs_cache_read_count(r);
+	da_resize(ir->techniques, count);
+
+	for (size_t i = 0; i < count && !r->error; i++) {
+		struct gs_effect_ir_technique *tech = ir->techniques.array + i;
+
+		tech->name = bstrdup(gs_cache_read_string(r));
+
+		size_t passes = gs_cache_read_count(r);
+		da_resize(tech->passes, passes);
+
+		for (size_t j = 0; j < passes && !r->error; j++) {
+			struct gs_effect_ir_pass *pass = tech->passes.array + j;
+
+			pass->name = bstrdup(gs_cache_read_string(r));
+			read_shader(r, &pass->vertex);
+			read_shader(r, &pass->pixel);
+		}
+	}
+
+	if (r->error || r->pos != r->end)
+		goto fail;
+
+	return ir;
+
+fail:
+	gs_effect_ir_destroy(ir);
+	return NULL;
+}
+
+/* ------------------------------------------------------------------------- */
+
+void gs_effect_cache_set_path(const char *path)
+{
+	pthread_mutex_lock(&cache_mutex);
+	bfree(cache_path);
+	cache_path = path && *path ? bstrdup(path) : NULL;
+	pthread_mutex_unlock(&cache_mutex);
+}
+
+/* cache_mutex must be held */
+static bool get_cache_file(struct dstr *cache_file, const char *name)
+{
+	if (!cache_path || !name)
+		return false;
+
+	dstr_printf(cache_file, "%s/%s", cache_path, name);
+	return true;
+}
+
+static void get_effect_name(struct dstr *name, const char *file)
+{
+	struct dstr key = {0};
+
+	/* shaders are generated differently for every backend */
+	dstr_printf(&key, "%s\n%s", file, gs_preprocessor_name() ? gs_preprocessor_name() : "");
+	dstr_printf(name, "%016llx.bin", (unsigned long long)gs_effect_cache_hash(key.array));
+	dstr_free(&key);
+}
+
+void *gs_effect_cache_load_blob(const char *name, size_t *size)
+{
+	struct dstr cache_file = {0};
+	uint8_t *buf = NULL;
+	FILE *f = NULL;
+
+	pthread_mutex_lock(&cache_mutex);
+	if (get_cache_file(&cache_file, name))
+		f = os_fopen(cache_file.array, "rb");
+	pthread_mutex_unlock(&cache_mutex);
+
+	dstr_free(&cache_file);
+	if (!f)
+		return NULL;
+
+	int64_t file_size = os_fgetsize(f);
+	if (file_size > 0 && (uint64_t)file_size <= SIZE_MAX) {
+		buf = bmalloc((size_t)file_size);
+
+		if (fread(buf, 1, (size_t)file_size, f) == (size_t)file_size) {
+			*size = (size_t)file_size;
+		} else {
+			bfree(buf);
+			buf = NULL;
+		}
+	}
+
+	fclose(f);
+	return buf;
+}
+
+bool gs_effect_cache_save_blob(const char *name, const void *data, size_t size)
+{
+	struct dstr cache_file = {0};
+	bool success = false;
+
+	pthread_mutex_lock(&cache_mutex);
+	if (get_cache_file(&cache_file, name)) {
+		os_mkdirs(cache_path);
+		success = os_quick_write_utf8_file_safe(cache_file.array, data, size, false, "tmp", NULL);
+		if (!success)
+			blog(LOG_WARNING, "Could not write effect cache file '%s'", cache_file.array);
+	}
+	pthread_mutex_unlock(&cache_mutex);
+
+	dstr_free(&cache_file);
+	return success;
+}
+
+gs_effect_ir_t *gs_effect_cache_load(const char *file, const char *effect_string)
+{
+	struct gs_effect_ir *ir = NULL;
+	struct dstr name = {0};
+	uint8_t *buf;
+	size_t size = 0;
+
+	if (!file || !effect_string)
+		return NULL;
+
+	get_effect_name(&name, file);
+	buf = gs_effect_cache_load_blob(name.array, &size);
+	dstr_free(&name);
+
+	if (buf) {
+		struct gs_cache_reader r = {buf, buf + size, false};
+		ir = read_ir(&r, file, effect_string);
+		bfree(buf);
+	}
+
+	return ir;
+}
+
+bool gs_effect_cache_save(const gs_effect_ir_t *ir)
+{
+	struct array_output_data output;
+	struct serializer s;
+	struct dstr name = {0};
+	bool success;
+
+	if (!ir || !ir->file)
+		return false;
+
+	array_output_serializer_init(&s, &output);
+	write_ir(&s, ir);
+
+	get_effect_name(&name, ir->file);
+	success = gs_effect_cache_save_blob(name.array, output.bytes.array, output.bytes.num);
+
+	dstr_free(&name);
+	array_output_serializer_free(&output);
+	return success;
+}
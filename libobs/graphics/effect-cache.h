@@ -0,0 +1,196 @@
+#pragma once
+
+#include "../util/darray.h"
+#include "../util/serializer.h"
+#include "graphics.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Parsed form of an effect, everything that is needed to create the effect
+ * without going through the effect parser again: parameters with their
+ * default values and annotations, and the generated shader text of every
+ * pass along with the parameters each shader uses.
+ *
+ * Effects loaded from files keep their parsed form in an on-disk cache,
+ * keyed by the effect's path and the graphics backend, and validated against
+ * hashes of the effect's source and of every file it includes.
+ */
+
+struct gs_effect_ir_param {
+	char *name;
+	enum gs_shader_param_type type;
+	DARRAY(uint8_t) default_val;
+	DARRAY(struct gs_effect_ir_param) annotations;
+};
+
+struct gs_effect_ir_shader {
+	char *text;
+	DARRAY(char *) params;
+};
+
+struct gs_effect_ir_pass {
+	char *name;
+	struct gs_effect_ir_shader vertex;
+	struct gs_effect_ir_shader pixel;
+};
+
+struct gs_effect_ir_technique {
+	char *name;
+	DARRAY(struct gs_effect_ir_pass) passes;
+};
+
+struct gs_effect_ir_dependency {
+	char *file;
+	uint64_t hash;
+};
+
+struct gs_effect_ir {
+	char *file;
+	uint64_t hash;
+	DARRAY(struct gs_effect_ir_dependency) dependencies;
+
+	DARRAY(struct gs_effect_ir_param) params;
+	DARRAY(struct gs_effect_ir_technique) techniques;
+};
+
+typedef struct gs_effect_ir gs_effect_ir_t;
+
+/* FNV-1a, only used to detect changed files and to name cache files */
+static inline uint64_t gs_effect_cache_hash_append(uint64_t hash, const char *str)
+{
+	while (str && *str) {
+		hash ^= (uint8_t)*(str++);
+		hash *= 0x100000001b3ULL;
+	}
+
+	return hash;
+}
+
+static inline uint64_t gs_effect_cache_hash(const char *str)
+{
+	return gs_effect_cache_hash_append(0xcbf29ce484222325ULL, str);
+}
+
+/* ------------------------------------------------------------------------- */
+/* helpers for the cache file format, shared with the graphics backends */
+
+static inline void gs_cache_write_varint(struct serializer *s, uint64_t val)
+{
+	while (val >= 0x80) {
+		s_w8(s, (uint8_t)(val | 0x80));
+		val >>= 7;
+	}
+
+	s_w8(s, (uint8_t)val);
+}
+
+static inline void gs_cache_write_string(struct serializer *s, const char *str)
+{
+	size_t len = str ? strlen(str) : 0;
+
+	gs_cache_write_varint(s, len);
+	s_write(s, str ? str : "", len + 1);
+}
+
+struct gs_cache_reader {
+	const uint8_t *pos;
+	const uint8_t *end;
+	bool error;
+};
+
+static inline uint8_t gs_cache_read_u8(struct gs_cache_reader *r)
+{
+	if (r->pos == r->end) {
+		r->error = true;
+		return 0;
+	}
+
+	return *(r->pos++);
+}
+
+static inline uint64_t gs_cache_read_u64(struct gs_cache_reader *r)
+{
+	uint64_t val = 0;
+
+	for (unsigned int shift = 0; shift < 64; shift += 8)
+		val |= (uint64_t)gs_cache_read_u8(r) << shift;
+
+	return val;
+}
+
+static inline uint64_t gs_cache_read_varint(struct gs_cache_reader *r)
+{
+	uint64_t val = 0;
+
+	for (unsigned int shift = 0; shift < 64; shift += 7) {
+		uint8_t byte = gs_cache_read_u8(r);
+
+		val |= (uint64_t)(byte & 0x7F) << shift;
+		if (!(byte & 0x80))
+			return val;
+	}
+
+	r->error = true;
+	return 0;
+}
+
+/* counts are checked against the remaining data so a corrupt file can't
+ * make us allocate huge arrays */
+static inline size_t gs_cache_read_count(struct gs_cache_reader *r)
+{
+	uint64_t count = gs_cache_read_varint(r);
+
+	if (r->error || count > (uint64_t)(r->end - r->pos)) {
+		r->error = true;
+		return 0;
+	}
+
+	return (size_t)count;
+}
+
+static inline const char *gs_cache_read_string(struct gs_cache_reader *r)
+{
+	uint64_t len = gs_cache_read_varint(r);
+
+	if (r->error || len >= (uint64_t)(r->end - r->pos) || r->pos[len] != 0) {
+		r->error = true;
+		return NULL;
+	}
+
+	const char *str = (const char *)r->pos;
+	r->pos += len + 1;
+	return str;
+}
+
+static inline const uint8_t *gs_cache_read_data(struct gs_cache_reader *r, size_t size)
+{
+	if (r->error || size > (size_t)(r->end - r->pos)) {
+		r->error = true;
+		return NULL;
+	}
+
+	const uint8_t *data = r->pos;
+	r->pos += size;
+	return data;
+}
+
+/* ------------------------------------------------------------------------- */
+
+EXPORT gs_effect_ir_t *gs_effect_ir_parse(const char *effect_string, const char *file, char **error_string);
+EXPORT void gs_effect_ir_destroy(gs_effect_ir_t *ir);
+
+EXPORT gs_effect_ir_t *gs_effect_cache_load(const char *file, const char *effect_string);
+EXPORT bool gs_effect_cache_save(const gs_effect_ir_t *ir);
+
+/* files of the graphics backends, such as translated shaders or program
+ * binaries, stored by name in the same directory.  the backends make the name
+ * unique to the data, and validate the data themselves */
+EXPORT void *gs_effect_cache_load_blob(const char *name, size_t *size);
+EXPORT bool gs_effect_cache_save_blob(const char *name, const void *data, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
@@ -20,6 +20,7 @@
 #include "../util/platform.h"
 #include "effect-parser.h"
 #include "effect.h"
+#include "effect-cache.h"
 
 typedef DARRAY(struct dstr) dstr_array_t;
 
@@ -1186,7 +1187,7 @@ static bool ep_compile(struct effect_parser *ep);
 extern const char *gs_preprocessor_name(void);
 
 #if defined(_DEBUG) && defined(_DEBUG_SHADERS)
-static void debug_get_default_value(struct gs_effect_param *param, char *buffer, unsigned long long buf_size)
+static void debug_get_default_value(struct gs_effect_ir_param *param, char *buffer, unsigned long long buf_size)
 {
 	if (param->default_val.num == 0) {
 		snprintf(buffer, buf_size, "(null)");
@@ -1252,7 +1253,7 @@ static void debug_get_default_value(struct gs_effect_param *param, char *buffer,
 	}
 }
 
-static void debug_param(struct gs_effect_param *param, struct ep_param *param_in, unsigned long long idx,
+static void debug_param(struct gs_effect_ir_param *param, struct ep_param *param_in, unsigned long long idx,
 			const char *offset)
 {
 	char _debug_type[4096];
@@ -1310,7 +1311,7 @@ static void debug_param(struct gs_effect_param *param, struct ep_param *param_in
 	}
 }
 
-static void debug_param_annotation(struct gs_effect_param *param, struct ep_param *param_in, unsigned long long idx,
+static void debug_param_annotation(struct gs_effect_ir_param *param, struct ep_param *param_in, unsigned long long idx,
 				   const char *offset)
 {
 	char _debug_buf[4096];
@@ -1352,7 +1353,7 @@ static void debug_print_string(const char *offset, const char *str)
 }
 #endif
 
-bool ep_parse(struct effect_parser *ep, gs_effect_t *effect, const char *effect_string, const char *file)
+bool ep_parse(struct effect_parser *ep, struct gs_effect_ir *ir, const char *effect_string, const char *file)
 {
 	bool success;
 
@@ -1369,7 +1370,7 @@ bool ep_parse(struct effect_parser *ep, gs_effect_t *effect, const char *effect_
 		cf_preprocessor_add_def(&ep->cfp.pp, &def);
 	}
 
-	ep->effect = effect;
+	ep->ir = ir;
 	if (!cf_parser_parse(&ep->cfp, effect_string, file))
 		return false;
 
@@ -1721,198 +1722,98 @@ static void ep_makeshaderstring(struct effect_parser *ep, struct dstr *shader, c
 	ep_reset_written(ep);
 }
 
-static void ep_compile_annotations(ep_param_array_t *ep_annotations, gs_effect_param_array_t *gsp_annotations,
-				   struct effect_parser *ep)
+static void ep_compile_annotations(ep_param_array_t *ep_annotations, struct gs_effect_ir_param *param)
 {
-	da_resize(*gsp_annotations, ep_annotations->num);
+	da_resize(param->annotations, ep_annotations->num);
 
 	size_t i;
 	for (i = 0; i < ep_annotations->num; i++) {
-		struct gs_effect_param *param = gsp_annotations->array + i;
-		struct ep_param *param_in = ep_annotations->array + i;
+		struct gs_effect_ir_param *annotation = param->annotations.array + i;
+		struct ep_param *annotation_in = ep_annotations->array + i;
 
-		param->name = bstrdup(param_in->name);
-		param->section = EFFECT_ANNOTATION;
-		param->effect = ep->effect;
-		da_move(param->default_val, param_in->default_val);
-
-		param->type = get_effect_param_type(param_in->type);
+		annotation->name = bstrdup(annotation_in->name);
+		annotation->type = get_effect_param_type(annotation_in->type);
+		da_move(annotation->default_val, annotation_in->default_val);
 
 #if defined(_DEBUG) && defined(_DEBUG_SHADERS)
-		debug_param(param, param_in, i, "\t\t");
+		debug_param(annotation, annotation_in, i, "\t\t");
 #endif
 	}
 }
 
-static void ep_compile_param_annotations(struct ep_param *ep_param_input, struct gs_effect_param *gs_effect_input,
-					 struct effect_parser *ep)
-{
-	ep_compile_annotations(&(ep_param_input->annotations), &(gs_effect_input->annotations), ep);
-}
-
 static void ep_compile_param(struct effect_parser *ep, size_t idx)
 {
-	struct gs_effect_param *param;
+	struct gs_effect_ir_param *param;
 	struct ep_param *param_in;
 
-	param = ep->effect->params.array + idx;
+	param = ep->ir->params.array + idx;
 	param_in = ep->params.array + idx;
-	param_in->param = param;
 
 	param->name = bstrdup(param_in->name);
-	param->section = EFFECT_PARAM;
-	param->effect = ep->effect;
-	da_move(param->default_val, param_in->default_val);
-
 	param->type = get_effect_param_type(param_in->type);
-
-	if (strcmp(param_in->name, "ViewProj") == 0)
-		ep->effect->view_proj = param;
-	else if (strcmp(param_in->name, "World") == 0)
-		ep->effect->world = param;
+	da_move(param->default_val, param_in->default_val);
 
 #if defined(_DEBUG) && defined(_DEBUG_SHADERS)
 	debug_param(param, param_in, idx, "\t");
 #endif
 
-	ep_compile_param_annotations(param_in, param, ep);
+	ep_compile_annotations(&param_in->annotations, param);
 }
 
-static bool ep_compile_pass_shaderparams(struct effect_parser *ep, pass_shaderparam_array_t *pass_params,
-					 dstr_array_t *used_params, gs_shader_t *shader)
-{
-	size_t i;
-	da_resize(*pass_params, used_params->num);
-
-	for (i = 0; i < pass_params->num; i++) {
-		struct dstr *param_name = used_params->array + i;
-		struct pass_shaderparam *param = pass_params->array + i;
-
-		param->eparam = gs_effect_get_param_by_name(ep->effect, param_name->array);
-		param->sparam = gs_shader_get_param_by_name(shader, param_name->array);
-
-#if defined(_DEBUG) && defined(_DEBUG_SHADERS)
-		debug_param(param->eparam, 0, i, "\t\t\t\t");
-#endif
-
-		if (!param->sparam) {
-			blog(LOG_ERROR, "Effect shader parameter not found");
-			return false;
-		}
-	}
-
-	return true;
-}
-
-static inline bool ep_compile_pass_shader(struct effect_parser *ep, struct gs_effect_technique *tech,
-					  struct gs_effect_pass *pass, struct ep_pass *pass_in, size_t pass_idx,
-					  enum gs_shader_type type)
+static inline void ep_compile_pass_shader(struct effect_parser *ep, struct gs_effect_ir_shader *shader,
+					  cf_token_array_t *shader_call)
 {
 	struct dstr shader_str;
-	struct dstr location;
 	dstr_array_t used_params;
-	pass_shaderparam_array_t *pass_params = NULL;
-	gs_shader_t *shader = NULL;
-	bool success = true;
-	char *errors = NULL;
 
 	dstr_init(&shader_str);
 	da_init(used_params);
-	dstr_init(&location);
-
-	dstr_copy(&location, ep->cfp.lex.file);
-	if (type == GS_SHADER_VERTEX)
-		dstr_cat(&location, " (Vertex ");
-	else if (type == GS_SHADER_PIXEL)
-		dstr_cat(&location, " (Pixel ");
-	/*else if (type == SHADER_GEOMETRY)
-		dstr_cat(&location, " (Geometry ");*/
-
-	assert(pass_idx <= UINT_MAX);
-	dstr_catf(&location, "shader, technique %s, pass %u)", tech->name, (unsigned)pass_idx);
 
-	if (type == GS_SHADER_VERTEX) {
-		ep_makeshaderstring(ep, &shader_str, &pass_in->vertex_program, &used_params);
-
-		pass->vertshader = gs_vertexshader_create(shader_str.array, location.array, &errors);
-
-		shader = pass->vertshader;
-		pass_params = &pass->vertshader_params;
-	} else if (type == GS_SHADER_PIXEL) {
-		ep_makeshaderstring(ep, &shader_str, &pass_in->fragment_program, &used_params);
-
-		pass->pixelshader = gs_pixelshader_create(shader_str.array, location.array, &errors);
-
-		shader = pass->pixelshader;
-		pass_params = &pass->pixelshader_params;
-	}
-
-	if (errors && strlen(errors)) {
-		cf_adderror(&ep->cfp, "Error creating shader: $1", LEX_ERROR, errors, NULL, NULL);
-	}
-	bfree(errors);
+	ep_makeshaderstring(ep, &shader_str, shader_call, &used_params);
 
 #if defined(_DEBUG) && defined(_DEBUG_SHADERS)
-	blog(LOG_DEBUG, "\t\t\t%s Shader:", type == GS_SHADER_VERTEX ? "Vertex" : "Fragment");
 	blog(LOG_DEBUG, "\t\t\tCode:");
-	debug_print_string("\t\t\t\t\t", shader_str.array);
-	blog(LOG_DEBUG, "\t\t\tParameters:");
+	debug_print_string("\t\t\t\t\t", shader_str.array ? shader_str.array : "");
 #endif
 
-	if (shader)
-		success = ep_compile_pass_shaderparams(ep, pass_params, &used_params, shader);
-	else
-		success = false;
+	/* the strings are handed over as they are */
+	shader->text = shader_str.array ? shader_str.array : bstrdup("");
+	da_resize(shader->params, used_params.num);
+	for (size_t i = 0; i < used_params.num; i++)
+		shader->params.array[i] = used_params.array[i].array;
 
-	dstr_free(&location);
-	dstr_array_free(used_params.array, used_params.num);
 	da_free(used_params);
-	dstr_free(&shader_str);
-
-	return success;
 }
 
-static bool ep_compile_pass(struct effect_parser *ep, struct gs_effect_technique *tech, struct ep_technique *tech_in,
+static void ep_compile_pass(struct effect_parser *ep, struct gs_effect_ir_technique *tech, struct ep_technique *tech_in,
 			    size_t idx)
 {
-	struct gs_effect_pass *pass;
+	struct gs_effect_ir_pass *pass;
 	struct ep_pass *pass_in;
-	bool success = true;
 
 	pass = tech->passes.array + idx;
 	pass_in = tech_in->passes.array + idx;
 
 	pass->name = bstrdup(pass_in->name);
-	pass->section = EFFECT_PASS;
 
 #if defined(_DEBUG) && defined(_DEBUG_SHADERS)
 	blog(LOG_DEBUG, "\t\t[%4lld] Pass '%s':", idx, pass->name);
 #endif
 
-	if (!ep_compile_pass_shader(ep, tech, pass, pass_in, idx, GS_SHADER_VERTEX)) {
-		success = false;
-		blog(LOG_ERROR, "Pass (%zu) <%s> missing vertex shader!", idx, pass->name ? pass->name : "");
-	}
-	if (!ep_compile_pass_shader(ep, tech, pass, pass_in, idx, GS_SHADER_PIXEL)) {
-		success = false;
-		blog(LOG_ERROR, "Pass (%zu) <%s> missing pixel shader!", idx, pass->name ? pass->name : "");
-	}
-	return success;
+	ep_compile_pass_shader(ep, &pass->vertex, &pass_in->vertex_program);
+	ep_compile_pass_shader(ep, &pass->pixel, &pass_in->fragment_program);
 }
 
-static inline bool ep_compile_technique(struct effect_parser *ep, size_t idx)
+static inline void ep_compile_technique(struct effect_parser *ep, size_t idx)
 {
-	struct gs_effect_technique *tech;
+	struct gs_effect_ir_technique *tech;
 	struct ep_technique *tech_in;
-	bool success = true;
 	size_t i;
 
-	tech = ep->effect->techniques.array + idx;
+	tech = ep->ir->techniques.array + idx;
 	tech_in = ep->techniques.array + idx;
 
 	tech->name = bstrdup(tech_in->name);
-	tech->section = EFFECT_TECHNIQUE;
-	tech->effect = ep->effect;
 
 	da_resize(tech->passes, tech_in->passes.num);
 
@@ -1920,23 +1821,35 @@ static inline bool ep_compile_technique(struct effect_parser *ep, size_t idx)
 	blog(LOG_DEBUG, "\t[%4lld] Technique '%s' has %lld passes:", idx, tech->name, tech->passes.num);
 #endif
 
-	for (i = 0; i < tech->passes.num; i++) {
-		if (!ep_compile_pass(ep, tech, tech_in, i))
-			success = false;
-	}
+	for (i = 0; i < tech->passes.num; i++)
+		ep_compile_pass(ep, tech, tech_in, i);
+}
 
-	return success;
+static void ep_compile_dependencies(struct effect_parser *ep)
+{
+	struct cf_preprocessor *pp = &ep->cfp.pp;
+
+	da_resize(ep->ir->dependencies, pp->dependencies.num);
+
+	for (size_t i = 0; i < pp->dependencies.num; i++) {
+		struct gs_effect_ir_dependency *dep = ep->ir->dependencies.array + i;
+		struct cf_lexer *dep_in = pp->dependencies.array + i;
+
+		dep->file = bstrdup(dep_in->file);
+		dep->hash = gs_effect_cache_hash(dep_in->base_lexer.text);
+	}
 }
 
+/* generates the shader text of every pass; the shaders themselves are only
+ * created once the parsed effect is loaded into an actual effect */
 static bool ep_compile(struct effect_parser *ep)
 {
-	bool success = true;
 	size_t i;
 
-	assert(ep->effect);
+	assert(ep->ir);
 
-	da_resize(ep->effect->params, ep->params.num);
-	da_resize(ep->effect->techniques, ep->techniques.num);
+	da_resize(ep->ir->params, ep->params.num);
+	da_resize(ep->ir->techniques, ep->techniques.num);
 
 #if defined(_DEBUG) && defined(_DEBUG_SHADERS)
 	blog(LOG_DEBUG, "Shader has %lld parameters:", ep->params.num);
@@ -1949,10 +1862,9 @@ static bool ep_compile(struct effect_parser *ep)
 	blog(LOG_DEBUG, "Shader has %lld techniques:", ep->techniques.num);
 #endif
 
-	for (i = 0; i < ep->techniques.num; i++) {
-		if (!ep_compile_technique(ep, i))
-			success = false;
-	}
+	for (i = 0; i < ep->techniques.num; i++)
+		ep_compile_technique(ep, i);
 
-	return success;
+	ep_compile_dependencies(ep);
+	return true;
 }
@@ -250,8 +250,10 @@ static inline void ep_func_free(struct ep_func *epf)
 
 /* ------------------------------------------------------------------------- */
 
+struct gs_effect_ir;
+
 struct effect_parser {
-	gs_effect_t *effect;
+	struct gs_effect_ir *ir;
 
 	ep_param_array_t params;
 	DARRAY(struct ep_struct) structs;
@@ -283,7 +285,7 @@ static inline void ep_init(struct effect_parser *ep)
 
 extern void ep_free(struct effect_parser *ep);
 
-extern bool ep_parse(struct effect_parser *ep, gs_effect_t *effect, const char *effect_string, const char *file);
+extern bool ep_parse(struct effect_parser *ep, struct gs_effect_ir *ir, const char *effect_string, const char *file);
 
 #ifdef __cplusplus
 }
@@ -15,12 +15,145 @@
     along with this program.  If not, see <http://www.gnu.org/licenses/>.
 ******************************************************************************/
 
+#include "../util/dstr.h"
 #include "effect.h"
+#include "effect-cache.h"
 #include "graphics-internal.h"
 #include "vec2.h"
 #include "vec3.h"
 #include "vec4.h"
 
+static void load_param(gs_effect_t *effect, struct gs_effect_param *param, const struct gs_effect_ir_param *param_in,
+		       enum effect_section section)
+{
+	param->name = bstrdup(param_in->name);
+	param->section = section;
+	param->effect = effect;
+	param->type = param_in->type;
+	da_copy(param->default_val, param_in->default_val);
+
+	da_resize(param->annotations, param_in->annotations.num);
+	for (size_t i = 0; i < param_in->annotations.num; i++)
+		load_param(effect, param->annotations.array + i, param_in->annotations.array + i, EFFECT_ANNOTATION);
+}
+
+static bool load_pass_shader(gs_effect_t *effect, struct gs_effect_technique *tech, struct gs_effect_pass *pass,
+			     size_t pass_idx, enum gs_shader_type type, const struct gs_effect_ir_shader *shader_in,
+			     struct dstr *errors)
+{
+	pass_shaderparam_array_t *pass_params;
+	gs_shader_t *shader = NULL;
+	struct dstr location = {0};
+	char *shader_errors = NULL;
+	bool success = true;
+
+	dstr_printf(&location, "%s (%s shader, technique %s, pass %u)", effect->effect_path ? effect->effect_path : "",
+		    type == GS_SHADER_VERTEX ? "Vertex" : "Pixel", tech->name, (unsigned)pass_idx);
+
+	if (type == GS_SHADER_VERTEX) {
+		if (shader_in->text && *shader_in->text)
+			pass->vertshader = gs_vertexshader_create(shader_in->text, location.array, &shader_errors);
+
+		shader = pass->vertshader;
+		pass_params = &pass->vertshader_params;
+	} else {
+		if (shader_in->text && *shader_in->text)
+			pass->pixelshader = gs_pixelshader_create(shader_in->text, location.array, &shader_errors);
+
+		shader = pass->pixelshader;
+		pass_params = &pass->pixelshader_params;
+	}
+
+	if (shader_errors && *shader_errors)
+		dstr_catf(errors, "%s: Error creating shader: %s\n", location.array, shader_errors);
+	bfree(shader_errors);
+	dstr_free(&location);
+
+	if (!shader)
+		return false;
+
+	da_resize(*pass_params, shader_in->params.num);
+
+	for (size_t i = 0; i < pass_params->num; i++) {
+		const char *name = shader_in->params.array[i];
+		struct pass_shaderparam *param = pass_params->array + i;
+
+		param->eparam = gs_effect_get_param_by_name(effect, name);
+		param->sparam = gs_shader_get_param_by_name(shader, name);
+
+		if (!param->sparam) {
+			blog(LOG_ERROR, "Effect shader parameter not found");
+			success = false;
+			break;
+		}
+	}
+
+	return success;
+}
+
+static bool load_pass(gs_effect_t *effect, struct gs_effect_technique *tech, size_t idx,
+		      const struct gs_effect_ir_pass *pass_in, struct dstr *errors)
+{
+	struct gs_effect_pass *pass = tech->passes.array + idx;
+	bool success = true;
+
+	pass->name = bstrdup(pass_in->name);
+	pass->section = EFFECT_PASS;
+
+	if (!load_pass_shader(effect, tech, pass, idx, GS_SHADER_VERTEX, &pass_in->vertex, errors)) {
+		success = false;
+		blog(LOG_ERROR, "Pass (%zu) <%s> missing vertex shader!", idx, pass->name ? pass->name : "");
+	}
+	if (!load_pass_shader(effect, tech, pass, idx, GS_SHADER_PIXEL, &pass_in->pixel, errors)) {
+		success = false;
+		blog(LOG_ERROR, "Pass (%zu) <%s> missing pixel shader!", idx, pass->name ? pass->name : "");
+	}
+
+	return success;
+}
+
+bool effect_load_ir(gs_effect_t *effect, const struct gs_effect_ir *ir, char **error_string)
+{
+	struct dstr errors = {0};
+	bool success = true;
+
+	da_resize(effect->params, ir->params.num);
+	da_resize(effect->techniques, ir->techniques.num);
+
+	for (size_t i = 0; i < ir->params.num; i++) {
+		struct gs_effect_param *param = effect->params.array + i;
+
+		load_param(effect, param, ir->params.array + i, EFFECT_PARAM);
+
+		if (strcmp(param->name, "ViewProj") == 0)
+			effect->view_proj = param;
+		else if (strcmp(param->name, "World") == 0)
+			effect->world = param;
+	}
+
+	for (size_t i = 0; i < ir->techniques.num; i++) {
+		struct gs_effect_technique *tech = effect->techniques.array + i;
+		const struct gs_effect_ir_technique *tech_in = ir->techniques.array + i;
+
+		tech->name = bstrdup(tech_in->name);
+		tech->section = EFFECT_TECHNIQUE;
+		tech->effect = effect;
+
+		da_resize(tech->passes, tech_in->passes.num);
+
+		for (size_t j = 0; j < tech->passes.num; j++) {
+			if (!load_pass(effect, tech, j, tech_in->passes.array + j, &errors))
+				success = false;
+		}
+	}
+
+	if (error_string && errors.len)
+		*error_string = bstrdup(errors.array);
+	dstr_free(&errors);
+
+	return success;
+}
+
 void gs_effect_actually_destroy(gs_effect_t *effect)
 {
 	effect_free(effect);
@@ -185,6 +185,14 @@ static inline void effect_free(gs_effect_t *effect)
 	effect->effect_dir = NULL;
 }
 
+/* ------------------------------------------------------------------------- */
+
+struct gs_effect_ir;
+
+/* creates the effect's parameters, techniques and shaders from its parsed
+ * form */
+extern bool effect_load_ir(gs_effect_t *effect, const struct gs_effect_ir *ir, char **error_string);
+
 #ifdef __cplusplus
 }
 #endif
@@ -26,6 +26,7 @@
 #include "quat.h"
 #include "axisang.h"
 #include "effect-parser.h"
+#include "effect-cache.h"
 #include "effect.h"
 
 #ifdef near
@@ -835,10 +836,35 @@ static inline struct gs_effect *find_cached_effect(const char *filename)
 	return effect;
 }
 
+static gs_effect_t *effect_create_from_ir(const struct gs_effect_ir *ir, char **error_string)
+{
+	struct gs_effect *effect = bzalloc(sizeof(struct gs_effect));
+
+	effect->graphics = thread_graphics;
+	effect->effect_path = bstrdup(ir->file);
+
+	if (!effect_load_ir(effect, ir, error_string)) {
+		gs_effect_destroy(effect);
+		return NULL;
+	}
+
+	pthread_mutex_lock(&thread_graphics->effect_mutex);
+
+	if (effect->effect_path) {
+		effect->cached = true;
+		effect->next = thread_graphics->first_effect;
+		thread_graphics->first_effect = effect;
+	}
+
+	pthread_mutex_unlock(&thread_graphics->effect_mutex);
+	return effect;
+}
+
 gs_effect_t *gs_effect_create_from_file(const char *file, char **error_string)
 {
 	char *file_string;
 	gs_effect_t *effect = NULL;
+	gs_effect_ir_t *ir;
 
 	if (!gs_valid_p("gs_effect_create_from_file", file))
 		return NULL;
@@ -853,46 +879,42 @@ gs_effect_t *gs_effect_create_from_file(const char *file, char **error_string)
 		return NULL;
 	}
 
-	effect = gs_effect_create(file_string, file, error_string);
-	bfree(file_string);
+	/* skip parsing if the file and its includes are unchanged since it was
+	 * last parsed */
+	ir = gs_effect_cache_load(file, file_string);
+	if (ir) {
+		effect = effect_create_from_ir(ir, NULL);
+		gs_effect_ir_destroy(ir);
+	}
 
+	if (!effect) {
+		ir = gs_effect_ir_parse(file_string, file, error_string);
+		if (ir) {
+			effect = effect_create_from_ir(ir, error_string);
+			if (effect)
+				gs_effect_cache_save(ir);
+			gs_effect_ir_destroy(ir);
+		}
+	}
+
+	bfree(file_string);
 	return effect;
 }
 
 gs_effect_t *gs_effect_create(const char *effect_string, const char *filename, char **error_string)
 {
+	gs_effect_t *effect = NULL;
+	gs_effect_ir_t *ir;
+
 	if (!gs_valid_p("gs_effect_create", effect_string))
 		return NULL;
 
-	struct gs_effect *effect = bzalloc(sizeof(struct gs_effect));
-	struct effect_parser parser;
-	bool success;
-
-	effect->graphics = thread_graphics;
-	effect->effect_path = bstrdup(filename);
-
-	ep_init(&parser);
-	success = ep_parse(&parser, effect, effect_string, filename);
-	if (!success) {
-		if (error_string)
-			*error_string = error_data_buildstring(&parser.cfp.error_list);
-		gs_effect_destroy(effect);
-		effect = NULL;
-	}
-
-	if (effect) {
-		pthread_mutex_lock(&thread_graphics->effect_mutex);
-
-		if (effect->effect_path) {
-			effect->cached = true;
-			effect->next = thread_graphics->first_effect;
-			thread_graphics->first_effect = effect;
-		}
-
-		pthread_mutex_unlock(&thread_graphics->effect_mutex);
+	ir = gs_effect_ir_parse(effect_string, filename, error_string);
+	if (ir) {
+		effect = effect_create_from_ir(ir, error_string);
+		gs_effect_ir_destroy(ir);
 	}
 
-	ep_free(&parser);
 	return effect;
 }
 
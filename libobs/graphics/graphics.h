@@ -554,6 +554,10 @@ EXPORT gs_effect_t *gs_get_effect(void);
 EXPORT gs_effect_t *gs_effect_create_from_file(const char *file, char **error_string);
 EXPORT gs_effect_t *gs_effect_create(const char *effect_string, const char *filename, char **error_string);
 
+/** Sets the directory parsed effect files are cached in, or NULL to disable
+ * the cache */
+EXPORT void gs_effect_cache_set_path(const char *path);
+
 EXPORT gs_shader_t *gs_vertexshader_create_from_file(const char *file, char **error_string);
 EXPORT gs_shader_t *gs_pixelshader_create_from_file(const char *file, char **error_string);
 
@@ -19,10 +19,21 @@
 #include "../util/base.h"
 #include "../util/platform.h"
 #include "../util/dstr.h"
+#include "../util/threading.h"
+#include "../util/uthash.h"
 #include "vec4.h"
 
+#include <sys/stat.h>
+
 #define blog(level, format, ...) blog(level, "%s: " format, __FUNCTION__, __VA_ARGS__)
 
+/* animated gifs that would take more than this fully decoded are streamed */
+#define GIF_STREAM_DEFAULT_LIMIT (64ULL * 1024ULL * 1024ULL)
+#define GIF_STREAM_MIN_FRAMES 2
+
+static os_thread_pool_t *decode_pool = NULL;
+static uint64_t gif_stream_limit = GIF_STREAM_DEFAULT_LIMIT;
+
 static void *bi_def_bitmap_create(int width, int height)
 {
 	return bmalloc((size_t)4 * width * height);
@@ -70,7 +81,7 @@ static inline void *alloc_mem(gs_image_file_t *image, uint64_t *mem_usage, size_
 }
 
 static bool init_animated_gif(gs_image_file_t *image, const char *path, uint64_t *mem_usage,
-			      enum gs_image_alpha_mode alpha_mode)
+			      enum gs_image_alpha_mode alpha_mode, bool allow_stream)
 {
 	bool is_animated_gif = true;
 	gif_result result;
@@ -131,19 +142,24 @@ static bool init_animated_gif(gs_image_file_t *image, const char *path, uint64_t
 	if (image->is_animated_gif) {
 		gif_decode_frame(&image->gif, 0);
 
-		image->animation_frame_cache = alloc_mem(image, mem_usage, image->gif.frame_count * sizeof(uint8_t *));
-		image->animation_frame_data = alloc_mem(image, mem_usage, get_full_decoded_gif_size(image));
+		/* animations too large to keep fully decoded are left to a
+		 * gif stream, which only keeps a window of frames around */
+		if (!allow_stream || (uint64_t)get_full_decoded_gif_size(image) <= gif_stream_limit) {
+			image->animation_frame_cache =
+				alloc_mem(image, mem_usage, image->gif.frame_count * sizeof(uint8_t *));
+			image->animation_frame_data = alloc_mem(image, mem_usage, get_full_decoded_gif_size(image));
+
+			for (unsigned int i = 0; i < image->gif.frame_count; i++) {
+				if (gif_decode_frame(&image->gif, i) != GIF_OK)
+					blog(LOG_WARNING,
+					     "Couldn't decode frame %u "
+					     "of '%s'",
+					     i, path);
+			}
 
-		for (unsigned int i = 0; i < image->gif.frame_count; i++) {
-			if (gif_decode_frame(&image->gif, i) != GIF_OK)
-				blog(LOG_WARNING,
-				     "Couldn't decode frame %u "
-				     "of '%s'",
-				     i, path);
+			gif_decode_frame(&image->gif, 0);
 		}
 
-		gif_decode_frame(&image->gif, 0);
-
 		image->cx = (uint32_t)image->gif.width;
 		image->cy = (uint32_t)image->gif.height;
 		image->format = GS_RGBA;
@@ -179,7 +195,8 @@ not_animated:
 }
 
 static void gs_image_file_init_internal(gs_image_file_t *image, const char *file, uint64_t *mem_usage,
-					enum gs_color_space *space, enum gs_image_alpha_mode alpha_mode)
+					enum gs_color_space *space, enum gs_image_alpha_mode alpha_mode,
+					bool allow_stream)
 {
 	size_t len;
 
@@ -194,7 +211,7 @@ static void gs_image_file_init_internal(gs_image_file_t *image, const char *file
 	len = strlen(file);
 
 	if (len > 4 && astrcmpi(file + len - 4, ".gif") == 0) {
-		if (init_animated_gif(image, file, mem_usage, alpha_mode)) {
+		if (init_animated_gif(image, file, mem_usage, alpha_mode, allow_stream)) {
 			return;
 		}
 	}
@@ -216,7 +233,7 @@ static void gs_image_file_init_internal(gs_image_file_t *image, const char *file
 void gs_image_file_init(gs_image_file_t *image, const char *file)
 {
 	enum gs_color_space unused;
-	gs_image_file_init_internal(image, file, NULL, &unused, GS_IMAGE_ALPHA_STRAIGHT);
+	gs_image_file_init_internal(image, file, NULL, &unused, GS_IMAGE_ALPHA_STRAIGHT, false);
 }
 
 void gs_image_file_free(gs_image_file_t *image)
@@ -242,23 +259,29 @@ void gs_image_file_free(gs_image_file_t *image)
 void gs_image_file2_init(gs_image_file2_t *if2, const char *file)
 {
 	enum gs_color_space unused;
-	gs_image_file_init_internal(&if2->image, file, &if2->mem_usage, &unused, GS_IMAGE_ALPHA_STRAIGHT);
+	gs_image_file_init_internal(&if2->image, file, &if2->mem_usage, &unused, GS_IMAGE_ALPHA_STRAIGHT, false);
 }
 
 void gs_image_file3_init(gs_image_file3_t *if3, const char *file, enum gs_image_alpha_mode alpha_mode)
 {
 	enum gs_color_space unused;
-	gs_image_file_init_internal(&if3->image2.image, file, &if3->image2.mem_usage, &unused, alpha_mode);
+	gs_image_file_init_internal(&if3->image2.image, file, &if3->image2.mem_usage, &unused, alpha_mode, false);
 	if3->alpha_mode = alpha_mode;
 }
 
-void gs_image_file4_init(gs_image_file4_t *if4, const char *file, enum gs_image_alpha_mode alpha_mode)
+static void gs_image_file4_init_internal(gs_image_file4_t *if4, const char *file, enum gs_image_alpha_mode alpha_mode,
+					 bool allow_stream)
 {
 	gs_image_file_init_internal(&if4->image3.image2.image, file, &if4->image3.image2.mem_usage, &if4->space,
-				    alpha_mode);
+				    alpha_mode, allow_stream);
 	if4->image3.alpha_mode = alpha_mode;
 }
 
+void gs_image_file4_init(gs_image_file4_t *if4, const char *file, enum gs_image_alpha_mode alpha_mode)
+{
+	gs_image_file4_init_internal(if4, file, alpha_mode, false);
+}
+
 void gs_image_file_init_texture(gs_image_file_t *image)
 {
 	if (!image->loaded)
@@ -418,3 +441,582 @@ void gs_image_file4_update_texture(gs_image_file4_t *if4)
 {
 	gs_image_file_update_texture_internal(&if4->image3.image2.image, if4->image3.alpha_mode);
 }
+
+/* ------------------------------------------------------------------------- */
+/* Streamed animated gifs                                                    */
+
+/*
+ * Frames are decoded in playback order on the decode pool into a ring of
+ * slots.  'head' is the slot of the frame being displayed, followed by
+ * 'filled' - 1 frames decoded ahead of it.  The decoder only ever writes the
+ * slot after the last filled one, which never changes while frames are
+ * consumed, so frames are copied without holding the mutex.
+ */
+struct gs_image_gif_stream {
+	gs_image_file_t *image;
+	enum gs_image_alpha_mode alpha_mode;
+
+	pthread_mutex_t mutex;
+	os_task_group_t *group;
+	bool decoding;
+	bool stopping;
+	bool upload_pending;
+
+	uint8_t *window;
+	int *slot_frames;
+	size_t frame_size;
+	size_t num_slots;
+	size_t head;
+	size_t filled;
+
+	int next_frame;
+	int uploaded_frame;
+	uint64_t generation;
+};
+
+void gs_image_file_set_decode_pool(os_thread_pool_t *pool)
+{
+	decode_pool = pool;
+}
+
+void gs_image_file_set_gif_stream_limit(uint64_t bytes)
+{
+	gif_stream_limit = bytes;
+}
+
+static inline uint8_t *gif_stream_slot(struct gs_image_gif_stream *stream, size_t slot)
+{
+	return stream->window + slot * stream->frame_size;
+}
+
+static void gif_stream_decode(void *param);
+
+/* called with the stream mutex held */
+static void gif_stream_queue(struct gs_image_gif_stream *stream)
+{
+	if (stream->decoding || stream->stopping || stream->filled == stream->num_slots)
+		return;
+
+	stream->decoding = true;
+	if (!stream->group)
+		return;
+
+	if (!os_thread_pool_queue(decode_pool, OS_TASK_PRIORITY_LOW, stream->group, gif_stream_decode, stream))
+		stream->decoding = false;
+}
+
+/* decodes the next frame, and queues itself again until the window is full */
+static void gif_stream_decode(void *param)
+{
+	struct gs_image_gif_stream *stream = param;
+	gs_image_file_t *image = stream->image;
+	const size_t area = stream->frame_size / 4;
+
+	pthread_mutex_lock(&stream->mutex);
+	const int frame = stream->next_frame;
+	const uint64_t generation = stream->generation;
+	const size_t slot = (stream->head + stream->filled) % stream->num_slots;
+	pthread_mutex_unlock(&stream->mutex);
+
+	/* a frame that fails to decode keeps whatever was plotted of it, so
+	 * that playback doesn't get stuck on it */
+	uint8_t *data = gif_stream_slot(stream, slot);
+	gif_decode_frame(&image->gif, frame);
+	memcpy(data, image->gif.frame_image, stream->frame_size);
+
+	if (stream->alpha_mode == GS_IMAGE_ALPHA_PREMULTIPLY_SRGB) {
+		gs_premultiply_xyza_srgb_loop(data, area);
+	} else if (stream->alpha_mode == GS_IMAGE_ALPHA_PREMULTIPLY) {
+		gs_premultiply_xyza_loop(data, area);
+	}
+
+	pthread_mutex_lock(&stream->mutex);
+	if (generation == stream->generation) {
+		stream->slot_frames[slot] = frame;
+		stream->filled++;
+		stream->next_frame = (frame + 1) % (int)image->gif.frame_count;
+	}
+
+	stream->decoding = false;
+	if (stream->group)
+		gif_stream_queue(stream);
+	pthread_mutex_unlock(&stream->mutex);
+}
+
+/* called with the stream mutex held, returns whether the frame is ready */
+static bool gif_stream_seek(struct gs_image_gif_stream *stream, int frame)
+{
+	size_t found = stream->filled;
+
+	for (size_t i = 0; i < stream->filled; i++) {
+		if (stream->slot_frames[(stream->head + i) % stream->num_slots] == frame) {
+			found = i;
+			break;
+		}
+	}
+
+	/* playing from the start again doesn't wait for the rest of the
+	 * animation to be decoded, the current frame stays up and the frames
+	 * decoded ahead of it are dropped.  otherwise the decoder fell behind,
+	 * and the latest frame it decoded stays up until it catches up */
+	if (found == stream->filled) {
+		if (frame == 0 && stream->next_frame != 0) {
+			found = 0;
+			if (stream->filled > 1)
+				stream->filled = 1;
+			stream->next_frame = 0;
+			stream->generation++;
+		} else {
+			found = stream->filled ? stream->filled - 1 : 0;
+		}
+	}
+
+	stream->head = (stream->head + found) % stream->num_slots;
+	stream->filled -= found;
+
+	gif_stream_queue(stream);
+	return stream->filled && stream->slot_frames[stream->head] == frame;
+}
+
+static struct gs_image_gif_stream *gif_stream_create(gs_image_file_t *image, enum gs_image_alpha_mode alpha_mode,
+						      uint64_t *mem_usage)
+{
+	struct gs_image_gif_stream *stream = bzalloc(sizeof(*stream));
+	size_t num_slots;
+
+	stream->image = image;
+	stream->alpha_mode = alpha_mode;
+	stream->frame_size = (size_t)image->cx * image->cy * 4;
+
+	num_slots = (size_t)(gif_stream_limit / stream->frame_size);
+	if (num_slots < GIF_STREAM_MIN_FRAMES)
+		num_slots = GIF_STREAM_MIN_FRAMES;
+	if (num_slots > image->gif.frame_count)
+		num_slots = image->gif.frame_count;
+
+	stream->num_slots = num_slots;
+	stream->window = bmalloc(num_slots * stream->frame_size);
+	stream->slot_frames = bzalloc(num_slots * sizeof(int));
+	*mem_usage += num_slots * stream->frame_size;
+
+	/* the first frame was already decoded while loading the gif */
+	memcpy(stream->window, image->gif.frame_image, stream->frame_size);
+	stream->filled = 1;
+	stream->next_frame = 1;
+
+	pthread_mutex_init_value(&stream->mutex);
+	pthread_mutex_init(&stream->mutex, NULL);
+	if (decode_pool)
+		stream->group = os_task_group_create(decode_pool);
+
+	pthread_mutex_lock(&stream->mutex);
+	gif_stream_queue(stream);
+	pthread_mutex_unlock(&stream->mutex);
+	return stream;
+}
+
+static void gif_stream_destroy(struct gs_image_gif_stream *stream)
+{
+	if (!stream)
+		return;
+
+	pthread_mutex_lock(&stream->mutex);
+	stream->stopping = true;
+	pthread_mutex_unlock(&stream->mutex);
+
+	os_task_group_cancel(stream->group);
+	os_task_group_destroy(stream->group);
+
+	pthread_mutex_destroy(&stream->mutex);
+	bfree(stream->slot_frames);
+	bfree(stream->window);
+	bfree(stream);
+}
+
+/* without a decode pool, frames are decoded on demand */
+static void gif_stream_decode_inline(struct gs_image_gif_stream *stream, int frame)
+{
+	pthread_mutex_lock(&stream->mutex);
+	while (!gif_stream_seek(stream, frame) && stream->decoding) {
+		pthread_mutex_unlock(&stream->mutex);
+		gif_stream_decode(stream);
+		pthread_mutex_lock(&stream->mutex);
+	}
+	stream->decoding = false;
+	pthread_mutex_unlock(&stream->mutex);
+}
+
+static void gif_stream_init_texture(struct gs_image_gif_stream *stream)
+{
+	gs_image_file_t *image = stream->image;
+
+	pthread_mutex_lock(&stream->mutex);
+	const uint8_t *data = gif_stream_slot(stream, stream->head);
+	image->texture = gs_texture_create(image->cx, image->cy, image->format, 1, &data, GS_DYNAMIC);
+	stream->uploaded_frame = stream->slot_frames[stream->head];
+	pthread_mutex_unlock(&stream->mutex);
+}
+
+static bool gif_stream_tick(struct gs_image_gif_stream *stream, uint64_t elapsed_time_ns)
+{
+	gs_image_file_t *image = stream->image;
+	bool updated = false;
+	int loops;
+
+	loops = image->gif.loop_count;
+	if (loops >= 0xFFFF)
+		loops = 0;
+
+	if (!loops || image->cur_loop < loops) {
+		int new_frame = calculate_new_frame(image, elapsed_time_ns, loops);
+
+		if (new_frame != image->cur_frame) {
+			image->cur_frame = new_frame;
+			updated = true;
+		}
+	}
+
+	pthread_mutex_lock(&stream->mutex);
+	updated = updated || stream->upload_pending;
+	pthread_mutex_unlock(&stream->mutex);
+	return updated;
+}
+
+static void gif_stream_update_texture(struct gs_image_gif_stream *stream)
+{
+	gs_image_file_t *image = stream->image;
+
+	if (!stream->group)
+		gif_stream_decode_inline(stream, image->cur_frame);
+
+	pthread_mutex_lock(&stream->mutex);
+	stream->upload_pending = !gif_stream_seek(stream, image->cur_frame);
+	if (image->texture && stream->filled && stream->slot_frames[stream->head] != stream->uploaded_frame) {
+		gs_texture_set_image(image->texture, gif_stream_slot(stream, stream->head), image->cx * 4, false);
+		stream->uploaded_frame = stream->slot_frames[stream->head];
+	}
+	pthread_mutex_unlock(&stream->mutex);
+}
+
+/* ------------------------------------------------------------------------- */
+/* Shared image cache                                                        */
+
+#define IMAGE_CACHE_DEFAULT_BUDGET (256ULL * 1024ULL * 1024ULL)
+
+struct gs_image_cache_entry {
+	char *key;
+	gs_image_file4_t image;
+	graphics_t *graphics;
+	bool texture_created;
+	uint64_t size;
+	long refs;
+
+	/* unused entries, least recently used first */
+	struct gs_image_cache_entry *prev_unused;
+	struct gs_image_cache_entry *next_unused;
+
+	UT_hash_handle hh;
+};
+
+static pthread_mutex_t image_cache_mutex = PTHREAD_MUTEX_INITIALIZER;
+static struct gs_image_cache_entry *image_cache = NULL;
+static struct gs_image_cache_entry *first_unused = NULL;
+static struct gs_image_cache_entry *last_unused = NULL;
+static struct gs_image_cache_stats image_cache_stats = {.budget = IMAGE_CACHE_DEFAULT_BUDGET};
+
+static void unused_remove(struct gs_image_cache_entry *entry)
+{
+	if (entry->prev_unused)
+		entry->prev_unused->next_unused = entry->next_unused;
+	else
+		first_unused = entry->next_unused;
+
+	if (entry->next_unused)
+		entry->next_unused->prev_unused = entry->prev_unused;
+	else
+		last_unused = entry->prev_unused;
+
+	entry->prev_unused = NULL;
+	entry->next_unused = NULL;
+	image_cache_stats.unused_bytes -= entry->size;
+}
+
+static void unused_push(struct gs_image_cache_entry *entry)
+{
+	entry->prev_unused = last_unused;
+	entry->next_unused = NULL;
+
+	if (last_unused)
+		last_unused->next_unused = entry;
+	else
+		first_unused = entry;
+
+	last_unused = entry;
+	image_cache_stats.unused_bytes += entry->size;
+}
+
+/* removes unused entries until the cache fits in 'limit', and returns them
+ * so they can be destroyed after the cache mutex has been released */
+static struct gs_image_cache_entry *image_cache_trim(uint64_t limit)
+{
+	struct gs_image_cache_entry *victims = NULL;
+
+	while (first_unused && image_cache_stats.bytes > limit) {
+		struct gs_image_cache_entry *entry = first_unused;
+
+		unused_remove(entry);
+		HASH_DELETE(hh, image_cache, entry);
+		image_cache_stats.bytes -= entry->size;
+		image_cache_stats.images--;
+		image_cache_stats.evictions++;
+
+		entry->next_unused = victims;
+		victims = entry;
+	}
+
+	return victims;
+}
+
+static void image_cache_entry_destroy(struct gs_image_cache_entry *entry)
+{
+	gs_image_file_t *image = &entry->image.image3.image2.image;
+
+	if (image->texture) {
+		gs_enter_context(entry->graphics);
+		gs_image_file4_free(&entry->image);
+		gs_leave_context();
+	} else {
+		bfree(image->texture_data);
+	}
+
+	bfree(entry->key);
+	bfree(entry);
+}
+
+static void image_cache_destroy_list(struct gs_image_cache_entry *entry)
+{
+	while (entry) {
+		struct gs_image_cache_entry *next = entry->next_unused;
+		image_cache_entry_destroy(entry);
+		entry = next;
+	}
+}
+
+static struct gs_image_cache_entry *image_cache_acquire(const char *key)
+{
+	struct gs_image_cache_entry *entry;
+
+	HASH_FIND_STR(image_cache, key, entry);
+	if (entry && entry->refs++ == 0)
+		unused_remove(entry);
+
+	return entry;
+}
+
+/* only the image file that decoded an entry reports its memory, so shared
+ * images aren't counted once per user */
+static void image_cache_get_view(gs_image_file5_t *if5, struct gs_image_cache_entry *entry, bool decoded)
+{
+	const gs_image_file_t *src = &entry->image.image3.image2.image;
+	gs_image_file_t *dst = &if5->image4.image3.image2.image;
+
+	dst->texture = src->texture;
+	dst->format = src->format;
+	dst->cx = src->cx;
+	dst->cy = src->cy;
+	dst->loaded = src->loaded;
+	if5->image4.image3.image2.mem_usage = decoded ? entry->size : 0;
+	if5->image4.image3.alpha_mode = entry->image.image3.alpha_mode;
+	if5->image4.space = entry->image.space;
+	if5->cache_entry = entry;
+}
+
+void gs_image_file5_init(gs_image_file5_t *if5, const char *file, enum gs_image_alpha_mode alpha_mode)
+{
+	struct gs_image_cache_entry *entry;
+	struct gs_image_cache_entry *victims = NULL;
+	struct dstr key = {0};
+	struct stat st;
+
+	if (!if5)
+		return;
+
+	memset(if5, 0, sizeof(*if5));
+
+	if (!file || os_stat(file, &st) != 0) {
+		gs_image_file4_init(&if5->image4, file, alpha_mode);
+		return;
+	}
+
+	dstr_printf(&key, "%d:%lld:%lld:%s", (int)alpha_mode, (long long)st.st_mtime, (long long)st.st_size, file);
+
+	pthread_mutex_lock(&image_cache_mutex);
+	entry = image_cache_acquire(key.array);
+	if (entry) {
+		image_cache_stats.hits++;
+		image_cache_get_view(if5, entry, false);
+	} else {
+		image_cache_stats.misses++;
+	}
+	pthread_mutex_unlock(&image_cache_mutex);
+
+	if (entry) {
+		dstr_free(&key);
+		return;
+	}
+
+	/* decode outside of the cache mutex, the same file may be decoded by
+	 * more than one thread at once, in which case the first one is kept */
+	entry = bzalloc(sizeof(*entry));
+	gs_image_file4_init_internal(&entry->image, file, alpha_mode, true);
+
+	if (!entry->image.image3.image2.image.loaded || entry->image.image3.image2.image.is_animated_gif) {
+		gs_image_file_t *image = &if5->image4.image3.image2.image;
+
+		if5->image4 = entry->image;
+		if (image->is_animated_gif && !image->animation_frame_cache)
+			if5->stream = gif_stream_create(image, alpha_mode, &if5->image4.image3.image2.mem_usage);
+
+		bfree(entry);
+		dstr_free(&key);
+		return;
+	}
+
+	entry->key = key.array;
+	entry->size = entry->image.image3.image2.mem_usage;
+	entry->refs = 1;
+
+	pthread_mutex_lock(&image_cache_mutex);
+	struct gs_image_cache_entry *existing = image_cache_acquire(entry->key);
+	bool decoded = !existing;
+	if (existing) {
+		victims = entry;
+		entry = existing;
+	} else {
+		HASH_ADD_KEYPTR(hh, image_cache, entry->key, strlen(entry->key), entry);
+		image_cache_stats.bytes += entry->size;
+		image_cache_stats.images++;
+		victims = image_cache_trim(image_cache_stats.budget);
+	}
+	image_cache_get_view(if5, entry, decoded);
+	pthread_mutex_unlock(&image_cache_mutex);
+
+	image_cache_destroy_list(victims);
+}
+
+void gs_image_file5_free(gs_image_file5_t *if5)
+{
+	struct gs_image_cache_entry *entry;
+	struct gs_image_cache_entry *victims = NULL;
+
+	if (!if5)
+		return;
+
+	entry = if5->cache_entry;
+	if (!entry) {
+		gif_stream_destroy(if5->stream);
+		if5->stream = NULL;
+		gs_image_file4_free(&if5->image4);
+		return;
+	}
+
+	pthread_mutex_lock(&image_cache_mutex);
+	if (--entry->refs == 0) {
+		unused_push(entry);
+		victims = image_cache_trim(image_cache_stats.budget);
+	}
+	pthread_mutex_unlock(&image_cache_mutex);
+
+	image_cache_destroy_list(victims);
+	memset(if5, 0, sizeof(*if5));
+}
+
+void gs_image_file5_init_texture(gs_image_file5_t *if5)
+{
+	struct gs_image_cache_entry *entry = if5->cache_entry;
+
+	if (if5->stream) {
+		gif_stream_init_texture(if5->stream);
+		return;
+	}
+	if (!entry) {
+		gs_image_file4_init_texture(&if5->image4);
+		return;
+	}
+
+	/* the texture is created once, by the first user of the entry, and
+	 * the decoded pixels are released along with it */
+	pthread_mutex_lock(&image_cache_mutex);
+	if (!entry->texture_created) {
+		gs_image_file4_init_texture(&entry->image);
+		entry->graphics = gs_get_context();
+		entry->texture_created = true;
+	}
+	if5->image4.image3.image2.image.texture = entry->image.image3.image2.image.texture;
+	pthread_mutex_unlock(&image_cache_mutex);
+}
+
+bool gs_image_file5_tick(gs_image_file5_t *if5, uint64_t elapsed_time_ns)
+{
+	if (if5->stream)
+		return gif_stream_tick(if5->stream, elapsed_time_ns);
+
+	return gs_image_file4_tick(&if5->image4, elapsed_time_ns);
+}
+
+void gs_image_file5_update_texture(gs_image_file5_t *if5)
+{
+	if (if5->stream) {
+		gif_stream_update_texture(if5->stream);
+		return;
+	}
+
+	gs_image_file4_update_texture(&if5->image4);
+}
+
+bool gs_image_file5_get_stream_stats(gs_image_file5_t *if5, struct gs_image_gif_stream_stats *stats)
+{
+	struct gs_image_gif_stream *stream = if5->stream;
+
+	if (!stream)
+		return false;
+
+	pthread_mutex_lock(&stream->mutex);
+	stats->frame = stream->slot_frames[stream->head];
+	stats->window = stream->num_slots;
+	stats->decoded = stream->filled;
+	/* without a decode pool the flag only means that a frame is wanted */
+	stats->decoding = stream->decoding && stream->group;
+	pthread_mutex_unlock(&stream->mutex);
+	return true;
+}
+
+void gs_image_cache_set_budget(uint64_t bytes)
+{
+	struct gs_image_cache_entry *victims;
+
+	pthread_mutex_lock(&image_cache_mutex);
+	image_cache_stats.budget = bytes;
+	victims = image_cache_trim(bytes);
+	pthread_mutex_unlock(&image_cache_mutex);
+
+	image_cache_destroy_list(victims);
+}
+
+void gs_image_cache_get_stats(struct gs_image_cache_stats *stats)
+{
+	pthread_mutex_lock(&image_cache_mutex);
+	*stats = image_cache_stats;
+	pthread_mutex_unlock(&image_cache_mutex);
+}
+
+void gs_image_cache_clear(void)
+{
+	struct gs_image_cache_entry *victims;
+
+	pthread_mutex_lock(&image_cache_mutex);
+	victims = image_cache_trim(0);
+	pthread_mutex_unlock(&image_cache_mutex);
+
+	image_cache_destroy_list(victims);
+}
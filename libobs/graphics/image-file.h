@@ -19,6 +19,7 @@
 
 #include "graphics.h"
 #include "libnsgif/libnsgif.h"
+#include "../util/thread-pool.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -61,10 +62,37 @@ struct gs_image_file4 {
 	enum gs_color_space space;
 };
 
+struct gs_image_cache_entry;
+struct gs_image_gif_stream;
+
+struct gs_image_file5 {
+	struct gs_image_file4 image4;
+	struct gs_image_cache_entry *cache_entry;
+	struct gs_image_gif_stream *stream;
+};
+
+struct gs_image_cache_stats {
+	uint64_t hits;
+	uint64_t misses;
+	uint64_t evictions;
+	uint64_t bytes;
+	uint64_t unused_bytes;
+	uint64_t budget;
+	size_t images;
+};
+
+struct gs_image_gif_stream_stats {
+	int frame;      /* frame being displayed */
+	size_t window;  /* frames that fit in the window */
+	size_t decoded; /* frames in the window, including the current one */
+	bool decoding;
+};
+
 typedef struct gs_image_file gs_image_file_t;
 typedef struct gs_image_file2 gs_image_file2_t;
 typedef struct gs_image_file3 gs_image_file3_t;
 typedef struct gs_image_file4 gs_image_file4_t;
+typedef struct gs_image_file5 gs_image_file5_t;
 
 EXPORT void gs_image_file_init(gs_image_file_t *image, const char *file);
 EXPORT void gs_image_file_free(gs_image_file_t *image);
@@ -88,6 +116,31 @@ EXPORT void gs_image_file4_init(gs_image_file4_t *if4, const char *file, enum gs
 EXPORT bool gs_image_file4_tick(gs_image_file4_t *if4, uint64_t elapsed_time_ns);
 EXPORT void gs_image_file4_update_texture(gs_image_file4_t *if4);
 
+/*
+ * gs_image_file5 shares the decoded pixels and the texture of static images
+ * through a process-wide cache keyed by path, modification time and alpha
+ * mode.  Animated gifs keep their own playback state, so they are decoded per
+ * image file like with gs_image_file4, except that large ones are decoded in
+ * the background into a bounded window of frames.  A gs_image_file5 must not
+ * be moved while it is loaded.  The mem_usage of a shared image is only set
+ * in the image file that decoded it and is 0 in the others, the memory held
+ * by the cache is reported by gs_image_cache_get_stats.
+ */
+EXPORT void gs_image_file5_init(gs_image_file5_t *if5, const char *file, enum gs_image_alpha_mode alpha_mode);
+EXPORT void gs_image_file5_free(gs_image_file5_t *if5);
+EXPORT void gs_image_file5_init_texture(gs_image_file5_t *if5);
+EXPORT bool gs_image_file5_tick(gs_image_file5_t *if5, uint64_t elapsed_time_ns);
+EXPORT void gs_image_file5_update_texture(gs_image_file5_t *if5);
+
+EXPORT bool gs_image_file5_get_stream_stats(gs_image_file5_t *if5, struct gs_image_gif_stream_stats *stats);
+
+EXPORT void gs_image_file_set_decode_pool(os_thread_pool_t *pool);
+EXPORT void gs_image_file_set_gif_stream_limit(uint64_t bytes);
+
+EXPORT void gs_image_cache_set_budget(uint64_t bytes);
+EXPORT void gs_image_cache_get_stats(struct gs_image_cache_stats *stats);
+EXPORT void gs_image_cache_clear(void);
+
 static inline void gs_image_file2_free(gs_image_file2_t *if2)
 {
 	gs_image_file_free(&if2->image);
@@ -119,6 +172,7 @@ static inline void gs_image_file4_init_texture(gs_image_file4_t *if4)
 	gs_image_file3_init_texture(&if4->image3);
 }
 
+
 #ifdef __cplusplus
 }
 #endif
@@ -26,6 +26,7 @@
 #include "../util/util_uint64.h"
 
 #include "audio-io.h"
+#include "audio-math.h"
 #include "audio-resampler.h"
 
 #ifdef _WIN32
@@ -104,18 +105,54 @@ static bool resample_audio_output(struct audio_input *input, struct audio_data *
 	return success;
 }
 
+/* clamps a mix for the inputs that read it, must be called with input_mutex
+ * held so that the inputs can't change before the mix is output.  a mix only
+ * read by inputs that allow clipping is left untouched, and the unclamped copy
+ * is only made if both kinds of inputs read the mix.  returns whether the
+ * unclamped copy was made. */
+static inline bool clamp_audio_output(struct audio_output *audio, struct audio_mix *mix, size_t float_size)
+{
+	bool clamped = false;
+	bool unclamped = false;
+
+	for (size_t i = 0; i < mix->inputs.num; i++) {
+		if (mix->inputs.array[i].conversion.allow_clipping)
+			unclamped = true;
+		else
+			clamped = true;
+	}
+
+	if (!clamped)
+		return false;
+
+	for (size_t plane = 0; plane < audio->planes; plane++) {
+		if (unclamped)
+			audio_float_clamp_copy(mix->buffer[plane], mix->buffer_unclamped[plane], float_size);
+		else
+			audio_float_clamp(mix->buffer[plane], float_size);
+	}
+
+	return unclamped;
+}
+
 static inline void do_audio_output(struct audio_output *audio, size_t mix_idx, uint64_t timestamp, uint32_t frames)
 {
 	struct audio_mix *mix = &audio->mixes[mix_idx];
+	size_t float_size = frames * audio->block_size / sizeof(float);
 	struct audio_data data;
+	bool unclamped_copy;
 
 	pthread_mutex_lock(&audio->input_mutex);
 
+	/* clamps audio data to -1.0..1.0 */
+	unclamped_copy = clamp_audio_output(audio, mix, float_size);
+
 	for (size_t i = mix->inputs.num; i > 0; i--) {
 		struct audio_input *input = mix->inputs.array + (i - 1);
 
-		float(*buf)[AUDIO_OUTPUT_FRAMES] = input->conversion.allow_clipping ? mix->buffer_unclamped
-										    : mix->buffer;
+		float(*buf)[AUDIO_OUTPUT_FRAMES] = input->conversion.allow_clipping && unclamped_copy
+								   ? mix->buffer_unclamped
+								   : mix->buffer;
 		for (size_t i = 0; i < audio->planes; i++)
 			data.data[i] = (uint8_t *)buf[i];
 
@@ -129,37 +166,8 @@ static inline void do_audio_output(struct audio_output *audio, size_t mix_idx, u
 	pthread_mutex_unlock(&audio->input_mutex);
 }
 
-static inline void clamp_audio_output(struct audio_output *audio, size_t bytes)
-{
-	size_t float_size = bytes / sizeof(float);
-
-	for (size_t mix_idx = 0; mix_idx < MAX_AUDIO_MIXES; mix_idx++) {
-		struct audio_mix *mix = &audio->mixes[mix_idx];
-
-		/* do not process mixing if a specific mix is inactive */
-		if (!mix->inputs.num)
-			continue;
-
-		for (size_t plane = 0; plane < audio->planes; plane++) {
-			float *mix_data = mix->buffer[plane];
-			float *mix_end = &mix_data[float_size];
-			/* Unclamped mix is copied directly. */
-			memcpy(mix->buffer_unclamped[plane], mix_data, bytes);
-
-			while (mix_data < mix_end) {
-				float val = *mix_data;
-				val = (val == val) ? val : 0.0f;
-				val = (val > 1.0f) ? 1.0f : val;
-				val = (val < -1.0f) ? -1.0f : val;
-				*(mix_data++) = val;
-			}
-		}
-	}
-}
-
 static void input_and_output(struct audio_output *audio, uint64_t audio_time, uint64_t prev_time)
 {
-	size_t bytes = AUDIO_OUTPUT_FRAMES * audio->block_size;
 	struct audio_output_data data[MAX_AUDIO_MIXES];
 	uint32_t active_mixes = 0;
 	uint64_t new_ts = 0;
@@ -168,6 +176,7 @@ static void input_and_output(struct audio_output *audio, uint64_t audio_time, ui
 	memset(data, 0, sizeof(data));
 
 #ifdef DEBUG_AUDIO
+	size_t bytes = AUDIO_OUTPUT_FRAMES * audio->block_size;
 	blog(LOG_DEBUG, "audio_time: %llu, prev_time: %llu, bytes: %lu", audio_time, prev_time, bytes);
 #endif
 
@@ -194,9 +203,6 @@ static void input_and_output(struct audio_output *audio, uint64_t audio_time, ui
 	if (!success)
 		return;
 
-	/* clamps audio data to -1.0..1.0 */
-	clamp_audio_output(audio, bytes);
-
 	/* output */
 	for (size_t i = 0; i < MAX_AUDIO_MIXES; i++)
 		do_audio_output(audio, i, new_ts, AUDIO_OUTPUT_FRAMES);
@@ -0,0 +1,87 @@
+#include "audio-math.h"
+
+#include "../util/sse-intrin.h"
+
+/* SSE is used everywhere, on ARM it is translated to NEON by SIMDe.  each
+ * function handles four floats at a time and finishes with a scalar tail. */
+
+void audio_float_add(float *dst, const float *src, size_t count)
+{
+	size_t i = 0;
+
+	for (; i + 4 <= count; i += 4) {
+		__m128 val = _mm_add_ps(_mm_loadu_ps(dst + i), _mm_loadu_ps(src + i));
+		_mm_storeu_ps(dst + i, val);
+	}
+
+	for (; i < count; i++)
+		dst[i] += src[i];
+}
+
+void audio_float_mul(float *data, float mul, size_t count)
+{
+	__m128 mul_val = _mm_set1_ps(mul);
+	size_t i = 0;
+
+	for (; i + 4 <= count; i += 4)
+		_mm_storeu_ps(data + i, _mm_mul_ps(_mm_loadu_ps(data + i), mul_val));
+
+	for (; i < count; i++)
+		data[i] *= mul;
+}
+
+void audio_float_mul_ramp(float *data, const float *mul, size_t count)
+{
+	size_t i = 0;
+
+	for (; i + 4 <= count; i += 4)
+		_mm_storeu_ps(data + i, _mm_mul_ps(_mm_loadu_ps(data + i), _mm_loadu_ps(mul + i)));
+
+	for (; i < count; i++)
+		data[i] *= mul[i];
+}
+
+static inline float clamp_sample(float val)
+{
+	val = (val == val) ? val : 0.0f;
+	val = (val > 1.0f) ? 1.0f : val;
+	val = (val < -1.0f) ? -1.0f : val;
+	return val;
+}
+
+/* NaN compares unordered with itself, so masking with cmpord zeroes it */
+#define clamp_ps(val, min_val, max_val) \
+	_mm_min_ps(_mm_max_ps(_mm_and_ps(val, _mm_cmpord_ps(val, val)), min_val), max_val)
+
+void audio_float_clamp(float *data, size_t count)
+{
+	__m128 min_val = _mm_set1_ps(-1.0f);
+	__m128 max_val = _mm_set1_ps(1.0f);
+	size_t i = 0;
+
+	for (; i + 4 <= count; i += 4) {
+		__m128 val = _mm_loadu_ps(data + i);
+		_mm_storeu_ps(data + i, clamp_ps(val, min_val, max_val));
+	}
+
+	for (; i < count; i++)
+		data[i] = clamp_sample(data[i]);
+}
+
+void audio_float_clamp_copy(float *data, float *unclamped, size_t count)
+{
+	__m128 min_val = _mm_set1_ps(-1.0f);
+	__m128 max_val = _mm_set1_ps(1.0f);
+	size_t i = 0;
+
+	for (; i + 4 <= count; i += 4) {
+		__m128 val = _mm_loadu_ps(data + i);
+		_mm_storeu_ps(unclamped + i, val);
+		_mm_storeu_ps(data + i, clamp_ps(val, min_val, max_val));
+	}
+
+	for (; i < count; i++) {
+		unclamped[i] = data[i];
+		data[i] = clamp_sample(data[i]);
+	}
+}
@@ -41,3 +41,31 @@ static inline float db_to_mul(const float db)
 #ifdef _MSC_VER
 #pragma warning(pop)
 #endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Vectorized helpers for planar float audio buffers, as used for mixing.
+ * Buffers do not need to be aligned.
+ */
+
+/** dst[i] += src[i] */
+EXPORT void audio_float_add(float *dst, const float *src, size_t count);
+
+/** data[i] *= mul */
+EXPORT void audio_float_mul(float *data, float mul, size_t count);
+
+/** data[i] *= mul[i], e.g. for volume ramps */
+EXPORT void audio_float_mul_ramp(float *data, const float *mul, size_t count);
+
+/** Replaces NaN with 0 and clamps to -1.0..1.0 */
+EXPORT void audio_float_clamp(float *data, size_t count);
+
+/** Same as audio_float_clamp, but also copies the unclamped values */
+EXPORT void audio_float_clamp_copy(float *data, float *unclamped, size_t count);
+
+#ifdef __cplusplus
+}
+#endif
@@ -15,9 +15,25 @@
     along with this program.  If not, see <http://www.gnu.org/licenses/>.
 ******************************************************************************/
 
+#include <string.h>
+
 #include "format-conversion.h"
 
 #include "../util/sse-intrin.h"
+#include "../util/platform.h"
+#include "../util/threading.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#if !defined(_M_ARM64EC)
+#define FORMAT_CONVERSION_AVX2
+#include <immintrin.h>
+#ifdef _MSC_VER
+#define AVX2_FUNC
+#else
+#define AVX2_FUNC __attribute__((target("avx2")))
+#endif
+#endif
+#endif
 
 /* ...surprisingly, if I don't use a macro to force inlining, it causes the
  * CPU usage to boost by a tremendous amount in debug builds. */
@@ -77,8 +93,8 @@ static FORCE_INLINE uint32_t min_uint32(uint32_t a, uint32_t b)
 	return a < b ? a : b;
 }
 
-void compress_uyvx_to_i420(const uint8_t *input, uint32_t in_linesize, uint32_t start_y, uint32_t end_y,
-			   uint8_t *output[], const uint32_t out_linesize[])
+static void compress_uyvx_to_i420_sse2(const uint8_t *input, uint32_t in_linesize, uint32_t start_y, uint32_t end_y,
+				       uint8_t *output[], const uint32_t out_linesize[])
 {
 	uint8_t *lum_plane = output[0];
 	uint8_t *u_plane = output[1];
@@ -109,8 +125,8 @@ void compress_uyvx_to_i420(const uint8_t *input, uint32_t in_linesize, uint32_t
 	}
 }
 
-void compress_uyvx_to_nv12(const uint8_t *input, uint32_t in_linesize, uint32_t start_y, uint32_t end_y,
-			   uint8_t *output[], const uint32_t out_linesize[])
+static void compress_uyvx_to_nv12_sse2(const uint8_t *input, uint32_t in_linesize, uint32_t start_y, uint32_t end_y,
+				       uint8_t *output[], const uint32_t out_linesize[])
 {
 	uint8_t *lum_plane = output[0];
 	uint8_t *chroma_plane = output[1];
@@ -140,6 +156,355 @@ void compress_uyvx_to_nv12(const uint8_t *input, uint32_t in_linesize, uint32_t
 	}
 }
 
+/* ------------------------------------------------------------------------- */
+/* AVX2 versions of the UYVX compression functions, selected at runtime.
+ * these handle eight pixels per line at a time and fall back to the SSE2
+ * macros above for the remaining four pixels of a line. */
+
+#ifdef FORMAT_CONVERSION_AVX2
+
+/* luma of eight pixels of two lines; packs_epi32 interleaves 64-bit halves
+ * of both lines per lane, so reorder them so that lane 0 holds the first line
+ * and lane 1 holds the second line */
+#define pack_lum_avx2(lum_plane, lum_pos0, lum_pos1, line1, line2, lum_mask)                                 \
+	do {                                                                                                  \
+		__m256i lum_val = _mm256_packs_epi32(_mm256_srli_epi32(_mm256_and_si256(line1, lum_mask), 8), \
+						     _mm256_srli_epi32(_mm256_and_si256(line2, lum_mask), 8)); \
+		lum_val = _mm256_permute4x64_epi64(lum_val, _MM_SHUFFLE(3, 1, 2, 0));                        \
+		lum_val = _mm256_packus_epi16(lum_val, lum_val);                                              \
+                                                                                                              \
+		_mm_storel_epi64((__m128i *)(lum_plane + lum_pos0), _mm256_castsi256_si128(lum_val));         \
+		_mm_storel_epi64((__m128i *)(lum_plane + lum_pos1), _mm256_extracti128_si256(lum_val, 1));    \
+	} while (false)
+
+/* averaged UV of eight pixels of two lines, resulting in four UV pairs as
+ * 16-bit values in the low 64 bits of each lane */
+#define avg_uv_avx2(avg_val, line1, line2, uv_mask)                                                     \
+	do {                                                                                            \
+		__m256i add_val =                                                                       \
+			_mm256_add_epi16(_mm256_and_si256(line1, uv_mask), _mm256_and_si256(line2, uv_mask)); \
+		avg_val = _mm256_add_epi16(add_val, _mm256_shuffle_epi32(add_val, _MM_SHUFFLE(2, 3, 0, 1))); \
+		avg_val = _mm256_srai_epi16(avg_val, 2);                                                \
+		avg_val = _mm256_shuffle_epi32(avg_val, _MM_SHUFFLE(3, 1, 2, 0));                       \
+	} while (false)
+
+static AVX2_FUNC void compress_uyvx_to_i420_avx2(const uint8_t *input, uint32_t in_linesize, uint32_t start_y,
+						 uint32_t end_y, uint8_t *output[], const uint32_t out_linesize[])
+{
+	uint8_t *lum_plane = output[0];
+	uint8_t *u_plane = output[1];
+	uint8_t *v_plane = output[2];
+	uint32_t width = min_uint32(in_linesize, out_linesize[0]);
+	uint32_t y;
+
+	__m256i lum_mask8 = _mm256_set1_epi32(0x0000FF00);
+	__m256i uv_mask8 = _mm256_set1_epi16(0x00FF);
+	__m128i lum_mask = _mm_set1_epi32(0x0000FF00);
+	__m128i uv_mask = _mm_set1_epi16(0x00FF);
+
+	for (y = start_y; y < end_y; y += 2) {
+		uint32_t y_pos = y * in_linesize;
+		uint32_t chroma_y_pos = (y >> 1) * out_linesize[1];
+		uint32_t lum_y_pos = y * out_linesize[0];
+		uint32_t x = 0;
+
+		for (; x + 8 <= width; x += 8) {
+			const uint8_t *img = input + y_pos + x * 4;
+			uint32_t lum_pos0 = lum_y_pos + x;
+			uint32_t lum_pos1 = lum_pos0 + out_linesize[0];
+			uint32_t chroma_pos = chroma_y_pos + (x >> 1);
+			__m256i avg_val;
+
+			__m256i line1 = _mm256_loadu_si256((const __m256i *)img);
+			__m256i line2 = _mm256_loadu_si256((const __m256i *)(img + in_linesize));
+
+			pack_lum_avx2(lum_plane, lum_pos0, lum_pos1, line1, line2, lum_mask8);
+			avg_uv_avx2(avg_val, line1, line2, uv_mask8);
+
+			/* u0 u1 v0 v1 per lane */
+			avg_val = _mm256_shufflelo_epi16(avg_val, _MM_SHUFFLE(3, 1, 2, 0));
+			avg_val = _mm256_packus_epi16(avg_val, avg_val);
+
+			uint32_t lo = (uint32_t)_mm256_extract_epi32(avg_val, 0);
+			uint32_t hi = (uint32_t)_mm256_extract_epi32(avg_val, 4);
+
+			uint32_t u = (lo & 0xFFFF) | (hi << 16);
+			uint32_t v = (lo >> 16) | (hi & 0xFFFF0000);
+
+			/* chroma planes of odd widths are not 4-byte aligned */
+			memcpy(u_plane + chroma_pos, &u, sizeof(u));
+			memcpy(v_plane + chroma_pos, &v, sizeof(v));
+		}
+
+		for (; x < width; x += 4) {
+			const uint8_t *img = input + y_pos + x * 4;
+			uint32_t lum_pos0 = lum_y_pos + x;
+			uint32_t lum_pos1 = lum_pos0 + out_linesize[0];
+
+			__m128i line1 = _mm_loadu_si128((const __m128i *)img);
+			__m128i line2 = _mm_loadu_si128((const __m128i *)(img + in_linesize));
+
+			pack_shift(lum_plane, lum_pos0, lum_pos1, line1, line2, lum_mask, 1);
+			pack_ch_2plane(u_plane, v_plane, chroma_y_pos + (x >> 1), line1, line2, uv_mask);
+		}
+	}
+}
+
+static AVX2_FUNC void compress_uyvx_to_nv12_avx2(const uint8_t *input, uint32_t in_linesize, uint32_t start_y,
+						 uint32_t end_y, uint8_t *output[], const uint32_t out_linesize[])
+{
+	uint8_t *lum_plane = output[0];
+	uint8_t *chroma_plane = output[1];
+	uint32_t width = min_uint32(in_linesize, out_linesize[0]);
+	uint32_t y;
+
+	__m256i lum_mask8 = _mm256_set1_epi32(0x0000FF00);
+	__m256i uv_mask8 = _mm256_set1_epi16(0x00FF);
+	__m128i lum_mask = _mm_set1_epi32(0x0000FF00);
+	__m128i uv_mask = _mm_set1_epi16(0x00FF);
+
+	for (y = start_y; y < end_y; y += 2) {
+		uint32_t y_pos = y * in_linesize;
+		uint32_t chroma_y_pos = (y >> 1) * out_linesize[1];
+		uint32_t lum_y_pos = y * out_linesize[0];
+		uint32_t x = 0;
+
+		for (; x + 8 <= width; x += 8) {
+			const uint8_t *img = input + y_pos + x * 4;
+			uint32_t lum_pos0 = lum_y_pos + x;
+			uint32_t lum_pos1 = lum_pos0 + out_linesize[0];
+			__m256i avg_val;
+
+			__m256i line1 = _mm256_loadu_si256((const __m256i *)img);
+			__m256i line2 = _mm256_loadu_si256((const __m256i *)(img + in_linesize));
+
+			pack_lum_avx2(lum_plane, lum_pos0, lum_pos1, line1, line2, lum_mask8);
+			avg_uv_avx2(avg_val, line1, line2, uv_mask8);
+
+			avg_val = _mm256_packus_epi16(avg_val, avg_val);
+
+			uint32_t *chroma = (uint32_t *)(chroma_plane + chroma_y_pos + x);
+			chroma[0] = (uint32_t)_mm256_extract_epi32(avg_val, 0);
+			chroma[1] = (uint32_t)_mm256_extract_epi32(avg_val, 4);
+		}
+
+		for (; x < width; x += 4) {
+			const uint8_t *img = input + y_pos + x * 4;
+			uint32_t lum_pos0 = lum_y_pos + x;
+			uint32_t lum_pos1 = lum_pos0 + out_linesize[0];
+
+			__m128i line1 = _mm_loadu_si128((const __m128i *)img);
+			__m128i line2 = _mm_loadu_si128((const __m128i *)(img + in_linesize));
+
+			pack_shift(lum_plane, lum_pos0, lum_pos1, line1, line2, lum_mask, 1);
+			pack_ch_1plane(chroma_plane, chroma_y_pos + x, line1, line2, uv_mask);
+		}
+	}
+}
+
+#endif
+
+typedef void (*compress_uyvx_func)(const uint8_t *input, uint32_t in_linesize, uint32_t start_y, uint32_t end_y,
+				   uint8_t *output[], const uint32_t out_linesize[]);
+
+static compress_uyvx_func uyvx_to_i420_func = compress_uyvx_to_i420_sse2;
+static compress_uyvx_func uyvx_to_nv12_func = compress_uyvx_to_nv12_sse2;
+static pthread_once_t compress_funcs_once = PTHREAD_ONCE_INIT;
+
+static void init_compress_funcs(void)
+{
+#ifdef FORMAT_CONVERSION_AVX2
+	if (os_cpu_has_avx2()) {
+		uyvx_to_i420_func = compress_uyvx_to_i420_avx2;
+		uyvx_to_nv12_func = compress_uyvx_to_nv12_avx2;
+	}
+#endif
+}
+
+void compress_uyvx_to_i420(const uint8_t *input, uint32_t in_linesize, uint32_t start_y, uint32_t end_y,
+			   uint8_t *output[], const uint32_t out_linesize[])
+{
+	pthread_once(&compress_funcs_once, init_compress_funcs);
+	uyvx_to_i420_func(input, in_linesize, start_y, end_y, output, out_linesize);
+}
+
+void compress_uyvx_to_nv12(const uint8_t *input, uint32_t in_linesize, uint32_t start_y, uint32_t end_y,
+			   uint8_t *output[], const uint32_t out_linesize[])
+{
+	pthread_once(&compress_funcs_once, init_compress_funcs);
+	uyvx_to_nv12_func(input, in_linesize, start_y, end_y, output, out_linesize);
+}
+
+/* ------------------------------------------------------------------------- */
+
+void convert_nv12_to_i444(const uint8_t *const input[], const uint32_t in_linesize[], uint32_t start_y,
+			  uint32_t end_y, uint8_t *output[], const uint32_t out_linesize[])
+{
+	uint32_t width = min_uint32(in_linesize[0], out_linesize[0]);
+	uint32_t y;
+
+	__m128i u_mask = _mm_set1_epi16(0x00FF);
+
+	for (y = start_y; y < end_y; y++)
+		memcpy(output[0] + y * out_linesize[0], input[0] + y * in_linesize[0], width);
+
+	for (y = start_y / 2; y < (end_y + 1) / 2; y++) {
+		const uint8_t *chroma = input[1] + y * in_linesize[1];
+		uint8_t *u0 = output[1] + y * 2 * out_linesize[1];
+		uint8_t *v0 = output[2] + y * 2 * out_linesize[2];
+		uint8_t *u1 = u0 + out_linesize[1];
+		uint8_t *v1 = v0 + out_linesize[2];
+		bool second_line = y * 2 + 1 < end_y;
+		uint32_t x = 0;
+
+		for (; x + 16 <= width; x += 16) {
+			__m128i uv = _mm_loadu_si128((const __m128i *)(chroma + x));
+			__m128i u = _mm_and_si128(uv, u_mask);
+			__m128i v = _mm_srli_epi16(uv, 8);
+
+			/* duplicate each chroma sample horizontally */
+			u = _mm_or_si128(u, _mm_slli_epi16(u, 8));
+			v = _mm_or_si128(v, _mm_slli_epi16(v, 8));
+
+			_mm_storeu_si128((__m128i *)(u0 + x), u);
+			_mm_storeu_si128((__m128i *)(v0 + x), v);
+			if (second_line) {
+				_mm_storeu_si128((__m128i *)(u1 + x), u);
+				_mm_storeu_si128((__m128i *)(v1 + x), v);
+			}
+		}
+
+		for (; x < width; x++) {
+			uint8_t u = chroma[x & ~1];
+			uint8_t v = chroma[x | 1];
+
+			u0[x] = u;
+			v0[x] = v;
+			if (second_line) {
+				u1[x] = u;
+				v1[x] = v;
+			}
+		}
+	}
+}
+
+/* ------------------------------------------------------------------------- */
+/* RGBA to NV12, using 8-bit fixed point coefficients (scaled by 256) */
+
+struct rgb_to_yuv_coeffs {
+	int16_t y[3];
+	int16_t u[3];
+	int16_t v[3];
+	int16_t y_offset;
+};
+
+static const struct rgb_to_yuv_coeffs *get_rgb_to_yuv_coeffs(enum video_colorspace cs, enum video_range_type range)
+{
+	static const struct rgb_to_yuv_coeffs coeffs_601[2] = {
+		{{66, 129, 25}, {-38, -74, 112}, {112, -94, -18}, 16},
+		{{77, 150, 29}, {-43, -85, 128}, {128, -107, -21}, 0},
+	};
+	static const struct rgb_to_yuv_coeffs coeffs_709[2] = {
+		{{47, 157, 16}, {-26, -86, 112}, {112, -102, -10}, 16},
+		{{54, 183, 19}, {-29, -99, 128}, {128, -116, -12}, 0},
+	};
+	static const struct rgb_to_yuv_coeffs coeffs_2100[2] = {
+		{{58, 149, 13}, {-31, -81, 112}, {112, -103, -9}, 16},
+		{{67, 174, 15}, {-36, -92, 128}, {128, -118, -10}, 0},
+	};
+
+	const int full = range == VIDEO_RANGE_FULL;
+
+	switch (cs) {
+	case VIDEO_CS_601:
+		return &coeffs_601[full];
+	case VIDEO_CS_2100_PQ:
+	case VIDEO_CS_2100_HLG:
+		return &coeffs_2100[full];
+	case VIDEO_CS_DEFAULT:
+	case VIDEO_CS_709:
+	case VIDEO_CS_SRGB:
+		break;
+	}
+
+	return &coeffs_709[full];
+}
+
+static FORCE_INLINE uint8_t clamp_uint8(int32_t val)
+{
+	return (uint8_t)(val < 0 ? 0 : (val > 255 ? 255 : val));
+}
+
+/* luma of four pixels */
+static FORCE_INLINE void rgba_to_lum(uint8_t *lum, const uint8_t *img, __m128i coeffs, __m128i offset)
+{
+	__m128i zero = _mm_setzero_si128();
+	__m128i px = _mm_loadu_si128((const __m128i *)img);
+
+	/* (r*cr + g*cg, b*cb + a*0) per pixel */
+	__m128i lo = _mm_madd_epi16(_mm_unpacklo_epi8(px, zero), coeffs);
+	__m128i hi = _mm_madd_epi16(_mm_unpackhi_epi8(px, zero), coeffs);
+
+	__m128i even = _mm_castps_si128(
+		_mm_shuffle_ps(_mm_castsi128_ps(lo), _mm_castsi128_ps(hi), _MM_SHUFFLE(2, 0, 2, 0)));
+	__m128i odd = _mm_castps_si128(
+		_mm_shuffle_ps(_mm_castsi128_ps(lo), _mm_castsi128_ps(hi), _MM_SHUFFLE(3, 1, 3, 1)));
+
+	__m128i val = _mm_srai_epi32(_mm_add_epi32(_mm_add_epi32(even, odd), offset), 8);
+	val = _mm_packs_epi32(val, val);
+	val = _mm_packus_epi16(val, val);
+
+	*(uint32_t *)lum = (uint32_t)_mm_cvtsi128_si32(val);
+}
+
+void convert_rgba_to_nv12(const uint8_t *input, uint32_t in_linesize, uint32_t start_y, uint32_t end_y,
+			  uint8_t *output[], const uint32_t out_linesize[], enum video_colorspace cs,
+			  enum video_range_type range)
+{
+	const struct rgb_to_yuv_coeffs *c = get_rgb_to_yuv_coeffs(cs, range);
+	uint32_t width = min_uint32(in_linesize / 4, out_linesize[0]);
+	uint32_t y;
+
+	__m128i coeffs = _mm_set_epi16(0, c->y[2], c->y[1], c->y[0], 0, c->y[2], c->y[1], c->y[0]);
+	__m128i offset = _mm_set1_epi32(128 + (c->y_offset << 8));
+
+	for (y = start_y; y < end_y; y += 2) {
+		const uint8_t *line0 = input + y * in_linesize;
+		const uint8_t *line1 = y + 1 < end_y ? line0 + in_linesize : line0;
+		uint8_t *lum0 = output[0] + y * out_linesize[0];
+		uint8_t *lum1 = y + 1 < end_y ? lum0 + out_linesize[0] : lum0;
+		uint8_t *chroma = output[1] + (y >> 1) * out_linesize[1];
+		uint32_t x = 0;
+
+		for (; x + 4 <= width; x += 4) {
+			rgba_to_lum(lum0 + x, line0 + x * 4, coeffs, offset);
+			rgba_to_lum(lum1 + x, line1 + x * 4, coeffs, offset);
+		}
+
+		for (; x < width; x++) {
+			const uint8_t *p0 = line0 + x * 4;
+			const uint8_t *p1 = line1 + x * 4;
+			lum0[x] = clamp_uint8(((c->y[0] * p0[0] + c->y[1] * p0[1] + c->y[2] * p0[2] + 128) >> 8) +
+					      c->y_offset);
+			lum1[x] = clamp_uint8(((c->y[0] * p1[0] + c->y[1] * p1[1] + c->y[2] * p1[2] + 128) >> 8) +
+					      c->y_offset);
+		}
+
+		for (x = 0; x < width; x += 2) {
+			const uint8_t *p0 = line0 + x * 4;
+			const uint8_t *p1 = line1 + x * 4;
+			uint32_t right = x + 1 < width ? 4 : 0;
+
+			int32_t r = (p0[0] + p0[right + 0] + p1[0] + p1[right + 0] + 2) >> 2;
+			int32_t g = (p0[1] + p0[right + 1] + p1[1] + p1[right + 1] + 2) >> 2;
+			int32_t b = (p0[2] + p0[right + 2] + p1[2] + p1[right + 2] + 2) >> 2;
+
+			chroma[x] = clamp_uint8(((c->u[0] * r + c->u[1] * g + c->u[2] * b + 128) >> 8) + 128);
+			chroma[x + 1] = clamp_uint8(((c->v[0] * r + c->v[1] * g + c->v[2] * b + 128) >> 8) + 128);
+		}
+	}
+}
+
 void convert_uyvx_to_i444(const uint8_t *input, uint32_t in_linesize, uint32_t start_y, uint32_t end_y,
 			  uint8_t *output[], const uint32_t out_linesize[])
 {
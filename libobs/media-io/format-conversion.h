@@ -18,6 +18,7 @@
 #pragma once
 
 #include "../util/c99defs.h"
+#include "video-io.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -36,6 +37,17 @@ EXPORT void compress_uyvx_to_nv12(const uint8_t *input, uint32_t in_linesize, ui
 EXPORT void convert_uyvx_to_i444(const uint8_t *input, uint32_t in_linesize, uint32_t start_y, uint32_t end_y,
 				 uint8_t *output[], const uint32_t out_linesize[]);
 
+/*
+ * Functions for converting between other formats
+ */
+
+EXPORT void convert_nv12_to_i444(const uint8_t *const input[], const uint32_t in_linesize[], uint32_t start_y,
+				 uint32_t end_y, uint8_t *output[], const uint32_t out_linesize[]);
+
+EXPORT void convert_rgba_to_nv12(const uint8_t *input, uint32_t in_linesize, uint32_t start_y, uint32_t end_y,
+				 uint8_t *output[], const uint32_t out_linesize[], enum video_colorspace cs,
+				 enum video_range_type range);
+
 EXPORT void decompress_nv12(const uint8_t *const input[], const uint32_t in_linesize[], uint32_t start_y,
 			    uint32_t end_y, uint8_t *output, uint32_t out_linesize);
 
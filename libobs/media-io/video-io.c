@@ -36,13 +36,15 @@ extern profiler_name_store_t *obs_get_profiler_name_store(void);
 
 struct cached_frame_info {
 	struct video_data frame;
-	int skipped;
-	int count;
+	volatile long skipped;
+	volatile long count;
 };
 
 struct video_input {
 	struct video_scale_info conversion;
 	video_scaler_t *scaler;
+	enum video_format convert_from; /* converted without the scaler */
+	const char *profile_name;
 	struct video_frame frame[MAX_CONVERT_BUFFERS];
 	int cur_frame;
 
@@ -71,7 +73,6 @@ struct video_output {
 	struct video_output_info info;
 
 	pthread_t thread;
-	pthread_mutex_t data_mutex;
 	bool stop;
 
 	os_sem_t *update_semaphore;
@@ -82,9 +83,13 @@ struct video_output {
 	pthread_mutex_t input_mutex;
 	DARRAY(struct video_input) inputs;
 
-	size_t available_frames;
-	size_t first_added;
-	size_t last_added;
+	/* single producer (graphics thread), single consumer (video thread)
+	 * ring.  positions run from 0 to 2 * cache_size - 1 so that a full
+	 * ring can be told apart from an empty one without a shared counter.
+	 * write_pos is only written by the producer, read_pos only by the
+	 * consumer. */
+	volatile long write_pos;
+	volatile long read_pos;
 	struct cached_frame_info cache[MAX_CACHE_SIZE];
 
 	struct video_output *parent;
@@ -95,11 +100,29 @@ struct video_output {
 
 /* ------------------------------------------------------------------------- */
 
+static bool convert_video_direct(struct video_input *input, struct video_frame *frame, const struct video_data *data)
+{
+	const struct video_scale_info *info = &input->conversion;
+
+	switch (input->convert_from) {
+	case VIDEO_FORMAT_NV12:
+		convert_nv12_to_i444((const uint8_t *const *)data->data, data->linesize, 0, info->height, frame->data,
+				     frame->linesize);
+		return true;
+	case VIDEO_FORMAT_RGBA:
+		convert_rgba_to_nv12(data->data[0], data->linesize[0], 0, info->height, frame->data, frame->linesize,
+				     info->colorspace, info->range);
+		return true;
+	default:
+		return false;
+	}
+}
+
 static inline bool scale_video_output(struct video_input *input, struct video_data *data)
 {
 	bool success = true;
 
-	if (input->scaler) {
+	if (input->scaler || input->convert_from != VIDEO_FORMAT_NONE) {
 		struct video_frame *frame;
 
 		if (++input->cur_frame == MAX_CONVERT_BUFFERS)
@@ -107,8 +130,11 @@ static inline bool scale_video_output(struct video_input *input, struct video_da
 
 		frame = &input->frame[input->cur_frame];
 
-		success = video_scaler_scale(input->scaler, frame->data, frame->linesize,
-					     (const uint8_t *const *)data->data, data->linesize);
+		if (input->scaler)
+			success = video_scaler_scale(input->scaler, frame->data, frame->linesize,
+						     (const uint8_t *const *)data->data, data->linesize);
+		else
+			success = convert_video_direct(input, frame, data);
 
 		if (success) {
 			for (size_t i = 0; i < MAX_AV_PLANES; i++) {
@@ -123,19 +149,39 @@ static inline bool scale_video_output(struct video_input *input, struct video_da
 	return success;
 }
 
+static inline long ring_next(const struct video_output *video, long pos)
+{
+	return (pos + 1) % (long)(video->info.cache_size * 2);
+}
+
+static inline size_t ring_count(const struct video_output *video, long write_pos, long read_pos)
+{
+	long wrap = (long)(video->info.cache_size * 2);
+	return (size_t)((write_pos - read_pos + wrap) % wrap);
+}
+
+static inline struct cached_frame_info *ring_slot(struct video_output *video, long pos)
+{
+	return &video->cache[(size_t)pos % video->info.cache_size];
+}
+
+static inline void atomic_add_long(volatile long *val, long add)
+{
+	long old_val = os_atomic_load_long(val);
+	while (!os_atomic_compare_exchange_long(val, &old_val, old_val + add))
+		;
+}
+
 static inline bool video_output_cur_frame(struct video_output *video)
 {
 	struct cached_frame_info *frame_info;
+	long read_pos = os_atomic_load_long(&video->read_pos);
 	bool complete;
-	bool skipped;
-
-	/* -------------------------------- */
-
-	pthread_mutex_lock(&video->data_mutex);
 
-	frame_info = &video->cache[video->first_added];
+	if (!ring_count(video, os_atomic_load_long(&video->write_pos), read_pos))
+		return true;
 
-	pthread_mutex_unlock(&video->data_mutex);
+	frame_info = ring_slot(video, read_pos);
 
 	/* -------------------------------- */
 
@@ -155,35 +201,29 @@ static inline bool video_output_cur_frame(struct video_output *video)
 		if (skip)
 			continue;
 
+		profile_start(input->profile_name);
+
 		if (scale_video_output(input, &frame))
 			input->callback(input->param, &frame);
+
+		profile_end(input->profile_name);
 	}
 
 	pthread_mutex_unlock(&video->input_mutex);
 
 	/* -------------------------------- */
 
-	pthread_mutex_lock(&video->data_mutex);
-
 	frame_info->frame.timestamp += video->frame_time;
-	complete = --frame_info->count == 0;
-	skipped = frame_info->skipped > 0;
+	complete = os_atomic_dec_long(&frame_info->count) == 0;
 
 	if (complete) {
-		if (++video->first_added == video->info.cache_size)
-			video->first_added = 0;
+		os_atomic_store_long(&video->read_pos, ring_next(video, read_pos));
 
-		if (++video->available_frames == video->info.cache_size)
-			video->last_added = video->first_added;
-	} else if (skipped) {
-		--frame_info->skipped;
+	} else if (os_atomic_load_long(&frame_info->skipped) > 0) {
+		os_atomic_dec_long(&frame_info->skipped);
 		os_atomic_inc_long(&video->skipped_frames);
 	}
 
-	pthread_mutex_unlock(&video->data_mutex);
-
-	/* -------------------------------- */
-
 	return complete;
 }
 
@@ -225,6 +265,8 @@ static inline void init_cache(struct video_output *video)
 {
 	if (video->info.cache_size > MAX_CACHE_SIZE)
 		video->info.cache_size = MAX_CACHE_SIZE;
+	if (video->info.cache_size < 2)
+		video->info.cache_size = 2;
 
 	for (size_t i = 0; i < video->info.cache_size; i++) {
 		struct video_frame *frame;
@@ -233,7 +275,8 @@ static inline void init_cache(struct video_output *video)
 		video_frame_init(frame, video->info.format, video->info.width, video->info.height);
 	}
 
-	video->available_frames = video->info.cache_size;
+	video->write_pos = 0;
+	video->read_pos = 0;
 }
 
 int video_output_open(video_t **video, struct video_output_info *info)
@@ -250,27 +293,25 @@ int video_output_open(video_t **video, struct video_output_info *info)
 	memcpy(&out->info, info, sizeof(struct video_output_info));
 	out->frame_time = util_mul_div64(1000000000ULL, info->fps_den, info->fps_num);
 
-	if (pthread_mutex_init_recursive(&out->data_mutex) != 0)
-		goto fail0;
+	init_cache(out);
+
 	if (pthread_mutex_init_recursive(&out->input_mutex) != 0)
-		goto fail1;
+		goto fail0;
 	if (os_sem_init(&out->update_semaphore, 0) != 0)
-		goto fail2;
+		goto fail1;
 	if (pthread_create(&out->thread, NULL, video_thread, out) != 0)
-		goto fail3;
-
-	init_cache(out);
+		goto fail2;
 
 	*video = out;
 	return VIDEO_OUTPUT_SUCCESS;
 
-fail3:
-	os_sem_destroy(out->update_semaphore);
 fail2:
-	pthread_mutex_destroy(&out->input_mutex);
+	os_sem_destroy(out->update_semaphore);
 fail1:
-	pthread_mutex_destroy(&out->data_mutex);
+	pthread_mutex_destroy(&out->input_mutex);
 fail0:
+	for (size_t i = 0; i < out->info.cache_size; i++)
+		video_frame_free((struct video_frame *)&out->cache[i]);
 	bfree(out);
 	return VIDEO_OUTPUT_FAIL;
 }
@@ -293,7 +334,6 @@ void video_output_close(video_t *video)
 
 	pthread_mutex_unlock(&video->input_mutex);
 	os_sem_destroy(video->update_semaphore);
-	pthread_mutex_destroy(&video->data_mutex);
 	pthread_mutex_destroy(&video->input_mutex);
 
 	bfree(video);
@@ -337,19 +377,66 @@ static bool match_space(enum video_colorspace a, enum video_colorspace b)
 	return (a == VIDEO_CS_DEFAULT) || (b == VIDEO_CS_DEFAULT) || (collapse_space(a) == collapse_space(b));
 }
 
+static uint32_t get_scale_threads(const struct video_output *video)
+{
+	uint32_t max_threads = (uint32_t)os_get_logical_cores();
+	uint32_t threads = video->info.scale_threads;
+
+	if (max_threads == 0)
+		max_threads = 1;
+
+	/* by default, only use a few threads so multiple scaled outputs
+	 * don't starve the rest of the program */
+	if (threads == 0) {
+		int physical = os_get_physical_cores();
+		threads = physical > 4 ? 4 : (physical > 0 ? (uint32_t)physical : 1);
+	}
+
+	return threads > max_threads ? max_threads : threads;
+}
+
+/* format changes that format-conversion handles directly, which is much
+ * cheaper than going through the scaler */
+static bool can_convert_direct(const struct video_input *input, const struct video_output *video)
+{
+	const struct video_scale_info *info = &input->conversion;
+
+	if (info->width != video->info.width || info->height != video->info.height)
+		return false;
+
+	if (video->info.format == VIDEO_FORMAT_NV12 && info->format == VIDEO_FORMAT_I444)
+		return match_range(info->range, video->info.range) &&
+		       match_space(info->colorspace, video->info.colorspace);
+
+	/* the colorspace and range are those of the output */
+	return video->info.format == VIDEO_FORMAT_RGBA && info->format == VIDEO_FORMAT_NV12;
+}
+
 static inline bool video_input_init(struct video_input *input, struct video_output *video)
 {
-	if (input->conversion.width != video->info.width || input->conversion.height != video->info.height ||
-	    input->conversion.format != video->info.format ||
-	    !match_range(input->conversion.range, video->info.range) ||
-	    !match_space(input->conversion.colorspace, video->info.colorspace)) {
+	input->convert_from = VIDEO_FORMAT_NONE;
+
+	if (can_convert_direct(input, video)) {
+		input->convert_from = video->info.format;
+		if (input->conversion.colorspace == VIDEO_CS_DEFAULT)
+			input->conversion.colorspace = video->info.colorspace;
+
+		for (size_t i = 0; i < MAX_CONVERT_BUFFERS; i++)
+			video_frame_init(&input->frame[i], input->conversion.format, input->conversion.width,
+					 input->conversion.height);
+
+	} else if (input->conversion.width != video->info.width || input->conversion.height != video->info.height ||
+		   input->conversion.format != video->info.format ||
+		   !match_range(input->conversion.range, video->info.range) ||
+		   !match_space(input->conversion.colorspace, video->info.colorspace)) {
 		struct video_scale_info from = {.format = video->info.format,
 						.width = video->info.width,
 						.height = video->info.height,
 						.range = video->info.range,
 						.colorspace = video->info.colorspace};
 
-		int ret = video_scaler_create(&input->scaler, &input->conversion, &from, VIDEO_SCALE_FAST_BILINEAR);
+		int ret = video_scaler_create2(&input->scaler, &input->conversion, &from, VIDEO_SCALE_FAST_BILINEAR,
+					       get_scale_threads(video));
 		if (ret != VIDEO_SCALER_SUCCESS) {
 			if (ret == VIDEO_SCALER_BAD_CONVERSION)
 				blog(LOG_ERROR, "video_input_init: Bad "
@@ -433,6 +520,10 @@ bool video_output_connect2(video_t *video, const struct video_scale_info *conver
 
 		success = video_input_init(&input, video);
 		if (success) {
+			input.profile_name = profile_store_name(
+				obs_get_profiler_name_store(), "video_input(%ux%u %s, %p)", input.conversion.width,
+				input.conversion.height, get_video_format_name(input.conversion.format), param);
+
 			if (video->inputs.num == 0) {
 				if (!os_atomic_load_long(&video->gpu_refs)) {
 					reset_frames(video);
@@ -509,39 +600,35 @@ const struct video_output_info *video_output_get_info(const video_t *video)
 bool video_output_lock_frame(video_t *video, struct video_frame *frame, int count, uint64_t timestamp)
 {
 	struct cached_frame_info *cfi;
-	bool locked;
+	long write_pos;
 
 	if (!video)
 		return false;
 
 	video = get_root(video);
 
-	pthread_mutex_lock(&video->data_mutex);
-
-	if (video->available_frames == 0) {
-		video->cache[video->last_added].count += count;
-		video->cache[video->last_added].skipped += count;
-		locked = false;
-
-	} else {
-		if (video->available_frames != video->info.cache_size) {
-			if (++video->last_added == video->info.cache_size)
-				video->last_added = 0;
-		}
-
-		cfi = &video->cache[video->last_added];
-		cfi->frame.timestamp = timestamp;
-		cfi->count = count;
-		cfi->skipped = 0;
+	write_pos = os_atomic_load_long(&video->write_pos);
 
-		memcpy(frame, &cfi->frame, sizeof(*frame));
+	if (ring_count(video, write_pos, os_atomic_load_long(&video->read_pos)) == video->info.cache_size) {
+		/* ring is full, so repeat the most recently added frame.  it
+		 * can't be the frame the video thread is currently working on
+		 * because the ring holds at least two frames. */
+		long last_pos = (write_pos + (long)(video->info.cache_size * 2) - 1) %
+				(long)(video->info.cache_size * 2);
 
-		locked = true;
+		cfi = ring_slot(video, last_pos);
+		atomic_add_long(&cfi->skipped, count);
+		atomic_add_long(&cfi->count, count);
+		return false;
 	}
 
-	pthread_mutex_unlock(&video->data_mutex);
+	cfi = ring_slot(video, write_pos);
+	cfi->frame.timestamp = timestamp;
+	os_atomic_store_long(&cfi->skipped, 0);
+	os_atomic_store_long(&cfi->count, count);
 
-	return locked;
+	memcpy(frame, &cfi->frame, sizeof(*frame));
+	return true;
 }
 
 void video_output_unlock_frame(video_t *video)
@@ -551,12 +638,9 @@ void video_output_unlock_frame(video_t *video)
 
 	video = get_root(video);
 
-	pthread_mutex_lock(&video->data_mutex);
-
-	video->available_frames--;
+	/* publishes the frame filled in after video_output_lock_frame */
+	os_atomic_store_long(&video->write_pos, ring_next(video, os_atomic_load_long(&video->write_pos)));
 	os_sem_post(video->update_semaphore);
-
-	pthread_mutex_unlock(&video->data_mutex);
 }
 
 uint64_t video_output_get_frame_time(const video_t *video)
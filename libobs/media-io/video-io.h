@@ -136,6 +136,9 @@ struct video_output_info {
 
 	enum video_colorspace colorspace;
 	enum video_range_type range;
+
+	/* threads used by each CPU scaler, 0 to pick automatically */
+	uint32_t scale_threads;
 };
 
 static inline bool format_is_yuv(enum video_format format)
@@ -18,6 +18,7 @@
 #include "../util/bmem.h"
 #include "video-scaler.h"
 
+#include <libavutil/frame.h>
 #include <libavutil/imgutils.h>
 #include <libavutil/opt.h>
 #include <libswscale/swscale.h>
@@ -28,6 +29,11 @@ struct video_scaler {
 	int dst_heights[4];
 	uint8_t *dst_pointers[4];
 	int dst_linesizes[4];
+
+	/* only used with slice threading, which requires the frame API */
+	int threads;
+	AVFrame *src_frame;
+	AVFrame *dst_frame;
 };
 
 static inline enum AVPixelFormat get_ffmpeg_video_format(enum video_format format)
@@ -142,6 +148,12 @@ static inline int get_ffmpeg_range_type(enum video_range_type type)
 
 int video_scaler_create(video_scaler_t **scaler_out, const struct video_scale_info *dst,
 			const struct video_scale_info *src, enum video_scale_type type)
+{
+	return video_scaler_create2(scaler_out, dst, src, type, 1);
+}
+
+int video_scaler_create2(video_scaler_t **scaler_out, const struct video_scale_info *dst,
+			 const struct video_scale_info *src, enum video_scale_type type, uint32_t threads)
 {
 	enum AVPixelFormat format_src = get_ffmpeg_video_format(src->format);
 	enum AVPixelFormat format_dst = get_ffmpeg_video_format(dst->format);
@@ -161,6 +173,7 @@ int video_scaler_create(video_scaler_t **scaler_out, const struct video_scale_in
 
 	scaler = bzalloc(sizeof(struct video_scaler));
 	scaler->src_height = src->height;
+	scaler->threads = threads > 1 ? (int)threads : 1;
 
 	const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(format_dst);
 	bool has_plane[4] = {0};
@@ -197,6 +210,8 @@ int video_scaler_create(video_scaler_t **scaler_out, const struct video_scale_in
 	av_opt_set_int(scaler->swscale, "dst_format", format_dst, 0);
 	av_opt_set_int(scaler->swscale, "src_range", range_src, 0);
 	av_opt_set_int(scaler->swscale, "dst_range", range_dst, 0);
+	if (scaler->threads > 1)
+		av_opt_set_int(scaler->swscale, "threads", scaler->threads, 0);
 	if (sws_init_context(scaler->swscale, NULL, NULL) < 0) {
 		blog(LOG_ERROR, "video_scaler_create: sws_init_context failed");
 		goto fail;
@@ -209,6 +224,22 @@ int video_scaler_create(video_scaler_t **scaler_out, const struct video_scale_in
 				"sws_setColorspaceDetails failed, ignoring");
 	}
 
+	if (scaler->threads > 1) {
+		scaler->src_frame = av_frame_alloc();
+		scaler->dst_frame = av_frame_alloc();
+		if (!scaler->src_frame || !scaler->dst_frame) {
+			blog(LOG_ERROR, "video_scaler_create: av_frame_alloc failed");
+			goto fail;
+		}
+
+		scaler->src_frame->format = format_src;
+		scaler->src_frame->width = src->width;
+		scaler->src_frame->height = src->height;
+		scaler->dst_frame->format = format_dst;
+		scaler->dst_frame->width = dst->width;
+		scaler->dst_frame->height = dst->height;
+	}
+
 	*scaler_out = scaler;
 	return VIDEO_SCALER_SUCCESS;
 
@@ -221,6 +252,8 @@ void video_scaler_destroy(video_scaler_t *scaler)
 {
 	if (scaler) {
 		sws_freeContext(scaler->swscale);
+		av_frame_free(&scaler->src_frame);
+		av_frame_free(&scaler->dst_frame);
 
 		if (scaler->dst_pointers[0])
 			av_freep(scaler->dst_pointers);
@@ -229,14 +262,54 @@ void video_scaler_destroy(video_scaler_t *scaler)
 	}
 }
 
+static void free_nothing(void *opaque, uint8_t *data)
+{
+	UNUSED_PARAMETER(opaque);
+	UNUSED_PARAMETER(data);
+}
+
+/* sws_scale_frame splits the output in to horizontal slices and scales them
+ * on the context's own worker threads.  the frames need buffer references or
+ * it would allocate and copy, so wrap the existing planes without taking
+ * ownership of them. */
+static int scale_threaded(struct video_scaler *scaler, const uint8_t *const input[], const uint32_t in_linesize[])
+{
+	AVFrame *src = scaler->src_frame;
+	AVFrame *dst = scaler->dst_frame;
+	int ret;
+
+	for (size_t i = 0; i < 4; i++) {
+		src->data[i] = (uint8_t *)input[i];
+		src->linesize[i] = (int)in_linesize[i];
+		dst->data[i] = scaler->dst_pointers[i];
+		dst->linesize[i] = scaler->dst_linesizes[i];
+	}
+
+	src->buf[0] = av_buffer_create((uint8_t *)input[0], 1, free_nothing, NULL, AV_BUFFER_FLAG_READONLY);
+	dst->buf[0] = av_buffer_create(scaler->dst_pointers[0], 1, free_nothing, NULL, 0);
+
+	if (src->buf[0] && dst->buf[0]) {
+		ret = sws_scale_frame(scaler->swscale, dst, src);
+		if (ret == 0)
+			ret = dst->height;
+	} else {
+		ret = AVERROR(ENOMEM);
+	}
+
+	av_buffer_unref(&src->buf[0]);
+	av_buffer_unref(&dst->buf[0]);
+	return ret;
+}
+
 bool video_scaler_scale(video_scaler_t *scaler, uint8_t *output[], const uint32_t out_linesize[],
 			const uint8_t *const input[], const uint32_t in_linesize[])
 {
 	if (!scaler)
 		return false;
 
-	int ret = sws_scale(scaler->swscale, input, (const int *)in_linesize, 0, scaler->src_height,
-			    scaler->dst_pointers, scaler->dst_linesizes);
+	int ret = scaler->threads > 1 ? scale_threaded(scaler, input, in_linesize)
+				      : sws_scale(scaler->swscale, input, (const int *)in_linesize, 0,
+						  scaler->src_height, scaler->dst_pointers, scaler->dst_linesizes);
 	if (ret <= 0) {
 		blog(LOG_ERROR, "video_scaler_scale: sws_scale failed: %d", ret);
 		return false;
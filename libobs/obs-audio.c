@@ -17,6 +17,7 @@
 
 #include <inttypes.h>
 #include "obs-internal.h"
+#include "media-io/audio-math.h"
 #include "util/util_uint64.h"
 
 struct ts_info {
@@ -106,15 +107,10 @@ static inline void mix_audio(struct audio_output_data *mixes, obs_source_t *sour
 
 	for (size_t mix_idx = 0; mix_idx < MAX_AUDIO_MIXES; mix_idx++) {
 		for (size_t ch = 0; ch < channels; ch++) {
-			register float *mix = mixes[mix_idx].data[ch];
-			register float *aud = source->audio_output_buf[mix_idx][ch];
-			register float *end;
+			float *mix = mixes[mix_idx].data[ch];
+			const float *aud = source->audio_output_buf[mix_idx][ch];
 
-			mix += start_point;
-			end = aud + total_floats;
-
-			while (aud < end)
-				*(mix++) += *(aud++);
+			audio_float_add(mix + start_point, aud, total_floats);
 		}
 	}
 }
@@ -490,6 +486,132 @@ static inline void release_audio_sources(struct obs_core_audio *audio)
 		obs_source_release(audio->render_order.array[i]);
 }
 
+static void build_audio_graph(struct obs_core_audio *audio)
+{
+	struct obs_core_data *data = &obs->data;
+	struct obs_source *source;
+
+	pthread_mutex_lock(&obs->video.mixes_mutex);
+	for (size_t j = 0; j < obs->video.mixes.num; j++) {
+		struct obs_view *view = obs->video.mixes.array[j]->view;
+		if (!view)
+			continue;
+
+		pthread_mutex_lock(&view->channels_mutex);
+
+		/* NOTE: these are source channels, not audio channels */
+		for (uint32_t i = 0; i < MAX_CHANNELS; i++) {
+			obs_source_t *source = view->channels[i];
+			if (!source)
+				continue;
+			if (!obs_source_active(source))
+				continue;
+			if (obs_source_removed(source))
+				continue;
+
+			/* first, add top - level sources as root_nodes */
+			if (obs->video.mixes.array[j]->mix_audio)
+				da_push_back(audio->root_nodes, &source);
+
+			/* Build audio tree, tag duplicate individual sources */
+			obs_source_enum_active_tree(source, push_audio_tree2, audio);
+
+			/* add top - level sources to audio tree */
+			push_audio_tree(NULL, source, audio);
+		}
+		pthread_mutex_unlock(&view->channels_mutex);
+	}
+	pthread_mutex_unlock(&obs->video.mixes_mutex);
+
+	pthread_mutex_lock(&data->audio_sources_mutex);
+
+	source = data->first_audio_source;
+	while (source) {
+		if (!obs_source_removed(source)) {
+			push_audio_tree(NULL, source, audio);
+		}
+		source = (struct obs_source *)source->next_audio_source;
+	}
+
+	pthread_mutex_unlock(&data->audio_sources_mutex);
+}
+
+static void clear_audio_graph(struct obs_core_audio *audio)
+{
+	for (size_t i = 0; i < audio->graph_order.num; i++)
+		obs_weak_source_release(audio->graph_order.array[i]);
+	da_resize(audio->graph_order, 0);
+	da_resize(audio->graph_roots, 0);
+}
+
+static void store_audio_graph(struct obs_core_audio *audio)
+{
+	clear_audio_graph(audio);
+
+	for (size_t i = 0; i < audio->render_order.num; i++) {
+		obs_weak_source_t *weak = obs_source_get_weak_source(audio->render_order.array[i]);
+		da_push_back(audio->graph_order, &weak);
+	}
+
+	for (size_t i = 0; i < audio->root_nodes.num; i++) {
+		size_t idx = da_find(audio->render_order, &audio->root_nodes.array[i], 0);
+		if (idx != DARRAY_INVALID)
+			da_push_back(audio->graph_roots, &idx);
+	}
+}
+
+/* fills render_order and root_nodes from the stored graph, fails if any of
+ * its sources has been destroyed since */
+static bool reuse_audio_graph(struct obs_core_audio *audio)
+{
+	for (size_t i = 0; i < audio->graph_order.num; i++) {
+		obs_source_t *source = obs_weak_source_get_source(audio->graph_order.array[i]);
+		if (!source)
+			return false;
+
+		da_push_back(audio->render_order, &source);
+	}
+
+	for (size_t i = 0; i < audio->graph_roots.num; i++)
+		da_push_back(audio->root_nodes, &audio->render_order.array[audio->graph_roots.array[i]]);
+
+	return true;
+}
+
+/*
+ * Walking the whole source tree is expensive with large scene collections and
+ * its result rarely changes, so the render order is only rebuilt when it has
+ * been invalidated (see obs_audio_graph_invalidate), when one of its sources
+ * is gone, and every AUDIO_GRAPH_MAX_AGE ticks regardless, for sources that
+ * change their active children without activating them.
+ */
+#define AUDIO_GRAPH_MAX_AGE 50
+
+static void load_audio_graph(struct obs_core_audio *audio)
+{
+	long generation = os_atomic_load_long(&audio->graph_generation);
+
+	da_resize(audio->render_order, 0);
+	da_resize(audio->root_nodes, 0);
+
+	if (generation == audio->graph_built_generation && audio->graph_age < AUDIO_GRAPH_MAX_AGE) {
+		if (reuse_audio_graph(audio)) {
+			audio->graph_age++;
+			return;
+		}
+
+		release_audio_sources(audio);
+		da_resize(audio->render_order, 0);
+		da_resize(audio->root_nodes, 0);
+	}
+
+	build_audio_graph(audio);
+	store_audio_graph(audio);
+
+	audio->graph_built_generation = generation;
+	audio->graph_age = 0;
+}
+
 static inline void execute_audio_tasks(void)
 {
 	struct obs_core_audio *audio = &obs->audio;
@@ -549,6 +671,92 @@ static inline void clear_audio_output_buf(obs_source_t *source, struct obs_core_
 	}
 }
 
+static void render_audio_source(struct obs_core_audio *audio, obs_source_t *source, const struct audio_render_job *job)
+{
+	uint64_t start = os_gettime_ns();
+
+	obs_source_audio_render(source, job->mixers, job->channels, job->sample_rate, job->size);
+	if (should_silence_monitored_source(source, audio))
+		clear_audio_output_buf(source, audio);
+
+	/* if a source has gone backward in time and we can no
+	 * longer buffer, drop some or all of its audio */
+	if (audio_buffering_maxed(audio) && source->audio_ts != 0 && source->audio_ts < job->start_ts) {
+		if (source->info.audio_render) {
+			blog(LOG_DEBUG,
+			     "render audio source %s timestamp has "
+			     "gone backwards",
+			     obs_source_get_name(source));
+
+			/* just avoid further damage */
+			source->audio_pending = true;
+#if DEBUG_AUDIO == 1
+			/* this should really be fixed */
+			assert(false);
+#endif
+		} else {
+			pthread_mutex_lock(&source->audio_buf_mutex);
+			bool rerender = ignore_audio(source, job->channels, job->sample_rate, job->start_ts);
+			pthread_mutex_unlock(&source->audio_buf_mutex);
+
+			/* if we (potentially) recovered, re-render */
+			if (rerender)
+				obs_source_audio_render(source, job->mixers, job->channels, job->sample_rate,
+							job->size);
+		}
+	}
+
+	source->audio_render_time = os_gettime_ns() - start;
+}
+
+/*
+ * Sources without an audio_render callback only use their own buffers when
+ * rendered, so they are rendered in parallel by the audio thread and the
+ * libobs thread pool.  Sources with an audio_render callback mix the
+ * output of their children and are rendered after all of those, on the audio
+ * thread and in render order, which always has children before their parents.
+ *
+ * Waking up the pool costs more than copying the buffers of a few sources, so
+ * it is only used when rendering the independent sources took longer than
+ * AUDIO_RENDER_PARALLEL_NS in the previous tick, which in practice means
+ * sources with audio_mix callbacks and the filters those run.
+ */
+#define AUDIO_RENDER_PARALLEL_NS 250000ULL
+
+static void render_leaf(void *param, size_t idx)
+{
+	struct obs_core_audio *audio = &obs->audio;
+	render_audio_source(audio, audio->render_leaves.array[idx], param);
+}
+
+static void render_audio_sources(struct obs_core_audio *audio, struct audio_render_job *job)
+{
+	da_resize(audio->render_leaves, 0);
+
+	for (size_t i = 0; i < audio->render_order.num; i++) {
+		obs_source_t *source = audio->render_order.array[i];
+		if (!source->info.audio_render)
+			da_push_back(audio->render_leaves, &source);
+	}
+
+	if (audio->render_leaves_time >= AUDIO_RENDER_PARALLEL_NS) {
+		obs_parallel_for(&audio->render_pool, audio->render_leaves.num, render_leaf, job);
+	} else {
+		for (size_t i = 0; i < audio->render_leaves.num; i++)
+			render_leaf(job, i);
+	}
+
+	audio->render_leaves_time = 0;
+	for (size_t i = 0; i < audio->render_leaves.num; i++)
+		audio->render_leaves_time += audio->render_leaves.array[i]->audio_render_time;
+
+	for (size_t i = 0; i < audio->render_order.num; i++) {
+		obs_source_t *source = audio->render_order.array[i];
+		if (source->info.audio_render)
+			render_audio_source(audio, source, job);
+	}
+}
+
 bool audio_callback(void *param, uint64_t start_ts_in, uint64_t end_ts_in, uint64_t *out_ts, uint32_t mixers,
 		    struct audio_output_data *mixes)
 {
@@ -561,9 +769,6 @@ bool audio_callback(void *param, uint64_t start_ts_in, uint64_t end_ts_in, uint6
 	size_t audio_size;
 	uint64_t min_ts;
 
-	da_resize(audio->render_order, 0);
-	da_resize(audio->root_nodes, 0);
-
 	deque_push_back(&audio->buffered_timestamps, &ts, sizeof(ts));
 	deque_peek_front(&audio->buffered_timestamps, &ts, sizeof(ts));
 	min_ts = ts.start;
@@ -577,84 +782,13 @@ bool audio_callback(void *param, uint64_t start_ts_in, uint64_t end_ts_in, uint6
 	/* ------------------------------------------------ */
 	/* build audio render order */
 
-	pthread_mutex_lock(&obs->video.mixes_mutex);
-	for (size_t j = 0; j < obs->video.mixes.num; j++) {
-		struct obs_view *view = obs->video.mixes.array[j]->view;
-		if (!view)
-			continue;
-
-		pthread_mutex_lock(&view->channels_mutex);
-
-		/* NOTE: these are source channels, not audio channels */
-		for (uint32_t i = 0; i < MAX_CHANNELS; i++) {
-			obs_source_t *source = view->channels[i];
-			if (!source)
-				continue;
-			if (!obs_source_active(source))
-				continue;
-			if (obs_source_removed(source))
-				continue;
-
-			/* first, add top - level sources as root_nodes */
-			if (obs->video.mixes.array[j]->mix_audio)
-				da_push_back(audio->root_nodes, &source);
-
-			/* Build audio tree, tag duplicate individual sources */
-			obs_source_enum_active_tree(source, push_audio_tree2, audio);
-
-			/* add top - level sources to audio tree */
-			push_audio_tree(NULL, source, audio);
-		}
-		pthread_mutex_unlock(&view->channels_mutex);
-	}
-	pthread_mutex_unlock(&obs->video.mixes_mutex);
-
-	pthread_mutex_lock(&data->audio_sources_mutex);
-
-	source = data->first_audio_source;
-	while (source) {
-		if (!obs_source_removed(source)) {
-			push_audio_tree(NULL, source, audio);
-		}
-		source = (struct obs_source *)source->next_audio_source;
-	}
-
-	pthread_mutex_unlock(&data->audio_sources_mutex);
+	load_audio_graph(audio);
 
 	/* ------------------------------------------------ */
 	/* render audio data */
-	for (size_t i = 0; i < audio->render_order.num; i++) {
-		obs_source_t *source = audio->render_order.array[i];
-		obs_source_audio_render(source, mixers, channels, sample_rate, audio_size);
-		if (should_silence_monitored_source(source, audio))
-			clear_audio_output_buf(source, audio);
-
-		/* if a source has gone backward in time and we can no
-		 * longer buffer, drop some or all of its audio */
-		if (audio_buffering_maxed(audio) && source->audio_ts != 0 && source->audio_ts < ts.start) {
-			if (source->info.audio_render) {
-				blog(LOG_DEBUG,
-				     "render audio source %s timestamp has "
-				     "gone backwards",
-				     obs_source_get_name(source));
-
-				/* just avoid further damage */
-				source->audio_pending = true;
-#if DEBUG_AUDIO == 1
-				/* this should really be fixed */
-				assert(false);
-#endif
-			} else {
-				pthread_mutex_lock(&source->audio_buf_mutex);
-				bool rerender = ignore_audio(source, channels, sample_rate, ts.start);
-				pthread_mutex_unlock(&source->audio_buf_mutex);
-
-				/* if we (potentially) recovered, re-render */
-				if (rerender)
-					obs_source_audio_render(source, mixers, channels, sample_rate, audio_size);
-			}
-		}
-	}
+	struct audio_render_job job = {mixers, channels, sample_rate, audio_size, ts.start};
+	render_audio_sources(audio, &job);
+	source_profiler_audio_render(audio->render_order.array, audio->render_order.num);
 
 	/* ------------------------------------------------ */
 	/* get minimum audio timestamp */
@@ -170,6 +170,7 @@ static obs_canvas_t *obs_canvas_create_internal(const char *name, const char *uu
 			pthread_mutex_lock(&obs->video.mixes_mutex);
 			da_push_back(obs->video.mixes, &canvas->mix);
 			pthread_mutex_unlock(&obs->video.mixes_mutex);
+			obs_audio_graph_invalidate();
 		}
 	}
 
@@ -278,6 +279,7 @@ void obs_canvas_clear_mix(obs_canvas_t *canvas)
 		}
 	}
 	pthread_mutex_unlock(&obs->video.mixes_mutex);
+	obs_audio_graph_invalidate();
 
 	canvas->mix = NULL;
 }
@@ -312,6 +314,7 @@ bool obs_canvas_reset_video_internal(obs_canvas_t *canvas, struct obs_video_info
 		pthread_mutex_lock(&obs->video.mixes_mutex);
 		da_push_back(obs->video.mixes, &canvas->mix);
 		pthread_mutex_unlock(&obs->video.mixes_mutex);
+		obs_audio_graph_invalidate();
 	}
 
 	canvas_dosignal(canvas, "canvas_video_reset", "video_reset");
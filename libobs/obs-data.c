@@ -21,6 +21,7 @@
 #include "util/darray.h"
 #include "util/platform.h"
 #include "util/uthash.h"
+#include "util/array-serializer.h"
 #include "graphics/vec2.h"
 #include "graphics/vec3.h"
 #include "graphics/vec4.h"
@@ -32,7 +33,10 @@
 struct obs_data_item {
 	volatile long ref;
 	const char *name;
+	unsigned hash;
 	struct obs_data *parent;
+	struct obs_data_item *prev;
+	struct obs_data_item *next;
 	UT_hash_handle hh;
 	enum obs_data_type type;
 	size_t name_len;
@@ -44,10 +48,31 @@ struct obs_data_item {
 	size_t capacity;
 };
 
+/* objects with fewer items than this are searched by scanning an array of
+ * item hashes, only larger ones get a hash table */
+#define FLAT_MAX_ITEMS 16
+
 struct obs_data {
 	volatile long ref;
 	char *json;
+
+	/* insertion order */
+	struct obs_data_item *first;
+	struct obs_data_item *last;
+	size_t num_items;
+
+	/* hash table, only used once the object has FLAT_MAX_ITEMS items */
 	struct obs_data_item *items;
+
+	unsigned flat_hashes[FLAT_MAX_ITEMS - 1];
+	struct obs_data_item *flat_items[FLAT_MAX_ITEMS - 1];
+};
+
+struct obs_data_key {
+	UT_hash_handle hh;
+	const char *name;
+	size_t len;
+	unsigned hash;
 };
 
 struct obs_data_array {
@@ -63,6 +88,149 @@ struct obs_data_number {
 	};
 };
 
+/* ------------------------------------------------------------------------- */
+/* Interned keys */
+
+static struct obs_data_key *data_keys = NULL;
+static pthread_mutex_t data_keys_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static inline unsigned get_name_hash(const char *name, size_t len)
+{
+	unsigned hash;
+	HASH_VALUE(name, (unsigned)len, hash);
+	return hash;
+}
+
+const obs_data_key_t *obs_data_key(const char *name)
+{
+	struct obs_data_key *key;
+	size_t len;
+	unsigned hash;
+
+	if (!name)
+		return NULL;
+
+	len = strlen(name);
+	hash = get_name_hash(name, len);
+
+	pthread_mutex_lock(&data_keys_mutex);
+
+	HASH_FIND_BYHASHVALUE(hh, data_keys, name, (unsigned)len, hash, key);
+	if (!key) {
+		key = bmalloc(sizeof(*key) + len + 1);
+		key->name = (char *)(key + 1);
+		key->len = len;
+		key->hash = hash;
+		memcpy(key + 1, name, len + 1);
+
+		HASH_ADD_KEYPTR_BYHASHVALUE(hh, data_keys, key->name, (unsigned)len, hash, key);
+	}
+
+	pthread_mutex_unlock(&data_keys_mutex);
+	return key;
+}
+
+const char *obs_data_key_name(const obs_data_key_t *key)
+{
+	return key ? key->name : NULL;
+}
+
+void obs_data_free_keys(void)
+{
+	struct obs_data_key *key, *temp;
+
+	pthread_mutex_lock(&data_keys_mutex);
+	HASH_ITER (hh, data_keys, key, temp) {
+		HASH_DELETE(hh, data_keys, key);
+		bfree(key);
+	}
+	pthread_mutex_unlock(&data_keys_mutex);
+}
+
+/* ------------------------------------------------------------------------- */
+/* Item lookup */
+
+static struct obs_data_item *find_item(struct obs_data *data, const char *name, size_t len, unsigned hash)
+{
+	struct obs_data_item *item = NULL;
+
+	if (data->items) {
+		HASH_FIND_BYHASHVALUE(hh, data->items, name, (unsigned)len, hash, item);
+		return item;
+	}
+
+	for (size_t i = 0; i < data->num_items; i++) {
+		if (data->flat_hashes[i] == hash && strcmp(data->flat_items[i]->name, name) == 0)
+			return data->flat_items[i];
+	}
+
+	return NULL;
+}
+
+static inline void hash_item(struct obs_data *data, struct obs_data_item *item)
+{
+	HASH_ADD_KEYPTR_BYHASHVALUE(hh, data->items, item->name, (unsigned)strlen(item->name), item->hash, item);
+}
+
+static void add_item(struct obs_data *data, struct obs_data_item *item)
+{
+	item->parent = data;
+	item->prev = data->last;
+	item->next = NULL;
+
+	if (data->last)
+		data->last->next = item;
+	else
+		data->first = item;
+	data->last = item;
+
+	if (data->items) {
+		hash_item(data, item);
+
+	} else if (data->num_items < FLAT_MAX_ITEMS - 1) {
+		data->flat_hashes[data->num_items] = item->hash;
+		data->flat_items[data->num_items] = item;
+
+	} else {
+		for (struct obs_data_item *cur = data->first; cur; cur = cur->next)
+			hash_item(data, cur);
+	}
+
+	data->num_items++;
+}
+
+static void remove_item(struct obs_data *data, struct obs_data_item *item)
+{
+	if (item->prev)
+		item->prev->next = item->next;
+	else
+		data->first = item->next;
+	if (item->next)
+		item->next->prev = item->prev;
+	else
+		data->last = item->prev;
+
+	if (data->items) {
+		HASH_DELETE(hh, data->items, item);
+
+	} else {
+		size_t last = data->num_items - 1;
+
+		for (size_t i = 0; i < last; i++) {
+			if (data->flat_items[i] == item) {
+				data->flat_hashes[i] = data->flat_hashes[last];
+				data->flat_items[i] = data->flat_items[last];
+				break;
+			}
+		}
+	}
+
+	data->num_items--;
+	item->parent = NULL;
+	item->prev = NULL;
+	item->next = NULL;
+}
+
 /* ------------------------------------------------------------------------- */
 /* Item structure, designed to be one allocation only */
 
@@ -294,6 +462,7 @@ static struct obs_data_item *obs_data_item_create(const char *name, const void *
 
 	char *name_ptr = get_item_name(item);
 	item->name = name_ptr;
+	item->hash = get_name_hash(name, strlen(name));
 
 	strcpy(name_ptr, name);
 	memcpy(get_item_data(item), data, size);
@@ -304,18 +473,14 @@ static struct obs_data_item *obs_data_item_create(const char *name, const void *
 
 static inline void obs_data_item_detach(struct obs_data_item *item)
 {
-	if (item->parent) {
-		HASH_DEL(item->parent->items, item);
-		item->parent = NULL;
-	}
+	if (item->parent)
+		remove_item(item->parent, item);
 }
 
 static inline void obs_data_item_reattach(struct obs_data *parent, struct obs_data_item *item)
 {
-	if (parent) {
-		HASH_ADD_STR(parent->items, name, item);
-		item->parent = parent;
-	}
+	if (parent)
+		add_item(parent, item);
 }
 
 static struct obs_data_item *obs_data_item_ensure_capacity(struct obs_data_item *item)
@@ -340,8 +505,7 @@ static struct obs_data_item *obs_data_item_ensure_capacity(struct obs_data_item
 
 static inline void obs_data_item_destroy(struct obs_data_item *item)
 {
-	if (item->parent)
-		HASH_DEL(item->parent->items, item);
+	obs_data_item_detach(item);
 
 	item_data_release(item);
 	item_default_data_release(item);
@@ -559,9 +723,8 @@ static json_t *obs_data_to_json(obs_data_t *data, bool with_defaults)
 	json_t *json = json_object();
 
 	obs_data_item_t *item = NULL;
-	obs_data_item_t *temp = NULL;
 
-	HASH_ITER (hh, data->items, item, temp) {
+	for (item = data->first; item; item = item->next) {
 		enum obs_data_type type = obs_data_item_gettype(item);
 		const char *name = get_item_name(item);
 
@@ -628,27 +791,26 @@ obs_data_t *obs_data_create_from_json_file(const char *json_file)
 	return data;
 }
 
-obs_data_t *obs_data_create_from_json_file_safe(const char *json_file, const char *backup_ext)
+static obs_data_t *create_from_file_safe(obs_data_t *(*create)(const char *file), const char *file,
+					 const char *backup_ext, const char *func)
 {
-	obs_data_t *file_data = obs_data_create_from_json_file(json_file);
+	obs_data_t *file_data = create(file);
 	if (!file_data && backup_ext && *backup_ext) {
 		struct dstr backup_file = {0};
 
-		dstr_copy(&backup_file, json_file);
+		dstr_copy(&backup_file, file);
 		if (*backup_ext != '.')
 			dstr_cat(&backup_file, ".");
 		dstr_cat(&backup_file, backup_ext);
 
 		if (os_file_exists(backup_file.array)) {
-			blog(LOG_WARNING, "obs-data.c: "
-					  "[obs_data_create_from_json_file_safe] "
-					  "attempting backup file");
+			blog(LOG_WARNING, "obs-data.c: [%s] attempting backup file", func);
 
 			/* delete current file if corrupt to prevent it from
 			 * being backed up again */
-			os_rename(backup_file.array, json_file);
+			os_rename(backup_file.array, file);
 
-			file_data = obs_data_create_from_json_file(json_file);
+			file_data = create(file);
 		}
 
 		dstr_free(&backup_file);
@@ -657,6 +819,12 @@ obs_data_t *obs_data_create_from_json_file_safe(const char *json_file, const cha
 	return file_data;
 }
 
+obs_data_t *obs_data_create_from_json_file_safe(const char *json_file, const char *backup_ext)
+{
+	return create_from_file_safe(obs_data_create_from_json_file, json_file, backup_ext,
+				     "obs_data_create_from_json_file_safe");
+}
+
 void obs_data_addref(obs_data_t *data)
 {
 	if (data)
@@ -667,7 +835,8 @@ static inline void obs_data_destroy(struct obs_data *data)
 {
 	struct obs_data_item *item, *temp;
 
-	HASH_ITER (hh, data->items, item, temp) {
+	for (item = data->first; item; item = temp) {
+		temp = item->next;
 		obs_data_item_detach(item);
 		obs_data_item_release(&item);
 	}
@@ -767,6 +936,381 @@ bool obs_data_save_json_pretty_safe(obs_data_t *data, const char *file, const ch
 	return false;
 }
 
+/* ------------------------------------------------------------------------- */
+/* Binary format
+ *
+ * Holds the same (user) values as the JSON format, in the same order, but can
+ * be written and read back without any parsing or number formatting.  Strings
+ * are stored with their terminator so they are used straight from the buffer
+ * they are read from, which also makes it suitable for reading from a file
+ * mapping.
+ *
+ * Integers are little endian, counts and lengths are LEB128 varints:
+ *
+ *   file:   "OBSD", u8 version, object
+ *   object: count, count * (u8 type, name, value)
+ *   string: length, length bytes, '\0'
+ *   value:  string | zigzag varint | f64 | (nothing for booleans) | object |
+ *           array: count, count * object
+ */
+
+#define BINARY_MAGIC "OBSD"
+#define BINARY_VERSION 1
+#define BINARY_MAX_DEPTH 512
+
+enum binary_type {
+	BINARY_STRING = 1,
+	BINARY_INT,
+	BINARY_DOUBLE,
+	BINARY_FALSE,
+	BINARY_TRUE,
+	BINARY_OBJECT,
+	BINARY_ARRAY,
+};
+
+static void write_varint(struct serializer *s, uint64_t val)
+{
+	while (val >= 0x80) {
+		s_w8(s, (uint8_t)(val | 0x80));
+		val >>= 7;
+	}
+
+	s_w8(s, (uint8_t)val);
+}
+
+static void write_binary_string(struct serializer *s, const char *str)
+{
+	size_t len = str ? strlen(str) : 0;
+
+	write_varint(s, len);
+	s_write(s, str ? str : "", len + 1);
+}
+
+static void write_binary_object(struct serializer *s, obs_data_t *data);
+
+static void write_binary_array(struct serializer *s, obs_data_array_t *array)
+{
+	size_t count = array ? array->objects.num : 0;
+
+	write_varint(s, count);
+
+	for (size_t i = 0; i < count; i++)
+		write_binary_object(s, array->objects.array[i]);
+}
+
+static void write_binary_item(struct serializer *s, obs_data_item_t *item)
+{
+	switch (item->type) {
+	case OBS_DATA_STRING:
+		s_w8(s, BINARY_STRING);
+		write_binary_string(s, get_item_name(item));
+		write_binary_string(s, obs_data_item_get_string(item));
+		break;
+
+	case OBS_DATA_NUMBER:
+		if (obs_data_item_numtype(item) == OBS_DATA_NUM_INT) {
+			uint64_t val = (uint64_t)obs_data_item_get_int(item);
+
+			s_w8(s, BINARY_INT);
+			write_binary_string(s, get_item_name(item));
+			write_varint(s, (val << 1) ^ (uint64_t)((int64_t)val >> 63));
+		} else {
+			s_w8(s, BINARY_DOUBLE);
+			write_binary_string(s, get_item_name(item));
+			s_wld(s, obs_data_item_get_double(item));
+		}
+		break;
+
+	case OBS_DATA_BOOLEAN:
+		s_w8(s, obs_data_item_get_bool(item) ? BINARY_TRUE : BINARY_FALSE);
+		write_binary_string(s, get_item_name(item));
+		break;
+
+	case OBS_DATA_OBJECT:
+		s_w8(s, BINARY_OBJECT);
+		write_binary_string(s, get_item_name(item));
+		write_binary_object(s, get_item_obj(item));
+		break;
+
+	case OBS_DATA_ARRAY:
+		s_w8(s, BINARY_ARRAY);
+		write_binary_string(s, get_item_name(item));
+		write_binary_array(s, get_item_array(item));
+		break;
+
+	case OBS_DATA_NULL:
+		break;
+	}
+}
+
+static inline bool has_binary_value(obs_data_item_t *item)
+{
+	return item->type != OBS_DATA_NULL && obs_data_item_has_user_value(item);
+}
+
+static void write_binary_object(struct serializer *s, obs_data_t *data)
+{
+	obs_data_item_t *item = NULL;
+	size_t count = 0;
+
+	if (data) {
+		for (item = data->first; item; item = item->next) {
+			if (has_binary_value(item))
+				count++;
+		}
+	}
+
+	write_varint(s, count);
+
+	if (!count)
+		return;
+
+	for (item = data->first; item; item = item->next) {
+		if (has_binary_value(item))
+			write_binary_item(s, item);
+	}
+}
+
+static void obs_data_to_binary(obs_data_t *data, struct array_output_data *output)
+{
+	struct serializer s;
+
+	array_output_serializer_init(&s, output);
+	s_write(&s, BINARY_MAGIC, 4);
+	s_w8(&s, BINARY_VERSION);
+	write_binary_object(&s, data);
+}
+
+struct binary_reader {
+	const uint8_t *pos;
+	const uint8_t *end;
+	bool error;
+};
+
+static inline uint8_t read_u8(struct binary_reader *r)
+{
+	if (r->pos == r->end) {
+		r->error = true;
+		return 0;
+	}
+
+	return *(r->pos++);
+}
+
+static uint64_t read_varint(struct binary_reader *r)
+{
+	uint64_t val = 0;
+
+	for (unsigned int shift = 0; shift < 64; shift += 7) {
+		uint8_t byte = read_u8(r);
+
+		val |= (uint64_t)(byte & 0x7F) << shift;
+		if (!(byte & 0x80))
+			return val;
+	}
+
+	r->error = true;
+	return 0;
+}
+
+static double read_double(struct binary_reader *r)
+{
+	uint64_t bits = 0;
+	double val;
+
+	for (unsigned int shift = 0; shift < 64; shift += 8)
+		bits |= (uint64_t)read_u8(r) << shift;
+
+	memcpy(&val, &bits, sizeof(val));
+	return val;
+}
+
+static const char *read_binary_string(struct binary_reader *r)
+{
+	uint64_t len = read_varint(r);
+
+	if (r->error || len >= (uint64_t)(r->end - r->pos) || r->pos[len] != 0) {
+		r->error = true;
+		return NULL;
+	}
+
+	const char *str = (const char *)r->pos;
+	r->pos += len + 1;
+	return str;
+}
+
+static void read_binary_object(struct binary_reader *r, obs_data_t *data, int depth);
+
+static void read_binary_array(struct binary_reader *r, obs_data_t *data, const char *name, int depth)
+{
+	obs_data_array_t *array = obs_data_array_create();
+	uint64_t count = read_varint(r);
+
+	for (uint64_t i = 0; i < count && !r->error; i++) {
+		obs_data_t *obj = obs_data_create();
+		read_binary_object(r, obj, depth + 1);
+		da_push_back(array->objects, &obj);
+	}
+
+	obs_data_set_array(data, name, array);
+	obs_data_array_release(array);
+}
+
+static void read_binary_item(struct binary_reader *r, obs_data_t *data, int depth)
+{
+	uint8_t type = read_u8(r);
+	const char *name = read_binary_string(r);
+
+	if (r->error)
+		return;
+
+	switch (type) {
+	case BINARY_STRING: {
+		const char *val = read_binary_string(r);
+		if (val)
+			obs_data_set_string(data, name, val);
+		break;
+	}
+
+	case BINARY_INT: {
+		uint64_t val = read_varint(r);
+		obs_data_set_int(data, name, (long long)((val >> 1) ^ (~(val & 1) + 1)));
+		break;
+	}
+
+	case BINARY_DOUBLE:
+		obs_data_set_double(data, name, read_double(r));
+		break;
+
+	case BINARY_FALSE:
+	case BINARY_TRUE:
+		obs_data_set_bool(data, name, type == BINARY_TRUE);
+		break;
+
+	case BINARY_OBJECT: {
+		obs_data_t *obj = obs_data_create();
+		read_binary_object(r, obj, depth + 1);
+		obs_data_set_obj(data, name, obj);
+		obs_data_release(obj);
+		break;
+	}
+
+	case BINARY_ARRAY:
+		read_binary_array(r, data, name, depth);
+		break;
+
+	default:
+		r->error = true;
+	}
+}
+
+static void read_binary_object(struct binary_reader *r, obs_data_t *data, int depth)
+{
+	if (depth > BINARY_MAX_DEPTH) {
+		r->error = true;
+		return;
+	}
+
+	uint64_t count = read_varint(r);
+
+	for (uint64_t i = 0; i < count && !r->error; i++)
+		read_binary_item(r, data, depth);
+}
+
+obs_data_t *obs_data_create_from_binary(const void *buf, size_t size)
+{
+	struct binary_reader r = {buf, (const uint8_t *)buf + size, false};
+
+	if (!buf || size < 5 || memcmp(buf, BINARY_MAGIC, 4) != 0) {
+		blog(LOG_ERROR, "obs-data.c: [obs_data_create_from_binary] "
+				"Not binary obs_data");
+		return NULL;
+	}
+
+	r.pos += 4;
+	uint8_t version = read_u8(&r);
+	if (version != BINARY_VERSION) {
+		blog(LOG_ERROR,
+		     "obs-data.c: [obs_data_create_from_binary] "
+		     "Unsupported version %u",
+		     version);
+		return NULL;
+	}
+
+	obs_data_t *data = obs_data_create();
+	read_binary_object(&r, data, 0);
+
+	if (r.error || r.pos != r.end) {
+		blog(LOG_ERROR, "obs-data.c: [obs_data_create_from_binary] "
+				"Data is corrupt");
+		obs_data_release(data);
+		return NULL;
+	}
+
+	return data;
+}
+
+obs_data_t *obs_data_create_from_binary_file(const char *binary_file)
+{
+	FILE *file = os_fopen(binary_file, "rb");
+	obs_data_t *data = NULL;
+
+	if (!file)
+		return NULL;
+
+	int64_t size = os_fgetsize(file);
+	if (size > 0 && (uint64_t)size <= SIZE_MAX) {
+		uint8_t *buf = bmalloc((size_t)size);
+
+		if (fread(buf, 1, (size_t)size, file) == (size_t)size)
+			data = obs_data_create_from_binary(buf, (size_t)size);
+
+		bfree(buf);
+	}
+
+	fclose(file);
+	return data;
+}
+
+obs_data_t *obs_data_create_from_binary_file_safe(const char *binary_file, const char *backup_ext)
+{
+	return create_from_file_safe(obs_data_create_from_binary_file, binary_file, backup_ext,
+				     "obs_data_create_from_binary_file_safe");
+}
+
+bool obs_data_save_binary(obs_data_t *data, const char *file)
+{
+	struct array_output_data output;
+	bool success;
+
+	if (!data)
+		return false;
+
+	obs_data_to_binary(data, &output);
+	success = os_quick_write_utf8_file(file, (const char *)output.bytes.array, output.bytes.num, false);
+	array_output_serializer_free(&output);
+
+	return success;
+}
+
+bool obs_data_save_binary_safe(obs_data_t *data, const char *file, const char *temp_ext, const char *backup_ext)
+{
+	struct array_output_data output;
+	bool success;
+
+	if (!data)
+		return false;
+
+	obs_data_to_binary(data, &output);
+	success = os_quick_write_utf8_file_safe(file, (const char *)output.bytes.array, output.bytes.num, false,
+						temp_ext, backup_ext);
+	array_output_serializer_free(&output);
+
+	return success;
+}
+
+/* ------------------------------------------------------------------------- */
+
 static void get_defaults_array_cb(obs_data_t *data, void *vp)
 {
 	obs_data_array_t *defs = (obs_data_array_t *)vp;
@@ -784,9 +1328,9 @@ obs_data_t *obs_data_get_defaults(obs_data_t *data)
 	if (!data)
 		return defaults;
 
-	struct obs_data_item *item, *temp;
+	struct obs_data_item *item;
 
-	HASH_ITER (hh, data->items, item, temp) {
+	for (item = data->first; item; item = item->next) {
 		const char *name = get_item_name(item);
 		switch (item->type) {
 		case OBS_DATA_NULL:
@@ -854,12 +1398,19 @@ obs_data_t *obs_data_get_defaults(obs_data_t *data)
 
 static struct obs_data_item *get_item(struct obs_data *data, const char *name)
 {
-	if (!data)
+	if (!data || !name)
 		return NULL;
 
-	struct obs_data_item *item;
-	HASH_FIND_STR(data->items, name, item);
-	return item;
+	size_t len = strlen(name);
+	return find_item(data, name, len, get_name_hash(name, len));
+}
+
+static inline struct obs_data_item *get_item_key(struct obs_data *data, const obs_data_key_t *key)
+{
+	if (!data || !key)
+		return NULL;
+
+	return find_item(data, key->name, key->len, key->hash);
 }
 
 static void set_item_data(struct obs_data *data, struct obs_data_item **item, const char *name, const void *ptr,
@@ -869,8 +1420,7 @@ static void set_item_data(struct obs_data *data, struct obs_data_item **item, co
 
 	if ((!item || !*item) && data) {
 		new_item = obs_data_item_create(name, ptr, size, type, default_data, autoselect_data);
-		new_item->parent = data;
-		HASH_ADD_STR(data->items, name, new_item);
+		add_item(data, new_item);
 
 	} else if (default_data) {
 		obs_data_item_set_default_data(item, ptr, size, type);
@@ -982,9 +1532,10 @@ static inline void copy_item(struct obs_data *data, struct obs_data_item *item)
 		if (array)
 			copy_array(data, name, *array, obs_data_set_array);
 
-	} else {
-		if (item->data_size)
-			set_item(data, NULL, name, ptr, item->data_size, item->type);
+	} else if (item->data_size) {
+		/* the hash is the same in both objects, no need to compute it again */
+		obs_data_item_t *target = find_item(data, name, strlen(name), item->hash);
+		set_item(data, &target, name, ptr, item->data_size, item->type);
 	}
 }
 
@@ -993,11 +1544,10 @@ void obs_data_apply(obs_data_t *target, obs_data_t *apply_data)
 	if (!target || !apply_data || target == apply_data)
 		return;
 
-	struct obs_data_item *item, *temp;
+	struct obs_data_item *item;
 
-	HASH_ITER (hh, apply_data->items, item, temp) {
+	for (item = apply_data->first; item; item = item->next)
 		copy_item(target, item);
-	}
 }
 
 void obs_data_erase(obs_data_t *data, const char *name)
@@ -1043,10 +1593,9 @@ void obs_data_clear(obs_data_t *target)
 	if (!target)
 		return;
 
-	struct obs_data_item *item, *temp;
-	HASH_ITER (hh, target->items, item, temp) {
+	struct obs_data_item *item;
+	for (item = target->first; item; item = item->next)
 		clear_item(item);
-	}
 }
 
 typedef void (*set_item_t)(obs_data_t *, obs_data_item_t **, const char *, const void *, size_t, enum obs_data_type);
@@ -1282,6 +1831,64 @@ obs_data_array_t *obs_data_get_autoselect_array(obs_data_t *data, const char *na
 	return obs_data_item_get_autoselect_array(get_item(data, name));
 }
 
+void obs_data_set_string_key(obs_data_t *data, const obs_data_key_t *key, const char *val)
+{
+	obs_data_item_t *item = get_item_key(data, key);
+	if (data && key)
+		obs_set_string(data, &item, key->name, val, set_item);
+}
+
+void obs_data_set_int_key(obs_data_t *data, const obs_data_key_t *key, long long val)
+{
+	obs_data_item_t *item = get_item_key(data, key);
+	if (data && key)
+		obs_set_int(data, &item, key->name, val, set_item);
+}
+
+void obs_data_set_double_key(obs_data_t *data, const obs_data_key_t *key, double val)
+{
+	obs_data_item_t *item = get_item_key(data, key);
+	if (data && key)
+		obs_set_double(data, &item, key->name, val, set_item);
+}
+
+void obs_data_set_bool_key(obs_data_t *data, const obs_data_key_t *key, bool val)
+{
+	obs_data_item_t *item = get_item_key(data, key);
+	if (data && key)
+		obs_set_bool(data, &item, key->name, val, set_item);
+}
+
+const char *obs_data_get_string_key(obs_data_t *data, const obs_data_key_t *key)
+{
+	return obs_data_item_get_string(get_item_key(data, key));
+}
+
+long long obs_data_get_int_key(obs_data_t *data, const obs_data_key_t *key)
+{
+	return obs_data_item_get_int(get_item_key(data, key));
+}
+
+double obs_data_get_double_key(obs_data_t *data, const obs_data_key_t *key)
+{
+	return obs_data_item_get_double(get_item_key(data, key));
+}
+
+bool obs_data_get_bool_key(obs_data_t *data, const obs_data_key_t *key)
+{
+	return obs_data_item_get_bool(get_item_key(data, key));
+}
+
+obs_data_t *obs_data_get_obj_key(obs_data_t *data, const obs_data_key_t *key)
+{
+	return obs_data_item_get_obj(get_item_key(data, key));
+}
+
+obs_data_array_t *obs_data_get_array_key(obs_data_t *data, const obs_data_key_t *key)
+{
+	return obs_data_item_get_array(get_item_key(data, key));
+}
+
 obs_data_array_t *obs_data_array_create()
 {
 	struct obs_data_array *array = bzalloc(sizeof(struct obs_data_array));
@@ -1480,9 +2087,9 @@ obs_data_item_t *obs_data_first(obs_data_t *data)
 	if (!data)
 		return NULL;
 
-	if (data->items)
-		os_atomic_inc_long(&data->items->ref);
-	return data->items;
+	if (data->first)
+		os_atomic_inc_long(&data->first->ref);
+	return data->first;
 }
 
 obs_data_item_t *obs_data_item_byname(obs_data_t *data, const char *name)
@@ -1496,10 +2103,18 @@ obs_data_item_t *obs_data_item_byname(obs_data_t *data, const char *name)
 	return item;
 }
 
+obs_data_item_t *obs_data_item_bykey(obs_data_t *data, const obs_data_key_t *key)
+{
+	struct obs_data_item *item = get_item_key(data, key);
+	if (item)
+		os_atomic_inc_long(&item->ref);
+	return item;
+}
+
 bool obs_data_item_next(obs_data_item_t **item)
 {
 	if (item && *item) {
-		obs_data_item_t *next = (*item)->hh.next;
+		obs_data_item_t *next = (*item)->next;
 		obs_data_item_release(item);
 
 		*item = next;
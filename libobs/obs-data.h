@@ -42,6 +42,7 @@ struct obs_data_array;
 typedef struct obs_data obs_data_t;
 typedef struct obs_data_item obs_data_item_t;
 typedef struct obs_data_array obs_data_array_t;
+typedef struct obs_data_key obs_data_key_t;
 
 enum obs_data_type {
 	OBS_DATA_NULL,
@@ -74,6 +75,14 @@ EXPORT bool obs_data_save_json_safe(obs_data_t *data, const char *file, const ch
 EXPORT bool obs_data_save_json_pretty_safe(obs_data_t *data, const char *file, const char *temp_ext,
 					   const char *backup_ext);
 
+/* Compact binary alternative to the JSON functions, holding the same values */
+EXPORT obs_data_t *obs_data_create_from_binary(const void *buf, size_t size);
+EXPORT obs_data_t *obs_data_create_from_binary_file(const char *binary_file);
+EXPORT obs_data_t *obs_data_create_from_binary_file_safe(const char *binary_file, const char *backup_ext);
+EXPORT bool obs_data_save_binary(obs_data_t *data, const char *file);
+EXPORT bool obs_data_save_binary_safe(obs_data_t *data, const char *file, const char *temp_ext,
+				      const char *backup_ext);
+
 EXPORT void obs_data_apply(obs_data_t *target, obs_data_t *apply_data);
 
 EXPORT void obs_data_erase(obs_data_t *data, const char *name);
@@ -138,6 +147,30 @@ OBS_DEPRECATED EXPORT bool obs_data_get_autoselect_bool(obs_data_t *data, const
 OBS_DEPRECATED EXPORT obs_data_t *obs_data_get_autoselect_obj(obs_data_t *data, const char *name);
 OBS_DEPRECATED EXPORT obs_data_array_t *obs_data_get_autoselect_array(obs_data_t *data, const char *name);
 
+/* ------------------------------------------------------------------------- */
+/* Interned keys
+ *
+ * A key holds the precomputed hash of a name, so looking up values with it
+ * does not have to hash the name on every call.  Keys are shared and stay
+ * valid until libobs is shut down, so they can be created once (e.g. when
+ * the source is created) and then used in update/tick callbacks.
+ */
+
+EXPORT const obs_data_key_t *obs_data_key(const char *name);
+EXPORT const char *obs_data_key_name(const obs_data_key_t *key);
+
+EXPORT void obs_data_set_string_key(obs_data_t *data, const obs_data_key_t *key, const char *val);
+EXPORT void obs_data_set_int_key(obs_data_t *data, const obs_data_key_t *key, long long val);
+EXPORT void obs_data_set_double_key(obs_data_t *data, const obs_data_key_t *key, double val);
+EXPORT void obs_data_set_bool_key(obs_data_t *data, const obs_data_key_t *key, bool val);
+
+EXPORT const char *obs_data_get_string_key(obs_data_t *data, const obs_data_key_t *key);
+EXPORT long long obs_data_get_int_key(obs_data_t *data, const obs_data_key_t *key);
+EXPORT double obs_data_get_double_key(obs_data_t *data, const obs_data_key_t *key);
+EXPORT bool obs_data_get_bool_key(obs_data_t *data, const obs_data_key_t *key);
+EXPORT obs_data_t *obs_data_get_obj_key(obs_data_t *data, const obs_data_key_t *key);
+EXPORT obs_data_array_t *obs_data_get_array_key(obs_data_t *data, const obs_data_key_t *key);
+
 /* Array functions */
 EXPORT obs_data_array_t *obs_data_array_create();
 EXPORT void obs_data_array_addref(obs_data_array_t *array);
@@ -178,6 +211,7 @@ OBS_DEPRECATED EXPORT void obs_data_item_unset_autoselect_value(obs_data_item_t
 
 EXPORT obs_data_item_t *obs_data_first(obs_data_t *data);
 EXPORT obs_data_item_t *obs_data_item_byname(obs_data_t *data, const char *name);
+EXPORT obs_data_item_t *obs_data_item_bykey(obs_data_t *data, const obs_data_key_t *key);
 EXPORT bool obs_data_item_next(obs_data_item_t **item);
 EXPORT void obs_data_item_release(obs_data_item_t **item);
 EXPORT void obs_data_item_remove(obs_data_item_t **item);
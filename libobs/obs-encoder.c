@@ -344,6 +344,7 @@ static void maybe_set_up_gpu_rescale(struct obs_encoder *encoder)
 	}
 
 	pthread_mutex_unlock(&obs->video.mixes_mutex);
+	obs_audio_graph_invalidate();
 }
 
 static void add_connection(struct obs_encoder *encoder)
@@ -441,6 +442,7 @@ void obs_encoder_destroy(obs_encoder_t *encoder)
 		da_free(encoder->callbacks);
 		da_free(encoder->roi);
 		da_free(encoder->encoder_packet_times);
+		da_free(encoder->nal_units);
 		pthread_mutex_destroy(&encoder->init_mutex);
 		pthread_mutex_destroy(&encoder->callbacks_mutex);
 		pthread_mutex_destroy(&encoder->outputs_mutex);
@@ -699,6 +701,7 @@ static void maybe_clear_encoder_core_video_mix(obs_encoder_t *encoder)
 		}
 	}
 	pthread_mutex_unlock(&obs->video.mixes_mutex);
+	obs_audio_graph_invalidate();
 }
 
 void obs_encoder_shutdown(obs_encoder_t *encoder)
@@ -1329,6 +1332,28 @@ void full_stop(struct obs_encoder *encoder)
 	}
 }
 
+static inline bool has_nal_units(const struct obs_encoder *encoder)
+{
+	const char *codec = encoder->info.codec;
+	return encoder->info.type == OBS_ENCODER_VIDEO && (strcmp(codec, "h264") == 0 || strcmp(codec, "hevc") == 0);
+}
+
+/* outputs used to scan every packet for start codes in each of their muxers,
+ * this does it once for all of them */
+static void index_nal_units(struct obs_encoder *encoder, const struct encoder_packet *pkt)
+{
+	size_t num = obs_nal_find_units(pkt->data, pkt->size, encoder->nal_units.array, encoder->nal_units.capacity);
+
+	if (num > encoder->nal_units.capacity) {
+		da_reserve(encoder->nal_units, num);
+		obs_nal_find_units(pkt->data, pkt->size, encoder->nal_units.array, num);
+	}
+
+	encoder->nal_units.num = num;
+	encoder->nal_units_data = pkt->data;
+	encoder->nal_units_size = pkt->size;
+}
+
 void send_off_encoder_packet(obs_encoder_t *encoder, bool success, bool received, struct encoder_packet *pkt)
 {
 	if (!success) {
@@ -1374,6 +1399,9 @@ void send_off_encoder_packet(obs_encoder_t *encoder, bool success, bool received
 				     pkt->pts);
 		}
 
+		if (has_nal_units(encoder) && pkt->data)
+			index_nal_units(encoder, pkt);
+
 		pthread_mutex_lock(&encoder->callbacks_mutex);
 
 		for (size_t i = encoder->callbacks.num; i > 0; i--) {
@@ -1384,6 +1412,8 @@ void send_off_encoder_packet(obs_encoder_t *encoder, bool success, bool received
 
 		pthread_mutex_unlock(&encoder->callbacks_mutex);
 
+		encoder->nal_units_data = NULL;
+
 		// Count number of video frames successfully encoded
 		if (pkt->type == OBS_ENCODER_VIDEO)
 			encoder->encoded_frames++;
@@ -1777,13 +1807,49 @@ void obs_encoder_remove_output(struct obs_encoder *encoder, struct obs_output *o
 
 void obs_encoder_packet_create_instance(struct encoder_packet *dst, const struct encoder_packet *src)
 {
-	long *p_refs;
+	const struct obs_encoder *encoder = src->encoder;
+	size_t num_units = 0;
+
+	/* packets that differ from the one sent off (such as the first one,
+	 * which gets the SEI prepended) simply go without an index */
+	if (encoder && src->data && encoder->nal_units_data == src->data && encoder->nal_units_size == src->size)
+		num_units = encoder->nal_units.num;
 
 	*dst = *src;
-	p_refs = bmalloc(src->size + sizeof(long));
-	dst->data = (void *)(p_refs + 1);
-	*p_refs = 1;
+
+	if (!num_units) {
+		dst->data = obs_packet_pool_alloc(src->size);
+		memcpy(dst->data, src->data, src->size);
+		return;
+	}
+
+	size_t offset = obs_nal_index_offset(src->size);
+	uint32_t num = (uint32_t)num_units;
+
+	dst->data = obs_packet_pool_alloc(offset + sizeof(num) + num_units * sizeof(struct obs_nal_unit));
 	memcpy(dst->data, src->data, src->size);
+	memcpy(dst->data + offset, &num, sizeof(num));
+	memcpy(dst->data + offset + sizeof(num), encoder->nal_units.array, num_units * sizeof(struct obs_nal_unit));
+
+	/* not visible to any other thread yet */
+	((long *)dst->data)[-1] |= OBS_PACKET_NAL_INDEX_FLAG;
+}
+
+const struct obs_nal_unit *obs_encoder_packet_get_nal_units(const struct encoder_packet *packet, size_t *num)
+{
+	if (!packet || !packet->data)
+		return NULL;
+
+	long refs = os_atomic_load_long(((const long *)packet->data) - 1);
+	if ((refs & OBS_PACKET_NAL_INDEX_FLAG) == 0)
+		return NULL;
+
+	const uint8_t *index = packet->data + obs_nal_index_offset(packet->size);
+	uint32_t count;
+
+	memcpy(&count, index, sizeof(count));
+	*num = count;
+	return (const struct obs_nal_unit *)(index + sizeof(count));
 }
 
 void obs_encoder_packet_ref(struct encoder_packet *dst, struct encoder_packet *src)
@@ -1806,8 +1872,12 @@ void obs_encoder_packet_release(struct encoder_packet *pkt)
 
 	if (pkt->data) {
 		long *p_refs = ((long *)pkt->data) - 1;
-		if (os_atomic_dec_long(p_refs) == 0)
+		long refs = os_atomic_dec_long(p_refs) & ~OBS_PACKET_NAL_INDEX_FLAG;
+
+		if (refs == 0)
 			bfree(p_refs);
+		else if (refs == OBS_PACKET_POOL_REF_FLAG)
+			obs_packet_pool_release(pkt->data);
 	}
 
 	memset(pkt, 0, sizeof(struct encoder_packet));
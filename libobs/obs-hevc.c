@@ -111,12 +111,56 @@ static void serialize_hevc_data(struct serializer *s, const uint8_t *data, size_
 	}
 }
 
+/* builds the length prefixed packet straight from the NAL units the encoder
+ * found, sized exactly and without scanning for start codes again */
+static void parse_indexed_hevc_packet(struct encoder_packet *hevc_packet, const struct encoder_packet *src,
+				      const struct obs_nal_unit *units, size_t num)
+{
+	size_t size = 0;
+	for (size_t i = 0; i < num; i++)
+		size += sizeof(uint32_t) + units[i].size;
+
+	long *p_refs = bmalloc(sizeof(long) + size);
+	uint8_t *out = (uint8_t *)(p_refs + 1);
+	*p_refs = 1;
+
+	hevc_packet->data = out;
+	hevc_packet->size = size;
+
+	for (size_t i = 0; i < num; i++) {
+		const uint8_t *nal_start = src->data + units[i].offset;
+		const uint32_t nal_size = units[i].size;
+
+		hevc_packet->priority = compute_hevc_keyframe_priority(nal_start, &hevc_packet->keyframe,
+							 hevc_packet->priority);
+
+		out[0] = (uint8_t)(nal_size >> 24);
+		out[1] = (uint8_t)(nal_size >> 16);
+		out[2] = (uint8_t)(nal_size >> 8);
+		out[3] = (uint8_t)nal_size;
+		memcpy(out + 4, nal_start, nal_size);
+		out += 4 + nal_size;
+	}
+
+	hevc_packet->drop_priority = hevc_packet->priority;
+}
+
 void obs_parse_hevc_packet(struct encoder_packet *hevc_packet, const struct encoder_packet *src)
 {
 	struct array_output_data output;
 	struct serializer s;
 	long ref = 1;
 
+	const struct obs_nal_unit *units;
+	size_t num_units;
+
+	units = obs_encoder_packet_get_nal_units(src, &num_units);
+	if (units) {
+		*hevc_packet = *src;
+		parse_indexed_hevc_packet(hevc_packet, src, units, num_units);
+		return;
+	}
+
 	array_output_serializer_init(&s, &output);
 	*hevc_packet = *src;
 
@@ -769,6 +769,20 @@ obs_data_t *obs_hotkeys_save_source(obs_source_t *source)
 		return result;
 
 	result = save_context_hotkeys(&source->context);
+
+	/* the hotkeys of lazy sources that are not created are only in the
+	 * hotkey data they were loaded from */
+	if (source->lazy && source->context.hotkey_data) {
+		obs_data_t *saved = obs_data_create();
+
+		obs_data_apply(saved, source->context.hotkey_data);
+		if (result)
+			obs_data_apply(saved, result);
+
+		obs_data_release(result);
+		result = saved;
+	}
+
 	unlock();
 
 	return result;
@@ -940,6 +954,36 @@ void obs_hotkeys_context_release(struct obs_context_data *context)
 	unlock();
 }
 
+void obs_hotkeys_context_release_after(struct obs_context_data *context, size_t num_hotkeys, size_t num_pairs)
+{
+	if (!lock())
+		return;
+
+	/* keep the bindings of the released hotkeys, so that they are bound
+	 * again when they are registered again, or saved meanwhile */
+	if (context->hotkeys.num > num_hotkeys && !context->hotkey_data)
+		context->hotkey_data = obs_data_create();
+
+	for (size_t i = num_hotkeys; i < context->hotkeys.num; i++) {
+		obs_hotkey_t *hotkey;
+		HASH_FIND_HKEY(obs->hotkeys.hotkeys, context->hotkeys.array[i], hotkey);
+		if (hotkey)
+			enum_save_hotkey(context->hotkey_data, hotkey);
+	}
+
+	for (size_t i = num_pairs; i < context->hotkey_pairs.num; i++)
+		unregister_hotkey_pair(context->hotkey_pairs.array[i]);
+	for (size_t i = num_hotkeys; i < context->hotkeys.num; i++)
+		unregister_hotkey(context->hotkeys.array[i]);
+
+	if (context->hotkey_pairs.num > num_pairs)
+		da_resize(context->hotkey_pairs, num_pairs);
+	if (context->hotkeys.num > num_hotkeys)
+		da_resize(context->hotkeys, num_hotkeys);
+
+	unlock();
+}
+
 void obs_hotkeys_free(void)
 {
 	obs_hotkey_t *hotkey, *tmp;
@@ -38,6 +38,8 @@
 #include "media-io/audio-io.h"
 
 #include "obs.h"
+#include "obs-nal.h"
+#include "obs-output-interleave.h"
 
 #include <obsversion.h>
 #include <caption/caption.h>
@@ -251,6 +253,9 @@ const char *obs_get_hotkey_translation(obs_key_t key, const char *def);
 
 struct obs_context_data;
 void obs_hotkeys_context_release(struct obs_context_data *context);
+/* releases the hotkeys registered after the first num_hotkeys/num_pairs ones,
+ * keeping their bindings in the hotkey data of the context */
+void obs_hotkeys_context_release_after(struct obs_context_data *context, size_t num_hotkeys, size_t num_pairs);
 
 void obs_hotkeys_free(void);
 
@@ -266,6 +271,33 @@ struct obs_hotkey_binding {
 struct obs_hotkey_name_map_item;
 void obs_hotkey_name_map_free(void);
 
+/* ------------------------------------------------------------------------- */
+/* parallel loops */
+
+#define OBS_PARALLEL_MAX_HELPERS 3
+
+typedef void (*obs_parallel_func_t)(void *param, size_t idx);
+
+/* a few tasks on the shared thread pool that help the thread calling
+ * obs_parallel_for, which must always be the same one */
+struct obs_parallel_pool {
+	os_thread_pool_t *thread_pool;
+	os_task_group_t *group;
+	size_t num_helpers;
+
+	obs_parallel_func_t func;
+	void *param;
+	size_t num;
+	volatile long next;
+};
+
+extern void obs_parallel_pool_init(struct obs_parallel_pool *pool, os_thread_pool_t *thread_pool);
+extern void obs_parallel_pool_free(struct obs_parallel_pool *pool);
+
+/* calls func for every idx below num, spread over the calling thread and the
+ * pool threads, and returns once all calls have returned */
+extern void obs_parallel_for(struct obs_parallel_pool *pool, size_t num, obs_parallel_func_t func, void *param);
+
 /* ------------------------------------------------------------------------- */
 /* views */
 
@@ -439,12 +471,28 @@ extern void add_ready_encoder_group(obs_encoder_t *encoder);
 
 struct audio_monitor;
 
+struct audio_render_job {
+	uint32_t mixers;
+	size_t channels;
+	size_t sample_rate;
+	size_t size;
+	uint64_t start_ts;
+};
+
 struct obs_core_audio {
 	audio_t *audio;
 
 	DARRAY(struct obs_source *) render_order;
 	DARRAY(struct obs_source *) root_nodes;
 
+	/* render order and root nodes as of the last tree walk, see
+	 * obs_audio_graph_invalidate */
+	DARRAY(obs_weak_source_t *) graph_order;
+	DARRAY(size_t) graph_roots;
+	volatile long graph_generation;
+	long graph_built_generation;
+	int graph_age;
+
 	uint64_t buffered_ts;
 	struct deque buffered_timestamps;
 	uint64_t buffering_wait_ticks;
@@ -461,6 +509,11 @@ struct obs_core_audio {
 	struct deque tasks;
 
 	struct obs_source *monitoring_duplicating_source;
+
+	/* sources without an audio_render callback, rendered in parallel */
+	struct obs_parallel_pool render_pool;
+	DARRAY(struct obs_source *) render_leaves;
+	uint64_t render_leaves_time;
 };
 
 /* user sources, output channels, and displays */
@@ -502,6 +555,14 @@ struct obs_core_data {
 
 	DARRAY(char *) protocols;
 	DARRAY(obs_source_t *) sources_to_tick;
+
+	/* sources with OBS_SOURCE_THREADSAFE_TICK, ticked in parallel */
+	struct obs_parallel_pool tick_pool;
+	DARRAY(obs_source_t *) threaded_ticks;
+	uint64_t threaded_ticks_time;
+
+	volatile long hidden_tick_interval;
+	volatile long lazy_unload_delay;
 };
 
 /* user hotkeys */
@@ -550,6 +611,9 @@ struct obs_core {
 	DARRAY(char *) disabled_modules;
 	DARRAY(char *) core_modules;
 
+	char *module_manifest_path;
+	obs_data_t *module_manifest;
+
 	obs_source_info_array_t source_types;
 	obs_source_info_array_t input_types;
 	obs_source_info_array_t filter_types;
@@ -574,12 +638,23 @@ struct obs_core {
 	struct obs_core_hotkeys hotkeys;
 
 	os_task_queue_t *destruction_task_thread;
+	os_thread_pool_t *thread_pool;
 
 	obs_task_handler_t ui_task_handler;
 };
 
 extern struct obs_core *obs;
 
+/* Makes the audio thread walk the source tree again on its next tick instead
+ * of reusing the render order it built before.  Needs to be called whenever
+ * what obs_source_enum_active_tree returns for an output channel may change,
+ * or when audio sources or mixes come and go. */
+static inline void obs_audio_graph_invalidate(void)
+{
+	if (obs)
+		os_atomic_inc_long(&obs->audio.graph_generation);
+}
+
 struct obs_graphics_context {
 	uint64_t last_time;
 	uint64_t interval;
@@ -754,6 +829,15 @@ struct async_frame {
 	bool used;
 };
 
+/* frames submitted with obs_source_output_video_ref, whose plane data is
+ * owned by the source and handed back through the release callback */
+struct async_frame_ref {
+	struct obs_source_frame *frame;
+	obs_source_frame_release_t release;
+	void *param;
+	bool cached;
+};
+
 enum audio_action_type {
 	AUDIO_ACTION_VOL,
 	AUDIO_ACTION_MUTE,
@@ -803,6 +887,14 @@ struct media_action {
 	};
 };
 
+enum obs_lazy_state {
+	OBS_LAZY_UNLOADED,
+	OBS_LAZY_LOADING,
+	OBS_LAZY_LOADED,
+	OBS_LAZY_UNLOADING,
+	OBS_LAZY_FAILED,
+};
+
 struct obs_source {
 	struct obs_context_data context;
 	struct obs_source_info info;
@@ -881,11 +973,39 @@ struct obs_source {
 	uint32_t audio_mixers;
 	float user_volume;
 	float volume;
+	signal_id_t volume_signal;
 	int64_t sync_offset;
 	int64_t last_sync_offset;
 	float balance;
 	/* audio_is_duplicated: tracks whether a source appears multiple times in the audio tree during this tick */
 	bool audio_is_duplicated;
+	/* time spent rendering audio in the current tick, in ns */
+	uint64_t audio_render_time;
+
+	/* video_tick throttling, see obs_set_hidden_tick_interval */
+	float tick_seconds;
+	float skipped_tick_seconds;
+	uint32_t skipped_ticks;
+	bool tick_skipped;
+	uint64_t tick_time;
+
+	/* deferred creation, see obs_source_create_lazy.  the state is
+	 * protected by lazy_mutex, which the video tick only ever tries to
+	 * lock.  sources with OBS_SOURCE_LAZY_UNLOAD are destroyed again when
+	 * they are not used, threads other than the video thread hold
+	 * lazy_data_users while they call into them */
+	bool lazy;
+	bool lazy_unload;
+	enum obs_lazy_state lazy_state;
+	pthread_mutex_t lazy_mutex;
+	bool lazy_load_pending;
+	bool lazy_sync_pending;
+	uint64_t lazy_idle_since;
+	size_t lazy_hotkeys;
+	size_t lazy_hotkey_pairs;
+	void *lazy_unload_data;
+	volatile long lazy_data_users;
+	os_event_t *lazy_unloaded;
 
 	/* async video data */
 	gs_texture_t *async_textures[MAX_AV_PLANES];
@@ -909,6 +1029,7 @@ struct obs_source {
 	bool async_decoupled;
 	struct obs_source_frame *async_preload_frame;
 	DARRAY(struct async_frame) async_cache;
+	DARRAY(struct async_frame_ref) async_ref_frames;
 	DARRAY(struct obs_source_frame *) async_frames;
 	pthread_mutex_t async_mutex;
 	uint32_t async_width;
@@ -1022,7 +1143,7 @@ extern obs_source_t *obs_source_create_canvas(obs_canvas_t *canvas, const char *
 					      obs_data_t *settings, obs_data_t *hotkey_data);
 extern obs_source_t *obs_source_create_set_last_ver(obs_canvas_t *canvas, const char *id, const char *name,
 						    const char *uuid, obs_data_t *settings, obs_data_t *hotkey_data,
-						    uint32_t last_obs_ver, bool is_private);
+						    uint32_t last_obs_ver, bool is_private, bool lazy);
 
 extern void obs_source_destroy(struct obs_source *source);
 extern void obs_source_addref(obs_source_t *source);
@@ -1119,7 +1240,10 @@ static inline enum gs_color_space convert_video_space(enum video_format format,
 extern void obs_source_set_texcoords_centered(obs_source_t *source, bool centered);
 extern void obs_source_activate(obs_source_t *source, enum view_type type);
 extern void obs_source_deactivate(obs_source_t *source, enum view_type type);
-extern void obs_source_video_tick(obs_source_t *source, float seconds);
+/* ticks everything but the video_tick callback, returns whether the callback
+ * is to be called this frame */
+extern bool obs_source_video_tick_begin(obs_source_t *source, float seconds);
+extern void obs_source_video_tick_callback(obs_source_t *source);
 extern float obs_source_get_target_volume(obs_source_t *source, obs_source_t *target);
 extern uint64_t obs_source_get_last_async_ts(const obs_source_t *source);
 
@@ -1136,6 +1260,9 @@ extern bool update_async_textures(struct obs_source *source, const struct obs_so
 extern bool set_async_texture_size(struct obs_source *source, const struct obs_source_frame *frame);
 extern void remove_async_frame(obs_source_t *source, struct obs_source_frame *frame);
 
+/* see obs-source-lazy.c, returns false while the source is being created */
+extern bool lazy_source_tick(obs_source_t *source, bool wanted);
+
 extern void set_deinterlace_texture_size(obs_source_t *source);
 extern void deinterlace_process_last_frame(obs_source_t *source, uint64_t sys_time);
 extern void deinterlace_update_async_video(obs_source_t *source);
@@ -1223,10 +1350,10 @@ struct obs_output {
 	int64_t audio_offsets[MAX_OUTPUT_AUDIO_ENCODERS];
 	int64_t highest_audio_ts;
 	int64_t highest_video_ts[MAX_OUTPUT_VIDEO_ENCODERS];
-	pthread_t end_data_capture_thread;
+	os_task_group_t *end_data_capture_task;
 	os_event_t *stopping_event;
 	pthread_mutex_t interleaved_mutex;
-	DARRAY(struct encoder_packet) interleaved_packets;
+	struct interleave_queue interleaved_packets;
 	size_t interleaver_max_batch_size;
 	int stop_code;
 
@@ -1322,6 +1449,27 @@ extern const struct obs_output_info *find_output(const char *id);
 extern void obs_output_remove_encoder(struct obs_output *output, struct obs_encoder *encoder);
 
 extern void obs_encoder_packet_create_instance(struct encoder_packet *dst, const struct encoder_packet *src);
+
+/* pooled payloads carry this bit in their reference count */
+#define OBS_PACKET_POOL_REF_FLAG 0x40000000L
+/* payloads followed by the index of their NAL units carry this bit in their
+ * reference count, see obs_encoder_packet_get_nal_units */
+#define OBS_PACKET_NAL_INDEX_FLAG 0x20000000L
+
+/* the NAL unit index follows the payload at a 4 byte aligned offset, as the
+ * number of units followed by the units themselves */
+static inline size_t obs_nal_index_offset(size_t size)
+{
+	return (size + 3) & ~(size_t)3;
+}
+
+extern void obs_packet_pool_init(void);
+extern void obs_packet_pool_free(void);
+extern uint8_t *obs_packet_pool_alloc(size_t size);
+extern void obs_packet_pool_release(uint8_t *data);
+
+/* frees the interned obs_data keys, see obs_data_key */
+extern void obs_data_free_keys(void);
 void obs_output_destroy(obs_output_t *output);
 
 /* ------------------------------------------------------------------------- */
@@ -1435,6 +1583,12 @@ struct obs_encoder {
 
 	DARRAY(struct encoder_packet_time) encoder_packet_times;
 
+	/* NAL units of the H.264/HEVC packet being sent off, copied into the
+	 * payload of each output's instance of it */
+	DARRAY(struct obs_nal_unit) nal_units;
+	const uint8_t *nal_units_data;
+	size_t nal_units_size;
+
 	struct pause_data pause;
 
 	const char *profile_encoder_encode_name;
@@ -1512,13 +1666,16 @@ extern void source_profiler_async_frame_received(obs_source_t *source);
 
 /* Get timestamp for start of tick */
 extern uint64_t source_profiler_source_tick_start(void);
-/* Submit start timestamp for source */
-extern void source_profiler_source_tick_end(obs_source_t *source, uint64_t start);
+/* Submit tick time for source, and whether its video_tick was skipped */
+extern void source_profiler_source_tick_end(obs_source_t *source, uint64_t time, bool skipped);
 
 /* Obtain GPU timer and start timestamp for render start of a source. */
 extern uint64_t source_profiler_source_render_begin(gs_timer_t **timer);
 /* Submit start timestamp and GPU timer after rendering source */
 extern void source_profiler_source_render_end(obs_source_t *source, uint64_t start, gs_timer_t *timer);
 
+/* Submit the audio render times of an audio tick (obs_source::audio_render_time) */
+extern void source_profiler_audio_render(obs_source_t *const *sources, size_t num);
+
 /* Remove source from profiler hashmaps */
 extern void source_profiler_remove_source(obs_source_t *source);
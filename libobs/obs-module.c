@@ -15,6 +15,8 @@
     along with this program.  If not, see <http://www.gnu.org/licenses/>.
 ******************************************************************************/
 
+#include <sys/stat.h>
+
 #include "util/platform.h"
 #include "util/dstr.h"
 
@@ -137,14 +139,16 @@ int obs_module_load_metadata(struct obs_module *mod)
 	return MODULE_SUCCESS;
 }
 
-int obs_open_module(obs_module_t **module, const char *path, const char *data_path)
+static const char *os_dlopen_name = "os_dlopen";
+static const char *obs_module_load_metadata_name = "obs_module_load_metadata";
+static const char *obs_module_set_locale_name = "obs_module_set_locale";
+
+/* Opens the module binary and fills in the module without touching any
+ * global state, so modules can be opened in parallel */
+static int open_module(struct obs_module *mod, const char *path, const char *data_path)
 {
-	struct obs_module mod = {0};
 	int errorcode;
 
-	if (!module || !path || !obs)
-		return MODULE_ERROR;
-
 #ifdef __APPLE__
 	/* HACK: Do not load obsolete obs-browser build on macOS; the
 	 * obs-browser plugin used to live in the Application Support
@@ -157,49 +161,77 @@ int obs_open_module(obs_module_t **module, const char *path, const char *data_pa
 
 	blog(LOG_DEBUG, "---------------------------------");
 
-	mod.module = os_dlopen(path);
-	if (!mod.module) {
+	profile_start(os_dlopen_name);
+	mod->module = os_dlopen(path);
+	profile_end(os_dlopen_name);
+
+	if (!mod->module) {
 		blog(LOG_WARNING, "Module '%s' not loaded", path);
 		return MODULE_FAILED_TO_OPEN;
 	}
 
-	errorcode = load_module_exports(&mod, path);
+	errorcode = load_module_exports(mod, path);
 	if (errorcode != MODULE_SUCCESS)
 		return errorcode;
 
 	/* Reject plugins compiled with a newer libobs. Patch version (lower 16-bit) is ignored. */
-	uint32_t ver = mod.ver ? mod.ver() & 0xFFFF0000 : 0;
+	uint32_t ver = mod->ver ? mod->ver() & 0xFFFF0000 : 0;
 	if (ver > LIBOBS_API_VER) {
 		blog(LOG_WARNING, "Module '%s' compiled with newer libobs %d.%d", path, (ver >> 24) & 0xFF,
 		     (ver >> 16) & 0xFF);
 		return MODULE_INCOMPATIBLE_VER;
 	}
 
-	mod.bin_path = bstrdup(path);
-	mod.file = strrchr(mod.bin_path, '/');
-	mod.file = (!mod.file) ? mod.bin_path : (mod.file + 1);
-	mod.mod_name = get_module_name(mod.file);
-	mod.data_path = bstrdup(data_path);
-	mod.next = obs->first_module;
-	mod.load_state = OBS_MODULE_ENABLED;
+	mod->bin_path = bstrdup(path);
+	mod->file = strrchr(mod->bin_path, '/');
+	mod->file = (!mod->file) ? mod->bin_path : (mod->file + 1);
+	mod->mod_name = get_module_name(mod->file);
+	mod->data_path = bstrdup(data_path);
+	mod->load_state = OBS_MODULE_ENABLED;
 
-	da_init(mod.sources);
-	da_init(mod.outputs);
-	da_init(mod.encoders);
-	da_init(mod.services);
+	da_init(mod->sources);
+	da_init(mod->outputs);
+	da_init(mod->encoders);
+	da_init(mod->services);
 
-	if (mod.file) {
-		blog(LOG_DEBUG, "Loading module: %s", mod.file);
+	if (mod->file) {
+		blog(LOG_DEBUG, "Loading module: %s", mod->file);
 	}
 
-	obs_module_load_metadata(&mod);
+	profile_start(obs_module_load_metadata_name);
+	obs_module_load_metadata(mod);
+	profile_end(obs_module_load_metadata_name);
+
+	return MODULE_SUCCESS;
+}
+
+static void set_module_pointer(obs_module_t *module)
+{
+	module->set_pointer(module);
+
+	if (module->set_locale) {
+		profile_start(obs_module_set_locale_name);
+		module->set_locale(obs->locale);
+		profile_end(obs_module_set_locale_name);
+	}
+}
+
+int obs_open_module(obs_module_t **module, const char *path, const char *data_path)
+{
+	struct obs_module mod = {0};
+	int errorcode;
+
+	if (!module || !path || !obs)
+		return MODULE_ERROR;
+
+	errorcode = open_module(&mod, path, data_path);
+	if (errorcode != MODULE_SUCCESS)
+		return errorcode;
 
 	*module = bmemdup(&mod, sizeof(mod));
+	(*module)->next = obs->first_module;
 	obs->first_module = (*module);
-	mod.set_pointer(*module);
-
-	if (mod.set_locale)
-		mod.set_locale(obs->locale);
+	set_module_pointer(*module);
 
 	return MODULE_SUCCESS;
 }
@@ -490,86 +522,402 @@ bool obs_get_module_allow_disable(const char *name)
 	return !is_core_module(name);
 }
 
-static void load_all_callback(void *param, const struct obs_module_info2 *info)
+/* ------------------------------------------------------------------------- */
+/* Module manifest cache */
+
+/*
+ * The manifest cache records, for every module binary that was found, its
+ * modification time and size, whether it is an OBS plugin, and the types it
+ * registered the last time it was loaded.  This allows listing what modules
+ * provide without opening them, and skips the plugin check on startup for
+ * unchanged binaries.
+ */
+
+static bool get_module_stamp(const char *path, int64_t *mtime, int64_t *size)
 {
-	struct fail_info *fail_info = param;
-	obs_module_t *module;
-	obs_module_t *disabled_module;
+	struct stat st;
+
+	if (os_stat(path, &st) != 0)
+		return false;
+
+	*mtime = (int64_t)st.st_mtime;
+	*size = (int64_t)st.st_size;
+	return true;
+}
+
+/* returns the manifest entry of a module binary if it is still valid */
+static obs_data_t *get_manifest_entry(const char *bin_path)
+{
+	obs_data_t *modules;
+	obs_data_t *entry;
+	int64_t mtime, size;
+
+	if (!obs->module_manifest || !get_module_stamp(bin_path, &mtime, &size))
+		return NULL;
+
+	modules = obs_data_get_obj(obs->module_manifest, "modules");
+	entry = obs_data_get_obj(modules, bin_path);
+	obs_data_release(modules);
+
+	if (entry && (obs_data_get_int(entry, "mtime") != mtime || obs_data_get_int(entry, "size") != size)) {
+		obs_data_release(entry);
+		entry = NULL;
+	}
+
+	return entry;
+}
+
+static void set_manifest_types(obs_data_t *entry, const char *name, const char *const *types, size_t count)
+{
+	obs_data_array_t *array = obs_data_array_create();
+
+	for (size_t i = 0; i < count; i++) {
+		obs_data_t *item = obs_data_create();
+		obs_data_set_string(item, "id", types[i]);
+		obs_data_array_push_back(array, item);
+		obs_data_release(item);
+	}
+
+	obs_data_set_array(entry, name, array);
+	obs_data_array_release(array);
+}
+
+static const char *manifest_type_names[] = {"sources", "outputs", "encoders", "services"};
+
+static void copy_manifest_types(obs_data_t *entry, obs_data_t *old_entry)
+{
+	for (size_t i = 0; i < OBS_COUNTOF(manifest_type_names); i++) {
+		obs_data_array_t *array = obs_data_get_array(old_entry, manifest_type_names[i]);
+		if (array)
+			obs_data_set_array(entry, manifest_type_names[i], array);
+		obs_data_array_release(array);
+	}
+}
+
+void obs_set_module_manifest_cache(const char *path)
+{
+	if (!obs)
+		return;
+
+	obs_data_release(obs->module_manifest);
+	bfree(obs->module_manifest_path);
+	obs->module_manifest = NULL;
+	obs->module_manifest_path = NULL;
+
+	if (!path)
+		return;
+
+	obs->module_manifest_path = bstrdup(path);
+	if (os_file_exists(path))
+		obs->module_manifest = obs_data_create_from_json_file_safe(path, "bak");
+	if (!obs->module_manifest)
+		obs->module_manifest = obs_data_create();
+}
+
+struct find_manifests_data {
+	obs_find_module_manifest_callback_t callback;
+	void *param;
+};
+
+static void find_manifests_callback(void *param, const struct obs_module_info2 *info)
+{
+	struct obs_module_manifest manifest = {0};
+	DARRAY(const char *) types[OBS_COUNTOF(manifest_type_names)] = {0};
+	struct find_manifests_data *data = param;
+	const char *end = NULL;
+	obs_data_t *entry = get_manifest_entry(info->bin_path);
+
+	if (!entry)
+		return;
+	if (!obs_data_get_bool(entry, "obs_plugin")) {
+		obs_data_release(entry);
+		return;
+	}
+
+	for (size_t i = 0; i < OBS_COUNTOF(manifest_type_names); i++) {
+		obs_data_array_t *array = obs_data_get_array(entry, manifest_type_names[i]);
+		size_t count = obs_data_array_count(array);
+
+		for (size_t j = 0; j < count; j++) {
+			obs_data_t *item = obs_data_array_item(array, j);
+			const char *id = obs_data_get_string(item, "id");
+			da_push_back(types[i], &id);
+			obs_data_release(item);
+		}
+
+		/* item strings stay valid while the entry holds the array */
+		obs_data_array_release(array);
+		da_push_back(types[i], &end);
+	}
+
+	manifest.bin_path = info->bin_path;
+	manifest.data_path = info->data_path;
+	manifest.name = info->name;
+	manifest.sources = types[0].array;
+	manifest.outputs = types[1].array;
+	manifest.encoders = types[2].array;
+	manifest.services = types[3].array;
+
+	data->callback(data->param, &manifest);
+
+	for (size_t i = 0; i < OBS_COUNTOF(manifest_type_names); i++)
+		da_free(types[i]);
+	obs_data_release(entry);
+}
+
+void obs_find_module_manifests(obs_find_module_manifest_callback_t callback, void *param)
+{
+	struct find_manifests_data data = {callback, param};
+
+	if (!obs || !callback)
+		return;
+
+	obs_find_modules2(find_manifests_callback, &data);
+}
+
+/* ------------------------------------------------------------------------- */
+/* Loading all modules */
+
+/*
+ * Modules are found first, then opened in parallel on the thread pool
+ * (plugin check, dlopen, metadata and locale), and finally initialized in
+ * the order they were found on the calling thread, as obs_module_load()
+ * registers types and plugins expect it to be called on the main thread.
+ */
+
+struct module_load_job {
+	char *bin_path;
+	char *data_path;
+	char *name;
+
+	/* OBS_MODULE_ENABLED if the module is to be opened */
+	enum obs_module_load_state state;
+	obs_data_t *manifest_entry;
 
 	bool is_obs_plugin;
+	int code;
+	obs_module_t *module;
+};
+
+typedef DARRAY(struct module_load_job) module_load_job_array_t;
+
+static void find_all_callback(void *param, const struct obs_module_info2 *info)
+{
+	module_load_job_array_t *jobs = param;
+	struct module_load_job *job = da_push_back_new(*jobs);
+
+	job->bin_path = bstrdup(info->bin_path);
+	job->data_path = bstrdup(info->data_path);
+	job->name = bstrdup(info->name);
+
+	if (!is_safe_module(info->name))
+		job->state = OBS_MODULE_DISABLED_SAFE;
+	else if (is_disabled_module(info->name))
+		job->state = OBS_MODULE_DISABLED;
+	else
+		job->state = OBS_MODULE_ENABLED;
+
+	job->manifest_entry = get_manifest_entry(info->bin_path);
+}
+
+static const char *get_plugin_info_name = "get_plugin_info";
+
+static void open_module_task(void *param)
+{
+	struct module_load_job *job = param;
+	const char *profile_name =
+		profile_store_name(obs_get_profiler_name_store(), "obs_open_module(%s)", job->name);
+	struct obs_module mod = {0};
+
+	profile_start(profile_name);
+
+	if (job->manifest_entry) {
+		job->is_obs_plugin = obs_data_get_bool(job->manifest_entry, "obs_plugin");
+	} else {
+		profile_start(get_plugin_info_name);
+		get_plugin_info(job->bin_path, &job->is_obs_plugin);
+		profile_end(get_plugin_info_name);
+	}
 
-	get_plugin_info(info->bin_path, &is_obs_plugin);
+	if (job->is_obs_plugin && job->state == OBS_MODULE_ENABLED) {
+		job->code = open_module(&mod, job->bin_path, job->data_path);
+		if (job->code == MODULE_SUCCESS) {
+			job->module = bmemdup(&mod, sizeof(mod));
+			set_module_pointer(job->module);
+		}
+	}
+
+	profile_end(profile_name);
+}
 
-	if (!is_obs_plugin) {
-		blog(LOG_WARNING, "Skipping module '%s', not an OBS plugin", info->bin_path);
+static void load_module_job(struct module_load_job *job, struct fail_info *fail_info)
+{
+	obs_module_t *disabled_module;
+
+	if (!job->is_obs_plugin) {
+		blog(LOG_WARNING, "Skipping module '%s', not an OBS plugin", job->bin_path);
 		return;
 	}
 
-	if (!is_safe_module(info->name)) {
-		obs_create_disabled_module(&disabled_module, info->bin_path, info->data_path, OBS_MODULE_DISABLED_SAFE);
-		blog(LOG_WARNING, "Skipping module '%s', not on safe list", info->name);
+	if (job->state == OBS_MODULE_DISABLED_SAFE) {
+		obs_create_disabled_module(&disabled_module, job->bin_path, job->data_path, OBS_MODULE_DISABLED_SAFE);
+		blog(LOG_WARNING, "Skipping module '%s', not on safe list", job->name);
 		return;
 	}
 
-	if (is_disabled_module(info->name)) {
-		obs_create_disabled_module(&disabled_module, info->bin_path, info->data_path, OBS_MODULE_DISABLED);
-		blog(LOG_WARNING, "Skipping module '%s', is disabled", info->name);
+	if (job->state == OBS_MODULE_DISABLED) {
+		obs_create_disabled_module(&disabled_module, job->bin_path, job->data_path, OBS_MODULE_DISABLED);
+		blog(LOG_WARNING, "Skipping module '%s', is disabled", job->name);
 		return;
 	}
 
-	int code = obs_open_module(&module, info->bin_path, info->data_path);
-	switch (code) {
+	switch (job->code) {
 	case MODULE_MISSING_EXPORTS:
-		blog(LOG_DEBUG, "Failed to load module file '%s', not an OBS plugin", info->bin_path);
+		blog(LOG_DEBUG, "Failed to load module file '%s', not an OBS plugin", job->bin_path);
 		return;
 	case MODULE_FAILED_TO_OPEN:
-		blog(LOG_DEBUG, "Failed to load module file '%s', module failed to open", info->bin_path);
-		obs_create_disabled_module(&disabled_module, info->bin_path, info->data_path,
-					   OBS_MODULE_FAILED_TO_OPEN);
+		blog(LOG_DEBUG, "Failed to load module file '%s', module failed to open", job->bin_path);
+		obs_create_disabled_module(&disabled_module, job->bin_path, job->data_path, OBS_MODULE_FAILED_TO_OPEN);
 		goto load_failure;
 	case MODULE_ERROR:
-		blog(LOG_DEBUG, "Failed to load module file '%s' (unknown error)", info->bin_path);
+		blog(LOG_DEBUG, "Failed to load module file '%s' (unknown error)", job->bin_path);
 		goto load_failure;
 	case MODULE_INCOMPATIBLE_VER:
-		blog(LOG_DEBUG, "Failed to load module file '%s', incompatible version", info->bin_path);
-		obs_create_disabled_module(&disabled_module, info->bin_path, info->data_path,
-					   OBS_MODULE_FAILED_TO_OPEN);
+		blog(LOG_DEBUG, "Failed to load module file '%s', incompatible version", job->bin_path);
+		obs_create_disabled_module(&disabled_module, job->bin_path, job->data_path, OBS_MODULE_FAILED_TO_OPEN);
 		goto load_failure;
 	case MODULE_HARDCODED_SKIP:
 		return;
 	}
 
-	if (!obs_init_module(module)) {
-		free_module(module);
-		obs_create_disabled_module(&disabled_module, info->bin_path, info->data_path,
+	job->module->next = obs->first_module;
+	obs->first_module = job->module;
+
+	if (!obs_init_module(job->module)) {
+		free_module(job->module);
+		job->module = NULL;
+		obs_create_disabled_module(&disabled_module, job->bin_path, job->data_path,
 					   OBS_MODULE_FAILED_TO_INITIALIZE);
 	}
 
-	UNUSED_PARAMETER(param);
 	return;
 
 load_failure:
 	if (fail_info) {
-		dstr_cat(&fail_info->fail_modules, info->name);
+		dstr_cat(&fail_info->fail_modules, job->name);
 		dstr_cat(&fail_info->fail_modules, ";");
 		fail_info->fail_count++;
 	}
 }
 
-static const char *obs_load_all_modules_name = "obs_load_all_modules";
+static void save_module_manifest(module_load_job_array_t *jobs)
+{
+	obs_data_t *modules = obs_data_create();
+	int64_t mtime, size;
+
+	for (size_t i = 0; i < jobs->num; i++) {
+		struct module_load_job *job = jobs->array + i;
+		obs_data_t *entry;
+
+		if (!get_module_stamp(job->bin_path, &mtime, &size))
+			continue;
+
+		entry = obs_data_create();
+		obs_data_set_int(entry, "mtime", mtime);
+		obs_data_set_int(entry, "size", size);
+		obs_data_set_bool(entry, "obs_plugin", job->is_obs_plugin);
+
+		/* types of modules that were not loaded this time are kept from
+		 * the last time they were */
+		if (job->module) {
+			obs_module_t *mod = job->module;
+			set_manifest_types(entry, "sources", (const char *const *)mod->sources.array,
+					   mod->sources.num);
+			set_manifest_types(entry, "outputs", (const char *const *)mod->outputs.array,
+					   mod->outputs.num);
+			set_manifest_types(entry, "encoders", (const char *const *)mod->encoders.array,
+					   mod->encoders.num);
+			set_manifest_types(entry, "services", (const char *const *)mod->services.array,
+					   mod->services.num);
+		} else if (job->manifest_entry) {
+			copy_manifest_types(entry, job->manifest_entry);
+		}
+
+		obs_data_set_obj(modules, job->bin_path, entry);
+		obs_data_release(entry);
+	}
+
+	obs_data_set_obj(obs->module_manifest, "modules", modules);
+	obs_data_release(modules);
+
+	if (!obs_data_save_json_safe(obs->module_manifest, obs->module_manifest_path, "tmp", "bak"))
+		blog(LOG_WARNING, "Failed to save module manifest cache '%s'", obs->module_manifest_path);
+}
+
+static const char *find_modules_name = "obs_find_modules";
+static const char *open_modules_name = "open_modules";
+static const char *init_modules_name = "init_modules";
 #ifdef _WIN32
 static const char *reset_win32_symbol_paths_name = "reset_win32_symbol_paths";
 #endif
 
-void obs_load_all_modules(void)
+static void load_all_modules(struct fail_info *fail_info)
 {
-	profile_start(obs_load_all_modules_name);
-	obs_find_modules2(load_all_callback, NULL);
+	module_load_job_array_t jobs = {0};
+
+	profile_start(find_modules_name);
+	obs_find_modules2(find_all_callback, &jobs);
+	profile_end(find_modules_name);
+
+	profile_start(open_modules_name);
+	if (obs->thread_pool) {
+		os_task_group_t *group = os_task_group_create(obs->thread_pool);
+
+		/* if a job can't be queued, open the module right here instead
+		 * of leaving it unopened */
+		for (size_t i = 0; i < jobs.num; i++) {
+			if (!os_thread_pool_queue(obs->thread_pool, OS_TASK_PRIORITY_NORMAL, group, open_module_task,
+						  jobs.array + i))
+				open_module_task(jobs.array + i);
+		}
+
+		os_task_group_destroy(group);
+	} else {
+		for (size_t i = 0; i < jobs.num; i++)
+			open_module_task(jobs.array + i);
+	}
+	profile_end(open_modules_name);
+
+	profile_start(init_modules_name);
+	for (size_t i = 0; i < jobs.num; i++)
+		load_module_job(jobs.array + i, fail_info);
+	profile_end(init_modules_name);
+
 #ifdef _WIN32
 	profile_start(reset_win32_symbol_paths_name);
 	reset_win32_symbol_paths();
 	profile_end(reset_win32_symbol_paths_name);
 #endif
+
+	if (obs->module_manifest_path)
+		save_module_manifest(&jobs);
+
+	for (size_t i = 0; i < jobs.num; i++) {
+		struct module_load_job *job = jobs.array + i;
+		obs_data_release(job->manifest_entry);
+		bfree(job->bin_path);
+		bfree(job->data_path);
+		bfree(job->name);
+	}
+	da_free(jobs);
+}
+
+static const char *obs_load_all_modules_name = "obs_load_all_modules";
+
+void obs_load_all_modules(void)
+{
+	profile_start(obs_load_all_modules_name);
+	load_all_modules(NULL);
 	profile_end(obs_load_all_modules_name);
 }
 
@@ -581,12 +929,7 @@ void obs_load_all_modules2(struct obs_module_failure_info *mfi)
 	memset(mfi, 0, sizeof(*mfi));
 
 	profile_start(obs_load_all_modules2_name);
-	obs_find_modules2(load_all_callback, &fail_info);
-#ifdef _WIN32
-	profile_start(reset_win32_symbol_paths_name);
-	reset_win32_symbol_paths();
-	profile_end(reset_win32_symbol_paths_name);
-#endif
+	load_all_modules(&fail_info);
 	profile_end(obs_load_all_modules2_name);
 
 	mfi->count = fail_info.fail_count;
@@ -16,6 +16,21 @@
 ******************************************************************************/
 
 #include "obs-nal.h"
+#include "util/platform.h"
+#include "util/threading.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#if !defined(_M_ARM64EC)
+#define NAL_AVX2
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define AVX2_FUNC
+#else
+#define AVX2_FUNC __attribute__((target("avx2")))
+#endif
+#endif
+#endif
 
 /* NOTE: I noticed that FFmpeg does some unusual special handling of certain
  * scenarios that I was unaware of, so instead of just searching for {0, 0, 1}
@@ -57,10 +72,99 @@ static const uint8_t *ff_avc_find_startcode_internal(const uint8_t *p, const uin
 	return end + 3;
 }
 
+/* AVX2 version of ff_avc_find_startcode_internal, selected at runtime.  this
+ * checks 32 positions at a time and leaves the last few bytes to the scalar
+ * loop, returning the same position in all cases. */
+
+#ifdef NAL_AVX2
+
+static inline unsigned int lowest_bit(uint32_t mask)
+{
+#ifdef _MSC_VER
+	unsigned long idx;
+	_BitScanForward(&idx, mask);
+	return (unsigned int)idx;
+#else
+	return (unsigned int)__builtin_ctz(mask);
+#endif
+}
+
+static AVX2_FUNC const uint8_t *find_startcode_avx2(const uint8_t *p, const uint8_t *end)
+{
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i one = _mm256_set1_epi8(1);
+
+	/* the scalar version only reports start codes that begin more than
+	 * three bytes before the end, the loads here read up to p + 33 */
+	while (end - p >= 35) {
+		__m256i b0 = _mm256_loadu_si256((const __m256i *)p);
+		__m256i b1 = _mm256_loadu_si256((const __m256i *)(p + 1));
+		__m256i b2 = _mm256_loadu_si256((const __m256i *)(p + 2));
+
+		__m256i match = _mm256_and_si256(_mm256_cmpeq_epi8(b0, zero), _mm256_cmpeq_epi8(b1, zero));
+		match = _mm256_and_si256(match, _mm256_cmpeq_epi8(b2, one));
+
+		uint32_t mask = (uint32_t)_mm256_movemask_epi8(match);
+		if (mask)
+			return p + lowest_bit(mask);
+
+		p += 32;
+	}
+
+	for (; end - p > 3; p++) {
+		if (p[0] == 0 && p[1] == 0 && p[2] == 1)
+			return p;
+	}
+
+	return end;
+}
+
+#endif
+
+typedef const uint8_t *(*find_startcode_func)(const uint8_t *p, const uint8_t *end);
+static find_startcode_func find_startcode = ff_avc_find_startcode_internal;
+static pthread_once_t find_startcode_once = PTHREAD_ONCE_INIT;
+
+static void init_find_startcode(void)
+{
+#ifdef NAL_AVX2
+	if (os_cpu_has_avx2())
+		find_startcode = find_startcode_avx2;
+#endif
+}
+
 const uint8_t *obs_nal_find_startcode(const uint8_t *p, const uint8_t *end)
 {
-	const uint8_t *out = ff_avc_find_startcode_internal(p, end);
+	pthread_once(&find_startcode_once, init_find_startcode);
+
+	const uint8_t *out = find_startcode(p, end);
 	if (p < out && out < end && !out[-1])
 		out--;
 	return out;
 }
+
+size_t obs_nal_find_units(const uint8_t *data, size_t size, struct obs_nal_unit *units, size_t max_units)
+{
+	const uint8_t *const end = data + size;
+	const uint8_t *nal_start = obs_nal_find_startcode(data, end);
+	size_t num = 0;
+
+	while (true) {
+		while (nal_start < end && !*(nal_start++))
+			;
+
+		if (nal_start == end)
+			break;
+
+		const uint8_t *const nal_end = obs_nal_find_startcode(nal_start, end);
+		if (num < max_units) {
+			units[num].offset = (uint32_t)(nal_start - data);
+			units[num].size = (uint32_t)(nal_end - nal_start);
+		}
+
+		num++;
+		nal_start = nal_end;
+	}
+
+	return num;
+}
@@ -30,8 +30,19 @@ enum {
 	OBS_NAL_PRIORITY_HIGHEST = 3,
 };
 
+/* NAL unit of an Annex-B buffer, offset is that of its header, right after
+ * the start code */
+struct obs_nal_unit {
+	uint32_t offset;
+	uint32_t size;
+};
+
 EXPORT const uint8_t *obs_nal_find_startcode(const uint8_t *p, const uint8_t *end);
 
+/* Fills up to max_units entries of units with the NAL units of an Annex-B
+ * buffer, returns the number of NAL units in it, which may be larger */
+EXPORT size_t obs_nal_find_units(const uint8_t *data, size_t size, struct obs_nal_unit *units, size_t max_units);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,141 @@
+#pragma once
+
+#include "util/deque.h"
+#include "obs.h"
+
+/*
+ * Encoded packets waiting to be interleaved are kept in one FIFO per track,
+ * video tracks first.  Every FIFO is sorted by dts_usec, so the next packet
+ * in interleaved order is the lowest head across all tracks, with the track
+ * order breaking ties (video before audio, lower track index first).
+ *
+ * Walking the merged order without consuming it is done with an iterator
+ * holding one read position per track.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define INTERLEAVE_TRACKS (MAX_OUTPUT_VIDEO_ENCODERS + MAX_OUTPUT_AUDIO_ENCODERS)
+
+struct interleave_queue {
+	struct deque tracks[INTERLEAVE_TRACKS];
+	size_t num;
+};
+
+struct interleave_iter {
+	size_t pos[INTERLEAVE_TRACKS];
+	size_t idx;
+};
+
+static inline size_t interleave_track(const struct encoder_packet *packet)
+{
+	return packet->type == OBS_ENCODER_VIDEO ? packet->track_idx : MAX_OUTPUT_VIDEO_ENCODERS + packet->track_idx;
+}
+
+static inline size_t interleave_track_size(const struct interleave_queue *queue, size_t track)
+{
+	return queue->tracks[track].size / sizeof(struct encoder_packet);
+}
+
+/* packets are only ever pushed and popped whole, so the deque capacity stays
+ * a multiple of the packet size and a packet never wraps around its end */
+static inline struct encoder_packet *interleave_track_get(struct interleave_queue *queue, size_t track, size_t idx)
+{
+	return (struct encoder_packet *)deque_data(&queue->tracks[track], idx * sizeof(struct encoder_packet));
+}
+
+static inline struct encoder_packet *interleave_track_first(struct interleave_queue *queue, size_t track)
+{
+	return interleave_track_get(queue, track, 0);
+}
+
+static inline struct encoder_packet *interleave_track_last(struct interleave_queue *queue, size_t track)
+{
+	size_t size = interleave_track_size(queue, track);
+	return size ? interleave_track_get(queue, track, size - 1) : NULL;
+}
+
+static inline void interleave_push(struct interleave_queue *queue, const struct encoder_packet *packet)
+{
+	size_t track = interleave_track(packet);
+	size_t size = interleave_track_size(queue, track);
+	size_t idx = size;
+
+	/* encoders emit packets in dts order, so this practically always
+	 * appends; anything else shifts the tail of its own track only */
+	while (idx > 0 && interleave_track_get(queue, track, idx - 1)->dts_usec > packet->dts_usec)
+		idx--;
+
+	deque_push_back(&queue->tracks[track], packet, sizeof(*packet));
+	for (size_t i = size; i > idx; i--)
+		*interleave_track_get(queue, track, i) = *interleave_track_get(queue, track, i - 1);
+	if (idx != size)
+		*interleave_track_get(queue, track, idx) = *packet;
+
+	queue->num++;
+}
+
+static inline void interleave_iter_init(struct interleave_iter *iter)
+{
+	memset(iter, 0, sizeof(*iter));
+}
+
+static inline struct encoder_packet *interleave_iter_peek(struct interleave_queue *queue,
+							  const struct interleave_iter *iter, size_t *track)
+{
+	struct encoder_packet *best = NULL;
+
+	for (size_t i = 0; i < INTERLEAVE_TRACKS; i++) {
+		struct encoder_packet *packet = interleave_track_get(queue, i, iter->pos[i]);
+
+		if (packet && (!best || packet->dts_usec < best->dts_usec)) {
+			best = packet;
+			*track = i;
+		}
+	}
+
+	return best;
+}
+
+/* returns the packet at iter->idx in interleaved order and advances */
+static inline struct encoder_packet *interleave_iter_next(struct interleave_queue *queue,
+							  struct interleave_iter *iter)
+{
+	size_t track = 0;
+	struct encoder_packet *packet = interleave_iter_peek(queue, iter, &track);
+
+	if (packet) {
+		iter->pos[track]++;
+		iter->idx++;
+	}
+
+	return packet;
+}
+
+static inline bool interleave_pop_front(struct interleave_queue *queue, struct encoder_packet *packet)
+{
+	struct interleave_iter iter;
+	size_t track;
+
+	interleave_iter_init(&iter);
+	if (!interleave_iter_peek(queue, &iter, &track))
+		return false;
+
+	deque_pop_front(&queue->tracks[track], packet, sizeof(*packet));
+	queue->num--;
+	return true;
+}
+
+/* the caller is expected to have released all packets */
+static inline void interleave_free(struct interleave_queue *queue)
+{
+	for (size_t i = 0; i < INTERLEAVE_TRACKS; i++)
+		deque_free(&queue->tracks[i]);
+	queue->num = 0;
+}
+
+#ifdef __cplusplus
+}
+#endif
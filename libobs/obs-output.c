@@ -215,6 +215,9 @@ obs_output_t *obs_output_create(const char *id, const char *name, obs_data_t *se
 		goto fail;
 	if (os_event_init(&output->stopping_event, OS_EVENT_TYPE_MANUAL) != 0)
 		goto fail;
+	output->end_data_capture_task = os_task_group_create(obs->thread_pool);
+	if (!output->end_data_capture_task)
+		goto fail;
 	if (!init_output_handlers(output, name, settings, hotkey_data))
 		goto fail;
 
@@ -262,9 +265,11 @@ fail:
 
 static inline void free_packets(struct obs_output *output)
 {
-	for (size_t i = 0; i < output->interleaved_packets.num; i++)
-		obs_encoder_packet_release(output->interleaved_packets.array + i);
-	da_free(output->interleaved_packets);
+	struct encoder_packet packet;
+
+	while (interleave_pop_front(&output->interleaved_packets, &packet))
+		obs_encoder_packet_release(&packet);
+	interleave_free(&output->interleaved_packets);
 }
 
 static inline void clear_raw_audio_buffers(obs_output_t *output)
@@ -299,8 +304,7 @@ void obs_output_destroy(obs_output_t *output)
 			obs_output_actual_stop(output, true, 0);
 
 		os_event_wait(output->stopping_event);
-		if (data_capture_ending(output))
-			pthread_join(output->end_data_capture_thread, NULL);
+		os_task_group_destroy(output->end_data_capture_task);
 
 		if (output->service)
 			output->service->output = NULL;
@@ -1668,11 +1672,38 @@ static bool add_caption(struct obs_output *output, struct encoder_packet *out)
 		if (data) {
 			bfree(data);
 		}
+
+		const size_t out_size = out_data.num - sizeof(ref);
+		const struct obs_nal_unit *units = NULL;
+		size_t num_units = 0;
+
+		/* keep the NAL unit index of the packet, with the SEI as one
+		 * more unit, so the output doesn't have to scan it again */
+		if (avc || hevc)
+			units = obs_encoder_packet_get_nal_units(out, &num_units);
+		if (units) {
+			struct obs_nal_unit sei_unit;
+			uint32_t count = (uint32_t)num_units;
+
+			sei_unit.offset = (uint32_t)(out->size + (avc ? 4 : 3));
+			sei_unit.size = (uint32_t)(out_size - sei_unit.offset);
+			if (sei_unit.size)
+				count++;
+
+			da_resize(out_data, sizeof(ref) + obs_nal_index_offset(out_size));
+			da_push_back_array(out_data, (uint8_t *)&count, sizeof(count));
+			da_push_back_array(out_data, (uint8_t *)units, num_units * sizeof(*units));
+			if (sei_unit.size)
+				da_push_back_array(out_data, (uint8_t *)&sei_unit, sizeof(sei_unit));
+
+			*(long *)out_data.array |= OBS_PACKET_NAL_INDEX_FLAG;
+		}
+
 		obs_encoder_packet_release(out);
 
 		*out = backup;
 		out->data = (uint8_t *)out_data.array + sizeof(ref);
-		out->size = out_data.num - sizeof(ref);
+		out->size = out_size;
 	}
 	sei_free(&sei);
 	return avc || hevc || av1;
@@ -1680,11 +1711,11 @@ static bool add_caption(struct obs_output *output, struct encoder_packet *out)
 
 static inline void send_interleaved(struct obs_output *output)
 {
-	struct encoder_packet out = output->interleaved_packets.array[0];
+	struct encoder_packet out;
 	struct encoder_packet_time ept_local = {0};
 	bool found_ept = false;
 
-	da_erase(output->interleaved_packets, 0);
+	interleave_pop_front(&output->interleaved_packets, &out);
 
 	if (out.type == OBS_ENCODER_VIDEO) {
 		output->total_frames++;
@@ -1777,11 +1808,15 @@ static size_t get_interleaved_start_idx(struct obs_output *output)
 {
 	int64_t closest_diff = 0x7FFFFFFFFFFFFFFFLL;
 	struct encoder_packet *first_video = find_first_packet_type(output, OBS_ENCODER_VIDEO, 0);
+	struct encoder_packet *closest_audio = NULL;
+	struct encoder_packet *packet;
+	struct interleave_iter iter;
 	size_t video_idx = DARRAY_INVALID;
 	size_t idx = 0;
 
-	for (size_t i = 0; i < output->interleaved_packets.num; i++) {
-		struct encoder_packet *packet = &output->interleaved_packets.array[i];
+	interleave_iter_init(&iter);
+	while ((packet = interleave_iter_next(&output->interleaved_packets, &iter)) != NULL) {
+		size_t i = iter.idx - 1;
 		int64_t diff;
 
 		if (packet->type != OBS_ENCODER_AUDIO) {
@@ -1793,19 +1828,28 @@ static size_t get_interleaved_start_idx(struct obs_output *output)
 		diff = llabs(packet->dts_usec - first_video->dts_usec);
 		if (diff < closest_diff) {
 			closest_diff = diff;
+			closest_audio = packet;
 			idx = i;
 		}
 	}
 
-	idx = video_idx < idx ? video_idx : idx;
-
 	/* Early AAC/Opus audio packets will be for "priming" the encoder and contain silence, but they should not be
 	 * discarded. Set the idx to the first audio packet if closest PTS was <= 0. */
-	size_t first_audio_idx = idx;
-	while (output->interleaved_packets.array[first_audio_idx].type != OBS_ENCODER_AUDIO)
-		first_audio_idx++;
+	struct encoder_packet *first_audio = closest_audio;
 
-	if (output->interleaved_packets.array[first_audio_idx].pts <= 0) {
+	if (video_idx < idx) {
+		idx = video_idx;
+
+		interleave_iter_init(&iter);
+		while ((packet = interleave_iter_next(&output->interleaved_packets, &iter)) != NULL) {
+			if (iter.idx > idx && packet->type == OBS_ENCODER_AUDIO) {
+				first_audio = packet;
+				break;
+			}
+		}
+	}
+
+	if (first_audio && first_audio->pts <= 0) {
 		for (size_t i = 0; i < MAX_OUTPUT_AUDIO_ENCODERS; i++) {
 			int audio_idx = find_first_packet_type_idx(output, OBS_ENCODER_AUDIO, i);
 			if (audio_idx >= 0 && (size_t)audio_idx < idx)
@@ -1836,7 +1880,7 @@ static int prune_premature_packets(struct obs_output *output)
 		return -1;
 
 	max_idx = video_idx;
-	video = &output->interleaved_packets.array[video_idx];
+	video = find_first_packet_type(output, OBS_ENCODER_VIDEO, 0);
 	duration_usec = video->timebase_num * 1000000LL / video->timebase_den;
 
 	for (size_t i = 0; i < MAX_OUTPUT_AUDIO_ENCODERS; i++) {
@@ -1854,7 +1898,7 @@ static int prune_premature_packets(struct obs_output *output)
 			return -1;
 		}
 
-		audio = &output->interleaved_packets.array[audio_idx];
+		audio = find_first_packet_type(output, OBS_ENCODER_AUDIO, i);
 		if (audio_idx > max_idx)
 			max_idx = audio_idx;
 
@@ -1884,19 +1928,20 @@ static int prune_premature_packets(struct obs_output *output)
 
 static void discard_to_idx(struct obs_output *output, size_t idx)
 {
+	struct encoder_packet packet;
+
 	for (size_t i = 0; i < idx; i++) {
-		struct encoder_packet *packet = &output->interleaved_packets.array[i];
+		if (!interleave_pop_front(&output->interleaved_packets, &packet))
+			break;
 #if DEBUG_STARTING_PACKETS == 1
 		blog(LOG_DEBUG, "discarding %s packet, dts: %lld, pts: %lld",
-		     packet->type == OBS_ENCODER_VIDEO ? "video" : "audio", packet->dts, packet->pts);
+		     packet.type == OBS_ENCODER_VIDEO ? "video" : "audio", packet.dts, packet.pts);
 #endif
-		if (packet->type == OBS_ENCODER_VIDEO) {
-			da_pop_front(output->encoder_packet_times[packet->track_idx]);
+		if (packet.type == OBS_ENCODER_VIDEO) {
+			da_pop_front(output->encoder_packet_times[packet.track_idx]);
 		}
-		obs_encoder_packet_release(packet);
+		obs_encoder_packet_release(&packet);
 	}
-
-	da_erase_range(output->interleaved_packets, 0, idx);
 }
 
 static bool prune_interleaved_packets(struct obs_output *output)
@@ -1905,12 +1950,15 @@ static bool prune_interleaved_packets(struct obs_output *output)
 	int prune_start = prune_premature_packets(output);
 
 #if DEBUG_STARTING_PACKETS == 1
+	struct encoder_packet *packet;
+	struct interleave_iter iter;
+
 	blog(LOG_DEBUG, "--------- Pruning! %d ---------", prune_start);
-	for (size_t i = 0; i < output->interleaved_packets.num; i++) {
-		struct encoder_packet *packet = &output->interleaved_packets.array[i];
+	interleave_iter_init(&iter);
+	while ((packet = interleave_iter_next(&output->interleaved_packets, &iter)) != NULL) {
 		blog(LOG_DEBUG, "packet: %s %d, ts: %lld, pruned = %s",
 		     packet->type == OBS_ENCODER_AUDIO ? "audio" : "video", (int)packet->track_idx, packet->dts_usec,
-		     (int)i < prune_start ? "true" : "false");
+		     (int)iter.idx - 1 < prune_start ? "true" : "false");
 	}
 #endif
 
@@ -1928,25 +1976,25 @@ static bool prune_interleaved_packets(struct obs_output *output)
 	return true;
 }
 
-static int find_first_packet_type_idx(struct obs_output *output, enum obs_encoder_type type, size_t idx)
+static inline size_t packet_type_track(enum obs_encoder_type type, size_t idx)
 {
-	for (size_t i = 0; i < output->interleaved_packets.num; i++) {
-		struct encoder_packet *packet = &output->interleaved_packets.array[i];
-
-		if (packet->type == type && packet->track_idx == idx)
-			return (int)i;
-	}
-
-	return -1;
+	return type == OBS_ENCODER_VIDEO ? idx : MAX_OUTPUT_VIDEO_ENCODERS + idx;
 }
 
-static int find_last_packet_type_idx(struct obs_output *output, enum obs_encoder_type type, size_t idx)
+/* returns the position of the first packet of a track in interleaved order */
+static int find_first_packet_type_idx(struct obs_output *output, enum obs_encoder_type type, size_t idx)
 {
-	for (size_t i = output->interleaved_packets.num; i > 0; i--) {
-		struct encoder_packet *packet = &output->interleaved_packets.array[i - 1];
+	struct encoder_packet *first = find_first_packet_type(output, type, idx);
+	struct encoder_packet *packet;
+	struct interleave_iter iter;
 
-		if (packet->type == type && packet->track_idx == idx)
-			return (int)(i - 1);
+	if (!first)
+		return -1;
+
+	interleave_iter_init(&iter);
+	while ((packet = interleave_iter_next(&output->interleaved_packets, &iter)) != NULL) {
+		if (packet == first)
+			return (int)(iter.idx - 1);
 	}
 
 	return -1;
@@ -1955,15 +2003,13 @@ static int find_last_packet_type_idx(struct obs_output *output, enum obs_encoder
 static inline struct encoder_packet *find_first_packet_type(struct obs_output *output, enum obs_encoder_type type,
 							    size_t audio_idx)
 {
-	int idx = find_first_packet_type_idx(output, type, audio_idx);
-	return (idx != -1) ? &output->interleaved_packets.array[idx] : NULL;
+	return interleave_track_first(&output->interleaved_packets, packet_type_track(type, audio_idx));
 }
 
 static inline struct encoder_packet *find_last_packet_type(struct obs_output *output, enum obs_encoder_type type,
 							   size_t audio_idx)
 {
-	int idx = find_last_packet_type_idx(output, type, audio_idx);
-	return (idx != -1) ? &output->interleaved_packets.array[idx] : NULL;
+	return interleave_track_last(&output->interleaved_packets, packet_type_track(type, audio_idx));
 }
 
 static bool get_audio_and_video_packets(struct obs_output *output, struct encoder_packet **video,
@@ -2061,68 +2107,54 @@ static bool initialize_interleaved_packets(struct obs_output *output)
 	/* subtract offsets from highest TS offset variables */
 	output->highest_audio_ts -= audio[first_audio_idx]->dts_usec;
 
-	/* apply new offsets to all existing packet DTS/PTS values */
-	for (size_t i = 0; i < output->interleaved_packets.num; i++) {
-		struct encoder_packet *packet = &output->interleaved_packets.array[i];
-		apply_interleaved_packet_offset(output, packet, NULL);
+	/* apply new offsets to all existing packet DTS/PTS values, the offset
+	 * is constant per track so every track stays sorted */
+	for (size_t i = 0; i < INTERLEAVE_TRACKS; i++) {
+		size_t size = interleave_track_size(&output->interleaved_packets, i);
+
+		for (size_t j = 0; j < size; j++) {
+			struct encoder_packet *packet = interleave_track_get(&output->interleaved_packets, i, j);
+			apply_interleaved_packet_offset(output, packet, NULL);
+		}
 	}
 
 	return true;
 }
 
+/* packets with the same DTS are ordered by track, so video comes before audio
+ * and video tracks stay in index order, which prevents the pruning logic from
+ * removing additional video tracks */
 static inline void insert_interleaved_packet(struct obs_output *output, struct encoder_packet *out)
 {
-	size_t idx;
-	for (idx = 0; idx < output->interleaved_packets.num; idx++) {
-		struct encoder_packet *cur_packet;
-		cur_packet = output->interleaved_packets.array + idx;
-
-		// sort video packets with same DTS by track index,
-		// to prevent the pruning logic from removing additional
-		// video tracks
-		if (out->dts_usec == cur_packet->dts_usec && out->type == OBS_ENCODER_VIDEO &&
-		    cur_packet->type == OBS_ENCODER_VIDEO && out->track_idx > cur_packet->track_idx)
-			continue;
-
-		if (out->dts_usec == cur_packet->dts_usec && out->type == OBS_ENCODER_VIDEO) {
-			break;
-		} else if (out->dts_usec < cur_packet->dts_usec) {
-			break;
-		}
-	}
-
-	da_insert(output->interleaved_packets, idx, out);
+	interleave_push(&output->interleaved_packets, out);
 }
 
+/* the merge order follows the new offsets by itself, only the highest
+ * timestamps need to be recalculated */
 static void resort_interleaved_packets(struct obs_output *output)
 {
-	DARRAY(struct encoder_packet) old_array;
-
-	old_array.da = output->interleaved_packets.da;
-	memset(&output->interleaved_packets, 0, sizeof(output->interleaved_packets));
-
-	for (size_t i = 0; i < old_array.num; i++) {
-		set_higher_ts(output, &old_array.array[i]);
-
-		insert_interleaved_packet(output, &old_array.array[i]);
+	for (size_t i = 0; i < INTERLEAVE_TRACKS; i++) {
+		struct encoder_packet *packet = interleave_track_last(&output->interleaved_packets, i);
+		if (packet)
+			set_higher_ts(output, packet);
 	}
-
-	da_free(old_array);
 }
 
 static void discard_unused_audio_packets(struct obs_output *output, int64_t dts_usec)
 {
-	size_t idx = 0;
-
-	for (; idx < output->interleaved_packets.num; idx++) {
-		struct encoder_packet *p = &output->interleaved_packets.array[idx];
+	struct encoder_packet *p;
+	struct interleave_iter iter;
 
-		if (p->dts_usec >= dts_usec)
+	interleave_iter_init(&iter);
+	while ((p = interleave_iter_next(&output->interleaved_packets, &iter)) != NULL) {
+		if (p->dts_usec >= dts_usec) {
+			iter.idx--;
 			break;
+		}
 	}
 
-	if (idx)
-		discard_to_idx(output, idx);
+	if (iter.idx)
+		discard_to_idx(output, iter.idx);
 }
 
 static bool purge_encoder_group_keyframe_data(obs_output_t *output, size_t idx)
@@ -2201,13 +2233,16 @@ static void apply_ept_offsets(struct obs_output *output)
 	}
 }
 
-static inline size_t count_streamable_frames(struct obs_output *output)
+/* counting stops at max_count, callers only need to know whether the batch
+ * limit has been exceeded */
+static inline size_t count_streamable_frames(struct obs_output *output, size_t max_count)
 {
+	struct encoder_packet *pkt;
+	struct interleave_iter iter;
 	size_t eligible = 0;
 
-	for (size_t idx = 0; idx < output->interleaved_packets.num; idx++) {
-		struct encoder_packet *pkt = &output->interleaved_packets.array[idx];
-
+	interleave_iter_init(&iter);
+	while (eligible < max_count && (pkt = interleave_iter_next(&output->interleaved_packets, &iter)) != NULL) {
 		/* Only count an interleaved packet as streamable if there are packets of the opposing type and of a
 		 * higher timestamp in the interleave buffer. This ensures that the timestamps are monotonic. */
 		if (!has_higher_opposing_ts(output, pkt))
@@ -2291,7 +2326,7 @@ static void interleave_packets(void *data, struct encoder_packet *packet, struct
 		} else {
 			set_higher_ts(output, &out);
 
-			size_t streamable = count_streamable_frames(output);
+			size_t streamable = count_streamable_frames(output, output->interleaver_max_batch_size + 2);
 			if (streamable) {
 				send_interleaved(output);
 
@@ -2529,14 +2564,21 @@ static inline void signal_start(struct obs_output *output)
 	do_output_signal(output, "start");
 }
 
+enum { RECONNECT_TIMEOUT, RECONNECT_OUTPUT };
+static const struct calldata_param reconnect_params[] = {
+	CALLDATA_PARAM_INT("timeout_sec"),
+	CALLDATA_PARAM_PTR("output"),
+};
+static struct calldata_layout reconnect_layout = CALLDATA_LAYOUT(reconnect_params);
+
 static inline void signal_reconnect(struct obs_output *output)
 {
 	struct calldata params;
 	uint8_t stack[128];
 
-	calldata_init_fixed(&params, stack, sizeof(stack));
-	calldata_set_int(&params, "timeout_sec", output->reconnect_retry_cur_msec / 1000);
-	calldata_set_ptr(&params, "output", output);
+	calldata_init_layout(&params, stack, sizeof(stack), &reconnect_layout);
+	calldata_slot_set_int(&params, &reconnect_layout, RECONNECT_TIMEOUT, output->reconnect_retry_cur_msec / 1000);
+	calldata_slot_set_ptr(&params, &reconnect_layout, RECONNECT_OUTPUT, output);
 	signal_handler_signal(output->context.signals, "reconnect", &params);
 }
 
@@ -2572,7 +2614,7 @@ bool obs_output_can_begin_data_capture(const obs_output_t *output, uint32_t flag
 		return false;
 
 	if (data_capture_ending(output))
-		pthread_join(output->end_data_capture_thread, NULL);
+		os_task_group_wait(output->end_data_capture_task);
 
 	return can_begin_data_capture(output);
 }
@@ -2834,7 +2876,7 @@ static inline void stop_raw_audio(obs_output_t *output)
 	}
 }
 
-static void *end_data_capture_thread(void *data)
+static void end_data_capture_task(void *data)
 {
 	encoded_callback_t encoded_callback;
 	obs_output_t *output = data;
@@ -2868,14 +2910,10 @@ static void *end_data_capture_thread(void *data)
 	os_atomic_set_bool(&output->active, false);
 	os_event_signal(output->stopping_event);
 	os_atomic_set_bool(&output->end_data_capture_thread_active, false);
-
-	return NULL;
 }
 
 static void obs_output_end_data_capture_internal(obs_output_t *output, bool signal)
 {
-	int ret;
-
 	if (!obs_output_valid(output, "obs_output_end_data_capture"))
 		return;
 
@@ -2905,16 +2943,16 @@ static void obs_output_end_data_capture_internal(obs_output_t *output, bool sign
 		log_frame_info(output);
 
 	if (data_capture_ending(output))
-		pthread_join(output->end_data_capture_thread, NULL);
+		os_task_group_wait(output->end_data_capture_task);
 
 	os_atomic_set_bool(&output->end_data_capture_thread_active, true);
-	ret = pthread_create(&output->end_data_capture_thread, NULL, end_data_capture_thread, output);
-	if (ret != 0) {
+	if (!os_thread_pool_queue(obs->thread_pool, OS_TASK_PRIORITY_HIGH, output->end_data_capture_task,
+				  end_data_capture_task, output)) {
 		blog(LOG_WARNING,
-		     "Failed to create end_data_capture_thread "
+		     "Failed to queue end_data_capture_task "
 		     "for output '%s'!",
 		     output->context.name);
-		end_data_capture_thread(output);
+		end_data_capture_task(output);
 	}
 
 	if (signal) {
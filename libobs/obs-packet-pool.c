@@ -0,0 +1,387 @@
+#include "obs-internal.h"
+
+/*
+ * Size-class pool for encoder packet payloads.
+ *
+ * Every payload is prefixed by the reference count that
+ * obs_encoder_packet_ref/release operate on.  Outputs and muxers also build
+ * packets themselves as a bmalloc'd buffer with a leading `long` (see
+ * obs-avc.c), so pooled blocks are told apart by a flag bit in the reference
+ * count instead of by anything stored before it.
+ *
+ * Each power of two between the smallest and largest class is split into
+ * four classes (1, 1.25, 1.5 and 1.75 times the power of two), so a payload
+ * wastes at most a quarter of its size instead of up to half of its block.
+ *
+ * Freed blocks go to a per-thread cache if the releasing thread allocates from
+ * that size class itself, and to a shared, mutex protected free list per size
+ * class otherwise, so blocks released by outputs make their way back to the
+ * encoder threads.  Both are bounded by bytes, anything past the limits is
+ * handed back to bfree.
+ *
+ * The hot path statistics are kept per thread and only summed up by
+ * obs_get_packet_pool_stats, so encoder and output threads don't fight over
+ * the same counters.
+ */
+
+#define POOL_MIN_SHIFT 9  /* 512 bytes */
+#define POOL_MAX_SHIFT 21 /* 2 megabytes */
+#define POOL_STEP_SHIFT 2 /* four classes per power of two */
+#define POOL_STEPS (1 << POOL_STEP_SHIFT)
+#define POOL_CLASSES ((POOL_MAX_SHIFT - POOL_MIN_SHIFT) * POOL_STEPS + 1)
+
+#define POOL_THREAD_CACHE_BYTES (1024 * 1024)
+#define POOL_SHARED_CACHE_BYTES (4 * 1024 * 1024)
+#define POOL_SHARED_CACHE_BLOCKS 64
+
+struct packet_block {
+	struct packet_block *next;
+	uint32_t size_class;
+	long refs;
+};
+
+struct packet_free_list {
+	struct packet_block *first;
+	size_t num;
+};
+
+/* only ever written by the thread they belong to */
+struct packet_thread_stats {
+	volatile long hits;
+	volatile long misses;
+	volatile long recycled;
+	volatile long cached_blocks;
+	volatile long cached_bytes;
+};
+
+struct packet_thread_cache {
+	struct packet_free_list lists[POOL_CLASSES];
+	bool allocates[POOL_CLASSES];
+	size_t bytes;
+
+	struct packet_thread_stats stats;
+	struct packet_thread_cache *next;
+	struct packet_thread_cache **prev_next;
+};
+
+struct packet_pool {
+	pthread_key_t thread_key;
+	pthread_mutex_t mutex[POOL_CLASSES];
+	struct packet_free_list lists[POOL_CLASSES];
+
+	volatile bool active;
+
+	/* thread caches, and the statistics of threads that have exited */
+	pthread_mutex_t threads_mutex;
+	struct packet_thread_cache *threads;
+	struct packet_thread_stats exited;
+
+	volatile long oversized;
+	volatile long discarded;
+};
+
+static struct packet_pool pool = {0};
+static pthread_once_t pool_once = PTHREAD_ONCE_INIT;
+static THREAD_LOCAL struct packet_thread_cache *thread_cache = NULL;
+
+static inline size_t class_size(uint32_t size_class)
+{
+	size_t step = POOL_STEPS + size_class % POOL_STEPS;
+	return step << (size_class / POOL_STEPS + POOL_MIN_SHIFT - POOL_STEP_SHIFT);
+}
+
+/* the shared cache budget is per power of two, so splitting it into more
+ * classes doesn't make the pool hold on to more memory */
+static inline size_t shared_cache_limit(uint32_t size_class)
+{
+	size_t limit = POOL_SHARED_CACHE_BYTES / POOL_STEPS / class_size(size_class);
+	if (!limit)
+		return 1;
+	return limit < POOL_SHARED_CACHE_BLOCKS ? limit : POOL_SHARED_CACHE_BLOCKS;
+}
+
+static inline uint32_t get_size_class(size_t size)
+{
+	uint32_t shift = POOL_MIN_SHIFT;
+	size_t last = size - 1;
+
+	if (size <= class_size(0))
+		return 0;
+
+	/* 2^shift <= last < 2^(shift + 1), the bits below the top one pick
+	 * the step, rounded up to the next class */
+	while (last >> (shift + 1))
+		shift++;
+
+	size_t step = (last >> (shift - POOL_STEP_SHIFT)) & (POOL_STEPS - 1);
+	return (uint32_t)((shift - POOL_MIN_SHIFT) * POOL_STEPS + step + 1);
+}
+
+static inline uint8_t *block_data(struct packet_block *block)
+{
+	return (uint8_t *)(&block->refs + 1);
+}
+
+static inline struct packet_block *data_block(uint8_t *data)
+{
+	return (struct packet_block *)(data - sizeof(long) - offsetof(struct packet_block, refs));
+}
+
+static inline void list_push(struct packet_free_list *list, struct packet_block *block)
+{
+	block->next = list->first;
+	list->first = block;
+	list->num++;
+}
+
+static inline struct packet_block *list_pop(struct packet_free_list *list)
+{
+	struct packet_block *block = list->first;
+	if (block) {
+		list->first = block->next;
+		list->num--;
+	}
+	return block;
+}
+
+static inline void stat_add(volatile long *stat, long val)
+{
+	/* only the owning thread writes, so this can't lose updates */
+	os_atomic_store_long(stat, os_atomic_load_long(stat) + val);
+}
+
+static inline void update_cached(struct packet_thread_cache *cache, long blocks, long bytes)
+{
+	stat_add(&cache->stats.cached_blocks, blocks);
+	stat_add(&cache->stats.cached_bytes, bytes);
+}
+
+static void add_stats(struct packet_thread_stats *dst, const struct packet_thread_stats *src)
+{
+	stat_add(&dst->hits, os_atomic_load_long(&src->hits));
+	stat_add(&dst->misses, os_atomic_load_long(&src->misses));
+	stat_add(&dst->recycled, os_atomic_load_long(&src->recycled));
+	stat_add(&dst->cached_blocks, os_atomic_load_long(&src->cached_blocks));
+	stat_add(&dst->cached_bytes, os_atomic_load_long(&src->cached_bytes));
+}
+
+static void release_block(struct packet_thread_cache *cache, struct packet_block *block)
+{
+	uint32_t size_class = block->size_class;
+	struct packet_free_list *list = &pool.lists[size_class];
+	bool cached = false;
+
+	pthread_mutex_lock(&pool.mutex[size_class]);
+	if (pool.active && list->num < shared_cache_limit(size_class)) {
+		list_push(list, block);
+		cached = true;
+	}
+	pthread_mutex_unlock(&pool.mutex[size_class]);
+
+	if (cached) {
+		update_cached(cache, 1, (long)class_size(size_class));
+	} else {
+		os_atomic_inc_long(&pool.discarded);
+		bfree(block);
+	}
+}
+
+static void flush_thread_cache(struct packet_thread_cache *cache)
+{
+	for (uint32_t i = 0; i < POOL_CLASSES; i++) {
+		struct packet_block *block;
+
+		while ((block = list_pop(&cache->lists[i])) != NULL) {
+			update_cached(cache, -1, -(long)class_size(i));
+			release_block(cache, block);
+		}
+	}
+
+	cache->bytes = 0;
+}
+
+static void thread_cache_destroy(void *data)
+{
+	struct packet_thread_cache *cache = data;
+
+	flush_thread_cache(cache);
+
+	pthread_mutex_lock(&pool.threads_mutex);
+	add_stats(&pool.exited, &cache->stats);
+	if (cache->next)
+		cache->next->prev_next = cache->prev_next;
+	*cache->prev_next = cache->next;
+	pthread_mutex_unlock(&pool.threads_mutex);
+
+	bfree(cache);
+}
+
+static void pool_init_once(void)
+{
+	for (size_t i = 0; i < POOL_CLASSES; i++)
+		pthread_mutex_init(&pool.mutex[i], NULL);
+	pthread_mutex_init(&pool.threads_mutex, NULL);
+	pthread_key_create(&pool.thread_key, thread_cache_destroy);
+}
+
+static struct packet_thread_cache *get_thread_cache(void)
+{
+	if (!thread_cache) {
+		thread_cache = bzalloc(sizeof(*thread_cache));
+		pthread_setspecific(pool.thread_key, thread_cache);
+
+		pthread_mutex_lock(&pool.threads_mutex);
+		thread_cache->next = pool.threads;
+		thread_cache->prev_next = &pool.threads;
+		if (pool.threads)
+			pool.threads->prev_next = &thread_cache->next;
+		pool.threads = thread_cache;
+		pthread_mutex_unlock(&pool.threads_mutex);
+	}
+	return thread_cache;
+}
+
+static struct packet_block *acquire_block(uint32_t size_class)
+{
+	struct packet_thread_cache *cache = get_thread_cache();
+	struct packet_block *block = list_pop(&cache->lists[size_class]);
+
+	/* from now on blocks of this class released on this thread are kept
+	 * here instead of going back to the shared list */
+	cache->allocates[size_class] = true;
+
+	if (block) {
+		cache->bytes -= class_size(size_class);
+	} else {
+		pthread_mutex_lock(&pool.mutex[size_class]);
+		block = list_pop(&pool.lists[size_class]);
+		pthread_mutex_unlock(&pool.mutex[size_class]);
+	}
+
+	if (block) {
+		update_cached(cache, -1, -(long)class_size(size_class));
+		stat_add(&cache->stats.hits, 1);
+	} else {
+		block = bmalloc(sizeof(struct packet_block) + class_size(size_class));
+		block->size_class = size_class;
+		stat_add(&cache->stats.misses, 1);
+	}
+
+	return block;
+}
+
+void obs_packet_pool_init(void)
+{
+	pthread_once(&pool_once, pool_init_once);
+	os_atomic_set_bool(&pool.active, true);
+}
+
+void obs_packet_pool_free(void)
+{
+	struct packet_thread_stats freed = {0};
+	struct obs_packet_pool_stats stats;
+
+	if (!os_atomic_load_bool(&pool.active))
+		return;
+
+	if (thread_cache) {
+		pthread_setspecific(pool.thread_key, NULL);
+		thread_cache_destroy(thread_cache);
+		thread_cache = NULL;
+	}
+
+	os_atomic_set_bool(&pool.active, false);
+
+	for (uint32_t i = 0; i < POOL_CLASSES; i++) {
+		struct packet_block *block;
+
+		/* release_block checks the active flag under this lock, so
+		 * nothing can be pushed after the list has been drained */
+		pthread_mutex_lock(&pool.mutex[i]);
+		while ((block = list_pop(&pool.lists[i])) != NULL) {
+			freed.cached_blocks--;
+			freed.cached_bytes -= (long)class_size(i);
+			bfree(block);
+		}
+		pthread_mutex_unlock(&pool.mutex[i]);
+	}
+
+	pthread_mutex_lock(&pool.threads_mutex);
+	add_stats(&pool.exited, &freed);
+	pthread_mutex_unlock(&pool.threads_mutex);
+
+	obs_get_packet_pool_stats(&stats);
+	blog(LOG_INFO, "Packet pool: %llu hits, %llu misses, %llu oversized, %llu discarded",
+	     (unsigned long long)stats.hits, (unsigned long long)stats.misses,
+	     (unsigned long long)stats.oversized, (unsigned long long)stats.discarded);
+}
+
+uint8_t *obs_packet_pool_alloc(size_t size)
+{
+	long *p_refs;
+
+	if (size > class_size(POOL_CLASSES - 1)) {
+		os_atomic_inc_long(&pool.oversized);
+
+	} else if (os_atomic_load_bool(&pool.active)) {
+		struct packet_block *block = acquire_block(get_size_class(size));
+		block->refs = OBS_PACKET_POOL_REF_FLAG | 1;
+		return block_data(block);
+	}
+
+	p_refs = bmalloc(size + sizeof(long));
+	*p_refs = 1;
+	return (uint8_t *)(p_refs + 1);
+}
+
+void obs_packet_pool_release(uint8_t *data)
+{
+	struct packet_block *block = data_block(data);
+	struct packet_thread_cache *cache;
+	struct packet_free_list *list;
+
+	size_t size;
+
+	if (!os_atomic_load_bool(&pool.active)) {
+		bfree(block);
+		return;
+	}
+
+	cache = get_thread_cache();
+	list = &cache->lists[block->size_class];
+	size = class_size(block->size_class);
+
+	stat_add(&cache->stats.recycled, 1);
+
+	if (cache->allocates[block->size_class] && cache->bytes + size <= POOL_THREAD_CACHE_BYTES) {
+		list_push(list, block);
+		cache->bytes += size;
+		update_cached(cache, 1, (long)size);
+	} else {
+		release_block(cache, block);
+	}
+}
+
+void obs_get_packet_pool_stats(struct obs_packet_pool_stats *stats)
+{
+	if (!stats)
+		return;
+
+	struct packet_thread_stats sum = {0};
+
+	pthread_once(&pool_once, pool_init_once);
+
+	pthread_mutex_lock(&pool.threads_mutex);
+	add_stats(&sum, &pool.exited);
+	for (struct packet_thread_cache *cache = pool.threads; cache; cache = cache->next)
+		add_stats(&sum, &cache->stats);
+	pthread_mutex_unlock(&pool.threads_mutex);
+
+	stats->hits = (uint64_t)sum.hits;
+	stats->misses = (uint64_t)sum.misses;
+	stats->oversized = (uint64_t)os_atomic_load_long(&pool.oversized);
+	stats->recycled = (uint64_t)sum.recycled;
+	stats->discarded = (uint64_t)os_atomic_load_long(&pool.discarded);
+	stats->cached_blocks = (uint64_t)sum.cached_blocks;
+	stats->cached_bytes = (uint64_t)sum.cached_bytes;
+}
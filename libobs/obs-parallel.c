@@ -0,0 +1,78 @@
+#include "obs-internal.h"
+
+/*
+ * Parallel loops run on the shared thread pool.  The calling thread works
+ * through the loop itself and queues a few helper tasks at high priority that
+ * join in once a worker picks them up.  Helpers that haven't started by the
+ * time the caller runs out of work are cancelled, so the loop never waits for
+ * a busy pool.
+ */
+
+static void parallel_run(struct obs_parallel_pool *pool)
+{
+	for (;;) {
+		size_t idx = (size_t)os_atomic_inc_long(&pool->next) - 1;
+		if (idx >= pool->num)
+			break;
+
+		pool->func(pool->param, idx);
+	}
+}
+
+static void parallel_task(void *param)
+{
+	parallel_run(param);
+}
+
+void obs_parallel_pool_init(struct obs_parallel_pool *pool, os_thread_pool_t *thread_pool)
+{
+	struct os_thread_pool_stats stats = {0};
+
+	memset(pool, 0, sizeof(*pool));
+	if (!thread_pool)
+		return;
+
+	/* leave room for the video and audio threads */
+	os_thread_pool_get_stats(thread_pool, &stats);
+	pool->num_helpers = stats.threads > 2 ? stats.threads - 2 : 0;
+	if (pool->num_helpers > OBS_PARALLEL_MAX_HELPERS)
+		pool->num_helpers = OBS_PARALLEL_MAX_HELPERS;
+	if (!pool->num_helpers)
+		return;
+
+	pool->thread_pool = thread_pool;
+	pool->group = os_task_group_create(thread_pool);
+	if (!pool->group)
+		pool->num_helpers = 0;
+}
+
+void obs_parallel_pool_free(struct obs_parallel_pool *pool)
+{
+	os_task_group_destroy(pool->group);
+	memset(pool, 0, sizeof(*pool));
+}
+
+void obs_parallel_for(struct obs_parallel_pool *pool, size_t num, obs_parallel_func_t func, void *param)
+{
+	size_t num_helpers = num > 1 ? num - 1 : 0;
+	if (num_helpers > pool->num_helpers)
+		num_helpers = pool->num_helpers;
+
+	pool->func = func;
+	pool->param = param;
+	pool->num = num;
+	pool->next = 0;
+
+	for (size_t i = 0; i < num_helpers; i++) {
+		if (!os_thread_pool_queue(pool->thread_pool, OS_TASK_PRIORITY_HIGH, pool->group, parallel_task, pool))
+			break;
+	}
+
+	parallel_run(pool);
+
+	if (num_helpers) {
+		os_task_group_cancel(pool->group);
+		os_task_group_wait(pool->group);
+		os_task_group_reset(pool->group);
+	}
+}
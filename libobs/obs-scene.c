@@ -598,6 +598,11 @@ static inline void update_nested_scene_crop(struct obs_scene_item *item, uint32_
 	item->crop.bottom = (int)((float)item->crop.bottom * scale_y);
 }
 
+/* "scene" is filled in by signal_parent */
+enum { TRANSFORM_ITEM, TRANSFORM_SCENE };
+static const struct calldata_param transform_params[] = {CALLDATA_PARAM_PTR("item"), CALLDATA_PARAM_PTR("scene")};
+static struct calldata_layout transform_layout = CALLDATA_LAYOUT(transform_params);
+
 static void update_item_transform(struct obs_scene_item *item, bool update_tex)
 {
 	uint32_t width;
@@ -695,8 +700,8 @@ static void update_item_transform(struct obs_scene_item *item, bool update_tex)
 
 	/* ----------------------- */
 
-	calldata_init_fixed(&params, stack, sizeof(stack));
-	calldata_set_ptr(&params, "item", item);
+	calldata_init_layout(&params, stack, sizeof(stack), &transform_layout);
+	calldata_slot_set_ptr(&params, &transform_layout, TRANSFORM_ITEM, item);
 	signal_parent(item->parent, "item_transform", &params);
 
 	if (!update_tex)
@@ -81,12 +81,11 @@ static bool ready_deinterlace_frames(obs_source_t *source, uint64_t sys_time)
 		if (source->async_frames.num <= 2) {
 			bool exit = true;
 
-			if (prev_frame) {
-				prev_frame->prev_frame = true;
-
-			} else if (!frame && source->async_frames.num == 2) {
+			/* prev_frame has just been removed, which releases frames
+			 * from obs_source_output_video_ref, so it can't be
+			 * touched anymore */
+			if (!prev_frame && !frame && source->async_frames.num == 2)
 				exit = false;
-			}
 
 			if (exit) {
 				source->deinterlace_offset = 0;
@@ -0,0 +1,221 @@
+#include "util/platform.h"
+#include "obs-internal.h"
+
+/*
+ * Lazy sources, see obs_source_create_lazy.
+ *
+ * The video tick starts creating a lazy source on the thread pool the first
+ * time it is shown or active.  Sources of types with OBS_SOURCE_LAZY_UNLOAD are
+ * destroyed on the thread pool again when they have not been used for the
+ * unload delay.  context.data is only ever set and unset with lazy_mutex
+ * locked, threads other than the video thread mark it as used with
+ * lazy_data_users, and unloading waits for them before destroying it.
+ */
+
+static const char *lazy_load_name = "obs_source_lazy_load";
+static const char *lazy_unload_name = "obs_source_lazy_unload";
+
+/* must be called with lazy_mutex locked */
+static void lazy_source_load(obs_source_t *source)
+{
+	void *data;
+
+	if (source->lazy_state != OBS_LAZY_UNLOADED && source->lazy_state != OBS_LAZY_LOADING)
+		return;
+
+	/* hotkeys registered from here on belong to the instance */
+	source->lazy_hotkeys = source->context.hotkeys.num;
+	source->lazy_hotkey_pairs = source->context.hotkey_pairs.num;
+
+	profile_start(lazy_load_name);
+	data = source->info.create(source->context.settings, source);
+	profile_end(lazy_load_name);
+
+	if (!data) {
+		blog(LOG_ERROR, "Failed to create source '%s'!", source->context.name);
+		source->lazy_state = OBS_LAZY_FAILED;
+		return;
+	}
+
+	if (source->lazy_load_pending && source->info.load)
+		source->info.load(data, source->context.settings);
+
+	/* only the video tick changes whether the source is showing or active,
+	 * so it is the one to call show/activate on the new instance, see
+	 * lazy_source_tick */
+	source->lazy_state = OBS_LAZY_LOADED;
+	source->lazy_sync_pending = true;
+	source->lazy_idle_since = 0;
+	os_atomic_set_ptr((void *volatile *)&source->context.data, data);
+
+	blog(LOG_DEBUG, "lazy source '%s' loaded", source->context.name);
+}
+
+static void lazy_source_load_task(void *param)
+{
+	obs_source_t *source = param;
+
+	pthread_mutex_lock(&source->lazy_mutex);
+	if (source->lazy_state == OBS_LAZY_LOADING)
+		lazy_source_load(source);
+	pthread_mutex_unlock(&source->lazy_mutex);
+
+	obs_source_release(source);
+}
+
+/* called with lazy_mutex locked, creates the source on the thread pool so
+ * the video thread does not wait for it */
+static void lazy_source_queue_load(obs_source_t *source)
+{
+	obs_source_t *ref = obs->thread_pool ? obs_source_get_ref(source) : NULL;
+
+	if (ref && os_thread_pool_queue(obs->thread_pool, OS_TASK_PRIORITY_HIGH, NULL, lazy_source_load_task, ref))
+		return;
+
+	lazy_source_load(source);
+	obs_source_release(ref);
+}
+
+/* called without lazy_mutex once context.data has been unset, destroys the
+ * instance the way obs_source_destroy does */
+static void lazy_source_unload(obs_source_t *source)
+{
+	void *data = source->lazy_unload_data;
+
+	profile_start(lazy_unload_name);
+
+	proc_handler_remove_data(source->context.procs, data);
+	while (os_atomic_load_long(&source->lazy_data_users) > 0)
+		os_sleep_ms(1);
+
+	obs_hotkeys_context_release_after(&source->context, source->lazy_hotkeys, source->lazy_hotkey_pairs);
+
+	if (source->info.save)
+		source->info.save(data, source->context.settings);
+	source->info.destroy(data);
+
+	profile_end(lazy_unload_name);
+
+	pthread_mutex_lock(&source->lazy_mutex);
+	source->lazy_unload_data = NULL;
+	source->lazy_state = OBS_LAZY_UNLOADED;
+	pthread_mutex_unlock(&source->lazy_mutex);
+
+	os_event_signal(source->lazy_unloaded);
+
+	blog(LOG_DEBUG, "lazy source '%s' unloaded", source->context.name);
+}
+
+static void lazy_source_unload_task(void *param)
+{
+	obs_source_t *source = param;
+
+	lazy_source_unload(source);
+	obs_source_release(source);
+}
+
+static void lazy_source_queue_unload(obs_source_t *source)
+{
+	obs_source_t *ref = obs->thread_pool ? obs_source_get_ref(source) : NULL;
+
+	if (ref && os_thread_pool_queue(obs->thread_pool, OS_TASK_PRIORITY_NORMAL, NULL, lazy_source_unload_task, ref))
+		return;
+
+	lazy_source_unload(source);
+	obs_source_release(ref);
+}
+
+/* called with lazy_mutex locked, returns whether the source has been unused
+ * for longer than the unload delay */
+static bool lazy_source_idle(obs_source_t *source)
+{
+	uint64_t delay = (uint64_t)os_atomic_load_long(&obs->data.lazy_unload_delay) * 1000000000ULL;
+	uint64_t now;
+
+	if (!delay || source->showing || source->active || source->lazy_sync_pending) {
+		source->lazy_idle_since = 0;
+		return false;
+	}
+
+	now = os_gettime_ns();
+	if (!source->lazy_idle_since)
+		source->lazy_idle_since = now;
+
+	return now - source->lazy_idle_since >= delay;
+}
+
+/* starts loading lazy sources that are about to be shown, calls show/activate
+ * on sources that were just created according to their state at the time, and
+ * starts unloading sources that have not been used for a while.  returns false
+ * while the source is being loaded, in which case show/hide and
+ * activate/deactivate are left for a later tick */
+bool lazy_source_tick(obs_source_t *source, bool wanted)
+{
+	bool unload = false;
+
+	if (pthread_mutex_trylock(&source->lazy_mutex) != 0)
+		return false;
+
+	if (wanted && source->lazy_state == OBS_LAZY_UNLOADED) {
+		source->lazy_state = OBS_LAZY_LOADING;
+		lazy_source_queue_load(source);
+	}
+
+	if (source->lazy_sync_pending) {
+		void *data = source->context.data;
+
+		if (source->showing && source->info.show)
+			source->info.show(data);
+		if (source->active && source->info.activate)
+			source->info.activate(data);
+
+		source->lazy_sync_pending = false;
+	}
+
+	if (source->lazy_unload && source->lazy_state == OBS_LAZY_LOADED) {
+		if (wanted) {
+			source->lazy_idle_since = 0;
+
+		} else if (lazy_source_idle(source)) {
+			source->lazy_unload_data = source->context.data;
+			source->lazy_state = OBS_LAZY_UNLOADING;
+			source->lazy_idle_since = 0;
+			os_event_reset(source->lazy_unloaded);
+			os_atomic_set_ptr((void *volatile *)&source->context.data, NULL);
+			unload = true;
+		}
+	}
+
+	pthread_mutex_unlock(&source->lazy_mutex);
+
+	if (unload)
+		lazy_source_queue_unload(source);
+	return true;
+}
+
+bool obs_source_is_lazy(const obs_source_t *source)
+{
+	return obs_source_valid(source, "obs_source_is_lazy") ? source->lazy : false;
+}
+
+void obs_source_preload(obs_source_t *source)
+{
+	if (!obs_source_valid(source, "obs_source_preload") || !source->lazy)
+		return;
+
+	pthread_mutex_lock(&source->lazy_mutex);
+
+	while (source->lazy_state == OBS_LAZY_UNLOADING) {
+		pthread_mutex_unlock(&source->lazy_mutex);
+		os_event_wait(source->lazy_unloaded);
+		pthread_mutex_lock(&source->lazy_mutex);
+	}
+
+	if (source->lazy_state == OBS_LAZY_FAILED)
+		source->lazy_state = OBS_LAZY_UNLOADED;
+
+	source->lazy_idle_since = 0;
+	lazy_source_load(source);
+
+	pthread_mutex_unlock(&source->lazy_mutex);
+}
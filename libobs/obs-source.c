@@ -21,6 +21,7 @@
 #include "media-io/format-conversion.h"
 #include "media-io/video-frame.h"
 #include "media-io/audio-io.h"
+#include "media-io/audio-math.h"
 #include "util/threading.h"
 #include "util/platform.h"
 #include "util/util_uint64.h"
@@ -40,6 +41,30 @@ static inline bool data_valid(const struct obs_source *source, const char *f)
 	return obs_source_valid(source, f) && source->context.data;
 }
 
+/* lazy sources with OBS_SOURCE_LAZY_UNLOAD are destroyed on the thread pool,
+ * see obs-source-lazy.c, so calls into them that are not made on the video
+ * thread have to mark the data as used while they make them */
+static inline void *source_data_acquire(const struct obs_source *source)
+{
+	struct obs_source *s = (struct obs_source *)source;
+	void *data;
+
+	if (!source->lazy_unload)
+		return source->context.data;
+
+	os_atomic_inc_long(&s->lazy_data_users);
+	data = os_atomic_load_ptr((void *const volatile *)&s->context.data);
+	if (!data)
+		os_atomic_dec_long(&s->lazy_data_users);
+	return data;
+}
+
+static inline void source_data_release(const struct obs_source *source, void *data)
+{
+	if (data && source->lazy_unload)
+		os_atomic_dec_long(&((struct obs_source *)source)->lazy_data_users);
+}
+
 static inline bool deinterlacing_enabled(const struct obs_source *source)
 {
 	return source->deinterlace_mode != OBS_DEINTERLACE_MODE_DISABLE;
@@ -121,7 +146,11 @@ bool obs_source_init_context(struct obs_source *source, obs_data_t *settings, co
 	if (!obs_context_data_init(&source->context, OBS_OBJ_TYPE_SOURCE, settings, name, uuid, hotkey_data, private))
 		return false;
 
-	return signal_handler_add_array(source->context.signals, source_signals);
+	if (!signal_handler_add_array(source->context.signals, source_signals))
+		return false;
+
+	source->volume_signal = signal_handler_get_id(source->context.signals, "volume");
+	return true;
 }
 
 const char *obs_source_get_display_name(const char *id)
@@ -226,6 +255,7 @@ static bool obs_source_init(struct obs_source *source)
 	pthread_mutex_init_value(&source->audio_cb_mutex);
 	pthread_mutex_init_value(&source->caption_cb_mutex);
 	pthread_mutex_init_value(&source->media_actions_mutex);
+	pthread_mutex_init_value(&source->lazy_mutex);
 
 	if (pthread_mutex_init_recursive(&source->filter_mutex) != 0)
 		return false;
@@ -243,6 +273,8 @@ static bool obs_source_init(struct obs_source *source)
 		return false;
 	if (pthread_mutex_init(&source->media_actions_mutex, NULL) != 0)
 		return false;
+	if (pthread_mutex_init(&source->lazy_mutex, NULL) != 0)
+		return false;
 
 	if (is_audio_source(source) || is_composite_source(source))
 		allocate_audio_output_buffer(source);
@@ -275,6 +307,7 @@ static void obs_source_init_finalize(struct obs_source *source, obs_canvas_t *ca
 		obs->data.first_audio_source = source;
 
 		pthread_mutex_unlock(&obs->data.audio_sources_mutex);
+		obs_audio_graph_invalidate();
 	}
 
 	if (!source->context.private) {
@@ -435,7 +468,7 @@ void obs_source_audio_output_capture_device_changed(obs_source_t *src, const cha
 
 static obs_source_t *obs_source_create_internal(const char *id, const char *name, const char *uuid,
 						obs_data_t *settings, obs_data_t *hotkey_data, bool private,
-						uint32_t last_obs_ver, obs_canvas_t *canvas)
+						uint32_t last_obs_ver, obs_canvas_t *canvas, bool lazy)
 {
 	struct obs_source *source = bzalloc(sizeof(struct obs_source));
 
@@ -486,14 +519,22 @@ static obs_source_t *obs_source_create_internal(const char *id, const char *name
 	if (!private)
 		obs_source_init_audio_hotkeys(source);
 
+	/* only inputs are created lazily, scenes, transitions and filters are
+	 * needed right away to tell what is going to be shown */
+	source->lazy = lazy && info && info->create && info->type == OBS_SOURCE_TYPE_INPUT;
+	source->lazy_unload = source->lazy && (info->output_flags & OBS_SOURCE_LAZY_UNLOAD) != 0 && info->destroy;
+	if (source->lazy_unload && os_event_init(&source->lazy_unloaded, OS_EVENT_TYPE_MANUAL) != 0)
+		source->lazy_unload = false;
+
 	/* allow the source to be created even if creation fails so that the
 	 * user's data doesn't become lost */
-	if (info && info->create)
+	if (info && info->create && !source->lazy)
 		source->context.data = info->create(source->context.settings, source);
-	if ((!info || info->create) && !source->context.data)
+	if ((!info || info->create) && !source->context.data && !source->lazy)
 		blog(LOG_ERROR, "Failed to create source '%s'!", name);
 
-	blog(LOG_DEBUG, "%ssource '%s' (%s) created", private ? "private " : "", name, id);
+	blog(LOG_DEBUG, "%s%ssource '%s' (%s) created", private ? "private " : "", source->lazy ? "lazy " : "", name,
+	     id);
 
 	source->flags = source->default_flags;
 	source->enabled = true;
@@ -519,25 +560,31 @@ fail:
 
 obs_source_t *obs_source_create(const char *id, const char *name, obs_data_t *settings, obs_data_t *hotkey_data)
 {
-	return obs_source_create_internal(id, name, NULL, settings, hotkey_data, false, LIBOBS_API_VER, NULL);
+	return obs_source_create_internal(id, name, NULL, settings, hotkey_data, false, LIBOBS_API_VER, NULL, false);
+}
+
+obs_source_t *obs_source_create_lazy(const char *id, const char *name, obs_data_t *settings, obs_data_t *hotkey_data)
+{
+	return obs_source_create_internal(id, name, NULL, settings, hotkey_data, false, LIBOBS_API_VER, NULL, true);
 }
 
 obs_source_t *obs_source_create_private(const char *id, const char *name, obs_data_t *settings)
 {
-	return obs_source_create_internal(id, name, NULL, settings, NULL, true, LIBOBS_API_VER, NULL);
+	return obs_source_create_internal(id, name, NULL, settings, NULL, true, LIBOBS_API_VER, NULL, false);
 }
 
 obs_source_t *obs_source_create_canvas(obs_canvas_t *canvas, const char *id, const char *name, obs_data_t *settings,
 				       obs_data_t *hotkey_data)
 {
-	return obs_source_create_internal(id, name, NULL, settings, hotkey_data, false, LIBOBS_API_VER, canvas);
+	return obs_source_create_internal(id, name, NULL, settings, hotkey_data, false, LIBOBS_API_VER, canvas, false);
 }
 
 obs_source_t *obs_source_create_set_last_ver(obs_canvas_t *canvas, const char *id, const char *name, const char *uuid,
 					     obs_data_t *settings, obs_data_t *hotkey_data, uint32_t last_obs_ver,
-					     bool is_private)
+					     bool is_private, bool lazy)
 {
-	return obs_source_create_internal(id, name, uuid, settings, hotkey_data, is_private, last_obs_ver, canvas);
+	return obs_source_create_internal(id, name, uuid, settings, hotkey_data, is_private, last_obs_ver, canvas,
+					  lazy);
 }
 
 static char *get_new_filter_name(obs_source_t *dst, const char *name)
@@ -697,10 +744,26 @@ void obs_source_frame_init(struct obs_source_frame *frame, enum video_format for
 	}
 }
 
-static inline void obs_source_frame_decref(struct obs_source_frame *frame)
+static void async_frame_destroy(obs_source_t *source, struct obs_source_frame *frame)
+{
+	for (size_t i = 0; i < source->async_ref_frames.num; i++) {
+		struct async_frame_ref *ref = &source->async_ref_frames.array[i];
+
+		if (ref->frame == frame) {
+			ref->release(ref->param);
+			da_erase(source->async_ref_frames, i);
+			bfree(frame);
+			return;
+		}
+	}
+
+	obs_source_frame_destroy(frame);
+}
+
+static inline void obs_source_frame_decref(obs_source_t *source, struct obs_source_frame *frame)
 {
 	if (os_atomic_dec_long(&frame->refs) == 0)
-		obs_source_frame_destroy(frame);
+		async_frame_destroy(source, frame);
 }
 
 static bool obs_source_filter_remove_refless(obs_source_t *source, obs_source_t *filter);
@@ -739,6 +802,7 @@ void obs_source_destroy(struct obs_source *source)
 			source->next_audio_source->prev_next_audio_source = source->prev_next_audio_source;
 	}
 	pthread_mutex_unlock(&obs->data.audio_sources_mutex);
+	obs_audio_graph_invalidate();
 
 	if (source->filter_parent)
 		obs_source_filter_remove_refless(source->filter_parent, source);
@@ -776,7 +840,6 @@ static void obs_source_destroy_defer(struct obs_source *source)
 		source->info.destroy(source->context.data);
 		source->context.data = NULL;
 	}
-
 	blog(LOG_DEBUG, "%ssource '%s' destroyed", source->context.private ? "private " : "", source->context.name);
 
 	audio_monitor_destroy(source->monitor);
@@ -786,7 +849,9 @@ static void obs_source_destroy_defer(struct obs_source *source)
 	obs_hotkey_pair_unregister(source->mute_unmute_key);
 
 	for (i = 0; i < source->async_cache.num; i++)
-		obs_source_frame_decref(source->async_cache.array[i].frame);
+		obs_source_frame_decref(source, source->async_cache.array[i].frame);
+	while (source->async_ref_frames.num)
+		async_frame_destroy(source, source->async_ref_frames.array[0].frame);
 
 	gs_enter_context(obs->video.graphics);
 	if (source->async_texrender)
@@ -820,6 +885,7 @@ static void obs_source_destroy_defer(struct obs_source *source)
 	da_free(source->audio_cb_list);
 	da_free(source->caption_cb_list);
 	da_free(source->async_cache);
+	da_free(source->async_ref_frames);
 	da_free(source->async_frames);
 	da_free(source->filters);
 	da_free(source->media_actions);
@@ -831,6 +897,8 @@ static void obs_source_destroy_defer(struct obs_source *source)
 	pthread_mutex_destroy(&source->caption_cb_mutex);
 	pthread_mutex_destroy(&source->async_mutex);
 	pthread_mutex_destroy(&source->media_actions_mutex);
+	pthread_mutex_destroy(&source->lazy_mutex);
+	os_event_destroy(source->lazy_unloaded);
 	obs_data_release(source->private_settings);
 	obs_context_data_free(&source->context);
 
@@ -933,6 +1001,7 @@ void obs_source_remove(obs_source_t *source)
 		obs_source_t *s = obs_source_get_ref(source);
 		if (s) {
 			s->removed = true;
+			obs_audio_graph_invalidate();
 			obs_source_dosignal(s, "source_remove", "remove");
 			/* Remove from canvas if there is one. */
 			if (source->canvas)
@@ -994,11 +1063,16 @@ obs_missing_files_t *obs_source_get_missing_files(const obs_source_t *source)
 	if (!data_valid(source, "obs_source_get_missing_files"))
 		return obs_missing_files_create();
 
-	if (source->info.missing_files) {
-		return source->info.missing_files(source->context.data);
-	}
+	void *data = source_data_acquire(source);
+	obs_missing_files_t *files;
 
-	return obs_missing_files_create();
+	if (data && source->info.missing_files)
+		files = source->info.missing_files(data);
+	else
+		files = obs_missing_files_create();
+
+	source_data_release(source, data);
+	return files;
 }
 
 void obs_source_replace_missing_file(obs_missing_file_cb cb, obs_source_t *source, const char *new_path, void *data)
@@ -1006,7 +1080,10 @@ void obs_source_replace_missing_file(obs_missing_file_cb cb, obs_source_t *sourc
 	if (!data_valid(source, "obs_source_replace_missing_file"))
 		return;
 
-	cb(source->context.data, new_path, data);
+	void *source_data = source_data_acquire(source);
+	if (source_data)
+		cb(source_data, new_path, data);
+	source_data_release(source, source_data);
 }
 
 bool obs_is_source_configurable(const char *id)
@@ -1017,29 +1094,34 @@ bool obs_is_source_configurable(const char *id)
 
 bool obs_source_configurable(const obs_source_t *source)
 {
-	return data_valid(source, "obs_source_configurable") &&
+	return (data_valid(source, "obs_source_configurable") || (source && source->lazy)) &&
 	       (source->info.get_properties || source->info.get_properties2);
 }
 
 obs_properties_t *obs_source_properties(const obs_source_t *source)
 {
+	/* the properties of a source are usually shown to change it, so it is
+	 * not worth deferring its creation any longer */
+	if (obs_source_valid(source, "obs_source_properties") && source->lazy && !source->context.data)
+		obs_source_preload((obs_source_t *)source);
+
 	if (!data_valid(source, "obs_source_properties"))
 		return NULL;
 
-	if (source->info.get_properties2) {
-		obs_properties_t *props;
-		props = source->info.get_properties2(source->context.data, source->info.type_data);
+	void *data = source_data_acquire(source);
+	obs_properties_t *props = NULL;
+
+	if (data && source->info.get_properties2) {
+		props = source->info.get_properties2(data, source->info.type_data);
 		obs_properties_apply_settings(props, source->context.settings);
-		return props;
 
-	} else if (source->info.get_properties) {
-		obs_properties_t *props;
-		props = source->info.get_properties(source->context.data);
+	} else if (data && source->info.get_properties) {
+		props = source->info.get_properties(data);
 		obs_properties_apply_settings(props, source->context.settings);
-		return props;
 	}
 
-	return NULL;
+	source_data_release(source, data);
+	return props;
 }
 
 uint32_t obs_source_get_output_flags(const obs_source_t *source)
@@ -1074,9 +1156,13 @@ void obs_source_update(obs_source_t *source, obs_data_t *settings)
 
 	if (source->info.output_flags & OBS_SOURCE_VIDEO) {
 		os_atomic_inc_long(&source->defer_update_count);
-	} else if (source->context.data && source->info.update) {
-		source->info.update(source->context.data, source->context.settings);
-		obs_source_dosignal(source, "source_update", "update");
+	} else if (source->info.update) {
+		void *data = source_data_acquire(source);
+		if (data) {
+			source->info.update(data, source->context.settings);
+			source_data_release(source, data);
+			obs_source_dosignal(source, "source_update", "update");
+		}
 	}
 }
 
@@ -1104,9 +1190,10 @@ void obs_source_send_mouse_click(obs_source_t *source, const struct obs_mouse_ev
 		return;
 
 	if (source->info.output_flags & OBS_SOURCE_INTERACTION) {
-		if (source->info.mouse_click) {
-			source->info.mouse_click(source->context.data, event, type, mouse_up, click_count);
-		}
+		void *data = source_data_acquire(source);
+		if (data && source->info.mouse_click)
+			source->info.mouse_click(data, event, type, mouse_up, click_count);
+		source_data_release(source, data);
 	}
 }
 
@@ -1116,9 +1203,10 @@ void obs_source_send_mouse_move(obs_source_t *source, const struct obs_mouse_eve
 		return;
 
 	if (source->info.output_flags & OBS_SOURCE_INTERACTION) {
-		if (source->info.mouse_move) {
-			source->info.mouse_move(source->context.data, event, mouse_leave);
-		}
+		void *data = source_data_acquire(source);
+		if (data && source->info.mouse_move)
+			source->info.mouse_move(data, event, mouse_leave);
+		source_data_release(source, data);
 	}
 }
 
@@ -1128,9 +1216,10 @@ void obs_source_send_mouse_wheel(obs_source_t *source, const struct obs_mouse_ev
 		return;
 
 	if (source->info.output_flags & OBS_SOURCE_INTERACTION) {
-		if (source->info.mouse_wheel) {
-			source->info.mouse_wheel(source->context.data, event, x_delta, y_delta);
-		}
+		void *data = source_data_acquire(source);
+		if (data && source->info.mouse_wheel)
+			source->info.mouse_wheel(data, event, x_delta, y_delta);
+		source_data_release(source, data);
 	}
 }
 
@@ -1140,9 +1229,10 @@ void obs_source_send_focus(obs_source_t *source, bool focus)
 		return;
 
 	if (source->info.output_flags & OBS_SOURCE_INTERACTION) {
-		if (source->info.focus) {
-			source->info.focus(source->context.data, focus);
-		}
+		void *data = source_data_acquire(source);
+		if (data && source->info.focus)
+			source->info.focus(data, focus);
+		source_data_release(source, data);
 	}
 }
 
@@ -1152,9 +1242,10 @@ void obs_source_send_key_click(obs_source_t *source, const struct obs_key_event
 		return;
 
 	if (source->info.output_flags & OBS_SOURCE_INTERACTION) {
-		if (source->info.key_click) {
-			source->info.key_click(source->context.data, event, key_up);
-		}
+		void *data = source_data_acquire(source);
+		if (data && source->info.key_click)
+			source->info.key_click(data, event, key_up);
+		source_data_release(source, data);
 	}
 }
 
@@ -1196,6 +1287,8 @@ static void hide_source(obs_source_t *source)
 	obs_source_dosignal(source, "source_hide", "hide");
 }
 
+/* ------------------------------------------------------------------------- */
+
 static void activate_tree(obs_source_t *parent, obs_source_t *child, void *param)
 {
 	os_atomic_inc_long(&child->activate_refs);
@@ -1239,6 +1332,7 @@ void obs_source_activate(obs_source_t *source, enum view_type type)
 	if (type == MAIN_VIEW) {
 		os_atomic_inc_long(&source->activate_refs);
 		obs_source_enum_active_tree(source, activate_tree, NULL);
+		obs_audio_graph_invalidate();
 	}
 }
 
@@ -1256,6 +1350,7 @@ void obs_source_deactivate(obs_source_t *source, enum view_type type)
 		if (os_atomic_load_long(&source->activate_refs) > 0) {
 			os_atomic_dec_long(&source->activate_refs);
 			obs_source_enum_active_tree(source, deactivate_tree, NULL);
+			obs_audio_graph_invalidate();
 		}
 	}
 }
@@ -1354,12 +1449,43 @@ static void async_tick(obs_source_t *source)
 	pthread_mutex_unlock(&source->async_mutex);
 }
 
-void obs_source_video_tick(obs_source_t *source, float seconds)
+/* sources that are not showing or active anywhere have their video_tick
+ * callback throttled by obs_set_hidden_tick_interval, unless they have no
+ * video, in which case there is nothing that could tell them apart */
+static bool update_tick_seconds(obs_source_t *source, float seconds)
+{
+	uint32_t interval = (uint32_t)os_atomic_load_long(&obs->data.hidden_tick_interval);
+
+	if (interval == 1 || source->showing || source->active || !(source->info.output_flags & OBS_SOURCE_VIDEO)) {
+		source->tick_seconds = source->skipped_tick_seconds + seconds;
+		source->skipped_tick_seconds = 0.0f;
+		source->skipped_ticks = 0;
+		return true;
+	}
+
+	/* with ticks disabled the source just stops, catching up on all the
+	 * time it has been hidden would be more surprising than useful */
+	if (!interval) {
+		source->skipped_tick_seconds = 0.0f;
+		return false;
+	}
+
+	source->skipped_tick_seconds += seconds;
+	if (++source->skipped_ticks < interval)
+		return false;
+
+	source->tick_seconds = source->skipped_tick_seconds;
+	source->skipped_tick_seconds = 0.0f;
+	source->skipped_ticks = 0;
+	return true;
+}
+
+bool obs_source_video_tick_begin(obs_source_t *source, float seconds)
 {
 	bool now_showing, now_active;
 
-	if (!obs_source_valid(source, "obs_source_video_tick"))
-		return;
+	if (!obs_source_valid(source, "obs_source_video_tick_begin"))
+		return false;
 
 	if (source->info.type == OBS_SOURCE_TYPE_TRANSITION)
 		obs_transition_tick(source, seconds);
@@ -1367,7 +1493,7 @@ void obs_source_video_tick(obs_source_t *source, float seconds)
 	if ((source->info.output_flags & OBS_SOURCE_ASYNC) != 0)
 		async_tick(source);
 
-	if ((source->info.output_flags & OBS_SOURCE_CONTROLLABLE_MEDIA) != 0)
+	if ((source->info.output_flags & OBS_SOURCE_CONTROLLABLE_MEDIA) != 0 && source->context.data)
 		process_media_actions(source);
 
 	if (os_atomic_load_long(&source->defer_update_count) > 0)
@@ -1377,8 +1503,15 @@ void obs_source_video_tick(obs_source_t *source, float seconds)
 	if (source->filter_texrender)
 		gs_texrender_reset(source->filter_texrender);
 
-	/* call show/hide if the reference changed */
 	now_showing = !!source->show_refs;
+	now_active = !!source->activate_refs;
+
+	if (source->lazy && !lazy_source_tick(source, now_showing || now_active)) {
+		now_showing = source->showing;
+		now_active = source->active;
+	}
+
+	/* call show/hide if the reference changed */
 	if (now_showing != source->showing) {
 		if (now_showing) {
 			show_source(source);
@@ -1401,7 +1534,6 @@ void obs_source_video_tick(obs_source_t *source, float seconds)
 	}
 
 	/* call activate/deactivate if the reference changed */
-	now_active = !!source->activate_refs;
 	if (now_active != source->active) {
 		if (now_active) {
 			activate_source(source);
@@ -1423,11 +1555,19 @@ void obs_source_video_tick(obs_source_t *source, float seconds)
 		source->active = now_active;
 	}
 
-	if (source->context.data && source->info.video_tick)
-		source->info.video_tick(source->context.data, seconds);
-
 	source->async_rendered = false;
 	source->deinterlace_rendered = false;
+
+	if (!source->context.data || !source->info.video_tick)
+		return false;
+
+	source->tick_skipped = !update_tick_seconds(source, seconds);
+	return !source->tick_skipped;
+}
+
+void obs_source_video_tick_callback(obs_source_t *source)
+{
+	source->info.video_tick(source->context.data, source->tick_seconds);
 }
 
 /* unless the value is 3+ hours worth of frames, this won't overflow */
@@ -2691,17 +2831,20 @@ static inline uint32_t get_async_height(const obs_source_t *source)
 static uint32_t get_base_width(const obs_source_t *source)
 {
 	bool is_filter = !!source->filter_parent;
-	bool func_valid = source->context.data && source->info.get_width;
 
-	if (source->info.type == OBS_SOURCE_TYPE_TRANSITION) {
+	if (source->info.type == OBS_SOURCE_TYPE_TRANSITION)
 		return source->enabled ? source->transition_actual_cx : 0;
 
-	} else if (func_valid && (!is_filter || source->enabled)) {
-		return source->info.get_width(source->context.data);
+	void *data = source_data_acquire(source);
+	if (data && source->info.get_width && (!is_filter || source->enabled)) {
+		uint32_t cx = source->info.get_width(data);
+		source_data_release(source, data);
+		return cx;
+	}
+	source_data_release(source, data);
 
-	} else if (is_filter) {
+	if (is_filter)
 		return get_base_width(source->filter_target);
-	}
 
 	return source->async_active ? get_async_width(source) : 0;
 }
@@ -2709,17 +2852,20 @@ static uint32_t get_base_width(const obs_source_t *source)
 static uint32_t get_base_height(const obs_source_t *source)
 {
 	bool is_filter = !!source->filter_parent;
-	bool func_valid = source->context.data && source->info.get_height;
 
-	if (source->info.type == OBS_SOURCE_TYPE_TRANSITION) {
+	if (source->info.type == OBS_SOURCE_TYPE_TRANSITION)
 		return source->enabled ? source->transition_actual_cy : 0;
 
-	} else if (func_valid && (!is_filter || source->enabled)) {
-		return source->info.get_height(source->context.data);
+	void *data = source_data_acquire(source);
+	if (data && source->info.get_height && (!is_filter || source->enabled)) {
+		uint32_t cy = source->info.get_height(data);
+		source_data_release(source, data);
+		return cy;
+	}
+	source_data_release(source, data);
 
-	} else if (is_filter) {
+	if (is_filter)
 		return get_base_height(source->filter_target);
-	}
 
 	return source->async_active ? get_async_height(source) : 0;
 }
@@ -3028,10 +3174,17 @@ enum gs_color_space obs_source_get_color_space(obs_source_t *source, size_t coun
 		return space;
 	}
 
-	assert(source->context.data);
-	return source->info.video_get_color_space
-		       ? source->info.video_get_color_space(source->context.data, count, preferred_spaces)
-		       : GS_CS_SRGB;
+	if (!source->info.video_get_color_space)
+		return GS_CS_SRGB;
+
+	void *data = source_data_acquire(source);
+	enum gs_color_space space = GS_CS_SRGB;
+
+	if (data)
+		space = source->info.video_get_color_space(data, count, preferred_spaces);
+
+	source_data_release(source, data);
+	return space;
 }
 
 uint32_t obs_source_get_base_width(obs_source_t *source)
@@ -3475,7 +3628,15 @@ static inline bool async_texture_changed(struct obs_source *source, const struct
 static inline void free_async_cache(struct obs_source *source)
 {
 	for (size_t i = 0; i < source->async_cache.num; i++)
-		obs_source_frame_decref(source->async_cache.array[i].frame);
+		obs_source_frame_decref(source, source->async_cache.array[i].frame);
+
+	for (size_t i = source->async_ref_frames.num; i > 0; i--) {
+		struct async_frame_ref *ref = &source->async_ref_frames.array[i - 1];
+		if (ref->cached) {
+			ref->cached = false;
+			obs_source_frame_decref(source, ref->frame);
+		}
+	}
 
 	da_resize(source->async_cache, 0);
 	da_resize(source->async_frames, 0);
@@ -3501,18 +3662,15 @@ static void clean_cache(obs_source_t *source)
 }
 
 #define MAX_ASYNC_FRAMES 30
-//if return value is not null then do (os_atomic_dec_long(&output->refs) == 0) && obs_source_frame_destroy(output)
-static inline struct obs_source_frame *cache_video(struct obs_source *source, const struct obs_source_frame *frame)
-{
-	struct obs_source_frame *new_frame = NULL;
-
-	pthread_mutex_lock(&source->async_mutex);
 
+/* must be called with async_mutex locked, returns false if the frame should
+ * be dropped */
+static bool prepare_async_cache(struct obs_source *source, const struct obs_source_frame *frame)
+{
 	if (source->async_frames.num >= MAX_ASYNC_FRAMES) {
 		free_async_cache(source);
 		source->last_frame_ts = 0;
-		pthread_mutex_unlock(&source->async_mutex);
-		return NULL;
+		return false;
 	}
 
 	if (async_texture_changed(source, frame)) {
@@ -3521,10 +3679,25 @@ static inline struct obs_source_frame *cache_video(struct obs_source *source, co
 		source->async_cache_height = frame->height;
 	}
 
-	const enum video_format format = frame->format;
-	source->async_cache_format = format;
+	source->async_cache_format = frame->format;
 	source->async_cache_full_range = frame->full_range;
 	source->async_cache_trc = frame->trc;
+	return true;
+}
+
+//if return value is not null then do (os_atomic_dec_long(&output->refs) == 0) && obs_source_frame_destroy(output)
+static inline struct obs_source_frame *cache_video(struct obs_source *source, const struct obs_source_frame *frame)
+{
+	struct obs_source_frame *new_frame = NULL;
+
+	pthread_mutex_lock(&source->async_mutex);
+
+	if (!prepare_async_cache(source, frame)) {
+		pthread_mutex_unlock(&source->async_mutex);
+		return NULL;
+	}
+
+	const enum video_format format = frame->format;
 
 	for (size_t i = 0; i < source->async_cache.num; i++) {
 		struct async_frame *af = &source->async_cache.array[i];
@@ -3560,10 +3733,46 @@ static inline struct obs_source_frame *cache_video(struct obs_source *source, co
 	return new_frame;
 }
 
-static void obs_source_output_video_internal(obs_source_t *source, const struct obs_source_frame *frame)
+/* same contract as cache_video, but the frame data is referenced instead of
+ * copied in to a cached frame */
+static inline struct obs_source_frame *ref_video(struct obs_source *source, const struct obs_source_frame *frame,
+						 obs_source_frame_release_t release, void *param)
 {
-	if (!obs_source_valid(source, "obs_source_output_video"))
+	struct obs_source_frame *new_frame;
+	struct async_frame_ref *ref;
+
+	pthread_mutex_lock(&source->async_mutex);
+
+	if (!prepare_async_cache(source, frame)) {
+		pthread_mutex_unlock(&source->async_mutex);
+		return NULL;
+	}
+
+	clean_cache(source);
+
+	new_frame = bmemdup(frame, sizeof(*frame));
+	new_frame->prev_frame = false;
+	new_frame->refs = 2;
+
+	ref = da_push_back_new(source->async_ref_frames);
+	ref->frame = new_frame;
+	ref->release = release;
+	ref->param = param;
+	ref->cached = true;
+
+	pthread_mutex_unlock(&source->async_mutex);
+
+	return new_frame;
+}
+
+static void obs_source_output_video_internal(obs_source_t *source, const struct obs_source_frame *frame,
+					     obs_source_frame_release_t release, void *param)
+{
+	if (!obs_source_valid(source, "obs_source_output_video")) {
+		if (release)
+			release(param);
 		return;
+	}
 
 	if (!frame) {
 		pthread_mutex_lock(&source->async_mutex);
@@ -3576,13 +3785,17 @@ static void obs_source_output_video_internal(obs_source_t *source, const struct
 
 	source_profiler_async_frame_received(source);
 
-	struct obs_source_frame *output = cache_video(source, frame);
+	struct obs_source_frame *output = release ? ref_video(source, frame, release, param)
+						  : cache_video(source, frame);
+
+	if (!output && release)
+		release(param);
 
 	/* ------------------------------------------- */
 	pthread_mutex_lock(&source->async_mutex);
 	if (output) {
 		if (os_atomic_dec_long(&output->refs) == 0) {
-			obs_source_frame_destroy(output);
+			async_frame_destroy(source, output);
 			output = NULL;
 		} else {
 			da_push_back(source->async_frames, &output);
@@ -3597,14 +3810,40 @@ void obs_source_output_video(obs_source_t *source, const struct obs_source_frame
 	if (destroying(source))
 		return;
 	if (!frame) {
-		obs_source_output_video_internal(source, NULL);
+		obs_source_output_video_internal(source, NULL, NULL, NULL);
 		return;
 	}
 
 	struct obs_source_frame new_frame = *frame;
 	new_frame.full_range = format_is_yuv(frame->format) ? new_frame.full_range : true;
 
-	obs_source_output_video_internal(source, &new_frame);
+	obs_source_output_video_internal(source, &new_frame, NULL, NULL);
+}
+
+static void output_frame2_to_frame(struct obs_source_frame *new_frame, const struct obs_source_frame2 *frame)
+{
+	enum video_range_type range = resolve_video_range(frame->format, frame->range);
+
+	memset(new_frame, 0, sizeof(*new_frame));
+
+	for (size_t i = 0; i < MAX_AV_PLANES; i++) {
+		new_frame->data[i] = frame->data[i];
+		new_frame->linesize[i] = frame->linesize[i];
+	}
+
+	new_frame->width = frame->width;
+	new_frame->height = frame->height;
+	new_frame->timestamp = frame->timestamp;
+	new_frame->format = frame->format;
+	new_frame->full_range = range == VIDEO_RANGE_FULL;
+	new_frame->max_luminance = 0;
+	new_frame->flip = frame->flip;
+	new_frame->flags = frame->flags;
+	new_frame->trc = frame->trc;
+
+	memcpy(&new_frame->color_matrix, &frame->color_matrix, sizeof(frame->color_matrix));
+	memcpy(&new_frame->color_range_min, &frame->color_range_min, sizeof(frame->color_range_min));
+	memcpy(&new_frame->color_range_max, &frame->color_range_max, sizeof(frame->color_range_max));
 }
 
 void obs_source_output_video2(obs_source_t *source, const struct obs_source_frame2 *frame)
@@ -3612,33 +3851,48 @@ void obs_source_output_video2(obs_source_t *source, const struct obs_source_fram
 	if (destroying(source))
 		return;
 	if (!frame) {
-		obs_source_output_video_internal(source, NULL);
+		obs_source_output_video_internal(source, NULL, NULL, NULL);
 		return;
 	}
 
-	struct obs_source_frame new_frame = {0};
-	enum video_range_type range = resolve_video_range(frame->format, frame->range);
+	struct obs_source_frame new_frame;
+	output_frame2_to_frame(&new_frame, frame);
 
-	for (size_t i = 0; i < MAX_AV_PLANES; i++) {
-		new_frame.data[i] = frame->data[i];
-		new_frame.linesize[i] = frame->linesize[i];
+	obs_source_output_video_internal(source, &new_frame, NULL, NULL);
+}
+
+void obs_source_output_video_ref(obs_source_t *source, const struct obs_source_frame *frame,
+				 obs_source_frame_release_t release, void *param)
+{
+	if (!obs_ptr_valid(frame, "obs_source_output_video_ref") ||
+	    !obs_ptr_valid(release, "obs_source_output_video_ref"))
+		return;
+	if (destroying(source)) {
+		release(param);
+		return;
 	}
 
-	new_frame.width = frame->width;
-	new_frame.height = frame->height;
-	new_frame.timestamp = frame->timestamp;
-	new_frame.format = frame->format;
-	new_frame.full_range = range == VIDEO_RANGE_FULL;
-	new_frame.max_luminance = 0;
-	new_frame.flip = frame->flip;
-	new_frame.flags = frame->flags;
-	new_frame.trc = frame->trc;
+	struct obs_source_frame new_frame = *frame;
+	new_frame.full_range = format_is_yuv(frame->format) ? new_frame.full_range : true;
 
-	memcpy(&new_frame.color_matrix, &frame->color_matrix, sizeof(frame->color_matrix));
-	memcpy(&new_frame.color_range_min, &frame->color_range_min, sizeof(frame->color_range_min));
-	memcpy(&new_frame.color_range_max, &frame->color_range_max, sizeof(frame->color_range_max));
+	obs_source_output_video_internal(source, &new_frame, release, param);
+}
 
-	obs_source_output_video_internal(source, &new_frame);
+void obs_source_output_video2_ref(obs_source_t *source, const struct obs_source_frame2 *frame,
+				  obs_source_frame_release_t release, void *param)
+{
+	if (!obs_ptr_valid(frame, "obs_source_output_video2_ref") ||
+	    !obs_ptr_valid(release, "obs_source_output_video2_ref"))
+		return;
+	if (destroying(source)) {
+		release(param);
+		return;
+	}
+
+	struct obs_source_frame new_frame;
+	output_frame2_to_frame(&new_frame, frame);
+
+	obs_source_output_video_internal(source, &new_frame, release, param);
 }
 
 void obs_source_set_async_rotation(obs_source_t *source, long rotation)
@@ -4077,6 +4331,20 @@ void remove_async_frame(obs_source_t *source, struct obs_source_frame *frame)
 
 		if (f->frame == frame) {
 			f->used = false;
+			return;
+		}
+	}
+
+	/* referenced frames are never reused, so hand them back to the
+	 * source as soon as they are no longer in use */
+	for (size_t i = 0; i < source->async_ref_frames.num; i++) {
+		struct async_frame_ref *ref = &source->async_ref_frames.array[i];
+
+		if (ref->frame == frame) {
+			if (ref->cached) {
+				ref->cached = false;
+				obs_source_frame_decref(source, frame);
+			}
 			break;
 		}
 	}
@@ -4228,7 +4496,7 @@ void obs_source_release_frame(obs_source_t *source, struct obs_source_frame *fra
 		pthread_mutex_lock(&source->async_mutex);
 
 		if (os_atomic_dec_long(&frame->refs) == 0)
-			obs_source_frame_destroy(frame);
+			async_frame_destroy(source, frame);
 		else
 			remove_async_frame(source, frame);
 
@@ -4512,6 +4780,10 @@ proc_handler_t *obs_source_get_proc_handler(const obs_source_t *source)
 	return obs_source_valid(source, "obs_source_get_proc_handler") ? source->context.procs : NULL;
 }
 
+enum { VOLUME_SOURCE, VOLUME_VOLUME };
+static const struct calldata_param volume_params[] = {CALLDATA_PARAM_PTR("source"), CALLDATA_PARAM_FLOAT("volume")};
+static struct calldata_layout volume_layout = CALLDATA_LAYOUT(volume_params);
+
 void obs_source_set_volume(obs_source_t *source, float volume)
 {
 	if (obs_source_valid(source, "obs_source_set_volume")) {
@@ -4520,15 +4792,15 @@ void obs_source_set_volume(obs_source_t *source, float volume)
 		struct calldata data;
 		uint8_t stack[128];
 
-		calldata_init_fixed(&data, stack, sizeof(stack));
-		calldata_set_ptr(&data, "source", source);
-		calldata_set_float(&data, "volume", volume);
+		calldata_init_layout(&data, stack, sizeof(stack), &volume_layout);
+		calldata_slot_set_ptr(&data, &volume_layout, VOLUME_SOURCE, source);
+		calldata_slot_set_float(&data, &volume_layout, VOLUME_VOLUME, volume);
 
-		signal_handler_signal(source->context.signals, "volume", &data);
+		signal_handler_signal_id(source->context.signals, source->volume_signal, &data);
 		if (!source->context.private)
 			signal_handler_signal(obs->signals, "source_volume", &data);
 
-		volume = (float)calldata_float(&data, "volume");
+		volume = (float)calldata_slot_float(&data, &volume_layout, VOLUME_VOLUME);
 
 		pthread_mutex_lock(&source->audio_actions_mutex);
 		da_push_back(source->audio_actions, &action);
@@ -4543,19 +4815,23 @@ float obs_source_get_volume(const obs_source_t *source)
 	return obs_source_valid(source, "obs_source_get_volume") ? source->user_volume : 0.0f;
 }
 
+enum { SYNC_SOURCE, SYNC_OFFSET };
+static const struct calldata_param sync_params[] = {CALLDATA_PARAM_PTR("source"), CALLDATA_PARAM_INT("offset")};
+static struct calldata_layout sync_layout = CALLDATA_LAYOUT(sync_params);
+
 void obs_source_set_sync_offset(obs_source_t *source, int64_t offset)
 {
 	if (obs_source_valid(source, "obs_source_set_sync_offset")) {
 		struct calldata data;
 		uint8_t stack[128];
 
-		calldata_init_fixed(&data, stack, sizeof(stack));
-		calldata_set_ptr(&data, "source", source);
-		calldata_set_int(&data, "offset", offset);
+		calldata_init_layout(&data, stack, sizeof(stack), &sync_layout);
+		calldata_slot_set_ptr(&data, &sync_layout, SYNC_SOURCE, source);
+		calldata_slot_set_int(&data, &sync_layout, SYNC_OFFSET, offset);
 
 		signal_handler_signal(source->context.signals, "audio_sync", &data);
 
-		source->sync_offset = calldata_int(&data, "offset");
+		source->sync_offset = calldata_slot_int(&data, &sync_layout, SYNC_OFFSET);
 	}
 }
 
@@ -4577,9 +4853,10 @@ static void enum_source_active_tree_callback(obs_source_t *parent, obs_source_t
 	if (is_transition)
 		obs_transition_enum_sources(child, enum_source_active_tree_callback, param);
 	if (child->info.enum_active_sources) {
-		if (child->context.data) {
-			child->info.enum_active_sources(child->context.data, enum_source_active_tree_callback, data);
-		}
+		void *child_data = source_data_acquire(child);
+		if (child_data)
+			child->info.enum_active_sources(child_data, enum_source_active_tree_callback, data);
+		source_data_release(child, child_data);
 	}
 
 	data->enum_callback(parent, child, data->param);
@@ -4601,8 +4878,12 @@ void obs_source_enum_active_sources(obs_source_t *source, obs_source_enum_proc_t
 
 	if (is_transition)
 		obs_transition_enum_sources(source, enum_callback, param);
-	if (source->info.enum_active_sources)
-		source->info.enum_active_sources(source->context.data, enum_callback, param);
+	if (source->info.enum_active_sources) {
+		void *source_data = source_data_acquire(source);
+		if (source_data)
+			source->info.enum_active_sources(source_data, enum_callback, param);
+		source_data_release(source, source_data);
+	}
 
 	obs_source_release(source);
 }
@@ -4625,8 +4906,12 @@ void obs_source_enum_active_tree(obs_source_t *source, obs_source_enum_proc_t en
 
 	if (source->info.type == OBS_SOURCE_TYPE_TRANSITION)
 		obs_transition_enum_sources(source, enum_source_active_tree_callback, &data);
-	if (source->info.enum_active_sources)
-		source->info.enum_active_sources(source->context.data, enum_source_active_tree_callback, &data);
+	if (source->info.enum_active_sources) {
+		void *source_data = source_data_acquire(source);
+		if (source_data)
+			source->info.enum_active_sources(source_data, enum_source_active_tree_callback, &data);
+		source_data_release(source, source_data);
+	}
 
 	obs_source_release(source);
 }
@@ -4638,14 +4923,13 @@ static void enum_source_full_tree_callback(obs_source_t *parent, obs_source_t *c
 
 	if (is_transition)
 		obs_transition_enum_sources(child, enum_source_full_tree_callback, param);
-	if (child->info.enum_all_sources) {
-		if (child->context.data) {
-			child->info.enum_all_sources(child->context.data, enum_source_full_tree_callback, data);
-		}
-	} else if (child->info.enum_active_sources) {
-		if (child->context.data) {
-			child->info.enum_active_sources(child->context.data, enum_source_full_tree_callback, data);
-		}
+	if (child->info.enum_all_sources || child->info.enum_active_sources) {
+		void *child_data = source_data_acquire(child);
+		if (child_data && child->info.enum_all_sources)
+			child->info.enum_all_sources(child_data, enum_source_full_tree_callback, data);
+		else if (child_data)
+			child->info.enum_active_sources(child_data, enum_source_full_tree_callback, data);
+		source_data_release(child, child_data);
 	}
 
 	data->enum_callback(parent, child, data->param);
@@ -4670,13 +4954,16 @@ void obs_source_enum_full_tree(obs_source_t *source, obs_source_enum_proc_t enum
 	if (source->info.type == OBS_SOURCE_TYPE_TRANSITION)
 		obs_transition_enum_sources(source, enum_source_full_tree_callback, &data);
 
-	if (source->info.enum_all_sources) {
-		source->info.enum_all_sources(source->context.data, enum_source_full_tree_callback, &data);
+	void *source_data = source_data_acquire(source);
 
-	} else if (source->info.enum_active_sources) {
-		source->info.enum_active_sources(source->context.data, enum_source_full_tree_callback, &data);
+	if (source_data && source->info.enum_all_sources) {
+		source->info.enum_all_sources(source_data, enum_source_full_tree_callback, &data);
+
+	} else if (source_data && source->info.enum_active_sources) {
+		source->info.enum_active_sources(source_data, enum_source_full_tree_callback, &data);
 	}
 
+	source_data_release(source, source_data);
 	obs_source_release(source);
 }
 
@@ -4740,23 +5027,38 @@ void obs_source_save(obs_source_t *source)
 
 	obs_source_dosignal(source, "source_save", "save");
 
-	if (source->info.save)
-		source->info.save(source->context.data, source->context.settings);
+	void *data = source->info.save ? source_data_acquire(source) : NULL;
+	if (data)
+		source->info.save(data, source->context.settings);
+	source_data_release(source, data);
 }
 
 void obs_source_load(obs_source_t *source)
 {
-	if (!data_valid(source, "obs_source_load"))
+	if (!obs_source_valid(source, "obs_source_load"))
 		return;
-	if (source->info.load)
+
+	if (source->lazy) {
+		/* lazy sources that are not created yet are loaded once they are */
+		pthread_mutex_lock(&source->lazy_mutex);
+		source->lazy_load_pending = true;
+		if (source->context.data && source->info.load)
+			source->info.load(source->context.data, source->context.settings);
+		pthread_mutex_unlock(&source->lazy_mutex);
+
+	} else if (!source->context.data) {
+		return;
+
+	} else if (source->info.load) {
 		source->info.load(source->context.data, source->context.settings);
+	}
 
 	obs_source_dosignal(source, "source_load", "load");
 }
 
 void obs_source_load2(obs_source_t *source)
 {
-	if (!data_valid(source, "obs_source_load2"))
+	if (!obs_source_valid(source, "obs_source_load2") || (!source->context.data && !source->lazy))
 		return;
 
 	obs_source_load(source);
@@ -4777,14 +5079,18 @@ bool obs_source_showing(const obs_source_t *source)
 	return obs_source_valid(source, "obs_source_showing") ? source->show_refs != 0 : false;
 }
 
+enum { FLAGS_SOURCE, FLAGS_FLAGS };
+static const struct calldata_param flags_params[] = {CALLDATA_PARAM_PTR("source"), CALLDATA_PARAM_INT("flags")};
+static struct calldata_layout flags_layout = CALLDATA_LAYOUT(flags_params);
+
 static inline void signal_flags_updated(obs_source_t *source)
 {
 	struct calldata data;
 	uint8_t stack[128];
 
-	calldata_init_fixed(&data, stack, sizeof(stack));
-	calldata_set_ptr(&data, "source", source);
-	calldata_set_int(&data, "flags", source->flags);
+	calldata_init_layout(&data, stack, sizeof(stack), &flags_layout);
+	calldata_slot_set_ptr(&data, &flags_layout, FLAGS_SOURCE, source);
+	calldata_slot_set_int(&data, &flags_layout, FLAGS_FLAGS, source->flags);
 
 	signal_handler_signal(source->context.signals, "update_flags", &data);
 }
@@ -4813,6 +5119,10 @@ uint32_t obs_source_get_flags(const obs_source_t *source)
 	return obs_source_valid(source, "obs_source_get_flags") ? source->flags : 0;
 }
 
+enum { MIXERS_SOURCE, MIXERS_MIXERS };
+static const struct calldata_param mixers_params[] = {CALLDATA_PARAM_PTR("source"), CALLDATA_PARAM_INT("mixers")};
+static struct calldata_layout mixers_layout = CALLDATA_LAYOUT(mixers_params);
+
 void obs_source_set_audio_mixers(obs_source_t *source, uint32_t mixers)
 {
 	struct calldata data;
@@ -4826,13 +5136,13 @@ void obs_source_set_audio_mixers(obs_source_t *source, uint32_t mixers)
 	if (source->audio_mixers == mixers)
 		return;
 
-	calldata_init_fixed(&data, stack, sizeof(stack));
-	calldata_set_ptr(&data, "source", source);
-	calldata_set_int(&data, "mixers", mixers);
+	calldata_init_layout(&data, stack, sizeof(stack), &mixers_layout);
+	calldata_slot_set_ptr(&data, &mixers_layout, MIXERS_SOURCE, source);
+	calldata_slot_set_int(&data, &mixers_layout, MIXERS_MIXERS, mixers);
 
 	signal_handler_signal(source->context.signals, "audio_mixers", &data);
 
-	mixers = (uint32_t)calldata_int(&data, "mixers");
+	mixers = (uint32_t)calldata_slot_int(&data, &mixers_layout, MIXERS_MIXERS);
 
 	source->audio_mixers = mixers;
 }
@@ -5005,6 +5315,11 @@ bool obs_source_enabled(const obs_source_t *source)
 	return obs_source_valid(source, "obs_source_enabled") ? source->enabled : false;
 }
 
+/* shared by "enable" and the push to mute/talk signals */
+enum { ENABLED_SOURCE, ENABLED_ENABLED };
+static const struct calldata_param enabled_params[] = {CALLDATA_PARAM_PTR("source"), CALLDATA_PARAM_BOOL("enabled")};
+static struct calldata_layout enabled_layout = CALLDATA_LAYOUT(enabled_params);
+
 void obs_source_set_enabled(obs_source_t *source, bool enabled)
 {
 	struct calldata data;
@@ -5015,9 +5330,9 @@ void obs_source_set_enabled(obs_source_t *source, bool enabled)
 
 	source->enabled = enabled;
 
-	calldata_init_fixed(&data, stack, sizeof(stack));
-	calldata_set_ptr(&data, "source", source);
-	calldata_set_bool(&data, "enabled", enabled);
+	calldata_init_layout(&data, stack, sizeof(stack), &enabled_layout);
+	calldata_slot_set_ptr(&data, &enabled_layout, ENABLED_SOURCE, source);
+	calldata_slot_set_bool(&data, &enabled_layout, ENABLED_ENABLED, enabled);
 
 	signal_handler_signal(source->context.signals, "enable", &data);
 }
@@ -5027,6 +5342,10 @@ bool obs_source_muted(const obs_source_t *source)
 	return obs_source_valid(source, "obs_source_muted") ? source->user_muted : false;
 }
 
+enum { MUTE_SOURCE, MUTE_MUTED };
+static const struct calldata_param mute_params[] = {CALLDATA_PARAM_PTR("source"), CALLDATA_PARAM_BOOL("muted")};
+static struct calldata_layout mute_layout = CALLDATA_LAYOUT(mute_params);
+
 void obs_source_set_muted(obs_source_t *source, bool muted)
 {
 	struct calldata data;
@@ -5038,9 +5357,9 @@ void obs_source_set_muted(obs_source_t *source, bool muted)
 
 	source->user_muted = muted;
 
-	calldata_init_fixed(&data, stack, sizeof(stack));
-	calldata_set_ptr(&data, "source", source);
-	calldata_set_bool(&data, "muted", muted);
+	calldata_init_layout(&data, stack, sizeof(stack), &mute_layout);
+	calldata_slot_set_ptr(&data, &mute_layout, MUTE_SOURCE, source);
+	calldata_slot_set_bool(&data, &mute_layout, MUTE_MUTED, muted);
 
 	signal_handler_signal(source->context.signals, "mute", &data);
 
@@ -5054,21 +5373,25 @@ static void source_signal_push_to_changed(obs_source_t *source, const char *sign
 	struct calldata data;
 	uint8_t stack[128];
 
-	calldata_init_fixed(&data, stack, sizeof(stack));
-	calldata_set_ptr(&data, "source", source);
-	calldata_set_bool(&data, "enabled", enabled);
+	calldata_init_layout(&data, stack, sizeof(stack), &enabled_layout);
+	calldata_slot_set_ptr(&data, &enabled_layout, ENABLED_SOURCE, source);
+	calldata_slot_set_bool(&data, &enabled_layout, ENABLED_ENABLED, enabled);
 
 	signal_handler_signal(source->context.signals, signal, &data);
 }
 
+enum { DELAY_SOURCE, DELAY_DELAY };
+static const struct calldata_param delay_params[] = {CALLDATA_PARAM_PTR("source"), CALLDATA_PARAM_INT("delay")};
+static struct calldata_layout delay_layout = CALLDATA_LAYOUT(delay_params);
+
 static void source_signal_push_to_delay(obs_source_t *source, const char *signal, uint64_t delay)
 {
 	struct calldata data;
 	uint8_t stack[128];
 
-	calldata_init_fixed(&data, stack, sizeof(stack));
-	calldata_set_ptr(&data, "source", source);
-	calldata_set_int(&data, "delay", delay);
+	calldata_init_layout(&data, stack, sizeof(stack), &delay_layout);
+	calldata_slot_set_ptr(&data, &delay_layout, DELAY_SOURCE, source);
+	calldata_slot_set_int(&data, &delay_layout, DELAY_DELAY, delay);
 
 	signal_handler_signal(source->context.signals, signal, &data);
 }
@@ -5214,23 +5537,13 @@ static float get_source_volume(obs_source_t *source, uint64_t os_time)
 
 static inline void multiply_output_audio(obs_source_t *source, size_t mix, size_t channels, float vol)
 {
-	register float *out = source->audio_output_buf[mix][0];
-	register float *end = out + AUDIO_OUTPUT_FRAMES * channels;
-
-	while (out < end)
-		*(out++) *= vol;
+	audio_float_mul(source->audio_output_buf[mix][0], vol, AUDIO_OUTPUT_FRAMES * channels);
 }
 
 static inline void multiply_vol_data(obs_source_t *source, size_t mix, size_t channels, float *vol_data)
 {
-	for (size_t ch = 0; ch < channels; ch++) {
-		register float *out = source->audio_output_buf[mix][ch];
-		register float *end = out + AUDIO_OUTPUT_FRAMES;
-		register float *vol = vol_data;
-
-		while (out < end)
-			*(out++) *= *(vol++);
-	}
+	for (size_t ch = 0; ch < channels; ch++)
+		audio_float_mul_ramp(source->audio_output_buf[mix][ch], vol_data, AUDIO_OUTPUT_FRAMES);
 }
 
 static inline void apply_audio_action(obs_source_t *source, const struct audio_action *action)
@@ -5335,7 +5648,7 @@ static void apply_audio_volume(obs_source_t *source, uint32_t mixers, size_t cha
 	}
 }
 
-static void custom_audio_render(obs_source_t *source, uint32_t mixers, size_t channels, size_t sample_rate)
+static void custom_audio_render(obs_source_t *source, void *data, uint32_t mixers, size_t channels, size_t sample_rate)
 {
 	struct obs_source_audio_mix audio_data;
 	bool success;
@@ -5351,7 +5664,7 @@ static void custom_audio_render(obs_source_t *source, uint32_t mixers, size_t ch
 		}
 	}
 
-	success = source->info.audio_render(source->context.data, &ts, &audio_data, mixers, channels, sample_rate);
+	success = source->info.audio_render(data, &ts, &audio_data, mixers, channels, sample_rate);
 	source->audio_ts = success ? ts : 0;
 	source->audio_pending = !success;
 
@@ -5372,7 +5685,7 @@ static void custom_audio_render(obs_source_t *source, uint32_t mixers, size_t ch
 	apply_audio_volume(source, mixers, channels, sample_rate);
 }
 
-static void audio_submix(obs_source_t *source, size_t channels, size_t sample_rate)
+static void audio_submix(obs_source_t *source, void *data, size_t channels, size_t sample_rate)
 {
 	struct audio_output_data audio_data;
 	struct obs_source_audio audio = {0};
@@ -5385,7 +5698,7 @@ static void audio_submix(obs_source_t *source, size_t channels, size_t sample_ra
 
 	memset(source->audio_mix_buf[0], 0, sizeof(float) * AUDIO_OUTPUT_FRAMES * channels);
 
-	success = source->info.audio_mix(source->context.data, &ts, &audio_data, channels, sample_rate);
+	success = source->info.audio_mix(data, &ts, &audio_data, channels, sample_rate);
 
 	if (!success)
 		return;
@@ -5460,16 +5773,21 @@ void obs_source_audio_render(obs_source_t *source, uint32_t mixers, size_t chann
 	}
 
 	if (source->info.audio_render) {
-		if (!source->context.data) {
+		void *data = source_data_acquire(source);
+		if (!data) {
 			source->audio_pending = true;
 			return;
 		}
-		custom_audio_render(source, mixers, channels, sample_rate);
+		custom_audio_render(source, data, mixers, channels, sample_rate);
+		source_data_release(source, data);
 		return;
 	}
 
 	if (source->info.audio_mix) {
-		audio_submix(source, channels, sample_rate);
+		void *data = source_data_acquire(source);
+		if (data)
+			audio_submix(source, data, channels, sample_rate);
+		source_data_release(source, data);
 	}
 
 	if (!source->audio_ts) {
@@ -5556,6 +5874,10 @@ void obs_source_remove_audio_capture_callback(obs_source_t *source, obs_source_a
 	pthread_mutex_unlock(&source->audio_cb_mutex);
 }
 
+enum { MONITORING_SOURCE, MONITORING_TYPE };
+static const struct calldata_param monitoring_params[] = {CALLDATA_PARAM_PTR("source"), CALLDATA_PARAM_INT("type")};
+static struct calldata_layout monitoring_layout = CALLDATA_LAYOUT(monitoring_params);
+
 void obs_source_set_monitoring_type(obs_source_t *source, enum obs_monitoring_type type)
 {
 	struct calldata data;
@@ -5568,9 +5890,9 @@ void obs_source_set_monitoring_type(obs_source_t *source, enum obs_monitoring_ty
 	if (source->monitoring_type == type)
 		return;
 
-	calldata_init_fixed(&data, stack, sizeof(stack));
-	calldata_set_ptr(&data, "source", source);
-	calldata_set_int(&data, "type", type);
+	calldata_init_layout(&data, stack, sizeof(stack), &monitoring_layout);
+	calldata_slot_set_ptr(&data, &monitoring_layout, MONITORING_SOURCE, source);
+	calldata_slot_set_int(&data, &monitoring_layout, MONITORING_TYPE, type);
 
 	signal_handler_signal(source->context.signals, "audio_monitoring", &data);
 
@@ -5657,19 +5979,23 @@ enum speaker_layout obs_source_get_speaker_layout(obs_source_t *source)
 	return source->sample_info.speakers;
 }
 
+enum { BALANCE_SOURCE, BALANCE_BALANCE };
+static const struct calldata_param balance_params[] = {CALLDATA_PARAM_PTR("source"), CALLDATA_PARAM_FLOAT("balance")};
+static struct calldata_layout balance_layout = CALLDATA_LAYOUT(balance_params);
+
 void obs_source_set_balance_value(obs_source_t *source, float balance)
 {
 	if (obs_source_valid(source, "obs_source_set_balance_value")) {
 		struct calldata data;
 		uint8_t stack[128];
 
-		calldata_init_fixed(&data, stack, sizeof(stack));
-		calldata_set_ptr(&data, "source", source);
-		calldata_set_float(&data, "balance", balance);
+		calldata_init_layout(&data, stack, sizeof(stack), &balance_layout);
+		calldata_slot_set_ptr(&data, &balance_layout, BALANCE_SOURCE, source);
+		calldata_slot_set_float(&data, &balance_layout, BALANCE_BALANCE, balance);
 
 		signal_handler_signal(source->context.signals, "audio_balance", &data);
 
-		source->balance = (float)calldata_float(&data, "balance");
+		source->balance = (float)calldata_slot_float(&data, &balance_layout, BALANCE_BALANCE);
 	}
 }
 
@@ -5811,10 +6137,13 @@ int64_t obs_source_media_get_duration(obs_source_t *source)
 
 	if ((source->info.output_flags & OBS_SOURCE_CONTROLLABLE_MEDIA) == 0)
 		return 0;
-	if (source->info.media_get_duration)
-		return source->info.media_get_duration(source->context.data);
-	else
+	if (!source->info.media_get_duration)
 		return 0;
+
+	void *data = source_data_acquire(source);
+	int64_t duration = data ? source->info.media_get_duration(data) : 0;
+	source_data_release(source, data);
+	return duration;
 }
 
 int64_t obs_source_media_get_time(obs_source_t *source)
@@ -5824,10 +6153,13 @@ int64_t obs_source_media_get_time(obs_source_t *source)
 
 	if ((source->info.output_flags & OBS_SOURCE_CONTROLLABLE_MEDIA) == 0)
 		return 0;
-	if (source->info.media_get_time)
-		return source->info.media_get_time(source->context.data);
-	else
+	if (!source->info.media_get_time)
 		return 0;
+
+	void *data = source_data_acquire(source);
+	int64_t time = data ? source->info.media_get_time(data) : 0;
+	source_data_release(source, data);
+	return time;
 }
 
 void obs_source_media_set_time(obs_source_t *source, int64_t ms)
@@ -5856,10 +6188,13 @@ enum obs_media_state obs_source_media_get_state(obs_source_t *source)
 	if ((source->info.output_flags & OBS_SOURCE_CONTROLLABLE_MEDIA) == 0)
 		return OBS_MEDIA_STATE_NONE;
 
-	if (source->info.media_get_state)
-		return source->info.media_get_state(source->context.data);
-	else
+	if (!source->info.media_get_state)
 		return OBS_MEDIA_STATE_NONE;
+
+	void *data = source_data_acquire(source);
+	enum obs_media_state state = data ? source->info.media_get_state(data) : OBS_MEDIA_STATE_NONE;
+	source_data_release(source, data);
+	return state;
 }
 
 void obs_source_media_started(obs_source_t *source)
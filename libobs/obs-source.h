@@ -208,6 +208,24 @@ enum obs_media_state {
  */
 #define OBS_SOURCE_REQUIRES_CANVAS (1 << 17)
 
+/**
+ * Source's video_tick may be called outside of the graphics thread, at the
+ * same time as other sources' video_tick.  It must not call into other
+ * sources and must enter the graphics context itself when it needs it.
+ * These sources are ticked before all other sources.
+ */
+#define OBS_SOURCE_THREADSAFE_TICK (1 << 18)
+
+/**
+ * Lazily created sources of this type may be destroyed again after they have
+ * not been shown or active for a while, and created again later on (see
+ * obs_set_lazy_source_unload_delay).  Creating and destroying the source must
+ * be re-entrant, and destroy must disconnect everything that create connected
+ * outside of the source's own signal handler.  Procedures the source added
+ * with its data and hotkeys it registered are removed along with it.
+ */
+#define OBS_SOURCE_LAZY_UNLOAD (1 << 19)
+
 /** @} */
 
 typedef void (*obs_source_enum_proc_t)(obs_source_t *parent, obs_source_t *child, void *param);
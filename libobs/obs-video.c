@@ -29,6 +29,39 @@
 #include <windows.h>
 #endif
 
+/*
+ * The video_tick callbacks of sources with OBS_SOURCE_THREADSAFE_TICK are
+ * called after those of all other sources, spread over the graphics thread
+ * and the libobs thread pool once they took longer than TICK_PARALLEL_NS
+ * together in the previous frame.  Below that, waking up the pool costs more
+ * than it saves.
+ */
+#define TICK_PARALLEL_NS 250000ULL
+
+static void tick_threaded_source(void *param, size_t idx)
+{
+	struct obs_core_data *data = param;
+	obs_source_t *source = data->threaded_ticks.array[idx];
+	uint64_t start = os_gettime_ns();
+
+	obs_source_video_tick_callback(source);
+	source->tick_time += os_gettime_ns() - start;
+}
+
+static void tick_threaded_sources(struct obs_core_data *data)
+{
+	if (data->threaded_ticks_time >= TICK_PARALLEL_NS) {
+		obs_parallel_for(&data->tick_pool, data->threaded_ticks.num, tick_threaded_source, data);
+	} else {
+		for (size_t i = 0; i < data->threaded_ticks.num; i++)
+			tick_threaded_source(data, i);
+	}
+
+	data->threaded_ticks_time = 0;
+	for (size_t i = 0; i < data->threaded_ticks.num; i++)
+		data->threaded_ticks_time += data->threaded_ticks.array[i]->tick_time;
+}
+
 static uint64_t tick_sources(uint64_t cur_time, uint64_t last_time)
 {
 	struct obs_core_data *data = &obs->data;
@@ -75,13 +108,43 @@ static uint64_t tick_sources(uint64_t cur_time, uint64_t last_time)
 	/* ------------------------------------- */
 	/* call the tick function of each source */
 
+	/* sources with thread-safe ticks can't depend on other sources, so
+	 * they go first, and scenes and other sources that use them see their
+	 * state for this frame */
+	da_clear(data->threaded_ticks);
+
 	for (size_t i = 0; i < data->sources_to_tick.num; i++) {
 		obs_source_t *s = data->sources_to_tick.array[i];
-		if (!obs_source_removed(s)) {
-			const uint64_t start = source_profiler_source_tick_start();
-			obs_source_video_tick(s, seconds);
-			source_profiler_source_tick_end(s, start);
-		}
+		if (obs_source_removed(s) || (s->info.output_flags & OBS_SOURCE_THREADSAFE_TICK) == 0)
+			continue;
+
+		const uint64_t start = source_profiler_source_tick_start();
+
+		if (obs_source_video_tick_begin(s, seconds))
+			da_push_back(data->threaded_ticks, &s);
+
+		s->tick_time = start ? os_gettime_ns() - start : 0;
+	}
+
+	tick_threaded_sources(data);
+
+	for (size_t i = 0; i < data->sources_to_tick.num; i++) {
+		obs_source_t *s = data->sources_to_tick.array[i];
+		if (obs_source_removed(s) || (s->info.output_flags & OBS_SOURCE_THREADSAFE_TICK) != 0)
+			continue;
+
+		const uint64_t start = source_profiler_source_tick_start();
+
+		if (obs_source_video_tick_begin(s, seconds))
+			obs_source_video_tick_callback(s);
+
+		s->tick_time = start ? os_gettime_ns() - start : 0;
+	}
+
+	for (size_t i = 0; i < data->sources_to_tick.num; i++) {
+		obs_source_t *s = data->sources_to_tick.array[i];
+		if (!obs_source_removed(s))
+			source_profiler_source_tick_end(s, s->tick_time, s->tick_skipped);
 		obs_source_release(s);
 	}
 
@@ -105,6 +105,7 @@ void obs_view_set_source(obs_view_t *view, uint32_t channel, obs_source_t *sourc
 	view->channels[channel] = source;
 
 	pthread_mutex_unlock(&view->channels_mutex);
+	obs_audio_graph_invalidate();
 
 	if (source)
 		obs_source_activate(source, view->type);
@@ -161,6 +162,7 @@ video_t *obs_view_add2(obs_view_t *view, struct obs_video_info *ovi)
 	pthread_mutex_lock(&obs->video.mixes_mutex);
 	da_push_back(obs->video.mixes, &mix);
 	pthread_mutex_unlock(&obs->video.mixes_mutex);
+	obs_audio_graph_invalidate();
 
 	return mix->video;
 }
@@ -176,6 +178,7 @@ void obs_view_remove(obs_view_t *view)
 			obs->video.mixes.array[i]->view = NULL;
 	}
 	pthread_mutex_unlock(&obs->video.mixes_mutex);
+	obs_audio_graph_invalidate();
 }
 
 void obs_view_enum_video_info(obs_view_t *view, bool (*enum_proc)(void *, struct obs_video_info *), void *param)
@@ -18,6 +18,7 @@
 #include <inttypes.h>
 
 #include "graphics/matrix4.h"
+#include "graphics/image-file.h"
 #include "callback/calldata.h"
 
 #include "obs.h"
@@ -41,6 +42,7 @@ static inline void make_video_info(struct video_output_info *vi, struct obs_vide
 	vi->range = ovi->range;
 	vi->colorspace = ovi->colorspace;
 	vi->cache_size = 6;
+	vi->scale_threads = ovi->scale_threads;
 }
 
 static inline void calc_gpu_conversion_sizes(struct obs_core_video_mix *video)
@@ -857,6 +859,7 @@ static void obs_free_graphics(void)
 	if (video->graphics) {
 		gs_enter_context(video->graphics);
 
+		gs_image_cache_clear();
 		gs_texture_destroy(video->transparent_texture);
 
 		gs_samplerstate_destroy(video->point_sampler);
@@ -917,6 +920,11 @@ static bool obs_init_audio(struct audio_output_info *ai)
 	audio->monitoring_device_id = bstrdup("default");
 	audio->monitoring_duplicating_source = NULL;
 
+	/* nothing has walked the source tree yet */
+	obs_audio_graph_invalidate();
+
+	obs_parallel_pool_init(&audio->render_pool, obs->thread_pool);
+
 	signal_handler_add(obs->signals, "void deduplication_changed(ptr source)");
 	signal_handler_connect(obs->signals, "deduplication_changed", apply_monitoring_deduplication, NULL);
 
@@ -947,9 +955,15 @@ static void obs_free_audio(void)
 	if (audio->audio)
 		audio_output_close(audio->audio);
 
+	obs_parallel_pool_free(&audio->render_pool);
+	da_free(audio->render_leaves);
 	deque_free(&audio->buffered_timestamps);
 	da_free(audio->render_order);
 	da_free(audio->root_nodes);
+	for (size_t i = 0; i < audio->graph_order.num; i++)
+		obs_weak_source_release(audio->graph_order.array[i]);
+	da_free(audio->graph_order);
+	da_free(audio->graph_roots);
 
 	da_free(audio->monitors);
 	bfree(audio->monitoring_device_name);
@@ -992,6 +1006,9 @@ static bool obs_init_data(void)
 	data->canvases = NULL;
 	data->named_canvases = NULL;
 	data->private_data = obs_data_create();
+	data->hidden_tick_interval = 1;
+	data->lazy_unload_delay = 0;
+	obs_parallel_pool_init(&data->tick_pool, obs->thread_pool);
 	data->valid = true;
 
 fail:
@@ -1073,6 +1090,9 @@ static void obs_free_data(void)
 		bfree(data->protocols.array[i]);
 	da_free(data->protocols);
 	da_free(data->sources_to_tick);
+
+	obs_parallel_pool_free(&data->tick_pool);
+	da_free(data->threaded_ticks);
 }
 
 static const char *obs_signals[] = {
@@ -1222,6 +1242,8 @@ static bool obs_init(const char *locale, const char *module_config_path, profile
 {
 	obs = bzalloc(sizeof(struct obs_core));
 
+	obs_packet_pool_init();
+
 	pthread_mutex_init_value(&obs->audio.monitoring_mutex);
 	pthread_mutex_init_value(&obs->audio.task_mutex);
 	pthread_mutex_init_value(&obs->video.task_mutex);
@@ -1237,6 +1259,12 @@ static bool obs_init(const char *locale, const char *module_config_path, profile
 
 	log_system_info();
 
+	/* used by the tick and audio render loops */
+	obs->thread_pool = os_thread_pool_create("obs_thread_pool", 0);
+	if (!obs->thread_pool)
+		return false;
+	gs_image_file_set_decode_pool(obs->thread_pool);
+
 	if (!obs_init_data())
 		return false;
 	if (!obs_init_handlers())
@@ -1429,12 +1457,18 @@ void obs_shutdown(void)
 	}
 	obs->first_disabled_module = NULL;
 
+	obs_set_module_manifest_cache(NULL);
 	obs_free_data();
 	obs_free_audio();
 	obs_free_video();
 	os_task_queue_destroy(obs->destruction_task_thread);
+	gs_image_file_set_decode_pool(NULL);
+	os_thread_pool_destroy(obs->thread_pool);
 	obs_free_hotkeys();
 	obs_free_graphics();
+	obs_packet_pool_free();
+	obs_data_free_keys();
+	gs_effect_cache_set_path(NULL);
 	proc_handler_destroy(obs->procs);
 	signal_handler_destroy(obs->signals);
 	obs->procs = NULL;
@@ -2259,6 +2293,7 @@ static obs_source_t *obs_load_source_type(obs_data_t *source_data, bool is_priva
 	const char *uuid = obs_data_get_string(source_data, "uuid");
 	const char *id = obs_data_get_string(source_data, "id");
 	const char *v_id = obs_data_get_string(source_data, "versioned_id");
+	bool lazy = obs_data_get_bool(source_data, "lazy");
 	obs_data_t *settings = obs_data_get_obj(source_data, "settings");
 	obs_data_t *hotkeys = obs_data_get_obj(source_data, "hotkeys");
 	obs_canvas_t *canvas = NULL;
@@ -2287,7 +2322,8 @@ static obs_source_t *obs_load_source_type(obs_data_t *source_data, bool is_priva
 		}
 	}
 
-	source = obs_source_create_set_last_ver(canvas, v_id, name, uuid, settings, hotkeys, prev_ver, is_private);
+	source = obs_source_create_set_last_ver(canvas, v_id, name, uuid, settings, hotkeys, prev_ver, is_private,
+						lazy);
 
 	if (source->owns_info_id) {
 		bfree((void *)source->info.unversioned_id);
@@ -2464,9 +2500,12 @@ obs_data_t *obs_save_source(obs_source_t *source)
 	hotkeys = obs_hotkeys_save_source(source);
 
 	if (hotkeys) {
+		/* lazy sources read the hotkey data when they are created */
+		pthread_mutex_lock(&obs->hotkeys.mutex);
 		obs_data_release(hotkey_data);
 		source->context.hotkey_data = hotkeys;
 		hotkey_data = hotkeys;
+		pthread_mutex_unlock(&obs->hotkeys.mutex);
 	}
 
 	obs_data_set_int(source_data, "prev_ver", LIBOBS_API_VER);
@@ -2492,6 +2531,9 @@ obs_data_t *obs_save_source(obs_source_t *source)
 	obs_data_set_int(source_data, "deinterlace_field_order", di_order);
 	obs_data_set_int(source_data, "monitoring_type", m_type);
 
+	if (source->lazy)
+		obs_data_set_bool(source_data, "lazy", true);
+
 	if (canvas) {
 		obs_data_set_string(source_data, "canvas_uuid", obs_canvas_get_uuid(canvas));
 		obs_canvas_release(canvas);
@@ -2877,6 +2919,11 @@ profiler_name_store_t *obs_get_profiler_name_store(void)
 	return obs->name_store;
 }
 
+os_thread_pool_t *obs_get_thread_pool(void)
+{
+	return obs ? obs->thread_pool : NULL;
+}
+
 uint64_t obs_get_video_frame_time(void)
 {
 	return obs->video.video_time;
@@ -2897,6 +2944,26 @@ uint64_t obs_get_frame_interval_ns(void)
 	return obs->video.video_frame_interval_ns;
 }
 
+void obs_set_hidden_tick_interval(uint32_t frames)
+{
+	os_atomic_set_long(&obs->data.hidden_tick_interval, (long)frames);
+}
+
+uint32_t obs_get_hidden_tick_interval(void)
+{
+	return (uint32_t)os_atomic_load_long(&obs->data.hidden_tick_interval);
+}
+
+void obs_set_lazy_source_unload_delay(uint32_t seconds)
+{
+	os_atomic_set_long(&obs->data.lazy_unload_delay, (long)seconds);
+}
+
+uint32_t obs_get_lazy_source_unload_delay(void)
+{
+	return (uint32_t)os_atomic_load_long(&obs->data.lazy_unload_delay);
+}
+
 enum obs_obj_type obs_obj_get_type(void *obj)
 {
 	struct obs_context_data *context = obj;
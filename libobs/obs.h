@@ -21,6 +21,7 @@
 #include "util/bmem.h"
 #include "util/profiler.h"
 #include "util/text-lookup.h"
+#include "util/thread-pool.h"
 #include "graphics/graphics.h"
 #include "graphics/vec2.h"
 #include "graphics/vec3.h"
@@ -216,6 +217,12 @@ struct obs_video_info {
 	enum video_range_type range;      /**< YUV range (if YUV) */
 
 	enum obs_scale_type scale_type; /**< How to scale if scaling */
+
+	/**
+	 * Threads used to convert/scale each raw output on the CPU, 0 to pick
+	 * automatically
+	 */
+	uint32_t scale_threads;
 };
 
 /**
@@ -419,6 +426,13 @@ EXPORT void obs_init_win32_crash_handler(void);
  */
 EXPORT profiler_name_store_t *obs_get_profiler_name_store(void);
 
+/**
+ * Returns the thread pool shared by libobs and plugins for short one-shot
+ * work (see util/thread-pool.h), or NULL in case obs_initialized() returns
+ * false.  Tasks must not block for long periods of time.
+ */
+EXPORT os_thread_pool_t *obs_get_thread_pool(void);
+
 /**
  * Sets base video output base resolution/fps/format.
  *
@@ -609,6 +623,33 @@ typedef void (*obs_find_module_callback2_t)(void *param, const struct obs_module
 
 /** Finds all modules within the search paths added by obs_add_module_path. */
 EXPORT void obs_find_modules2(obs_find_module_callback2_t callback, void *param);
+
+/**
+ * Sets the file the module manifest cache is kept in, or NULL to disable it.
+ * The manifest records the types each module registered when it was last
+ * loaded, so it should be set before modules are loaded.
+ */
+EXPORT void obs_set_module_manifest_cache(const char *path);
+
+struct obs_module_manifest {
+	const char *bin_path;
+	const char *data_path;
+	const char *name;
+
+	/* NULL-terminated lists of type ids */
+	const char *const *sources;
+	const char *const *outputs;
+	const char *const *encoders;
+	const char *const *services;
+};
+
+typedef void (*obs_find_module_manifest_callback_t)(void *param, const struct obs_module_manifest *manifest);
+
+/**
+ * Finds all modules within the search paths that have an up to date entry in
+ * the module manifest cache, without opening them.
+ */
+EXPORT void obs_find_module_manifests(obs_find_module_manifest_callback_t callback, void *param);
 #endif
 
 typedef void (*obs_enum_module_callback_t)(void *param, obs_module_t *module);
@@ -913,6 +954,23 @@ EXPORT uint64_t obs_get_frame_interval_ns(void);
 EXPORT uint32_t obs_get_total_frames(void);
 EXPORT uint32_t obs_get_lagged_frames(void);
 
+/**
+ * Sets how often sources that are neither showing nor active get their
+ * video_tick callback called: every frame (1, the default), every Nth frame
+ * with the time of the skipped frames added up, or not at all (0).  Sources
+ * without video are always ticked.
+ */
+EXPORT void obs_set_hidden_tick_interval(uint32_t frames);
+EXPORT uint32_t obs_get_hidden_tick_interval(void);
+
+/**
+ * Sets how many seconds lazy sources of types with OBS_SOURCE_LAZY_UNLOAD stay
+ * created after they were last shown or active before they are destroyed again
+ * until they are needed.  0, the default, keeps them created.
+ */
+EXPORT void obs_set_lazy_source_unload_delay(uint32_t seconds);
+EXPORT uint32_t obs_get_lazy_source_unload_delay(void);
+
 OBS_DEPRECATED EXPORT bool obs_nv12_tex_active(void);
 OBS_DEPRECATED EXPORT bool obs_p010_tex_active(void);
 
@@ -1047,6 +1105,21 @@ EXPORT obs_source_t *obs_source_create(const char *id, const char *name, obs_dat
 
 EXPORT obs_source_t *obs_source_create_private(const char *id, const char *name, obs_data_t *settings);
 
+/**
+ * Creates an input source whose creation is deferred until it is first shown
+ * or activated, or until obs_source_preload is called.  Until then it keeps
+ * its settings but does not render or output anything.  Saved sources remember
+ * this, so they are loaded lazily again.
+ */
+EXPORT obs_source_t *obs_source_create_lazy(const char *id, const char *name, obs_data_t *settings,
+					    obs_data_t *hotkey_data);
+
+/** Returns true if the source was created with obs_source_create_lazy */
+EXPORT bool obs_source_is_lazy(const obs_source_t *source);
+
+/** Creates a lazy source right away if it has not been created yet */
+EXPORT void obs_source_preload(obs_source_t *source);
+
 /* if source has OBS_SOURCE_DO_NOT_DUPLICATE output flag set, only returns a
  * reference */
 EXPORT obs_source_t *obs_source_duplicate(obs_source_t *source, const char *desired_name, bool create_private);
@@ -1416,6 +1489,22 @@ EXPORT void obs_source_draw(gs_texture_t *image, int x, int y, uint32_t cx, uint
 EXPORT void obs_source_output_video(obs_source_t *source, const struct obs_source_frame *frame);
 EXPORT void obs_source_output_video2(obs_source_t *source, const struct obs_source_frame2 *frame);
 
+typedef void (*obs_source_frame_release_t)(void *param);
+
+/**
+ * Outputs asynchronous video data without copying it.  The plane data of the
+ * frame is borrowed by libobs until it has been uploaded or dropped, at which
+ * point the release callback is called exactly once with the given param so
+ * the source can return the buffer to its own pool.
+ *
+ * The release callback can be called from any thread, including the calling
+ * thread, and must not call back in to the source.
+ */
+EXPORT void obs_source_output_video_ref(obs_source_t *source, const struct obs_source_frame *frame,
+					obs_source_frame_release_t release, void *param);
+EXPORT void obs_source_output_video2_ref(obs_source_t *source, const struct obs_source_frame2 *frame,
+					 obs_source_frame_release_t release, void *param);
+
 EXPORT void obs_source_set_async_rotation(obs_source_t *source, long rotation);
 
 EXPORT void obs_source_output_cea708(obs_source_t *source, const struct obs_source_cea_708 *captions);
@@ -2450,6 +2539,29 @@ EXPORT uint32_t obs_encoder_get_caps(const obs_encoder_t *encoder);
 EXPORT void obs_encoder_packet_ref(struct encoder_packet *dst, struct encoder_packet *src);
 EXPORT void obs_encoder_packet_release(struct encoder_packet *packet);
 
+struct obs_nal_unit;
+
+/**
+ * Returns the NAL units of an H.264/HEVC packet received by an output, as
+ * found once when the packet was sent off by its encoder, or NULL if the
+ * packet was not indexed (in which case it has to be scanned for them).
+ */
+EXPORT const struct obs_nal_unit *obs_encoder_packet_get_nal_units(const struct encoder_packet *packet,
+								   size_t *num);
+
+/** Encoder packet payload pool statistics */
+struct obs_packet_pool_stats {
+	uint64_t hits;          /**< allocations served from a free list */
+	uint64_t misses;        /**< allocations that needed a new block */
+	uint64_t oversized;     /**< payloads too large to be pooled */
+	uint64_t recycled;      /**< blocks returned to the pool */
+	uint64_t discarded;     /**< blocks freed because the pool was full */
+	uint64_t cached_blocks; /**< blocks currently held by the pool */
+	uint64_t cached_bytes;  /**< payload bytes currently held by the pool */
+};
+
+EXPORT void obs_get_packet_pool_stats(struct obs_packet_pool_stats *stats);
+
 EXPORT void *obs_encoder_create_rerouted(obs_encoder_t *encoder, const char *reroute_id);
 
 /** Returns whether encoder is paused */
@@ -14,10 +14,20 @@
  * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
  */
 
+#ifdef __linux__
+#define _GNU_SOURCE
+#endif
+
 #include "buffered-file-serializer.h"
 
 #include <inttypes.h>
 
+#ifdef __linux__
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
 #include "platform.h"
 #include "threading.h"
 #include "deque.h"
@@ -26,6 +36,160 @@
 static const size_t DEFAULT_BUF_SIZE = 256ULL * 1048576ULL; // 256 MiB
 static const size_t DEFAULT_CHUNK_SIZE = 1048576;           // 1 MiB
 
+/* ========================================================================== */
+/* Direct I/O (Linux only)                                                    */
+
+#ifdef __linux__
+/* Writing around the page cache means the I/O thread never ends up throttled
+ * by the kernel flushing gigabytes of dirty pages at once, which otherwise
+ * stalls it long enough for the buffer to fill up and block the output.
+ *
+ * O_DIRECT requires offsets, sizes and memory to be block aligned, so writes
+ * are collected in an aligned buffer and partial blocks at either end are
+ * completed with what is already in the file. The file is truncated to its
+ * actual size once closed. */
+
+#define DIRECT_IO_ALIGN 4096
+#define DIRECT_IO_BUF_SIZE (4 * 1048576)
+
+struct direct_file {
+	int fd;
+	uint8_t *buf;
+	uint8_t *block;
+
+	/* aligned file offset of buf[0] */
+	uint64_t buf_pos;
+	size_t used;
+
+	uint64_t pos;
+	uint64_t size;
+};
+
+static bool direct_file_open(struct direct_file *df, const char *path)
+{
+	memset(df, 0, sizeof(*df));
+
+	df->fd = open(path, O_RDWR | O_CREAT | O_TRUNC | O_DIRECT | O_CLOEXEC, 0644);
+	if (df->fd == -1)
+		return false;
+
+	if (posix_memalign((void **)&df->buf, DIRECT_IO_ALIGN, DIRECT_IO_BUF_SIZE) != 0 ||
+	    posix_memalign((void **)&df->block, DIRECT_IO_ALIGN, DIRECT_IO_ALIGN) != 0) {
+		free(df->buf);
+		close(df->fd);
+		return false;
+	}
+
+	return true;
+}
+
+static bool direct_read_block(struct direct_file *df, uint64_t offset, uint8_t *dst)
+{
+	memset(dst, 0, DIRECT_IO_ALIGN);
+
+	if (offset >= df->size)
+		return true;
+
+	ssize_t ret;
+	do {
+		ret = pread(df->fd, dst, DIRECT_IO_ALIGN, (off_t)offset);
+	} while (ret == -1 && errno == EINTR);
+
+	return ret != -1;
+}
+
+static bool direct_flush(struct direct_file *df)
+{
+	if (!df->used)
+		return true;
+
+	size_t partial = df->used % DIRECT_IO_ALIGN;
+	size_t len = df->used - partial;
+
+	if (partial) {
+		/* keep whatever follows the new data in its last block */
+		if (!direct_read_block(df, df->buf_pos + len, df->block))
+			return false;
+
+		memcpy(df->buf + df->used, df->block + partial, DIRECT_IO_ALIGN - partial);
+		len += DIRECT_IO_ALIGN;
+	}
+
+	const uint8_t *data = df->buf;
+	uint64_t offset = df->buf_pos;
+
+	while (len) {
+		ssize_t ret = pwrite(df->fd, data, len, (off_t)offset);
+		if (ret == -1 && errno == EINTR)
+			continue;
+		if (ret <= 0)
+			return false;
+
+		data += ret;
+		offset += (uint64_t)ret;
+		len -= (size_t)ret;
+	}
+
+	if (df->buf_pos + df->used > df->size)
+		df->size = df->buf_pos + df->used;
+
+	df->used = 0;
+	return true;
+}
+
+static bool direct_file_seek(struct direct_file *df, uint64_t pos)
+{
+	if (pos == df->pos)
+		return true;
+
+	bool success = direct_flush(df);
+	df->pos = pos;
+	return success;
+}
+
+static bool direct_file_write(struct direct_file *df, const uint8_t *data, size_t size)
+{
+	while (size) {
+		if (!df->used) {
+			df->buf_pos = df->pos & ~(uint64_t)(DIRECT_IO_ALIGN - 1);
+			df->used = (size_t)(df->pos - df->buf_pos);
+
+			if (df->used && !direct_read_block(df, df->buf_pos, df->buf))
+				return false;
+		}
+
+		size_t n = DIRECT_IO_BUF_SIZE - df->used;
+		if (n > size)
+			n = size;
+
+		memcpy(df->buf + df->used, data, n);
+		df->used += n;
+		df->pos += n;
+		data += n;
+		size -= n;
+
+		if (df->used == DIRECT_IO_BUF_SIZE && !direct_flush(df))
+			return false;
+	}
+
+	return true;
+}
+
+static bool direct_file_close(struct direct_file *df)
+{
+	bool success = direct_flush(df);
+
+	if (ftruncate(df->fd, (off_t)df->size) != 0)
+		success = false;
+	if (close(df->fd) != 0)
+		success = false;
+
+	free(df->buf);
+	free(df->block);
+	return success;
+}
+#endif
+
 /* ========================================================================== */
 /* Buffered writer based on ffmpeg-mux implementation                         */
 
@@ -43,6 +207,10 @@ struct io_buffer {
 	pthread_t io_thread;
 	pthread_mutex_t data_mutex;
 	FILE *output_file;
+#ifdef __linux__
+	bool direct;
+	struct direct_file direct_file;
+#endif
 	struct deque data;
 	uint64_t next_pos;
 
@@ -55,6 +223,33 @@ struct file_output_data {
 	struct io_buffer io;
 };
 
+static bool io_seek(struct io_buffer *io, uint64_t pos)
+{
+#ifdef __linux__
+	if (io->direct)
+		return direct_file_seek(&io->direct_file, pos);
+#endif
+	return os_fseeki64(io->output_file, (int64_t)pos, SEEK_SET) == 0;
+}
+
+static bool io_write(struct io_buffer *io, const void *data, size_t size)
+{
+#ifdef __linux__
+	if (io->direct)
+		return direct_file_write(&io->direct_file, data, size);
+#endif
+	return fwrite(data, 1, size, io->output_file) == size;
+}
+
+static bool io_close(struct io_buffer *io)
+{
+#ifdef __linux__
+	if (io->direct)
+		return direct_file_close(&io->direct_file);
+#endif
+	return fclose(io->output_file) == 0;
+}
+
 static void *io_thread(void *opaque)
 {
 	struct file_output_data *out = opaque;
@@ -160,7 +355,13 @@ static void *io_thread(void *opaque)
 
 			// Seek if we need to
 			if (want_seek) {
-				os_fseeki64(out->io.output_file, next_seek_position, SEEK_SET);
+				if (!io_seek(&out->io, next_seek_position)) {
+					blog(LOG_ERROR, "Error seeking in '%s': %s", out->filename.array,
+					     strerror(errno));
+					os_atomic_set_bool(&out->io.output_error, true);
+
+					goto error;
+				}
 
 				// Update the next virtual position, making sure to take
 				// into account the size of the chunk we're about to write.
@@ -177,10 +378,9 @@ static void *io_thread(void *opaque)
 			}
 
 			// Write the current chunk to the output file
-			size_t bytes_written = fwrite(chunk, 1, chunk_used, out->io.output_file);
-			if (bytes_written != chunk_used) {
-				blog(LOG_ERROR, "Error writing to '%s': %s (%zu != %zu)\n", out->filename.array,
-				     strerror(errno), bytes_written, chunk_used);
+			if (!io_write(&out->io, chunk, chunk_used)) {
+				blog(LOG_ERROR, "Error writing %zu bytes to '%s': %s", chunk_used, out->filename.array,
+				     strerror(errno));
 				os_atomic_set_bool(&out->io.output_error, true);
 
 				goto error;
@@ -199,7 +399,11 @@ error:
 	if (chunk)
 		bfree(chunk);
 
-	fclose(out->io.output_file);
+	if (!io_close(&out->io)) {
+		blog(LOG_ERROR, "Error closing '%s': %s", out->filename.array, strerror(errno));
+		os_atomic_set_bool(&out->io.output_error, true);
+	}
+
 	return NULL;
 }
 
@@ -319,12 +523,26 @@ static int64_t file_output_get_pos(void *opaque)
 	return (int64_t)out->io.next_pos;
 }
 
-bool buffered_file_serializer_init_defaults(struct serializer *s, const char *path)
+static bool open_output_file(struct io_buffer *io, const char *path, bool direct)
 {
-	return buffered_file_serializer_init(s, path, 0, 0);
+#ifdef __linux__
+	if (direct) {
+		io->direct = direct_file_open(&io->direct_file, path);
+		if (io->direct)
+			return true;
+
+		blog(LOG_WARNING, "Unable to open '%s' for direct I/O (%s), falling back to buffered I/O", path,
+		     strerror(errno));
+	}
+#else
+	UNUSED_PARAMETER(direct);
+#endif
+
+	io->output_file = os_fopen(path, "wb");
+	return io->output_file != NULL;
 }
 
-bool buffered_file_serializer_init(struct serializer *s, const char *path, size_t max_bufsize, size_t chunk_size)
+static bool init_internal(struct serializer *s, const char *path, size_t max_bufsize, size_t chunk_size, bool direct)
 {
 	struct file_output_data *out;
 
@@ -332,8 +550,7 @@ bool buffered_file_serializer_init(struct serializer *s, const char *path, size_
 
 	dstr_init_copy(&out->filename, path);
 
-	out->io.output_file = os_fopen(path, "wb");
-	if (!out->io.output_file) {
+	if (!open_output_file(&out->io, path, direct)) {
 		dstr_free(&out->filename);
 		bfree(out);
 		return false;
@@ -363,6 +580,22 @@ bool buffered_file_serializer_init(struct serializer *s, const char *path, size_
 	return true;
 }
 
+bool buffered_file_serializer_init_defaults(struct serializer *s, const char *path)
+{
+	return buffered_file_serializer_init(s, path, 0, 0);
+}
+
+bool buffered_file_serializer_init(struct serializer *s, const char *path, size_t max_bufsize, size_t chunk_size)
+{
+	return init_internal(s, path, max_bufsize, chunk_size, false);
+}
+
+bool buffered_file_serializer_init_direct(struct serializer *s, const char *path, size_t max_bufsize,
+					  size_t chunk_size)
+{
+	return init_internal(s, path, max_bufsize, chunk_size, true);
+}
+
 void buffered_file_serializer_free(struct serializer *s)
 {
 	struct file_output_data *out = s->data;
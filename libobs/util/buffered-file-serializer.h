@@ -25,6 +25,10 @@ extern "C" {
 EXPORT bool buffered_file_serializer_init_defaults(struct serializer *s, const char *path);
 EXPORT bool buffered_file_serializer_init(struct serializer *s, const char *path, size_t max_bufsize,
 					  size_t chunk_size);
+/* Same as buffered_file_serializer_init(), but bypasses the page cache where
+ * supported (O_DIRECT on Linux), falling back to buffered I/O otherwise. */
+EXPORT bool buffered_file_serializer_init_direct(struct serializer *s, const char *path, size_t max_bufsize,
+						 size_t chunk_size);
 EXPORT void buffered_file_serializer_free(struct serializer *s);
 
 #ifdef __cplusplus
@@ -61,6 +61,9 @@ static inline uint32_t get_winver(void)
 	return winver;
 }
 
+/* the dll directory is process-wide, so modules are loaded one at a time */
+static SRWLOCK dll_directory_lock = SRWLOCK_INIT;
+
 void *os_dlopen(const char *path)
 {
 	struct dstr dll_name;
@@ -79,6 +82,8 @@ void *os_dlopen(const char *path)
 
 	dstr_free(&dll_name);
 
+	AcquireSRWLockExclusive(&dll_directory_lock);
+
 	/* to make module dependency issues easier to deal with, allow
 	 * dynamically loaded libraries on windows to search for dependent
 	 * libraries that are within the library's own directory */
@@ -96,6 +101,8 @@ void *os_dlopen(const char *path)
 	if (wpath_slash)
 		SetDllDirectoryW(NULL);
 
+	ReleaseSRWLockExclusive(&dll_directory_lock);
+
 	if (!h_library) {
 		DWORD error = GetLastError();
 
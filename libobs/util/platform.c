@@ -29,6 +29,14 @@
 #include "obs.h"
 #include "threading.h"
 
+#if (defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)) && !defined(_M_ARM64EC)
+#define PLATFORM_X86
+#ifdef _MSC_VER
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+#endif
+
 FILE *os_wfopen(const wchar_t *path, const char *mode)
 {
 	FILE *file = NULL;
@@ -844,3 +852,38 @@ struct timespec *os_nstime_to_timespec(uint64_t timestamp, struct timespec *stor
 
 	return storage;
 }
+
+static bool has_avx2 = false;
+
+static void init_cpu_features(void)
+{
+#ifdef PLATFORM_X86
+#ifdef _MSC_VER
+	int info[4];
+
+	__cpuid(info, 0);
+	if (info[0] < 7)
+		return;
+
+	/* AVX2 also requires the OS to save the YMM registers */
+	__cpuid(info, 1);
+	if ((info[2] & (1 << 27)) == 0 || (info[2] & (1 << 28)) == 0)
+		return;
+	if ((_xgetbv(0) & 6) != 6)
+		return;
+
+	__cpuidex(info, 7, 0);
+	has_avx2 = (info[1] & (1 << 5)) != 0;
+#else
+	__builtin_cpu_init();
+	has_avx2 = __builtin_cpu_supports("avx2") != 0;
+#endif
+#endif
+}
+
+bool os_cpu_has_avx2(void)
+{
+	static pthread_once_t once = PTHREAD_ONCE_INIT;
+	pthread_once(&once, init_cpu_features);
+	return has_avx2;
+}
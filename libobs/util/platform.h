@@ -178,6 +178,7 @@ EXPORT void os_oom(void);
 
 EXPORT int os_get_physical_cores(void);
 EXPORT int os_get_logical_cores(void);
+EXPORT bool os_cpu_has_avx2(void);
 
 EXPORT uint64_t os_get_sys_free_size(void);
 EXPORT uint64_t os_get_sys_total_size(void);
@@ -10,8 +10,6 @@
 
 #include <zlib.h>
 
-//#define TRACK_OVERHEAD
-
 struct profiler_snapshot {
 	DARRAY(profiler_snapshot_entry_t) roots;
 };
@@ -35,14 +33,8 @@ typedef struct profiler_time_entry profiler_time_entry;
 typedef struct profile_call profile_call;
 struct profile_call {
 	const char *name;
-#ifdef TRACK_OVERHEAD
-	uint64_t overhead_start;
-#endif
 	uint64_t start_time;
 	uint64_t end_time;
-#ifdef TRACK_OVERHEAD
-	uint64_t overhead_end;
-#endif
 	uint64_t expected_time_between_calls;
 	DARRAY(profile_call) children;
 	profile_call *parent;
@@ -70,9 +62,6 @@ typedef struct profile_entry profile_entry;
 struct profile_entry {
 	const char *name;
 	profile_times_table times;
-#ifdef TRACK_OVERHEAD
-	profile_times_table overhead;
-#endif
 	uint64_t expected_time_between_calls;
 	profile_times_table times_between_calls;
 	DARRAY(profile_entry) children;
@@ -80,10 +69,9 @@ struct profile_entry {
 
 typedef struct profile_root_entry profile_root_entry;
 struct profile_root_entry {
-	pthread_mutex_t *mutex;
 	const char *name;
 	profile_entry *entry;
-	profile_call *prev_call;
+	uint64_t prev_start_time;
 };
 
 static inline uint64_t diff_ns_to_usec(uint64_t prev, uint64_t next)
@@ -202,9 +190,6 @@ static profile_entry *init_entry(profile_entry *entry, const char *name)
 {
 	entry->name = name;
 	init_hashmap(&entry->times, 1);
-#ifdef TRACK_OVERHEAD
-	init_hashmap(&entry->overhead, 1);
-#endif
 	entry->expected_time_between_calls = 0;
 	init_hashmap(&entry->times_between_calls, 1);
 	return entry;
@@ -222,50 +207,169 @@ static profile_entry *get_child(profile_entry *parent, const char *name)
 	return init_entry(da_push_back_new(parent->children), name);
 }
 
-static void merge_call(profile_entry *entry, profile_call *call, profile_call *prev_call)
+static void merge_call(profile_entry *entry, profile_call *call, uint64_t prev_start_time)
 {
 	const size_t num = call->children.num;
 	for (size_t i = 0; i < num; i++) {
 		profile_call *child = &call->children.array[i];
-		merge_call(get_child(entry, child->name), child, NULL);
+		merge_call(get_child(entry, child->name), child, 0);
 	}
 
-	if (entry->expected_time_between_calls != 0 && prev_call) {
+	if (entry->expected_time_between_calls != 0 && prev_start_time) {
 		migrate_old_entries(&entry->times_between_calls, true);
-		uint64_t usec = diff_ns_to_usec(prev_call->start_time, call->start_time);
+		uint64_t usec = diff_ns_to_usec(prev_start_time, call->start_time);
 		add_hashmap_entry(&entry->times_between_calls, usec, 1);
 	}
 
 	migrate_old_entries(&entry->times, true);
 	uint64_t usec = diff_ns_to_usec(call->start_time, call->end_time);
 	add_hashmap_entry(&entry->times, usec, 1);
-
-#ifdef TRACK_OVERHEAD
-	migrate_old_entries(&entry->overhead, true);
-	usec = diff_ns_to_usec(call->overhead_start, call->start_time);
-	usec += diff_ns_to_usec(call->end_time, call->overhead_end);
-	add_hashmap_entry(&entry->overhead, usec, 1);
-#endif
 }
 
-static bool enabled = false;
+/*
+ * Recording
+ *
+ * profile_start/profile_end only append an event to a ring buffer owned by
+ * the calling thread.  Each ring has a single producer (its thread) and a
+ * single consumer at a time (whoever holds root_mutex), so neither side takes
+ * a lock.  The events are turned back into call trees and merged into the
+ * root entries when the rings are drained, which happens in
+ * profile_snapshot_create and, when a ring is getting full, opportunistically
+ * by its own thread after a top-level profile_end.
+ *
+ * When a ring is full the thread stops recording until it is back at the top
+ * level and then records a discard event, so that the partially recorded call
+ * is thrown away instead of being merged with wrong nesting.
+ */
+
+#define PROFILE_RING_SIZE 8192
+#define PROFILE_RING_MASK (PROFILE_RING_SIZE - 1)
+#define PROFILE_DRAIN_THRESHOLD (PROFILE_RING_SIZE / 2)
+
+enum profile_event_type {
+	PROFILE_EVENT_START,
+	PROFILE_EVENT_END,
+	PROFILE_EVENT_DISCARD,
+};
+
+typedef struct profile_event profile_event;
+struct profile_event {
+	const char *name;
+	uint64_t time;
+	enum profile_event_type type;
+};
+
+typedef struct profile_thread profile_thread;
+struct profile_thread {
+	/* written by the owning thread only */
+	unsigned long write_pos;
+	unsigned long cached_read_pos;
+	long depth;
+	bool dropping;
+
+	volatile long published;
+	volatile long consumed;
+
+	/* used while draining, with root_mutex held */
+	profile_call root_call;
+	profile_call *context;
+
+	/* protected by threads_mutex */
+	bool exited;
+	bool detached;
+
+	profile_event events[PROFILE_RING_SIZE];
+};
+
+static volatile bool enabled = false;
 static pthread_mutex_t root_mutex = PTHREAD_MUTEX_INITIALIZER;
 static DARRAY(profile_root_entry) root_entries;
+static uint64_t dropped_calls = 0;
 
-static THREAD_LOCAL profile_call *thread_context = NULL;
+static pthread_mutex_t threads_mutex = PTHREAD_MUTEX_INITIALIZER;
+static DARRAY(profile_thread *) threads;
+static pthread_once_t thread_key_once = PTHREAD_ONCE_INIT;
+static pthread_key_t thread_key;
+
+static THREAD_LOCAL profile_thread *thread_ring = NULL;
 static THREAD_LOCAL bool thread_enabled = true;
 
+static void free_call_children(profile_call *call);
+
+static void free_thread(profile_thread *thread)
+{
+	free_call_children(&thread->root_call);
+	bfree(thread);
+}
+
+static void thread_exited(void *data)
+{
+	profile_thread *thread = data;
+
+	pthread_mutex_lock(&threads_mutex);
+	if (thread->detached)
+		free_thread(thread);
+	else
+		thread->exited = true;
+	pthread_mutex_unlock(&threads_mutex);
+}
+
+static void create_thread_key(void)
+{
+	pthread_key_create(&thread_key, thread_exited);
+}
+
+static profile_thread *get_thread(void)
+{
+	if (thread_ring)
+		return thread_ring;
+
+	pthread_once(&thread_key_once, create_thread_key);
+
+	thread_ring = bzalloc(sizeof(profile_thread));
+	pthread_setspecific(thread_key, thread_ring);
+
+	pthread_mutex_lock(&threads_mutex);
+	da_push_back(threads, &thread_ring);
+	pthread_mutex_unlock(&threads_mutex);
+
+	return thread_ring;
+}
+
+static inline bool push_event(profile_thread *thread, const char *name, uint64_t time, enum profile_event_type type)
+{
+	unsigned long pos = thread->write_pos;
+
+	/* the last slot is kept free for the discard event */
+	size_t limit = type == PROFILE_EVENT_DISCARD ? PROFILE_RING_SIZE : PROFILE_RING_SIZE - 1;
+
+	if (pos - thread->cached_read_pos >= limit) {
+		thread->cached_read_pos = (unsigned long)os_atomic_load_long(&thread->consumed);
+		if (pos - thread->cached_read_pos >= limit)
+			return false;
+	}
+
+	profile_event *event = &thread->events[pos & PROFILE_RING_MASK];
+	event->name = name;
+	event->time = time;
+	event->type = type;
+
+	thread->write_pos = pos + 1;
+	os_atomic_store_long(&thread->published, (long)thread->write_pos);
+	return true;
+}
+
 void profiler_start(void)
 {
 	pthread_mutex_lock(&root_mutex);
-	enabled = true;
+	os_atomic_set_bool(&enabled, true);
 	pthread_mutex_unlock(&root_mutex);
 }
 
 void profiler_stop(void)
 {
 	pthread_mutex_lock(&root_mutex);
-	enabled = false;
+	os_atomic_set_bool(&enabled, false);
 	pthread_mutex_unlock(&root_mutex);
 }
 
@@ -274,9 +378,7 @@ void profile_reenable_thread(void)
 	if (thread_enabled)
 		return;
 
-	pthread_mutex_lock(&root_mutex);
-	thread_enabled = enabled;
-	pthread_mutex_unlock(&root_mutex);
+	thread_enabled = os_atomic_load_bool(&enabled);
 }
 
 static bool lock_root(void)
@@ -304,9 +406,6 @@ static profile_root_entry *get_root_entry(const char *name)
 
 	if (!r_entry) {
 		r_entry = da_push_back_new(root_entries);
-		r_entry->mutex = bmalloc(sizeof(pthread_mutex_t));
-		pthread_mutex_init(r_entry->mutex, NULL);
-
 		r_entry->name = name;
 		r_entry->entry = bzalloc(sizeof(profile_entry));
 		init_entry(r_entry->entry, name);
@@ -324,48 +423,20 @@ void profile_register_root(const char *name, uint64_t expected_time_between_call
 	pthread_mutex_unlock(&root_mutex);
 }
 
-static void free_call_context(profile_call *context);
-
+/* root_mutex must be held */
 static void merge_context(profile_call *context)
 {
-	pthread_mutex_t *mutex = NULL;
-	profile_entry *entry = NULL;
-	profile_call *prev_call = NULL;
-
-	if (!lock_root()) {
-		free_call_context(context);
-		return;
-	}
-
 	profile_root_entry *r_entry = get_root_entry(context->name);
 
-	mutex = r_entry->mutex;
-	entry = r_entry->entry;
-	prev_call = r_entry->prev_call;
-
-	r_entry->prev_call = context;
-
-	pthread_mutex_lock(mutex);
-	pthread_mutex_unlock(&root_mutex);
-
-	merge_call(entry, context, prev_call);
-
-	pthread_mutex_unlock(mutex);
-
-	free_call_context(prev_call);
+	merge_call(r_entry->entry, context, r_entry->prev_start_time);
+	r_entry->prev_start_time = context->start_time;
 }
 
-void profile_start(const char *name)
+static void replay_start(profile_thread *thread, const char *name, uint64_t time)
 {
-	if (!thread_enabled)
-		return;
-
 	profile_call new_call = {
 		.name = name,
-#ifdef TRACK_OVERHEAD
-		.overhead_start = os_gettime_ns(),
-#endif
-		.parent = thread_context,
+		.parent = thread->context,
 	};
 
 	profile_call *call = NULL;
@@ -374,21 +445,19 @@ void profile_start(const char *name)
 		size_t idx = da_push_back(new_call.parent->children, &new_call);
 		call = &new_call.parent->children.array[idx];
 	} else {
-		call = bmalloc(sizeof(profile_call));
+		/* top-level calls are merged as soon as they end, so every
+		 * thread only ever needs one */
+		call = &thread->root_call;
 		memcpy(call, &new_call, sizeof(profile_call));
 	}
 
-	thread_context = call;
-	call->start_time = os_gettime_ns();
+	thread->context = call;
+	call->start_time = time;
 }
 
-void profile_end(const char *name)
+static void replay_end(profile_thread *thread, const char *name, uint64_t time)
 {
-	uint64_t end = os_gettime_ns();
-	if (!thread_enabled)
-		return;
-
-	profile_call *call = thread_context;
+	profile_call *call = thread->context;
 	if (!call) {
 		blog(LOG_ERROR, "Called profile end with no active profile");
 		return;
@@ -411,22 +480,129 @@ void profile_end(const char *name)
 			return;
 
 		while (call->name != name) {
-			profile_end(call->name);
+			replay_end(thread, call->name, time);
 			call = call->parent;
 		}
 	}
 
-	thread_context = call->parent;
-
-	call->end_time = end;
-#ifdef TRACK_OVERHEAD
-	call->overhead_end = os_gettime_ns();
-#endif
+	thread->context = call->parent;
+	call->end_time = time;
 
 	if (call->parent)
 		return;
 
 	merge_context(call);
+	free_call_children(call);
+}
+
+static void discard_context(profile_thread *thread)
+{
+	profile_call *call = thread->context;
+
+	while (call && call->parent)
+		call = call->parent;
+
+	free_call_children(call);
+	thread->context = NULL;
+	dropped_calls++;
+}
+
+/* root_mutex must be held */
+static void drain_thread(profile_thread *thread)
+{
+	unsigned long end = (unsigned long)os_atomic_load_long(&thread->published);
+	unsigned long pos = (unsigned long)os_atomic_load_long(&thread->consumed);
+
+	for (; pos != end; pos++) {
+		profile_event *event = &thread->events[pos & PROFILE_RING_MASK];
+
+		switch (event->type) {
+		case PROFILE_EVENT_START:
+			replay_start(thread, event->name, event->time);
+			break;
+		case PROFILE_EVENT_END:
+			replay_end(thread, event->name, event->time);
+			break;
+		case PROFILE_EVENT_DISCARD:
+			discard_context(thread);
+			break;
+		}
+	}
+
+	os_atomic_store_long(&thread->consumed, (long)end);
+}
+
+/* root_mutex must be held */
+static void drain_threads(void)
+{
+	pthread_mutex_lock(&threads_mutex);
+	for (size_t i = 0; i < threads.num;) {
+		profile_thread *thread = threads.array[i];
+
+		drain_thread(thread);
+
+		if (thread->exited) {
+			free_thread(thread);
+			da_erase(threads, i);
+		} else {
+			i++;
+		}
+	}
+	pthread_mutex_unlock(&threads_mutex);
+}
+
+void profile_start(const char *name)
+{
+	profile_start_at(name, os_gettime_ns());
+}
+
+void profile_start_at(const char *name, uint64_t start_time)
+{
+	if (!thread_enabled)
+		return;
+
+	profile_thread *thread = get_thread();
+
+	thread->depth++;
+	if (thread->dropping)
+		return;
+
+	if (!push_event(thread, name, start_time, PROFILE_EVENT_START))
+		thread->dropping = true;
+}
+
+void profile_end(const char *name)
+{
+	uint64_t end = os_gettime_ns();
+	if (!thread_enabled)
+		return;
+
+	profile_thread *thread = get_thread();
+
+	if (thread->depth > 0)
+		thread->depth--;
+
+	if (!thread->dropping && !push_event(thread, name, end, PROFILE_EVENT_END))
+		thread->dropping = true;
+	if (thread->dropping && !thread->depth && push_event(thread, name, end, PROFILE_EVENT_DISCARD))
+		thread->dropping = false;
+
+	if (thread->depth)
+		return;
+
+	if (!os_atomic_load_bool(&enabled)) {
+		thread_enabled = false;
+		return;
+	}
+
+	/* never wait for the lock here, if a snapshot is being taken it
+	 * drains this thread's ring anyway */
+	if (thread->write_pos - thread->cached_read_pos >= PROFILE_DRAIN_THRESHOLD &&
+	    pthread_mutex_trylock(&root_mutex) == 0) {
+		drain_thread(thread);
+		pthread_mutex_unlock(&root_mutex);
+		thread->cached_read_pos = (unsigned long)os_atomic_load_long(&thread->consumed);
+	}
 }
 
 static int profiler_time_entry_compare(const void *first, const void *second)
@@ -736,12 +912,6 @@ static void free_call_children(profile_call *call)
 	da_free(call->children);
 }
 
-static void free_call_context(profile_call *context)
-{
-	free_call_children(context);
-	bfree(context);
-}
-
 static void free_hashmap(profile_times_table *map)
 {
 	map->size = 0;
@@ -757,9 +927,6 @@ static void free_profile_entry(profile_entry *entry)
 		free_profile_entry(&entry->children.array[i]);
 
 	free_hashmap(&entry->times);
-#ifdef TRACK_OVERHEAD
-	free_hashmap(&entry->overhead);
-#endif
 	free_hashmap(&entry->times_between_calls);
 	da_free(entry->children);
 }
@@ -767,23 +934,36 @@ static void free_profile_entry(profile_entry *entry)
 void profiler_free(void)
 {
 	DARRAY(profile_root_entry) old_root_entries = {0};
+	uint64_t dropped;
 
 	pthread_mutex_lock(&root_mutex);
-	enabled = false;
+	os_atomic_set_bool(&enabled, false);
 	da_move(old_root_entries, root_entries);
-	pthread_mutex_unlock(&root_mutex);
 
-	for (size_t i = 0; i < old_root_entries.num; i++) {
-		profile_root_entry *entry = &old_root_entries.array[i];
+	/* threads that are still running keep writing to their ring until
+	 * they notice profiling has stopped, so those are left to be freed
+	 * when the thread exits */
+	pthread_mutex_lock(&threads_mutex);
+	for (size_t i = 0; i < threads.num; i++) {
+		profile_thread *thread = threads.array[i];
 
-		pthread_mutex_lock(entry->mutex);
-		pthread_mutex_unlock(entry->mutex);
+		if (thread->exited)
+			free_thread(thread);
+		else
+			thread->detached = true;
+	}
+	da_free(threads);
+	pthread_mutex_unlock(&threads_mutex);
+
+	dropped = dropped_calls;
+	dropped_calls = 0;
+	pthread_mutex_unlock(&root_mutex);
 
-		pthread_mutex_destroy(entry->mutex);
-		bfree(entry->mutex);
-		entry->mutex = NULL;
+	if (dropped)
+		blog(LOG_INFO, "Profiler dropped %" PRIu64 " calls that did not fit in the event buffers", dropped);
 
-		free_call_context(entry->prev_call);
+	for (size_t i = 0; i < old_root_entries.num; i++) {
+		profile_root_entry *entry = &old_root_entries.array[i];
 
 		free_profile_entry(entry->entry);
 		bfree(entry->entry);
@@ -888,12 +1068,11 @@ profiler_snapshot_t *profile_snapshot_create(void)
 	profiler_snapshot_t *snap = bzalloc(sizeof(profiler_snapshot_t));
 
 	pthread_mutex_lock(&root_mutex);
+	drain_threads();
+
 	da_reserve(snap->roots, root_entries.num);
-	for (size_t i = 0; i < root_entries.num; i++) {
-		pthread_mutex_lock(root_entries.array[i].mutex);
+	for (size_t i = 0; i < root_entries.num; i++)
 		add_entry_to_snapshot(root_entries.array[i].entry, da_push_back_new(snap->roots));
-		pthread_mutex_unlock(root_entries.array[i].mutex);
-	}
 	pthread_mutex_unlock(&root_mutex);
 
 	for (size_t i = 0; i < snap->roots.num; i++)
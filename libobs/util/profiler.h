@@ -17,6 +17,7 @@ typedef struct profiler_time_entry profiler_time_entry_t;
 EXPORT void profile_register_root(const char *name, uint64_t expected_time_between_calls);
 
 EXPORT void profile_start(const char *name);
+EXPORT void profile_start_at(const char *name, uint64_t start_time);
 EXPORT void profile_end(const char *name);
 
 EXPORT void profile_reenable_thread(void);
@@ -25,6 +25,7 @@
 
 struct frame_sample {
 	uint64_t tick;
+	bool tick_skipped;
 	DARRAY(uint64_t) render_cpu;
 	DARRAY(gs_timer_t *) render_timers;
 };
@@ -59,6 +60,8 @@ struct profiler_entry {
 
 	/* Tick times for last N frames */
 	struct ucirclebuf tick;
+	/* Whether video_tick was skipped, for last N frames */
+	struct ucirclebuf tick_skipped;
 	/* Time of first render pass in a frame, for last N frames */
 	struct ucirclebuf render_cpu;
 	struct ucirclebuf render_gpu;
@@ -69,6 +72,8 @@ struct profiler_entry {
 	struct ucirclebuf async_frame_ts;
 	/* Timestamps of last N async frames rendered */
 	struct ucirclebuf async_rendered_ts;
+	/* Audio render times for last N audio ticks */
+	struct ucirclebuf audio_render;
 
 	UT_hash_handle hh;
 };
@@ -168,24 +173,28 @@ static struct profiler_entry *entry_create(const uintptr_t key)
 	struct profiler_entry *ent = bzalloc(sizeof(struct profiler_entry));
 	ent->key = key;
 	ucirclebuf_init(&ent->tick, profiler_samples);
+	ucirclebuf_init(&ent->tick_skipped, profiler_samples);
 	ucirclebuf_init(&ent->render_cpu, profiler_samples);
 	ucirclebuf_init(&ent->render_gpu, profiler_samples);
 	ucirclebuf_init(&ent->render_cpu_sum, profiler_samples);
 	ucirclebuf_init(&ent->render_gpu_sum, profiler_samples);
 	ucirclebuf_init(&ent->async_frame_ts, profiler_samples);
 	ucirclebuf_init(&ent->async_rendered_ts, profiler_samples);
+	ucirclebuf_init(&ent->audio_render, profiler_samples);
 	return ent;
 }
 
 static void entry_destroy(struct profiler_entry *entry)
 {
 	ucirclebuf_free(&entry->tick);
+	ucirclebuf_free(&entry->tick_skipped);
 	ucirclebuf_free(&entry->render_cpu);
 	ucirclebuf_free(&entry->render_gpu);
 	ucirclebuf_free(&entry->render_cpu_sum);
 	ucirclebuf_free(&entry->render_gpu_sum);
 	ucirclebuf_free(&entry->async_frame_ts);
 	ucirclebuf_free(&entry->async_rendered_ts);
+	ucirclebuf_free(&entry->audio_render);
 	bfree(entry);
 }
 
@@ -327,6 +336,7 @@ void source_profiler_frame_collect(void)
 		}
 
 		ucirclebuf_push(&ent->tick, smp->tick);
+		ucirclebuf_push(&ent->tick_skipped, smp->tick_skipped);
 
 		if (smp->render_cpu.num) {
 			uint64_t sum = 0;
@@ -420,12 +430,13 @@ uint64_t source_profiler_source_tick_start(void)
 	return os_gettime_ns();
 }
 
-void source_profiler_source_tick_end(obs_source_t *source, uint64_t start)
+void source_profiler_source_tick_end(obs_source_t *source, uint64_t time, bool skipped)
 {
 	if (!enabled)
 		return;
 
-	const uint64_t delta = os_gettime_ns() - start;
+	/* a tick time of 0 means there is no data for the frame */
+	const uint64_t delta = time ? time : 1;
 
 	struct source_samples *smp = NULL;
 	HASH_FIND_PTR(hm_samples, &source, smp);
@@ -439,6 +450,7 @@ void source_profiler_source_tick_end(obs_source_t *source, uint64_t start)
 	}
 
 	smp->frames[smp->frame_idx]->tick = delta;
+	smp->frames[smp->frame_idx]->tick_skipped = skipped;
 }
 
 uint64_t source_profiler_source_render_begin(gs_timer_t **timer)
@@ -478,6 +490,23 @@ void source_profiler_source_render_end(obs_source_t *source, uint64_t start, gs_
 	}
 }
 
+void source_profiler_audio_render(obs_source_t *const *sources, size_t num)
+{
+	if (!enabled)
+		return;
+
+	pthread_rwlock_wrlock(&hm_rwlock);
+
+	for (size_t i = 0; i < num; i++) {
+		struct profiler_entry *ent;
+		HASH_FIND_PTR(hm_entries, &sources[i], ent);
+		if (ent)
+			ucirclebuf_push(&ent->audio_render, sources[i]->audio_render_time);
+	}
+
+	pthread_rwlock_unlock(&hm_rwlock);
+}
+
 static void task_delete_source(void *key)
 {
 	struct source_samples *smp;
@@ -520,6 +549,9 @@ static inline void calculate_tick(struct profiler_entry *ent, struct profiler_re
 
 	if (idx)
 		result->tick_avg = sum / idx;
+
+	for (idx = 0; idx < ent->tick_skipped.num; idx++)
+		result->ticks_skipped += ent->tick_skipped.array[idx];
 }
 
 static inline void calculate_render(struct profiler_entry *ent, struct profiler_result *result)
@@ -560,6 +592,23 @@ static inline void calculate_render(struct profiler_entry *ent, struct profiler_
 	}
 }
 
+static inline void calculate_audio_render(struct profiler_entry *ent, struct profiler_result *result)
+{
+	size_t idx = 0;
+	uint64_t sum = 0;
+
+	for (; idx < ent->audio_render.num; idx++) {
+		const uint64_t delta = ent->audio_render.array[idx];
+		if (delta > result->audio_render_max)
+			result->audio_render_max = delta;
+
+		sum += delta;
+	}
+
+	if (idx)
+		result->audio_render_avg = sum / idx;
+}
+
 static inline void calculate_fps(const struct ucirclebuf *frames, double *avg, uint64_t *best, uint64_t *worst)
 {
 	uint64_t deltas = 0, delta_sum = 0, best_delta = 0, worst_delta = 0;
@@ -605,6 +654,7 @@ bool source_profiler_fill_result(obs_source_t *source, struct profiler_result *r
 	if (ent) {
 		calculate_tick(ent, result);
 		calculate_render(ent, result);
+		calculate_audio_render(ent, result);
 
 		if (is_async_video_source(source)) {
 			calculate_fps(&ent->async_frame_ts, &result->async_input, &result->async_input_best,
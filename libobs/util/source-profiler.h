@@ -49,6 +49,13 @@ typedef struct profiler_result {
 	uint64_t async_input_worst;
 	uint64_t async_rendered_best;
 	uint64_t async_rendered_worst;
+
+	/* Average and max audio render times in ns */
+	uint64_t audio_render_avg;
+	uint64_t audio_render_max;
+
+	/* Frames in which video_tick was skipped, see obs_set_hidden_tick_interval */
+	uint64_t ticks_skipped;
 } profiler_result_t;
 
 /* Enable/disable profiler (applied on next frame) */
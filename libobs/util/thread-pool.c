@@ -0,0 +1,480 @@
+#include "thread-pool.h"
+#include "bmem.h"
+#include "base.h"
+#include "platform.h"
+#include "profiler.h"
+#include "threading.h"
+
+#include <errno.h>
+
+#define NUM_PRIORITIES (OS_TASK_PRIORITY_LOW + 1)
+
+struct pool_task {
+	os_task_t task;
+	void *param;
+	os_task_group_t *group;
+	uint64_t queued_time;
+
+	struct pool_task *prev;
+	struct pool_task *next;
+};
+
+struct task_list {
+	struct pool_task *first;
+	struct pool_task *last;
+};
+
+struct pool_worker {
+	os_thread_pool_t *pool;
+	pthread_t thread;
+
+	pthread_mutex_t mutex;
+	struct task_list queues[NUM_PRIORITIES];
+};
+
+struct os_thread_pool {
+	const char *name;
+	size_t num_workers;
+	struct pool_worker *workers;
+
+	/* one post per queued task; waking up to find the task already taken
+	 * by someone else is harmless */
+	os_sem_t *sem;
+	volatile bool exiting;
+	volatile long next_worker;
+	volatile long queued;
+
+	pthread_mutex_t stats_mutex;
+	struct os_thread_pool_stats stats;
+};
+
+struct os_task_group {
+	os_thread_pool_t *pool;
+
+	/* done_event is signaled exactly while pending is 0 */
+	pthread_mutex_t mutex;
+	os_event_t *done_event;
+	size_t pending;
+	volatile bool cancelled;
+};
+
+static const char *queued_name = "queued";
+static const char *run_name = "run";
+
+static THREAD_LOCAL struct pool_worker *current_worker = NULL;
+
+/* ------------------------------------------------------------------------- */
+
+static inline void list_push_back(struct task_list *list, struct pool_task *task)
+{
+	task->prev = list->last;
+	task->next = NULL;
+
+	if (list->last)
+		list->last->next = task;
+	else
+		list->first = task;
+	list->last = task;
+}
+
+static inline void list_remove(struct task_list *list, struct pool_task *task)
+{
+	if (task->prev)
+		task->prev->next = task->next;
+	else
+		list->first = task->next;
+
+	if (task->next)
+		task->next->prev = task->prev;
+	else
+		list->last = task->prev;
+}
+
+static inline struct pool_worker *get_current_worker(os_thread_pool_t *pool)
+{
+	return current_worker && current_worker->pool == pool ? current_worker : NULL;
+}
+
+static void group_add(os_task_group_t *group)
+{
+	pthread_mutex_lock(&group->mutex);
+	if (group->pending++ == 0)
+		os_event_reset(group->done_event);
+	pthread_mutex_unlock(&group->mutex);
+}
+
+static void group_finish(os_task_group_t *group, size_t count)
+{
+	pthread_mutex_lock(&group->mutex);
+	group->pending -= count;
+	if (group->pending == 0)
+		os_event_signal(group->done_event);
+	pthread_mutex_unlock(&group->mutex);
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* own queue is worked through oldest first, other workers are stolen from
+ * at the other end so the two rarely contend for the same task */
+static struct pool_task *take_from(struct pool_worker *worker, size_t priority, bool steal)
+{
+	struct task_list *list = &worker->queues[priority];
+	struct pool_task *task;
+
+	pthread_mutex_lock(&worker->mutex);
+	task = steal ? list->last : list->first;
+	if (task)
+		list_remove(list, task);
+	pthread_mutex_unlock(&worker->mutex);
+
+	return task;
+}
+
+static struct pool_task *take_task(os_thread_pool_t *pool, struct pool_worker *self)
+{
+	if (os_atomic_load_long(&pool->queued) <= 0)
+		return NULL;
+
+	size_t start = self ? (size_t)(self - pool->workers) : 0;
+
+	for (size_t p = 0; p < NUM_PRIORITIES; p++) {
+		for (size_t i = 0; i < pool->num_workers; i++) {
+			struct pool_worker *worker = &pool->workers[(start + i) % pool->num_workers];
+			struct pool_task *task = take_from(worker, p, worker != self);
+
+			if (task) {
+				os_atomic_dec_long(&pool->queued);
+				return task;
+			}
+		}
+	}
+
+	return NULL;
+}
+
+static void run_task(os_thread_pool_t *pool, struct pool_task *task)
+{
+	os_task_group_t *group = task->group;
+	bool cancelled = group && os_atomic_load_bool(&group->cancelled);
+	uint64_t latency = os_gettime_ns() - task->queued_time;
+
+	profile_start_at(pool->name, task->queued_time);
+	profile_start_at(queued_name, task->queued_time);
+	profile_end(queued_name);
+
+	if (!cancelled) {
+		profile_start(run_name);
+		task->task(task->param);
+		profile_end(run_name);
+	}
+
+	profile_end(pool->name);
+
+	pthread_mutex_lock(&pool->stats_mutex);
+	if (cancelled) {
+		pool->stats.cancelled++;
+	} else {
+		pool->stats.tasks++;
+		pool->stats.total_latency_ns += latency;
+		if (latency > pool->stats.max_latency_ns)
+			pool->stats.max_latency_ns = latency;
+	}
+	pthread_mutex_unlock(&pool->stats_mutex);
+
+	if (group)
+		group_finish(group, 1);
+	bfree(task);
+}
+
+static void *pool_worker_thread(void *param)
+{
+	struct pool_worker *worker = param;
+	os_thread_pool_t *pool = worker->pool;
+
+	current_worker = worker;
+	os_set_thread_name(pool->name);
+
+	for (;;) {
+		struct pool_task *task = take_task(pool, worker);
+		if (task) {
+			run_task(pool, task);
+			continue;
+		}
+
+		if (os_atomic_load_bool(&pool->exiting))
+			break;
+		os_sem_wait(pool->sem);
+	}
+
+	current_worker = NULL;
+	return NULL;
+}
+
+/* ------------------------------------------------------------------------- */
+
+os_thread_pool_t *os_thread_pool_create(const char *name, size_t threads)
+{
+	struct os_thread_pool *pool = bzalloc(sizeof(*pool));
+	size_t created = 0;
+
+	if (!threads) {
+		int cores = os_get_logical_cores();
+		threads = cores > 0 ? (size_t)cores : 1;
+	}
+
+	pool->name = name;
+	pool->workers = bzalloc(sizeof(struct pool_worker) * threads);
+
+	if (pthread_mutex_init(&pool->stats_mutex, NULL) != 0)
+		goto fail1;
+	if (os_sem_init(&pool->sem, 0) != 0)
+		goto fail2;
+
+	for (size_t i = 0; i < threads; i++) {
+		pool->workers[i].pool = pool;
+		pthread_mutex_init(&pool->workers[i].mutex, NULL);
+	}
+
+	pool->num_workers = threads;
+
+	for (; created < threads; created++) {
+		struct pool_worker *worker = &pool->workers[created];
+		if (pthread_create(&worker->thread, NULL, pool_worker_thread, worker) != 0)
+			goto fail3;
+	}
+
+	pool->stats.threads = threads;
+	return pool;
+
+fail3:
+	blog(LOG_ERROR, "%s: failed to create thread %zu of %zu", name, created + 1, threads);
+	os_atomic_set_bool(&pool->exiting, true);
+	for (size_t i = 0; i < created; i++)
+		os_sem_post(pool->sem);
+	for (size_t i = 0; i < created; i++)
+		pthread_join(pool->workers[i].thread, NULL);
+	for (size_t i = 0; i < threads; i++)
+		pthread_mutex_destroy(&pool->workers[i].mutex);
+	os_sem_destroy(pool->sem);
+fail2:
+	pthread_mutex_destroy(&pool->stats_mutex);
+fail1:
+	bfree(pool->workers);
+	bfree(pool);
+	return NULL;
+}
+
+void os_thread_pool_destroy(os_thread_pool_t *pool)
+{
+	if (!pool)
+		return;
+
+	/* workers keep going until every queued task has run */
+	os_atomic_set_bool(&pool->exiting, true);
+	for (size_t i = 0; i < pool->num_workers; i++)
+		os_sem_post(pool->sem);
+	for (size_t i = 0; i < pool->num_workers; i++)
+		pthread_join(pool->workers[i].thread, NULL);
+
+	struct os_thread_pool_stats *stats = &pool->stats;
+	blog(LOG_DEBUG,
+	     "%s: %llu tasks (%llu cancelled) on %zu threads, "
+	     "max queue depth %zu, max latency %llu us",
+	     pool->name, (unsigned long long)stats->tasks, (unsigned long long)stats->cancelled, stats->threads,
+	     stats->max_queued, (unsigned long long)(stats->max_latency_ns / 1000));
+
+	for (size_t i = 0; i < pool->num_workers; i++)
+		pthread_mutex_destroy(&pool->workers[i].mutex);
+	os_sem_destroy(pool->sem);
+	pthread_mutex_destroy(&pool->stats_mutex);
+	bfree(pool->workers);
+	bfree(pool);
+}
+
+bool os_thread_pool_queue(os_thread_pool_t *pool, enum os_task_priority priority, os_task_group_t *group,
+			  os_task_t task, void *param)
+{
+	if (!pool || !task)
+		return false;
+	if (os_atomic_load_bool(&pool->exiting) && !get_current_worker(pool))
+		return false;
+	if (group && (group->pool != pool || os_atomic_load_bool(&group->cancelled)))
+		return false;
+	if ((size_t)priority >= NUM_PRIORITIES)
+		priority = OS_TASK_PRIORITY_LOW;
+
+	struct pool_task *pt = bmalloc(sizeof(*pt));
+	pt->task = task;
+	pt->param = param;
+	pt->group = group;
+	pt->queued_time = os_gettime_ns();
+
+	if (group)
+		group_add(group);
+
+	/* tasks queued from a worker are most likely related to what it is
+	 * doing, so it keeps them unless someone else is idle */
+	struct pool_worker *worker = get_current_worker(pool);
+	if (!worker) {
+		unsigned long idx = (unsigned long)os_atomic_inc_long(&pool->next_worker);
+		worker = &pool->workers[idx % pool->num_workers];
+	}
+
+	pthread_mutex_lock(&worker->mutex);
+	list_push_back(&worker->queues[priority], pt);
+	pthread_mutex_unlock(&worker->mutex);
+
+	long depth = os_atomic_inc_long(&pool->queued);
+	if (depth > 0) {
+		pthread_mutex_lock(&pool->stats_mutex);
+		if ((size_t)depth > pool->stats.max_queued)
+			pool->stats.max_queued = (size_t)depth;
+		pthread_mutex_unlock(&pool->stats_mutex);
+	}
+
+	os_sem_post(pool->sem);
+	return true;
+}
+
+bool os_thread_pool_inside(os_thread_pool_t *pool)
+{
+	return pool && get_current_worker(pool) != NULL;
+}
+
+void os_thread_pool_get_stats(os_thread_pool_t *pool, struct os_thread_pool_stats *stats)
+{
+	if (!pool || !stats)
+		return;
+
+	long queued = os_atomic_load_long(&pool->queued);
+
+	pthread_mutex_lock(&pool->stats_mutex);
+	*stats = pool->stats;
+	pthread_mutex_unlock(&pool->stats_mutex);
+
+	stats->queued = queued > 0 ? (size_t)queued : 0;
+}
+
+/* ------------------------------------------------------------------------- */
+
+os_task_group_t *os_task_group_create(os_thread_pool_t *pool)
+{
+	if (!pool)
+		return NULL;
+
+	struct os_task_group *group = bzalloc(sizeof(*group));
+	group->pool = pool;
+
+	if (pthread_mutex_init(&group->mutex, NULL) != 0)
+		goto fail1;
+	if (os_event_init(&group->done_event, OS_EVENT_TYPE_MANUAL) != 0)
+		goto fail2;
+
+	os_event_signal(group->done_event);
+	return group;
+
+fail2:
+	pthread_mutex_destroy(&group->mutex);
+fail1:
+	bfree(group);
+	return NULL;
+}
+
+void os_task_group_destroy(os_task_group_t *group)
+{
+	if (!group)
+		return;
+
+	os_task_group_wait(group);
+
+	/* the last task to finish may still be on its way out */
+	pthread_mutex_lock(&group->mutex);
+	pthread_mutex_unlock(&group->mutex);
+
+	os_event_destroy(group->done_event);
+	pthread_mutex_destroy(&group->mutex);
+	bfree(group);
+}
+
+void os_task_group_wait(os_task_group_t *group)
+{
+	if (!group)
+		return;
+
+	os_thread_pool_t *pool = group->pool;
+	struct pool_worker *self = get_current_worker(pool);
+
+	if (!self) {
+		os_event_wait(group->done_event);
+		return;
+	}
+
+	/* waiting from inside the pool, keep working so the tasks being
+	 * waited on can't end up stuck behind the waiter */
+	while (os_event_try(group->done_event) == EAGAIN) {
+		struct pool_task *task = take_task(pool, self);
+		if (task)
+			run_task(pool, task);
+		else
+			os_event_timedwait(group->done_event, 1);
+	}
+}
+
+size_t os_task_group_cancel(os_task_group_t *group)
+{
+	if (!group)
+		return 0;
+
+	os_thread_pool_t *pool = group->pool;
+	struct task_list cancelled = {0};
+	size_t count = 0;
+
+	os_atomic_set_bool(&group->cancelled, true);
+
+	for (size_t i = 0; i < pool->num_workers; i++) {
+		struct pool_worker *worker = &pool->workers[i];
+
+		pthread_mutex_lock(&worker->mutex);
+		for (size_t p = 0; p < NUM_PRIORITIES; p++) {
+			struct pool_task *task = worker->queues[p].first;
+			while (task) {
+				struct pool_task *next = task->next;
+				if (task->group == group) {
+					list_remove(&worker->queues[p], task);
+					list_push_back(&cancelled, task);
+					os_atomic_dec_long(&pool->queued);
+					count++;
+				}
+				task = next;
+			}
+		}
+		pthread_mutex_unlock(&worker->mutex);
+	}
+
+	while (cancelled.first) {
+		struct pool_task *task = cancelled.first;
+		list_remove(&cancelled, task);
+		bfree(task);
+	}
+
+	if (count) {
+		pthread_mutex_lock(&pool->stats_mutex);
+		pool->stats.cancelled += count;
+		pthread_mutex_unlock(&pool->stats_mutex);
+
+		group_finish(group, count);
+	}
+
+	return count;
+}
+
+bool os_task_group_cancelled(os_task_group_t *group)
+{
+	return group && os_atomic_load_bool(&group->cancelled);
+}
+
+void os_task_group_reset(os_task_group_t *group)
+{
+	if (group)
+		os_atomic_set_bool(&group->cancelled, false);
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "c99defs.h"
+#include "task.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Shared pool of worker threads for short one-shot work.
+ *
+ *   Every worker has its own queue per priority.  Tasks queued from a worker
+ * go to that worker's queue, other tasks are spread over the workers, and
+ * idle workers steal from the others.  Tasks can be grouped so that they can
+ * be waited on or cancelled together.
+ *
+ *   Tasks are expected not to block for long: the pool does not grow, so a
+ * task that sits in a blocking call holds up a whole worker.
+ */
+
+struct os_thread_pool;
+struct os_task_group;
+typedef struct os_thread_pool os_thread_pool_t;
+typedef struct os_task_group os_task_group_t;
+
+enum os_task_priority {
+	OS_TASK_PRIORITY_HIGH,
+	OS_TASK_PRIORITY_NORMAL,
+	OS_TASK_PRIORITY_LOW,
+};
+
+struct os_thread_pool_stats {
+	size_t threads;
+	size_t queued;
+	size_t max_queued;
+	uint64_t tasks;
+	uint64_t cancelled;
+	uint64_t total_latency_ns;
+	uint64_t max_latency_ns;
+};
+
+/* name is used as profiler root, so it must stay valid as long as the
+ * profiler does (e.g. a string literal); 0 threads uses one per core */
+EXPORT os_thread_pool_t *os_thread_pool_create(const char *name, size_t threads);
+EXPORT void os_thread_pool_destroy(os_thread_pool_t *pool);
+EXPORT bool os_thread_pool_queue(os_thread_pool_t *pool, enum os_task_priority priority, os_task_group_t *group,
+				 os_task_t task, void *param);
+EXPORT bool os_thread_pool_inside(os_thread_pool_t *pool);
+EXPORT void os_thread_pool_get_stats(os_thread_pool_t *pool, struct os_thread_pool_stats *stats);
+
+EXPORT os_task_group_t *os_task_group_create(os_thread_pool_t *pool);
+EXPORT void os_task_group_destroy(os_task_group_t *group);
+EXPORT void os_task_group_wait(os_task_group_t *group);
+EXPORT size_t os_task_group_cancel(os_task_group_t *group);
+EXPORT bool os_task_group_cancelled(os_task_group_t *group);
+EXPORT void os_task_group_reset(os_task_group_t *group);
+
+#ifdef __cplusplus
+}
+#endif
@@ -140,3 +140,20 @@ static inline bool os_atomic_load_bool(const volatile bool *ptr)
 
 	return b;
 }
+
+static inline void *os_atomic_exchange_ptr(void *volatile *ptr, void *val)
+{
+	return _InterlockedExchangePointer(ptr, val);
+}
+
+static inline void *os_atomic_set_ptr(void *volatile *ptr, void *val)
+{
+	return _InterlockedExchangePointer(ptr, val);
+}
+
+static inline void *os_atomic_load_ptr(void *const volatile *ptr)
+{
+	/* a compare-exchange that never changes anything, but is a full
+	 * barrier on every supported architecture */
+	return _InterlockedCompareExchangePointer((void *volatile *)ptr, NULL, NULL);
+}
@@ -27,7 +27,7 @@ struct image_source {
 	volatile bool file_decoded;
 	volatile bool texture_loaded;
 
-	gs_image_file4_t if4;
+	gs_image_file5_t if5;
 };
 
 static time_t get_modified_timestamp(const char *filename)
@@ -51,7 +51,7 @@ void image_source_preload_image(void *data)
 		return;
 
 	context->file_timestamp = get_modified_timestamp(context->file);
-	gs_image_file4_init(&context->if4, context->file,
+	gs_image_file5_init(&context->if5, context->file,
 			    context->linear_alpha ? GS_IMAGE_ALPHA_PREMULTIPLY_SRGB : GS_IMAGE_ALPHA_PREMULTIPLY);
 	os_atomic_set_bool(&context->file_decoded, true);
 }
@@ -65,10 +65,10 @@ static void image_source_load_texture(void *data)
 	debug("loading texture '%s'", context->file);
 
 	obs_enter_graphics();
-	gs_image_file4_init_texture(&context->if4);
+	gs_image_file5_init_texture(&context->if5);
 	obs_leave_graphics();
 
-	if (!context->if4.image3.image2.image.loaded)
+	if (!context->if5.image4.image3.image2.image.loaded)
 		warn("failed to load texture '%s'", context->file);
 	context->update_time_elapsed = 0;
 	os_atomic_set_bool(&context->texture_loaded, true);
@@ -81,7 +81,7 @@ static void image_source_unload(void *data)
 	os_atomic_set_bool(&context->texture_loaded, false);
 
 	obs_enter_graphics();
-	gs_image_file4_free(&context->if4);
+	gs_image_file5_free(&context->if5);
 	obs_leave_graphics();
 }
 
@@ -146,13 +146,13 @@ static void restart_gif(void *data)
 {
 	struct image_source *context = data;
 
-	if (context->if4.image3.image2.image.is_animated_gif) {
-		context->if4.image3.image2.image.cur_frame = 0;
-		context->if4.image3.image2.image.cur_loop = 0;
-		context->if4.image3.image2.image.cur_time = 0;
+	if (context->if5.image4.image3.image2.image.is_animated_gif) {
+		context->if5.image4.image3.image2.image.cur_frame = 0;
+		context->if5.image4.image3.image2.image.cur_loop = 0;
+		context->if5.image4.image3.image2.image.cur_time = 0;
 
 		obs_enter_graphics();
-		gs_image_file4_update_texture(&context->if4);
+		gs_image_file5_update_texture(&context->if5);
 		obs_leave_graphics();
 
 		context->restart_gif = false;
@@ -188,13 +188,13 @@ static void image_source_destroy(void *data)
 static uint32_t image_source_getwidth(void *data)
 {
 	struct image_source *context = data;
-	return context->if4.image3.image2.image.cx;
+	return context->if5.image4.image3.image2.image.cx;
 }
 
 static uint32_t image_source_getheight(void *data)
 {
 	struct image_source *context = data;
-	return context->if4.image3.image2.image.cy;
+	return context->if5.image4.image3.image2.image.cy;
 }
 
 static void image_source_render(void *data, gs_effect_t *effect)
@@ -203,7 +203,7 @@ static void image_source_render(void *data, gs_effect_t *effect)
 	if (!os_atomic_load_bool(&context->texture_loaded))
 		return;
 
-	struct gs_image_file *const image = &context->if4.image3.image2.image;
+	struct gs_image_file *const image = &context->if5.image4.image3.image2.image;
 	gs_texture_t *const texture = image->texture;
 	if (!texture)
 		return;
@@ -251,7 +251,7 @@ static void image_source_tick(void *data, float seconds)
 
 	if (obs_source_showing(context->source)) {
 		if (!context->active) {
-			if (context->if4.image3.image2.image.is_animated_gif)
+			if (context->if5.image4.image3.image2.image.is_animated_gif)
 				context->last_time = frame_time;
 			context->active = true;
 		}
@@ -268,13 +268,13 @@ static void image_source_tick(void *data, float seconds)
 		return;
 	}
 
-	if (context->last_time && context->if4.image3.image2.image.is_animated_gif) {
+	if (context->last_time && context->if5.image4.image3.image2.image.is_animated_gif) {
 		uint64_t elapsed = frame_time - context->last_time;
-		bool updated = gs_image_file4_tick(&context->if4, elapsed);
+		bool updated = gs_image_file5_tick(&context->if5, elapsed);
 
 		if (updated) {
 			obs_enter_graphics();
-			gs_image_file4_update_texture(&context->if4);
+			gs_image_file5_update_texture(&context->if5);
 			obs_leave_graphics();
 		}
 	}
@@ -313,10 +313,12 @@ static obs_properties_t *image_source_properties(void *data)
 	return props;
 }
 
+/* shared images only count for the source that decoded them, see
+ * gs_image_cache_get_stats for the memory held by the image cache */
 uint64_t image_source_get_memory_usage(void *data)
 {
 	struct image_source *s = data;
-	return s->if4.image3.image2.mem_usage;
+	return s->if5.image4.image3.image2.mem_usage;
 }
 
 static void missing_file_callback(void *src, const char *new_path, void *data)
@@ -356,14 +358,14 @@ static enum gs_color_space image_source_get_color_space(void *data, size_t count
 	UNUSED_PARAMETER(preferred_spaces);
 
 	struct image_source *const s = data;
-	gs_image_file4_t *const if4 = &s->if4;
+	gs_image_file4_t *const if4 = &s->if5.image4;
 	return if4->image3.image2.image.texture ? if4->space : GS_CS_SRGB;
 }
 
 static struct obs_source_info image_source_info = {
 	.id = "image_source",
 	.type = OBS_SOURCE_TYPE_INPUT,
-	.output_flags = OBS_SOURCE_VIDEO | OBS_SOURCE_SRGB,
+	.output_flags = OBS_SOURCE_VIDEO | OBS_SOURCE_SRGB | OBS_SOURCE_THREADSAFE_TICK,
 	.get_name = image_source_get_name,
 	.create = image_source_create,
 	.destroy = image_source_destroy,
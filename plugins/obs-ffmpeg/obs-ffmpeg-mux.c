@@ -53,6 +53,17 @@ static inline void replay_buffer_clear(struct ffmpeg_muxer *stream)
 	}
 
 	deque_free(&stream->packets);
+
+	if (spill_file_active(&stream->spill)) {
+		/* a save in progress still reads from the file */
+		if (stream->mux_thread_joinable) {
+			pthread_join(stream->mux_thread, NULL);
+			stream->mux_thread_joinable = false;
+		}
+		spill_file_close(&stream->spill);
+	}
+	deque_free(&stream->spill_offsets);
+
 	stream->cur_size = 0;
 	stream->cur_time = 0;
 	stream->max_size = 0;
@@ -71,6 +82,7 @@ static void ffmpeg_mux_destroy(void *data)
 	for (size_t i = 0; i < stream->mux_packets.num; i++)
 		obs_encoder_packet_release(&stream->mux_packets.array[i]);
 	da_free(stream->mux_packets);
+	da_free(stream->mux_offsets);
 	deque_free(&stream->packets);
 
 	os_process_pipe_destroy(stream->pipe);
@@ -975,6 +987,65 @@ static void replay_buffer_destroy(void *data)
 	ffmpeg_mux_destroy(data);
 }
 
+static int64_t get_encoder_bitrate(obs_encoder_t *encoder)
+{
+	if (!encoder)
+		return 0;
+
+	obs_data_t *settings = obs_encoder_get_settings(encoder);
+	int64_t bitrate = obs_data_get_int(settings, "bitrate");
+	obs_data_release(settings);
+	return bitrate;
+}
+
+/* without a size limit the file is sized for the time limit at the bitrates
+ * the encoders were set up with, plus headroom for rate control overshoot */
+static int64_t get_spill_size(struct ffmpeg_muxer *stream)
+{
+	int64_t kbps = 0;
+
+	if (stream->max_size)
+		return stream->max_size;
+
+	for (size_t i = 0; i < MAX_OUTPUT_VIDEO_ENCODERS; i++)
+		kbps += get_encoder_bitrate(obs_output_get_video_encoder2(stream->output, i));
+	for (size_t i = 0; i < MAX_OUTPUT_AUDIO_ENCODERS; i++)
+		kbps += get_encoder_bitrate(obs_output_get_audio_encoder(stream->output, i));
+
+	return kbps * 1000 / 8 * (stream->max_time / 1000000) * 3 / 2;
+}
+
+static void replay_buffer_open_spill(struct ffmpeg_muxer *stream, obs_data_t *settings)
+{
+	const char *dir = obs_data_get_string(settings, "spill_directory");
+	int64_t size = get_spill_size(stream);
+	struct dstr path = {0};
+
+	if (!size) {
+		warn("Keeping the replay buffer in memory, spilling to disk needs a size limit or bitrate");
+		return;
+	}
+
+	if (!dir || !*dir)
+		dir = obs_data_get_string(settings, "directory");
+
+	dstr_copy(&path, dir);
+	dstr_replace(&path, "\\", "/");
+	if (dstr_end(&path) != '/')
+		dstr_cat_ch(&path, '/');
+	os_mkdirs(path.array);
+	dstr_catf(&path, "obs-replay-buffer-%llu.tmp", (unsigned long long)os_gettime_ns());
+
+	/* whatever fits at the end of the file but is not used is wasted
+	 * until the ring wraps around, leave some room for that */
+	if (spill_file_open(&stream->spill, path.array, size + size / 8))
+		info("Replay buffer is spilled to '%s'", path.array);
+	else
+		warn("Failed to create replay buffer file '%s', keeping it in memory", path.array);
+
+	dstr_free(&path);
+}
+
 static bool replay_buffer_start(void *data)
 {
 	struct ffmpeg_muxer *stream = data;
@@ -987,6 +1058,8 @@ static bool replay_buffer_start(void *data)
 	obs_data_t *s = obs_output_get_settings(stream->output);
 	stream->max_time = obs_data_get_int(s, "max_time_sec") * 1000000LL;
 	stream->max_size = obs_data_get_int(s, "max_size_mb") * (1024 * 1024);
+	if (obs_data_get_bool(s, "spill_to_disk"))
+		replay_buffer_open_spill(stream, s);
 	obs_data_release(s);
 
 	os_atomic_set_bool(&stream->active, true);
@@ -1007,6 +1080,13 @@ static bool purge_front(struct ffmpeg_muxer *stream)
 
 	deque_pop_front(&stream->packets, &pkt, sizeof(pkt));
 
+	if (spill_file_active(&stream->spill)) {
+		int64_t offset;
+		deque_pop_front(&stream->spill_offsets, &offset, sizeof(offset));
+		if (offset >= 0)
+			spill_file_free(&stream->spill, offset, pkt.size);
+	}
+
 	keyframe = pkt.type == OBS_ENCODER_VIDEO && pkt.keyframe;
 
 	if (keyframe)
@@ -1060,8 +1140,9 @@ static inline void replay_buffer_purge(struct ffmpeg_muxer *stream, struct encod
 		purge(stream);
 }
 
-static void insert_packet(mux_packets_t *packets, struct encoder_packet *packet, int64_t video_offset,
-			  int64_t *audio_offsets, int64_t video_pts_offset, int64_t *audio_dts_offsets)
+static void insert_packet(mux_packets_t *packets, mux_offsets_t *offsets, struct encoder_packet *packet,
+			  int64_t offset, int64_t video_offset, int64_t *audio_offsets, int64_t video_pts_offset,
+			  int64_t *audio_dts_offsets)
 {
 	struct encoder_packet pkt;
 	size_t idx;
@@ -1085,11 +1166,15 @@ static void insert_packet(mux_packets_t *packets, struct encoder_packet *packet,
 	}
 
 	da_insert(*packets, idx, &pkt);
+	if (offsets)
+		da_insert(*offsets, idx, &offset);
 }
 
 static void *replay_buffer_mux_thread(void *data)
 {
 	struct ffmpeg_muxer *stream = data;
+	DARRAY(uint8_t) buffer = {0};
+	FILE *spill = NULL;
 	bool error = false;
 
 	start_pipe(stream, stream->path.array);
@@ -1106,14 +1191,38 @@ static void *replay_buffer_mux_thread(void *data)
 		goto error;
 	}
 
+	if (stream->mux_offsets.num) {
+		spill = os_fopen(stream->spill.path, "rb");
+		if (!spill) {
+			warn("Could not open replay buffer file '%s'", stream->spill.path);
+			error = true;
+			goto error;
+		}
+	}
+
 	for (size_t i = 0; i < stream->mux_packets.num; i++) {
 		struct encoder_packet *pkt = &stream->mux_packets.array[i];
+		struct encoder_packet spilled;
+
+		if (spill && stream->mux_offsets.array[i] >= 0) {
+			da_resize(buffer, pkt->size);
+			if (!spill_file_read(spill, stream->mux_offsets.array[i], buffer.array, pkt->size)) {
+				warn("Could not read packet from '%s'", stream->spill.path);
+				error = true;
+				goto error;
+			}
+
+			spilled = *pkt;
+			spilled.data = buffer.array;
+			pkt = &spilled;
+		}
+
 		if (!write_packet(stream, pkt)) {
 			warn("Could not write packet for file '%s'", stream->path.array);
 			error = true;
 			goto error;
 		}
-		obs_encoder_packet_release(pkt);
+		obs_encoder_packet_release(&stream->mux_packets.array[i]);
 	}
 
 	info("Wrote replay buffer to '%s'", stream->path.array);
@@ -1126,6 +1235,10 @@ error:
 			obs_encoder_packet_release(&stream->mux_packets.array[i]);
 	}
 	da_free(stream->mux_packets);
+	da_free(stream->mux_offsets);
+	da_free(buffer);
+	if (spill)
+		fclose(spill);
 	os_atomic_set_bool(&stream->muxing, false);
 
 	if (!error) {
@@ -1141,8 +1254,17 @@ static void replay_buffer_save(struct ffmpeg_muxer *stream)
 {
 	const size_t size = sizeof(struct encoder_packet);
 	size_t num_packets = stream->packets.size / size;
+	bool spilled = spill_file_active(&stream->spill);
 
 	da_reserve(stream->mux_packets, num_packets);
+	if (spilled) {
+		da_reserve(stream->mux_offsets, num_packets);
+
+		/* keep the payloads in place until the mux thread has read
+		 * them back, see replay_buffer_data */
+		if (!spill_file_hold(&stream->spill))
+			warn("Failed to flush replay buffer file '%s'", stream->spill.path);
+	}
 
 	/* ---------------------------- */
 	/* reorder packets */
@@ -1172,8 +1294,12 @@ static void replay_buffer_save(struct ffmpeg_muxer *stream)
 			}
 		}
 
-		insert_packet(&stream->mux_packets, pkt, video_offset, audio_offsets, video_pts_offset,
-			      audio_dts_offsets);
+		int64_t offset = -1;
+		if (spilled)
+			offset = *(int64_t *)deque_data(&stream->spill_offsets, i * sizeof(offset));
+
+		insert_packet(&stream->mux_packets, spilled ? &stream->mux_offsets : NULL, pkt, offset, video_offset,
+			      audio_offsets, video_pts_offset, audio_dts_offsets);
 	}
 
 	generate_filename(stream, &stream->path, true);
@@ -1200,6 +1326,38 @@ static void deactivate_replay_buffer(struct ffmpeg_muxer *stream, int code)
 	replay_buffer_clear(stream);
 }
 
+/* Moves the payload of a packet to the ring file, leaving only its metadata in
+ * memory.  While a save is reading the file back nothing in it is reused, and
+ * packets that do not fit in the remaining space keep their payload in memory
+ * until the save is done. */
+static void replay_buffer_spill(struct ffmpeg_muxer *stream, struct encoder_packet *pkt)
+{
+	bool muxing = os_atomic_load_bool(&stream->muxing);
+	int64_t offset;
+
+	if (!muxing)
+		spill_file_unhold(&stream->spill);
+
+	offset = spill_file_write(&stream->spill, pkt->data, pkt->size);
+
+	/* space lost at the end of the ring can leave it short even though
+	 * the size limit is met, purge further to make room */
+	while (offset < 0 && !muxing && stream->packets.size && stream->keyframes > 2) {
+		purge(stream);
+		offset = spill_file_write(&stream->spill, pkt->data, pkt->size);
+	}
+
+	if (offset >= 0) {
+		struct encoder_packet meta = *pkt;
+
+		obs_encoder_packet_release(pkt);
+		*pkt = meta;
+		pkt->data = NULL;
+	}
+
+	deque_push_back(&stream->spill_offsets, &offset, sizeof(offset));
+}
+
 static void replay_buffer_data(void *data, struct encoder_packet *packet)
 {
 	struct ffmpeg_muxer *stream = data;
@@ -1224,11 +1382,14 @@ static void replay_buffer_data(void *data, struct encoder_packet *packet)
 	obs_encoder_packet_ref(&pkt, packet);
 	replay_buffer_purge(stream, &pkt);
 
+	if (spill_file_active(&stream->spill))
+		replay_buffer_spill(stream, &pkt);
+
 	if (!stream->packets.size)
 		stream->cur_time = pkt.dts_usec;
 	stream->cur_size += pkt.size;
 
-	deque_push_back(&stream->packets, packet, sizeof(*packet));
+	deque_push_back(&stream->packets, &pkt, sizeof(pkt));
 
 	if (packet->type == OBS_ENCODER_VIDEO && packet->keyframe)
 		stream->keyframes++;
@@ -1254,6 +1415,7 @@ static void replay_buffer_defaults(obs_data_t *s)
 	obs_data_set_default_string(s, "format", "%CCYY-%MM-%DD %hh-%mm-%ss");
 	obs_data_set_default_string(s, "extension", "mp4");
 	obs_data_set_default_bool(s, "allow_spaces", true);
+	obs_data_set_default_bool(s, "spill_to_disk", false);
 }
 
 struct obs_output_info replay_buffer = {
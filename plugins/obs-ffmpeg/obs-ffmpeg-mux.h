@@ -9,7 +9,10 @@
 #include <util/platform.h>
 #include <util/threading.h>
 
+#include "obs-ffmpeg-spill.h"
+
 typedef DARRAY(struct encoder_packet) mux_packets_t;
+typedef DARRAY(int64_t) mux_offsets_t;
 
 struct ffmpeg_muxer {
 	obs_output_t *output;
@@ -38,6 +41,12 @@ struct ffmpeg_muxer {
 	volatile bool muxing;
 	mux_packets_t mux_packets;
 
+	/* replay buffer payloads kept on disk, packets then only hold the
+	 * metadata and the file offset of each payload is kept alongside */
+	struct spill_file spill;
+	struct deque spill_offsets;
+	mux_offsets_t mux_offsets;
+
 	/* split file */
 	bool found_video;
 	bool found_audio[MAX_AUDIO_MIXES];
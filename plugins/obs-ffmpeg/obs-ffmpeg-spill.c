@@ -0,0 +1,126 @@
+#include "obs-ffmpeg-spill.h"
+
+#include <util/bmem.h>
+#include <util/platform.h>
+
+#ifdef __linux__
+#include <fcntl.h>
+#endif
+
+static bool preallocate(FILE *file, int64_t capacity)
+{
+#ifdef __linux__
+	/* reserve the blocks now so the disk filling up shows up when the
+	 * replay buffer starts rather than halfway through it */
+	if (posix_fallocate(fileno(file), 0, (off_t)capacity) == 0)
+		return true;
+#endif
+	const uint8_t zero = 0;
+	return os_fseeki64(file, capacity - 1, SEEK_SET) == 0 && fwrite(&zero, 1, 1, file) == 1 && fflush(file) == 0;
+}
+
+bool spill_file_open(struct spill_file *spill, const char *path, int64_t capacity)
+{
+	memset(spill, 0, sizeof(*spill));
+
+	spill->file = os_fopen(path, "w+b");
+	if (!spill->file)
+		return false;
+
+	spill->path = bstrdup(path);
+	spill->capacity = capacity;
+
+	if (!preallocate(spill->file, capacity)) {
+		spill_file_close(spill);
+		return false;
+	}
+
+	return true;
+}
+
+void spill_file_close(struct spill_file *spill)
+{
+	if (spill->file) {
+		fclose(spill->file);
+		os_unlink(spill->path);
+	}
+
+	bfree(spill->path);
+	memset(spill, 0, sizeof(*spill));
+}
+
+static int64_t find_space(struct spill_file *spill, int64_t size)
+{
+	if (!spill->num)
+		spill->start = spill->end = 0;
+
+	if (spill->end >= spill->start) {
+		if (spill->capacity - spill->end >= size)
+			return spill->end;
+
+		/* the end must never catch up with the start, otherwise a
+		 * full ring would look the same as an empty one */
+		if (spill->start > size)
+			return 0;
+
+	} else if (spill->start - spill->end > size) {
+		return spill->end;
+	}
+
+	return -1;
+}
+
+int64_t spill_file_write(struct spill_file *spill, const uint8_t *data, size_t size)
+{
+	int64_t offset = find_space(spill, (int64_t)size);
+	if (offset < 0)
+		return -1;
+
+	if (os_fseeki64(spill->file, offset, SEEK_SET) != 0)
+		return -1;
+	if (fwrite(data, 1, size, spill->file) != size)
+		return -1;
+
+	spill->end = offset + (int64_t)size;
+	spill->num++;
+	return offset;
+}
+
+void spill_file_free(struct spill_file *spill, int64_t offset, size_t size)
+{
+	if (spill->hold) {
+		spill->held_start = offset + (int64_t)size;
+		spill->held_num++;
+		return;
+	}
+
+	spill->start = offset + (int64_t)size;
+	spill->num--;
+}
+
+bool spill_file_hold(struct spill_file *spill)
+{
+	spill->hold = true;
+	return fflush(spill->file) == 0;
+}
+
+void spill_file_unhold(struct spill_file *spill)
+{
+	if (!spill->hold)
+		return;
+
+	if (spill->held_num) {
+		spill->start = spill->held_start;
+		spill->num -= spill->held_num;
+		spill->held_num = 0;
+	}
+
+	spill->hold = false;
+}
+
+bool spill_file_read(FILE *file, int64_t offset, uint8_t *data, size_t size)
+{
+	if (os_fseeki64(file, offset, SEEK_SET) != 0)
+		return false;
+	return fread(data, 1, size, file) == size;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <stdio.h>
+#include <util/c99defs.h>
+
+/*
+ * Preallocated ring file holding replay buffer packet payloads.
+ *
+ * Space is handed out in order at the write end and given back in the same
+ * order from the read end, which is how the replay buffer purges packets.  A
+ * payload never wraps around the end of the file, whatever does not fit at
+ * the end is written at the start instead.
+ *
+ * While a replay is being saved the saving thread reads payloads back through
+ * its own handle, so space is held (returned only once the save is done)
+ * rather than overwritten while the save is in progress.
+ */
+
+struct spill_file {
+	FILE *file;
+	char *path;
+	int64_t capacity;
+
+	int64_t start;
+	int64_t end;
+	size_t num;
+
+	bool hold;
+	int64_t held_start;
+	size_t held_num;
+};
+
+bool spill_file_open(struct spill_file *spill, const char *path, int64_t capacity);
+void spill_file_close(struct spill_file *spill);
+
+/* returns the offset the payload was written to, or -1 if there is no room */
+int64_t spill_file_write(struct spill_file *spill, const uint8_t *data, size_t size);
+
+/* gives back the oldest payload, which must be the one at offset */
+void spill_file_free(struct spill_file *spill, int64_t offset, size_t size);
+
+/* flushes the payloads written so far and stops space from being reused */
+bool spill_file_hold(struct spill_file *spill);
+void spill_file_unhold(struct spill_file *spill);
+
+static inline bool spill_file_active(const struct spill_file *spill)
+{
+	return spill->file != NULL;
+}
+
+bool spill_file_read(FILE *file, int64_t offset, uint8_t *data, size_t size);
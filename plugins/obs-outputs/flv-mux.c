@@ -305,7 +305,8 @@ void flv_meta_data(obs_output_t *context, uint8_t **output, size_t *size, bool w
 static int32_t last_time = 0;
 #endif
 
-static void flv_video(struct serializer *s, int32_t dts_offset, struct encoder_packet *packet, bool is_header)
+static void flv_video(struct serializer *s, int32_t dts_offset, struct encoder_packet *packet, bool is_header,
+		      bool tag_header_only)
 {
 	int32_t ct_offset_ms = get_ms_time(packet, packet->pts) - get_ms_time(packet, packet->dts);
 	int32_t time_ms = get_ms_time(packet, packet->dts) - dts_offset;
@@ -333,12 +334,16 @@ static void flv_video(struct serializer *s, int32_t dts_offset, struct encoder_p
 	s_w8(s, packet->keyframe ? 0x17 : 0x27);
 	s_w8(s, is_header ? 0 : 1);
 	s_wb24(s, ct_offset_ms);
+	if (tag_header_only)
+		return;
+
 	s_write(s, packet->data, packet->size);
 
 	write_previous_tag_size(s);
 }
 
-static void flv_audio(struct serializer *s, int32_t dts_offset, struct encoder_packet *packet, bool is_header)
+static void flv_audio(struct serializer *s, int32_t dts_offset, struct encoder_packet *packet, bool is_header,
+		      bool tag_header_only)
 {
 	int32_t time_ms = get_ms_time(packet, packet->dts) - dts_offset;
 
@@ -364,12 +369,16 @@ static void flv_audio(struct serializer *s, int32_t dts_offset, struct encoder_p
 	/* these are the two extra bytes mentioned above */
 	s_w8(s, 0xaf);
 	s_w8(s, is_header ? 0 : 1);
+	if (tag_header_only)
+		return;
+
 	s_write(s, packet->data, packet->size);
 
 	write_previous_tag_size(s);
 }
 
-void flv_packet_mux(struct encoder_packet *packet, int32_t dts_offset, uint8_t **output, size_t *size, bool is_header)
+static void flv_packet_mux_internal(struct encoder_packet *packet, int32_t dts_offset, uint8_t **output, size_t *size,
+				    bool is_header, bool tag_header_only)
 {
 	struct array_output_data data;
 	struct serializer s;
@@ -377,16 +386,27 @@ void flv_packet_mux(struct encoder_packet *packet, int32_t dts_offset, uint8_t *
 	array_output_serializer_init(&s, &data);
 
 	if (packet->type == OBS_ENCODER_VIDEO)
-		flv_video(&s, dts_offset, packet, is_header);
+		flv_video(&s, dts_offset, packet, is_header, tag_header_only);
 	else
-		flv_audio(&s, dts_offset, packet, is_header);
+		flv_audio(&s, dts_offset, packet, is_header, tag_header_only);
 
 	*output = data.bytes.array;
 	*size = data.bytes.num;
 }
 
-void flv_packet_audio_ex(struct encoder_packet *packet, enum audio_id_t codec_id, int32_t dts_offset, uint8_t **output,
-			 size_t *size, int type, size_t idx)
+void flv_packet_mux(struct encoder_packet *packet, int32_t dts_offset, uint8_t **output, size_t *size, bool is_header)
+{
+	flv_packet_mux_internal(packet, dts_offset, output, size, is_header, false);
+}
+
+void flv_packet_mux_tag_header(struct encoder_packet *packet, int32_t dts_offset, uint8_t **output, size_t *size,
+			       bool is_header)
+{
+	flv_packet_mux_internal(packet, dts_offset, output, size, is_header, true);
+}
+
+static void flv_packet_audio_ex(struct encoder_packet *packet, enum audio_id_t codec_id, int32_t dts_offset,
+				uint8_t **output, size_t *size, int type, size_t idx, bool tag_header_only)
 {
 	struct array_output_data data;
 	struct serializer s;
@@ -399,6 +419,9 @@ void flv_packet_audio_ex(struct encoder_packet *packet, enum audio_id_t codec_id
 
 	bool is_multitrack = idx > 0;
 
+	*output = NULL;
+	*size = 0;
+
 	if (!packet->data || !packet->size)
 		return;
 
@@ -431,17 +454,19 @@ void flv_packet_audio_ex(struct encoder_packet *packet, enum audio_id_t codec_id
 		s_wa4cc(&s, codec_id);
 	}
 
-	s_write(&s, packet->data, packet->size);
+	if (!tag_header_only) {
+		s_write(&s, packet->data, packet->size);
 
-	write_previous_tag_size(&s);
+		write_previous_tag_size(&s);
+	}
 
 	*output = data.bytes.array;
 	*size = data.bytes.num;
 }
 
 // Y2023 spec
-void flv_packet_ex(struct encoder_packet *packet, enum video_id_t codec_id, int32_t dts_offset, uint8_t **output,
-		   size_t *size, int type, size_t idx)
+static void flv_packet_ex(struct encoder_packet *packet, enum video_id_t codec_id, int32_t dts_offset,
+			  uint8_t **output, size_t *size, int type, size_t idx, bool tag_header_only)
 {
 	struct array_output_data data;
 	struct serializer s;
@@ -490,11 +515,13 @@ void flv_packet_ex(struct encoder_packet *packet, enum video_id_t codec_id, int3
 		s_wb24(&s, ct_offset_ms);
 	}
 
-	// packet data
-	s_write(&s, packet->data, packet->size);
+	if (!tag_header_only) {
+		// packet data
+		s_write(&s, packet->data, packet->size);
 
-	// packet tail
-	write_previous_tag_size(&s);
+		// packet tail
+		write_previous_tag_size(&s);
+	}
 
 	*output = data.bytes.array;
 	*size = data.bytes.num;
@@ -502,35 +529,51 @@ void flv_packet_ex(struct encoder_packet *packet, enum video_id_t codec_id, int3
 
 void flv_packet_start(struct encoder_packet *packet, enum video_id_t codec, uint8_t **output, size_t *size, size_t idx)
 {
-	flv_packet_ex(packet, codec, 0, output, size, PACKETTYPE_SEQ_START, idx);
+	flv_packet_ex(packet, codec, 0, output, size, PACKETTYPE_SEQ_START, idx, false);
 }
 
-void flv_packet_frames(struct encoder_packet *packet, enum video_id_t codec, int32_t dts_offset, uint8_t **output,
-		       size_t *size, size_t idx)
+static inline int get_frames_packet_type(struct encoder_packet *packet, enum video_id_t codec)
 {
-	int packet_type = PACKETTYPE_FRAMES;
 	// PACKETTYPE_FRAMESX is an optimization to avoid sending composition
 	// time offsets of 0. See Enhanced RTMP spec.
 	if ((codec == CODEC_H264 || codec == CODEC_HEVC) && packet->dts == packet->pts)
-		packet_type = PACKETTYPE_FRAMESX;
-	flv_packet_ex(packet, codec, dts_offset, output, size, packet_type, idx);
+		return PACKETTYPE_FRAMESX;
+	return PACKETTYPE_FRAMES;
+}
+
+void flv_packet_frames(struct encoder_packet *packet, enum video_id_t codec, int32_t dts_offset, uint8_t **output,
+		       size_t *size, size_t idx)
+{
+	flv_packet_ex(packet, codec, dts_offset, output, size, get_frames_packet_type(packet, codec), idx, false);
+}
+
+void flv_packet_frames_tag_header(struct encoder_packet *packet, enum video_id_t codec, int32_t dts_offset,
+				  uint8_t **output, size_t *size, size_t idx)
+{
+	flv_packet_ex(packet, codec, dts_offset, output, size, get_frames_packet_type(packet, codec), idx, true);
 }
 
 void flv_packet_end(struct encoder_packet *packet, enum video_id_t codec, uint8_t **output, size_t *size, size_t idx)
 {
-	flv_packet_ex(packet, codec, 0, output, size, PACKETTYPE_SEQ_END, idx);
+	flv_packet_ex(packet, codec, 0, output, size, PACKETTYPE_SEQ_END, idx, false);
 }
 
 void flv_packet_audio_start(struct encoder_packet *packet, enum audio_id_t codec, uint8_t **output, size_t *size,
 			    size_t idx)
 {
-	flv_packet_audio_ex(packet, codec, 0, output, size, AUDIO_PACKETTYPE_SEQ_START, idx);
+	flv_packet_audio_ex(packet, codec, 0, output, size, AUDIO_PACKETTYPE_SEQ_START, idx, false);
 }
 
 void flv_packet_audio_frames(struct encoder_packet *packet, enum audio_id_t codec, int32_t dts_offset, uint8_t **output,
 			     size_t *size, size_t idx)
 {
-	flv_packet_audio_ex(packet, codec, dts_offset, output, size, AUDIO_PACKETTYPE_FRAMES, idx);
+	flv_packet_audio_ex(packet, codec, dts_offset, output, size, AUDIO_PACKETTYPE_FRAMES, idx, false);
+}
+
+void flv_packet_audio_frames_tag_header(struct encoder_packet *packet, enum audio_id_t codec, int32_t dts_offset,
+					uint8_t **output, size_t *size, size_t idx)
+{
+	flv_packet_audio_ex(packet, codec, dts_offset, output, size, AUDIO_PACKETTYPE_FRAMES, idx, true);
 }
 
 void flv_packet_metadata(enum video_id_t codec_id, uint8_t **output, size_t *size, int bits_per_raw_sample,
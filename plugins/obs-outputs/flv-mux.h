@@ -77,3 +77,14 @@ extern void flv_packet_audio_start(struct encoder_packet *packet, enum audio_id_
 				   size_t idx);
 extern void flv_packet_audio_frames(struct encoder_packet *packet, enum audio_id_t codec, int32_t dts_offset,
 				    uint8_t **output, size_t *size, size_t idx);
+
+/* The _tag_header variants only write the FLV tag header and the codec
+ * specific bytes that precede the payload; the payload itself is
+ * packet->data and no PreviousTagSize is written.  Used to send packets
+ * without copying their payload. */
+extern void flv_packet_mux_tag_header(struct encoder_packet *packet, int32_t dts_offset, uint8_t **output,
+				      size_t *size, bool is_header);
+extern void flv_packet_frames_tag_header(struct encoder_packet *packet, enum video_id_t codec, int32_t dts_offset,
+					 uint8_t **output, size_t *size, size_t idx);
+extern void flv_packet_audio_frames_tag_header(struct encoder_packet *packet, enum audio_id_t codec,
+					       int32_t dts_offset, uint8_t **output, size_t *size, size_t idx);
@@ -173,6 +173,7 @@ static void HandleClientBW(RTMP *r, const RTMPPacket *packet);
 
 static int ReadN(RTMP *r, char *buffer, int n);
 static int WriteN(RTMP *r, const char *buffer, int n);
+static int HandleSendError(RTMP *r, int n);
 
 static void DecodeTEA(AVal *key, AVal *text);
 
@@ -1576,11 +1577,37 @@ ReadN(RTMP *r, char *buffer, int n)
     return nOriginalSize - n;
 }
 
+/* returns TRUE if the send should be retried */
+static int
+HandleSendError(RTMP *r, int n)
+{
+    struct linger l;
+    int sockerr = GetSockError();
+    RTMP_Log(RTMP_LOGERROR, "%s, RTMP send error %d (%d bytes)", __FUNCTION__,
+             sockerr, n);
+
+    if (sockerr == EINTR && !RTMP_ctrlC)
+        return TRUE;
+
+    r->last_error_code = sockerr;
+
+    // Force-close the socket. Sometimes a send() error isn't fatal, so
+    // we could end up writing an unpublish message which some services
+    // treat as a clean shutdown. We need to disable lingering too so
+    // the remote side sees an abortive shutdown (RST).
+    l.l_onoff = 1;
+    l.l_linger = 0;
+    setsockopt(r->m_sb.sb_socket, SOL_SOCKET, SO_LINGER, (char *)&l, sizeof(l));
+    RTMPSockBuf_Close(&r->m_sb);
+
+    RTMP_Close(r);
+    return FALSE;
+}
+
 static int
 WriteN(RTMP *r, const char *buffer, int n)
 {
     const char *ptr = buffer;
-    struct linger l;
 
     while (n > 0)
     {
@@ -1596,25 +1623,9 @@ WriteN(RTMP *r, const char *buffer, int n)
 
         if (nBytes < 0)
         {
-            int sockerr = GetSockError();
-            RTMP_Log(RTMP_LOGERROR, "%s, RTMP send error %d (%d bytes)", __FUNCTION__,
-                     sockerr, n);
-
-            if (sockerr == EINTR && !RTMP_ctrlC)
+            if (HandleSendError(r, n))
                 continue;
 
-            r->last_error_code = sockerr;
-
-            // Force-close the socket. Sometimes a send() error isn't fatal, so
-            // we could end up writing an unpublish message which some services
-            // treat as a clean shutdown. We need to disable lingering too so
-            // the remote side sees an abortive shutdown (RST).
-            l.l_onoff = 1;
-            l.l_linger = 0;
-            setsockopt(r->m_sb.sb_socket, SOL_SOCKET, SO_LINGER, (char *)&l, sizeof(l));
-            RTMPSockBuf_Close(&r->m_sb);
-
-            RTMP_Close(r);
             n = 1;
             break;
         }
@@ -4085,18 +4096,19 @@ RTMP_SendChunk(RTMP *r, RTMPChunk *chunk)
     return wrote;
 }
 
-int
-RTMP_SendPacket(RTMP *r, RTMPPacket *packet, int queue)
+/* Encodes the chunk header of the first chunk of a packet.  The header ends
+ * right where the body starts: in front of m_body if the packet has one,
+ * otherwise at the end of hbuf. */
+static int
+EncodePacketHeader(RTMP *r, RTMPPacket *packet, char *hbuf, char **pHeader, int *pHSize, int *pCSize, char *pC,
+                   uint32_t *pT)
 {
     const RTMPPacket *prevPacket;
     uint32_t last = 0;
     int nSize;
     int hSize, cSize;
-    char *header, *hptr, *hend, hbuf[RTMP_MAX_HEADER_SIZE], c;
+    char *header, *hptr, *hend, c;
     uint32_t t;
-    char *buffer, *tbuf = NULL, *toff = NULL;
-    int nChunkSize;
-    int tlen;
 
     if (packet->m_nChannel >= r->m_channelsAllocatedOut)
     {
@@ -4159,7 +4171,7 @@ RTMP_SendPacket(RTMP *r, RTMPPacket *packet, int queue)
     else
     {
         header = hbuf + 6;
-        hend = hbuf + sizeof(hbuf);
+        hend = hbuf + RTMP_MAX_HEADER_SIZE;
     }
 
     if (packet->m_nChannel > 319)
@@ -4217,6 +4229,36 @@ RTMP_SendPacket(RTMP *r, RTMPPacket *packet, int queue)
     if (nSize > 1 && t >= 0xffffff)
         hptr = AMF_EncodeInt32(hptr, hend, t);
 
+    *pHeader = header;
+    *pHSize = hSize;
+    *pCSize = cSize;
+    *pC = c;
+    *pT = t;
+    return TRUE;
+}
+
+static void
+StoreSentPacket(RTMP *r, const RTMPPacket *packet)
+{
+    if (!r->m_vecChannelsOut[packet->m_nChannel])
+        r->m_vecChannelsOut[packet->m_nChannel] = malloc(sizeof(RTMPPacket));
+    memcpy(r->m_vecChannelsOut[packet->m_nChannel], packet, sizeof(RTMPPacket));
+}
+
+int
+RTMP_SendPacket(RTMP *r, RTMPPacket *packet, int queue)
+{
+    int nSize;
+    int hSize, cSize;
+    char *header, hbuf[RTMP_MAX_HEADER_SIZE], c;
+    uint32_t t;
+    char *buffer, *tbuf = NULL, *toff = NULL;
+    int nChunkSize;
+    int tlen;
+
+    if (!EncodePacketHeader(r, packet, hbuf, &header, &hSize, &cSize, &c, &t))
+        return FALSE;
+
     nSize = packet->m_nBodySize;
     buffer = packet->m_body;
     nChunkSize = r->m_outChunkSize;
@@ -4314,9 +4356,206 @@ RTMP_SendPacket(RTMP *r, RTMPPacket *packet, int queue)
         }
     }
 
-    if (!r->m_vecChannelsOut[packet->m_nChannel])
-        r->m_vecChannelsOut[packet->m_nChannel] = malloc(sizeof(RTMPPacket));
-    memcpy(r->m_vecChannelsOut[packet->m_nChannel], packet, sizeof(RTMPPacket));
+    StoreSentPacket(r, packet);
+    return TRUE;
+}
+
+/* Gather lists are flushed whenever this many entries have been queued, which
+ * keeps them on the stack and well below IOV_MAX. */
+#define RTMP_IOV_BATCH 192
+
+#ifdef _WIN32
+typedef WSABUF RTMPIovec;
+#define RTMP_IOV_BASE(v) ((v)->buf)
+#define RTMP_IOV_LEN(v) ((int)(v)->len)
+#else
+typedef struct iovec RTMPIovec;
+#define RTMP_IOV_BASE(v) ((char *)(v)->iov_base)
+#define RTMP_IOV_LEN(v) ((int)(v)->iov_len)
+#endif
+
+static inline void
+SetIov(RTMPIovec *v, const char *b, int l)
+{
+#ifdef _WIN32
+    v->buf = (CHAR *)b;
+    v->len = (ULONG)l;
+#else
+    v->iov_base = (void *)b;
+    v->iov_len = (size_t)l;
+#endif
+}
+
+static int
+RTMPSockBuf_SendIov(RTMPSockBuf *sb, RTMPIovec *iov, int iovcnt)
+{
+#ifdef _WIN32
+    DWORD sent = 0;
+    if (WSASend(sb->sb_socket, iov, (DWORD)iovcnt, &sent, 0, NULL, NULL) == SOCKET_ERROR)
+        return -1;
+    return (int)sent;
+#else
+    struct msghdr msg = {0};
+    msg.msg_iov = iov;
+    msg.msg_iovlen = iovcnt;
+    return (int)sendmsg(sb->sb_socket, &msg, MSG_NOSIGNAL);
+#endif
+}
+
+static int
+FlushIov(RTMP *r, RTMPIovec *iov, int iovcnt)
+{
+    int total = 0;
+
+    for (int i = 0; i < iovcnt; i++)
+        total += RTMP_IOV_LEN(&iov[i]);
+
+    /* A custom send function queues the data itself, so hand it each
+     * piece as is; that is the only copy the payload sees. */
+    if (r->m_bCustomSend && r->m_customSendFunc)
+    {
+        for (int i = 0; i < iovcnt; i++)
+        {
+            if (!WriteN(r, RTMP_IOV_BASE(&iov[i]), RTMP_IOV_LEN(&iov[i])))
+                return FALSE;
+        }
+        return TRUE;
+    }
+
+    /* RTMPT posts and TLS records want one contiguous write, not one per
+     * chunk header, so merge the batch first. */
+    if ((r->Link.protocol & RTMP_FEATURE_HTTP)
+#if defined(CRYPTO) && !defined(NO_SSL)
+        || r->m_sb.sb_ssl
+#endif
+       )
+    {
+        char *buf = malloc(total), *ptr = buf;
+        int wrote;
+
+        if (!buf)
+            return FALSE;
+
+        for (int i = 0; i < iovcnt; i++)
+        {
+            memcpy(ptr, RTMP_IOV_BASE(&iov[i]), RTMP_IOV_LEN(&iov[i]));
+            ptr += RTMP_IOV_LEN(&iov[i]);
+        }
+
+        wrote = WriteN(r, buf, total);
+        free(buf);
+        return wrote;
+    }
+
+    while (iovcnt > 0)
+    {
+        int nBytes = RTMPSockBuf_SendIov(&r->m_sb, iov, iovcnt);
+
+        if (nBytes < 0)
+        {
+            if (HandleSendError(r, total))
+                continue;
+            return FALSE;
+        }
+
+        if (nBytes == 0)
+            return FALSE;
+
+        total -= nBytes;
+
+        /* skip whatever went out, a partially sent entry is advanced */
+        while (nBytes > 0)
+        {
+            int len = RTMP_IOV_LEN(iov);
+
+            if (nBytes >= len)
+            {
+                nBytes -= len;
+                iov++;
+                iovcnt--;
+            }
+            else
+            {
+                SetIov(iov, RTMP_IOV_BASE(iov) + nBytes, len - nBytes);
+                nBytes = 0;
+            }
+        }
+    }
+
+    return TRUE;
+}
+
+/* Same as RTMP_SendPacket, but the body is given as two separate pieces
+ * which are never copied or modified: chunk headers are written to their own
+ * buffers and everything goes out as one gather list per batch of chunks. */
+static int
+SendPacketIov(RTMP *r, RTMPPacket *packet, const char *prefix, int prefixSize, const char *payload,
+              int payloadSize)
+{
+    RTMPIovec iov[RTMP_IOV_BATCH + 3];
+    int iovcnt = 0;
+    char hbuf[RTMP_MAX_HEADER_SIZE], cbuf[7], c;
+    char *header;
+    int hSize, cSize, contSize = 1;
+    int nChunkSize = r->m_outChunkSize;
+    int offset = 0;
+    uint32_t t;
+
+    packet->m_body = NULL;
+    if (!EncodePacketHeader(r, packet, hbuf, &header, &hSize, &cSize, &c, &t))
+        return FALSE;
+
+    /* the header of every following Type 3 chunk is identical */
+    cbuf[0] = (0xc0 | c);
+    if (cSize)
+    {
+        int tmp = packet->m_nChannel - 64;
+        cbuf[contSize++] = tmp & 0xff;
+        if (cSize == 2)
+            cbuf[contSize++] = tmp >> 8;
+    }
+    if (t >= 0xffffff)
+    {
+        AMF_EncodeInt32(cbuf + contSize, cbuf + sizeof(cbuf), t);
+        contSize += 4;
+    }
+
+    RTMP_Log(RTMP_LOGDEBUG2, "%s: fd=%d, size=%d", __FUNCTION__, (int)r->m_sb.sb_socket,
+             prefixSize + payloadSize);
+
+    SetIov(&iov[iovcnt++], header, hSize);
+
+    while (offset < prefixSize + payloadSize)
+    {
+        int end = offset + nChunkSize;
+
+        if (end > prefixSize + payloadSize)
+            end = prefixSize + payloadSize;
+
+        if (offset)
+            SetIov(&iov[iovcnt++], cbuf, contSize);
+        if (offset < prefixSize)
+            SetIov(&iov[iovcnt++], prefix + offset, (end < prefixSize ? end : prefixSize) - offset);
+        if (end > prefixSize)
+        {
+            int start = offset > prefixSize ? offset - prefixSize : 0;
+            SetIov(&iov[iovcnt++], payload + start, end - prefixSize - start);
+        }
+
+        offset = end;
+
+        if (iovcnt >= RTMP_IOV_BATCH)
+        {
+            if (!FlushIov(r, iov, iovcnt))
+                return FALSE;
+            iovcnt = 0;
+        }
+    }
+
+    if (iovcnt && !FlushIov(r, iov, iovcnt))
+        return FALSE;
+
+    StoreSentPacket(r, packet);
     return TRUE;
 }
 
@@ -5314,6 +5553,47 @@ fail:
     return total;
 }
 
+int
+RTMP_WriteTag(RTMP *r, const char *tag, int tagSize, const char *payload, int payloadSize, int streamIdx)
+{
+    RTMPPacket pkt = {0};
+
+    if (tagSize < 11)
+    {
+        /* FLV pkt too small */
+        return 0;
+    }
+
+    pkt.m_nChannel = 0x04;	/* source channel */
+    pkt.m_nInfoField2 = r->Link.streams[streamIdx].id;
+    pkt.m_packetType = tag[0];
+    pkt.m_nBodySize = AMF_DecodeInt24(tag + 1);
+    pkt.m_nTimeStamp = AMF_DecodeInt24(tag + 4);
+    pkt.m_nTimeStamp |= (uint32_t)(uint8_t)tag[7] << 24;
+
+    if (pkt.m_nBodySize != (uint32_t)(tagSize - 11 + payloadSize))
+    {
+        RTMP_Log(RTMP_LOGERROR, "%s, FLV tag size mismatch", __FUNCTION__);
+        return 0;
+    }
+
+    if (((pkt.m_packetType == RTMP_PACKET_TYPE_AUDIO
+            || pkt.m_packetType == RTMP_PACKET_TYPE_VIDEO) &&
+            !pkt.m_nTimeStamp) || pkt.m_packetType == RTMP_PACKET_TYPE_INFO)
+    {
+        pkt.m_headerType = RTMP_PACKET_SIZE_LARGE;
+    }
+    else
+    {
+        pkt.m_headerType = RTMP_PACKET_SIZE_MEDIUM;
+    }
+
+    if (!SendPacketIov(r, &pkt, tag + 11, tagSize - 11, payload, payloadSize))
+        return -1;
+
+    return tagSize + payloadSize;
+}
+
 int
 RTMP_Write(RTMP *r, const char *buf, int size, int streamIdx)
 {
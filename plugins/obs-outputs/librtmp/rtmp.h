@@ -543,6 +543,11 @@ extern "C"
     void RTMP_DropRequest(RTMP *r, int i, int freeit);
     int RTMP_Read(RTMP *r, char *buf, int size);
     int RTMP_Write(RTMP *r, const char *buf, int size, int streamIdx);
+    /* Writes a single FLV tag without copying its payload.  tag holds the
+     * 11 byte FLV tag header followed by the start of the tag body, payload
+     * holds the rest of the body.  No PreviousTagSize follows. */
+    int RTMP_WriteTag(RTMP *r, const char *tag, int tagSize, const char *payload, int payloadSize,
+                      int streamIdx);
 
 #ifdef USE_HASHSWF
     /* hashswf.c */
@@ -18,6 +18,7 @@
 #pragma once
 
 #include "mp4-mux.h"
+#include "mp4-spill.h"
 
 #include <util/darray.h>
 #include <util/deque.h>
@@ -117,6 +118,14 @@ struct mp4_track {
 	/* Sync samples, i.e. keyframes (Video only) */
 	DARRAY(uint32_t) sync_samples;
 
+	/* Leading entries of the tables above that have been spilled to disk,
+	 * only the entries after those are kept in memory. */
+	struct spilled_table spilled_sample_sizes;
+	struct spilled_table spilled_chunks;
+	struct spilled_table spilled_deltas;
+	struct spilled_table spilled_offsets;
+	struct spilled_table spilled_sync_samples;
+
 	/* Temporary array with information about the samples to be included
 	 * in the next fragment. */
 	DARRAY(struct fragment_sample) fragment_samples;
@@ -147,6 +156,9 @@ struct mp4_mux {
 	DARRAY(struct mp4_track) tracks;
 	/* Special tracks */
 	struct mp4_track *chapter_track;
+
+	/* Temporary file sample tables are spilled to (if enabled) */
+	struct mp4_spill_file spill;
 };
 
 /* clang-format off */
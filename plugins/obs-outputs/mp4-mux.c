@@ -2611,6 +2611,59 @@ static void write_packets(struct mp4_mux *mux, struct mp4_track *track)
 	da_clear(track->fragment_samples);
 }
 
+/* ========================================================================== */
+/* Sample table spilling                                                      */
+
+/* The sample tables grow with every sample until the full moov is written on
+ * finalisation, which over a day long recording adds up to a few hundred MB.
+ * With spilling enabled, whatever exceeds this much per table is written to a
+ * temporary file instead and only read back when finalising. */
+#define SPILL_THRESHOLD (256 * 1024)
+
+#define spill_track_table(table) \
+	mp4_spill_table(&mux->spill, &track->spilled_##table, &track->table.da, sizeof(*track->table.array), \
+			SPILL_THRESHOLD)
+
+static void spill_track_tables(struct mp4_mux *mux, struct mp4_track *track)
+{
+	bool success = spill_track_table(sample_sizes) && spill_track_table(chunks) && spill_track_table(deltas) &&
+		       spill_track_table(offsets) && spill_track_table(sync_samples);
+
+	if (!success) {
+		warn("Failed to write sample tables to '%s', keeping them in memory", mux->spill.path);
+		mux->spill.error = true;
+	}
+}
+
+#undef spill_track_table
+
+#define restore_track_table(table) \
+	mp4_restore_table(&mux->spill, &track->spilled_##table, &track->table.da, sizeof(*track->table.array))
+
+static bool restore_sample_tables(struct mp4_mux *mux)
+{
+	bool success = true;
+
+	if (!mux->spill.file)
+		return true;
+
+	info("Reading back %zu KiB of spilled sample tables...", (size_t)(mux->spill.size / 1024));
+
+	for (size_t i = 0; i < mux->tracks.num; i++) {
+		struct mp4_track *track = &mux->tracks.array[i];
+
+		success = restore_track_table(sample_sizes) && success;
+		success = restore_track_table(chunks) && success;
+		success = restore_track_table(deltas) && success;
+		success = restore_track_table(offsets) && success;
+		success = restore_track_table(sync_samples) && success;
+	}
+
+	return success;
+}
+
+#undef restore_track_table
+
 static void mp4_flush_fragment(struct mp4_mux *mux)
 {
 	struct serializer *s = mux->serializer;
@@ -2693,6 +2746,11 @@ static void mp4_flush_fragment(struct mp4_mux *mux)
 	if (!mux->next_frag_pts && mux->chapter_track)
 		write_packets(mux, mux->chapter_track);
 
+	if (mux->spill.file && !mux->spill.error) {
+		for (size_t i = 0; i < mux->tracks.num && !mux->spill.error; i++)
+			spill_track_tables(mux, &mux->tracks.array[i]);
+	}
+
 	mux->next_frag_pts = 0;
 }
 
@@ -2829,6 +2887,12 @@ static inline void free_track(struct mp4_track *track)
 	da_free(track->offsets);
 	da_free(track->sync_samples);
 	da_free(track->fragment_samples);
+
+	da_free(track->spilled_sample_sizes.ranges);
+	da_free(track->spilled_chunks.ranges);
+	da_free(track->spilled_deltas.ranges);
+	da_free(track->spilled_offsets.ranges);
+	da_free(track->spilled_sync_samples.ranges);
 }
 
 /* ===========================================================================*/
@@ -2877,9 +2941,20 @@ void mp4_mux_destroy(struct mp4_mux *mux)
 	free_track(mux->chapter_track);
 	bfree(mux->chapter_track);
 	da_free(mux->tracks);
+	mp4_spill_close(&mux->spill);
 	bfree(mux);
 }
 
+bool mp4_mux_spill_sample_tables(struct mp4_mux *mux, const char *path)
+{
+	if (!mp4_spill_open(&mux->spill, path)) {
+		warn("Unable to open sample table spill file '%s'", path);
+		return false;
+	}
+
+	return true;
+}
+
 bool mp4_mux_submit_packet(struct mp4_mux *mux, struct encoder_packet *pkt)
 {
 	struct mp4_track *track = NULL;
@@ -2971,6 +3046,13 @@ bool mp4_mux_finalise(struct mp4_mux *mux)
 		return true;
 	}
 
+	/* The file is complete as a fragmented MP4 at this point, so leave it
+	 * as that rather than write a moov that is missing samples. */
+	if (!restore_sample_tables(mux)) {
+		warn("Unable to read back spilled sample tables, leaving file fragmented!");
+		return false;
+	}
+
 	int64_t data_end = serializer_get_pos(s);
 
 	/* ---------------------------------------- */
@@ -43,6 +43,7 @@ enum mp4_mux_flags {
 struct mp4_mux *mp4_mux_create(obs_output_t *output, struct serializer *serializer, enum mp4_mux_flags flags,
 			       enum mp4_flavor flavor);
 void mp4_mux_destroy(struct mp4_mux *mux);
+bool mp4_mux_spill_sample_tables(struct mp4_mux *mux, const char *path);
 bool mp4_mux_submit_packet(struct mp4_mux *mux, struct encoder_packet *pkt);
 bool mp4_mux_add_chapter(struct mp4_mux *mux, int64_t dts_usec, const char *name);
 bool mp4_mux_finalise(struct mp4_mux *mux);
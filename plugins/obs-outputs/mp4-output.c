@@ -48,6 +48,7 @@ struct mp4_output {
 	/* File serializer buffer configuration */
 	size_t buffer_size;
 	size_t chunk_size;
+	bool direct_io;
 	struct serializer serializer;
 
 	bool enable_bpm;
@@ -64,6 +65,7 @@ struct mp4_output {
 	struct mp4_mux *muxer;
 	enum mp4_flavor muxer_flavor;
 	int flags;
+	bool spill_sample_tables;
 
 	size_t chapter_ctr;
 	struct deque chapters;
@@ -262,6 +264,10 @@ static void parse_custom_options(struct mp4_output *out, const char *opts_str)
 			out->chunk_size = strtoull(opt.value, 0, 10) * 1048576ULL;
 		} else if (strcmp(opt.name, "bpm") == 0) {
 			out->enable_bpm = !!atoi(opt.value);
+		} else if (strcmp(opt.name, "direct_io") == 0) {
+			out->direct_io = !!atoi(opt.value);
+		} else if (strcmp(opt.name, "spill_sample_tables") == 0) {
+			out->spill_sample_tables = !!atoi(opt.value);
 		} else {
 			blog(LOG_WARNING, "Unknown muxer option: %s = %s", opt.name, opt.value);
 		}
@@ -274,6 +280,30 @@ static void parse_custom_options(struct mp4_output *out, const char *opts_str)
 
 static void generate_filename(struct mp4_output *out, struct dstr *dst, bool overwrite);
 
+static bool open_output_file(struct mp4_output *out)
+{
+	if (out->direct_io)
+		return buffered_file_serializer_init_direct(&out->serializer, out->path.array, out->buffer_size,
+							    out->chunk_size);
+
+	return buffered_file_serializer_init(&out->serializer, out->path.array, out->buffer_size, out->chunk_size);
+}
+
+static void create_muxer(struct mp4_output *out)
+{
+	out->muxer = mp4_mux_create(out->output, &out->serializer, out->flags, out->muxer_flavor);
+
+	/* Keeps memory usage flat for very long recordings, the sample tables
+	 * are only needed in full once the file gets finalised. */
+	if (out->spill_sample_tables) {
+		struct dstr spill_path;
+		dstr_init_copy_dstr(&spill_path, &out->path);
+		dstr_cat(&spill_path, ".tables");
+		mp4_mux_spill_sample_tables(out->muxer, spill_path.array);
+		dstr_free(&spill_path);
+	}
+}
+
 static bool mp4_output_start(void *data)
 {
 	struct mp4_output *out = data;
@@ -313,7 +343,7 @@ static bool mp4_output_start(void *data)
 		obs_output_add_packet_callback(out->output, bpm_inject, NULL);
 	}
 
-	if (!buffered_file_serializer_init(&out->serializer, out->path.array, out->buffer_size, out->chunk_size)) {
+	if (!open_output_file(out)) {
 		warn("Unable to open file '%s'", out->path.array);
 		return false;
 	}
@@ -322,7 +352,7 @@ static bool mp4_output_start(void *data)
 	obs_output_add_packet_callback(out->output, mp4_pkt_callback, (void *)out);
 
 	/* Initialise muxer and start capture */
-	out->muxer = mp4_mux_create(out->output, &out->serializer, out->flags, out->muxer_flavor);
+	create_muxer(out);
 	os_atomic_set_bool(&out->active, true);
 	obs_output_begin_data_capture(out->output, 0);
 
@@ -431,12 +461,12 @@ static bool change_file(struct mp4_output *out, struct encoder_packet *pkt)
 	generate_filename(out, &out->path, out->allow_overwrite);
 	info("Changing output file to '%s'", out->path.array);
 
-	if (!buffered_file_serializer_init(&out->serializer, out->path.array, out->buffer_size, out->chunk_size)) {
+	if (!open_output_file(out)) {
 		warn("Unable to open file '%s'", out->path.array);
 		return false;
 	}
 
-	out->muxer = mp4_mux_create(out->output, &out->serializer, out->flags, out->muxer_flavor);
+	create_muxer(out);
 
 	calldata_t cd = {0};
 	signal_handler_t *sh = obs_output_get_signal_handler(out->output);
@@ -0,0 +1,92 @@
+#include "mp4-spill.h"
+
+#include <util/bmem.h>
+#include <util/platform.h>
+
+bool mp4_spill_open(struct mp4_spill_file *spill, const char *path)
+{
+	mp4_spill_close(spill);
+
+	spill->file = os_fopen(path, "w+b");
+	if (!spill->file)
+		return false;
+
+	spill->path = bstrdup(path);
+	spill->size = 0;
+	spill->error = false;
+	return true;
+}
+
+void mp4_spill_close(struct mp4_spill_file *spill)
+{
+	if (spill->file) {
+		fclose(spill->file);
+		os_unlink(spill->path);
+	}
+
+	bfree(spill->path);
+	spill->file = NULL;
+	spill->path = NULL;
+}
+
+bool mp4_spill_table(struct mp4_spill_file *spill, struct spilled_table *spilled, struct darray *da,
+		     size_t element_size, size_t threshold)
+{
+	if (da->num * element_size < threshold || da->num < 2)
+		return true;
+
+	/* Keep the last entry, run-length encoded tables keep extending it */
+	size_t num = da->num - 1;
+	size_t size = num * element_size;
+
+	if (os_fseeki64(spill->file, spill->size, SEEK_SET) != 0 || fwrite(da->array, 1, size, spill->file) != size)
+		return false;
+
+	struct spilled_range *range = da_push_back_new(spilled->ranges);
+	range->offset = spill->size;
+	range->num = num;
+
+	spilled->num += num;
+	spill->size += (int64_t)size;
+
+	darray_erase_range(element_size, da, 0, num);
+	return true;
+}
+
+bool mp4_restore_table(struct mp4_spill_file *spill, struct spilled_table *spilled, struct darray *da,
+		       size_t element_size)
+{
+	if (!spilled->num)
+		return true;
+
+	struct darray merged;
+	darray_init(&merged);
+	darray_resize(element_size, &merged, spilled->num + da->num);
+
+	uint8_t *dst = merged.array;
+	bool success = true;
+
+	for (size_t i = 0; i < spilled->ranges.num; i++) {
+		struct spilled_range *range = &spilled->ranges.array[i];
+		size_t size = range->num * element_size;
+
+		if (os_fseeki64(spill->file, range->offset, SEEK_SET) != 0 ||
+		    fread(dst, 1, size, spill->file) != size) {
+			success = false;
+			break;
+		}
+
+		dst += size;
+	}
+
+	if (success) {
+		memcpy(dst, da->array, da->num * element_size);
+		darray_move(da, &merged);
+	} else {
+		darray_free(&merged);
+	}
+
+	da_free(spilled->ranges);
+	spilled->num = 0;
+	return success;
+}
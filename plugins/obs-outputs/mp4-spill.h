@@ -0,0 +1,37 @@
+#pragma once
+
+#include <stdio.h>
+
+#include <util/c99defs.h>
+#include <util/darray.h>
+
+/* Run of sample table entries moved out to the spill file */
+struct spilled_range {
+	int64_t offset;
+	size_t num;
+};
+
+struct spilled_table {
+	DARRAY(struct spilled_range) ranges;
+	size_t num;
+};
+
+/* Temporary file sample tables are spilled to */
+struct mp4_spill_file {
+	FILE *file;
+	char *path;
+	int64_t size;
+	bool error;
+};
+
+bool mp4_spill_open(struct mp4_spill_file *spill, const char *path);
+void mp4_spill_close(struct mp4_spill_file *spill);
+
+/* Moves all but the last entry of a table to the spill file once the table
+ * takes up at least threshold bytes, returns false if writing failed */
+bool mp4_spill_table(struct mp4_spill_file *spill, struct spilled_table *spilled, struct darray *da,
+		     size_t element_size, size_t threshold);
+
+/* Puts the spilled entries of a table back in front of those in memory */
+bool mp4_restore_table(struct mp4_spill_file *spill, struct spilled_table *spilled, struct darray *da,
+		       size_t element_size);
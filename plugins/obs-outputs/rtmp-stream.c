@@ -396,6 +396,30 @@ static int handle_socket_read(struct rtmp_stream *stream)
 	return 0;
 }
 
+/* Sends an FLV tag whose header was muxed separately, the payload is handed to
+ * librtmp as is and only copied if the socket path needs a contiguous buffer. */
+static int write_tag(struct rtmp_stream *stream, struct encoder_packet *packet, uint8_t *tag_header,
+		     size_t tag_header_size, size_t *size)
+{
+	int ret;
+
+	if (!tag_header_size) {
+		*size = 0;
+		return 0;
+	}
+
+	*size = tag_header_size + packet->size;
+
+#ifdef TEST_FRAMEDROPS
+	droptest_cap_data_rate(stream, *size);
+#endif
+
+	ret = RTMP_WriteTag(&stream->rtmp, (char *)tag_header, (int)tag_header_size, (char *)packet->data,
+			    (int)packet->size, 0);
+	bfree(tag_header);
+	return ret;
+}
+
 static int send_packet(struct rtmp_stream *stream, struct encoder_packet *packet, bool is_header)
 {
 	uint8_t *data;
@@ -405,14 +429,8 @@ static int send_packet(struct rtmp_stream *stream, struct encoder_packet *packet
 	if (handle_socket_read(stream))
 		return -1;
 
-	flv_packet_mux(packet, is_header ? 0 : stream->start_dts_offset, &data, &size, is_header);
-
-#ifdef TEST_FRAMEDROPS
-	droptest_cap_data_rate(stream, size);
-#endif
-
-	ret = RTMP_Write(&stream->rtmp, (char *)data, (int)size, 0);
-	bfree(data);
+	flv_packet_mux_tag_header(packet, is_header ? 0 : stream->start_dts_offset, &data, &size, is_header);
+	ret = write_tag(stream, packet, data, size, &size);
 
 	if (is_header)
 		bfree(packet->data);
@@ -433,20 +451,23 @@ static int send_packet_ex(struct rtmp_stream *stream, struct encoder_packet *pac
 	if (handle_socket_read(stream))
 		return -1;
 
-	if (is_header) {
-		flv_packet_start(packet, stream->video_codec[idx], &data, &size, idx);
-	} else if (is_footer) {
-		flv_packet_end(packet, stream->video_codec[idx], &data, &size, idx);
-	} else {
-		flv_packet_frames(packet, stream->video_codec[idx], stream->start_dts_offset, &data, &size, idx);
-	}
+	if (is_header || is_footer) {
+		if (is_header)
+			flv_packet_start(packet, stream->video_codec[idx], &data, &size, idx);
+		else
+			flv_packet_end(packet, stream->video_codec[idx], &data, &size, idx);
 
 #ifdef TEST_FRAMEDROPS
-	droptest_cap_data_rate(stream, size);
+		droptest_cap_data_rate(stream, size);
 #endif
 
-	ret = RTMP_Write(&stream->rtmp, (char *)data, (int)size, 0);
-	bfree(data);
+		ret = RTMP_Write(&stream->rtmp, (char *)data, (int)size, 0);
+		bfree(data);
+	} else {
+		flv_packet_frames_tag_header(packet, stream->video_codec[idx], stream->start_dts_offset, &data, &size,
+					     idx);
+		ret = write_tag(stream, packet, data, size, &size);
+	}
 
 	if (is_header || is_footer) // manually created packets
 		bfree(packet->data);
@@ -468,13 +489,15 @@ static int send_audio_packet_ex(struct rtmp_stream *stream, struct encoder_packe
 
 	if (is_header) {
 		flv_packet_audio_start(packet, stream->audio_codec[idx], &data, &size, idx);
+
+		ret = RTMP_Write(&stream->rtmp, (char *)data, (int)size, 0);
+		bfree(data);
 	} else {
-		flv_packet_audio_frames(packet, stream->audio_codec[idx], stream->start_dts_offset, &data, &size, idx);
+		flv_packet_audio_frames_tag_header(packet, stream->audio_codec[idx], stream->start_dts_offset, &data,
+						   &size, idx);
+		ret = write_tag(stream, packet, data, size, &size);
 	}
 
-	ret = RTMP_Write(&stream->rtmp, (char *)data, (int)size, 0);
-	bfree(data);
-
 	if (is_header)
 		bfree(packet->data);
 	else
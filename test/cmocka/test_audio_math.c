@@ -0,0 +1,114 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <math.h>
+#include <string.h>
+#include <cmocka.h>
+
+#include <util/platform.h>
+#include <media-io/audio-math.h>
+
+/* odd size so that the scalar tails run too */
+#define TEST_FRAMES 1027
+#define BENCH_FRAMES 1024
+#define BENCH_ITERATIONS 100000
+
+static void fill_samples(float *data, size_t count, float scale)
+{
+	uint32_t seed = 0x2545F491;
+
+	for (size_t i = 0; i < count; i++) {
+		seed = seed * 1103515245 + 12345;
+		data[i] = ((float)(seed >> 8) / (float)(1 << 24) - 0.5f) * scale;
+	}
+}
+
+static void add_mul_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	float a[TEST_FRAMES], b[TEST_FRAMES], ramp[TEST_FRAMES], ref[TEST_FRAMES];
+
+	fill_samples(a, TEST_FRAMES, 2.0f);
+	fill_samples(b, TEST_FRAMES, 1.0f);
+	fill_samples(ramp, TEST_FRAMES, 1.0f);
+
+	for (size_t i = 0; i < TEST_FRAMES; i++)
+		ref[i] = ((a[i] + b[i]) * 0.5f) * ramp[i];
+
+	audio_float_add(a, b, TEST_FRAMES);
+	audio_float_mul(a, 0.5f, TEST_FRAMES);
+	audio_float_mul_ramp(a, ramp, TEST_FRAMES);
+
+	assert_memory_equal(a, ref, sizeof(ref));
+}
+
+static void clamp_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	float data[TEST_FRAMES], unclamped[TEST_FRAMES], orig[TEST_FRAMES];
+
+	fill_samples(data, TEST_FRAMES, 4.0f);
+	data[0] = NAN;
+	data[5] = INFINITY;
+	data[6] = -INFINITY;
+	data[TEST_FRAMES - 1] = NAN;
+	memcpy(orig, data, sizeof(data));
+
+	audio_float_clamp_copy(data, unclamped, TEST_FRAMES);
+
+	assert_memory_equal(unclamped, orig, sizeof(orig));
+
+	for (size_t i = 0; i < TEST_FRAMES; i++) {
+		float val = orig[i];
+		val = (val == val) ? val : 0.0f;
+		val = (val > 1.0f) ? 1.0f : val;
+		val = (val < -1.0f) ? -1.0f : val;
+
+		assert_true(data[i] == val);
+	}
+
+	audio_float_clamp(orig, TEST_FRAMES);
+	assert_memory_equal(orig, data, sizeof(data));
+}
+
+/* not a correctness check, prints the cost of one mix-sized buffer */
+static void benchmark_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	float a[BENCH_FRAMES], b[BENCH_FRAMES], c[BENCH_FRAMES];
+	uint64_t start;
+
+	fill_samples(a, BENCH_FRAMES, 0.001f);
+	fill_samples(b, BENCH_FRAMES, 0.001f);
+
+#define BENCH(name, call)                                                                          \
+	do {                                                                                       \
+		start = os_gettime_ns();                                                           \
+		for (int i = 0; i < BENCH_ITERATIONS; i++)                                         \
+			call;                                                                      \
+		print_message("%-24s %8.1f ns/buffer\n", name,                                     \
+			      (double)(os_gettime_ns() - start) / (double)BENCH_ITERATIONS);       \
+	} while (false)
+
+	BENCH("audio_float_add", audio_float_add(a, b, BENCH_FRAMES));
+	BENCH("audio_float_mul", audio_float_mul(a, 1.0f, BENCH_FRAMES));
+	BENCH("audio_float_mul_ramp", audio_float_mul_ramp(a, b, BENCH_FRAMES));
+	BENCH("audio_float_clamp", audio_float_clamp(a, BENCH_FRAMES));
+	BENCH("audio_float_clamp_copy", audio_float_clamp_copy(a, c, BENCH_FRAMES));
+
+#undef BENCH
+}
+
+int main()
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(add_mul_test),
+		cmocka_unit_test(clamp_test),
+		cmocka_unit_test(benchmark_test),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,123 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include <callback/calldata.h>
+#include <util/platform.h>
+
+#define BENCH_RUNS 1000000
+
+enum { TEST_SOURCE, TEST_VOLUME, TEST_MUTED, TEST_OFFSET };
+static const struct calldata_param test_params[] = {
+	CALLDATA_PARAM_PTR("source"),
+	CALLDATA_PARAM_FLOAT("volume"),
+	CALLDATA_PARAM_BOOL("muted"),
+	CALLDATA_PARAM_INT("offset"),
+};
+static struct calldata_layout test_layout = CALLDATA_LAYOUT(test_params);
+
+static void layout_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	struct calldata data;
+	uint8_t stack[256];
+	int source;
+
+	assert_true(calldata_init_layout(&data, stack, sizeof(stack), &test_layout));
+
+	/* every parameter exists from the start */
+	assert_null(calldata_ptr(&data, "source"));
+	assert_true(calldata_get_int(&data, "offset", &(long long){1}));
+
+	/* the slot offsets are worked out once and match a lookup by name */
+	assert_int_equal(test_layout.ready, 1);
+	assert_int_equal(test_layout.size, data.size);
+	for (size_t i = 0; i < test_layout.num; i++) {
+		assert_non_null(calldata_slot(&data, &test_layout, i));
+		assert_ptr_equal(calldata_slot(&data, &test_layout, i), calldata_slot_lookup(&data, &test_layout, i));
+	}
+
+	calldata_slot_set_ptr(&data, &test_layout, TEST_SOURCE, &source);
+	calldata_slot_set_float(&data, &test_layout, TEST_VOLUME, 0.5);
+	calldata_slot_set_bool(&data, &test_layout, TEST_MUTED, true);
+	calldata_slot_set_int(&data, &test_layout, TEST_OFFSET, -42);
+
+	/* and can be read the usual way */
+	assert_ptr_equal(calldata_ptr(&data, "source"), &source);
+	assert_true(calldata_float(&data, "volume") == 0.5);
+	assert_true(calldata_bool(&data, "muted"));
+	assert_int_equal(calldata_int(&data, "offset"), -42);
+
+	/* values changed by name are visible through the slots */
+	calldata_set_float(&data, "volume", 0.25);
+	assert_true(calldata_slot_float(&data, &test_layout, TEST_VOLUME) == 0.25);
+
+	/* even if a callback moved things around */
+	calldata_set_string(&data, "source", "not a pointer anymore");
+	assert_null(calldata_slot_ptr(&data, &test_layout, TEST_SOURCE));
+	assert_true(calldata_slot_bool(&data, &test_layout, TEST_MUTED));
+	assert_int_equal(calldata_slot_int(&data, &test_layout, TEST_OFFSET), -42);
+
+	calldata_slot_set_int(&data, &test_layout, TEST_OFFSET, 7);
+	assert_int_equal(calldata_int(&data, "offset"), 7);
+}
+
+static void layout_overflow_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	struct calldata data;
+	uint8_t stack[32];
+
+	assert_false(calldata_init_layout(&data, stack, sizeof(stack), &test_layout));
+	assert_null(calldata_slot(&data, &test_layout, TEST_OFFSET));
+	assert_int_equal(calldata_slot_int(&data, &test_layout, TEST_OFFSET), 0);
+}
+
+static void layout_benchmark_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	struct calldata data;
+	uint8_t stack[256];
+	double sum = 0.0;
+	uint64_t start;
+
+	start = os_gettime_ns();
+	for (int i = 0; i < BENCH_RUNS; i++) {
+		calldata_init_fixed(&data, stack, sizeof(stack));
+		calldata_set_ptr(&data, "source", stack);
+		calldata_set_float(&data, "volume", 1.0);
+		calldata_set_bool(&data, "muted", false);
+		calldata_set_int(&data, "offset", i);
+		sum += calldata_float(&data, "volume");
+	}
+	double by_name = (double)(os_gettime_ns() - start) / BENCH_RUNS;
+
+	start = os_gettime_ns();
+	for (int i = 0; i < BENCH_RUNS; i++) {
+		calldata_init_layout(&data, stack, sizeof(stack), &test_layout);
+		calldata_slot_set_ptr(&data, &test_layout, TEST_SOURCE, stack);
+		calldata_slot_set_float(&data, &test_layout, TEST_VOLUME, 1.0);
+		calldata_slot_set_bool(&data, &test_layout, TEST_MUTED, false);
+		calldata_slot_set_int(&data, &test_layout, TEST_OFFSET, i);
+		sum += calldata_slot_float(&data, &test_layout, TEST_VOLUME);
+	}
+	double by_slot = (double)(os_gettime_ns() - start) / BENCH_RUNS;
+
+	assert_true(sum == 2.0 * BENCH_RUNS);
+	print_message("fill and read back by name %.1f ns, by slot %.1f ns\n", by_name, by_slot);
+}
+
+int main()
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(layout_test),
+		cmocka_unit_test(layout_overflow_test),
+		cmocka_unit_test(layout_benchmark_test),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,120 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include <obs-internal.h>
+
+/*
+ * obs-source-deinterlace.c is built in to this test, the parts of obs-source.c
+ * it uses are replaced below.  remove_async_frame frees every frame the way it
+ * does for frames submitted with obs_source_output_video_ref, so touching a
+ * frame after it has been removed shows up under AddressSanitizer.
+ */
+
+#define FRAME_COUNT 6
+#define FRAME_INTERVAL 10000000ULL
+#define FIRST_TS 1000000000ULL
+
+struct obs_core *obs = NULL;
+
+static size_t frames_released = 0;
+
+void remove_async_frame(obs_source_t *source, struct obs_source_frame *frame)
+{
+	UNUSED_PARAMETER(source);
+
+	if (!frame)
+		return;
+
+	frames_released++;
+	bfree(frame);
+}
+
+bool set_async_texture_size(struct obs_source *source, const struct obs_source_frame *frame)
+{
+	UNUSED_PARAMETER(source);
+	UNUSED_PARAMETER(frame);
+	return false;
+}
+
+bool update_async_textures(struct obs_source *source, const struct obs_source_frame *frame,
+			   gs_texture_t *tex[MAX_AV_PLANES], gs_texrender_t *texrender)
+{
+	UNUSED_PARAMETER(source);
+	UNUSED_PARAMETER(frame);
+	UNUSED_PARAMETER(tex);
+	UNUSED_PARAMETER(texrender);
+	return false;
+}
+
+gs_effect_t *obs_load_effect(gs_effect_t **effect, const char *file)
+{
+	UNUSED_PARAMETER(file);
+	return *effect;
+}
+
+static struct obs_source_frame *create_frame(uint64_t timestamp)
+{
+	struct obs_source_frame *frame = bzalloc(sizeof(*frame));
+	frame->timestamp = timestamp;
+	frame->refs = 1;
+	return frame;
+}
+
+static void skip_frames_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	struct obs_source_frame *frames[FRAME_COUNT];
+	obs_source_t *source = bzalloc(sizeof(*source));
+
+	obs = bzalloc(sizeof(*obs));
+	obs->video.video_half_frame_interval_ns = FRAME_INTERVAL / 2;
+	frames_released = 0;
+
+	for (size_t i = 0; i < FRAME_COUNT; i++) {
+		frames[i] = create_frame(FIRST_TS + i * FRAME_INTERVAL);
+		da_push_back(source->async_frames, &frames[i]);
+	}
+
+	/* the first two frames are shown as a field pair */
+	obs->video.video_time = FIRST_TS;
+	deinterlace_process_last_frame(source, obs->video.video_time);
+	source->last_sys_timestamp = obs->video.video_time;
+
+	assert_ptr_equal(source->prev_async_frame, frames[0]);
+	assert_ptr_equal(source->cur_async_frame, frames[1]);
+	assert_int_equal(source->async_frames.num, FRAME_COUNT - 2);
+	assert_int_equal(frames_released, 0);
+
+	/* rendering stalls for several frames, the frames that were missed are
+	 * removed until only two are left, without looking at them again */
+	obs->video.video_time += 5 * FRAME_INTERVAL;
+	deinterlace_process_last_frame(source, obs->video.video_time);
+	source->last_sys_timestamp = obs->video.video_time;
+
+	assert_int_equal(frames_released, 4);
+	assert_null(source->prev_async_frame);
+	assert_ptr_equal(source->cur_async_frame, frames[4]);
+	assert_int_equal(source->async_frames.num, 1);
+	assert_ptr_equal(source->async_frames.array[0], frames[5]);
+
+	remove_async_frame(source, source->cur_async_frame);
+	remove_async_frame(source, source->async_frames.array[0]);
+	assert_int_equal(frames_released, FRAME_COUNT);
+
+	da_free(source->async_frames);
+	bfree(source);
+	bfree(obs);
+	obs = NULL;
+}
+
+int main()
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(skip_frames_test),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,380 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include <graphics/effect-cache.h>
+#include <util/dstr.h>
+#include <util/platform.h>
+
+#define CACHE_DIR "effect_cache_test"
+#define BENCH_RUNS 20
+
+static const char *include_effect = "uniform texture2d image;\n"
+				    "\n"
+				    "sampler_state def_sampler {\n"
+				    "	Filter   = Linear;\n"
+				    "	AddressU = Clamp;\n"
+				    "	AddressV = Clamp;\n"
+				    "};\n"
+				    "\n"
+				    "float3 darken(float3 rgb, float amount)\n"
+				    "{\n"
+				    "	return rgb * (1.0 - amount);\n"
+				    "}\n";
+
+static const char *main_effect = "#include \"include.effect\"\n"
+				 "\n"
+				 "uniform float4x4 ViewProj;\n"
+				 "uniform float amount<string name = \"Amount\"; float minimum = 0.0;> = 0.25;\n"
+				 "\n"
+				 "struct VertInOut {\n"
+				 "	float4 pos : POSITION;\n"
+				 "	float2 uv  : TEXCOORD0;\n"
+				 "};\n"
+				 "\n"
+				 "VertInOut VSDefault(VertInOut vert_in)\n"
+				 "{\n"
+				 "	VertInOut vert_out;\n"
+				 "	vert_out.pos = mul(float4(vert_in.pos.xyz, 1.0), ViewProj);\n"
+				 "	vert_out.uv  = vert_in.uv;\n"
+				 "	return vert_out;\n"
+				 "}\n"
+				 "\n"
+				 "float4 PSDarken(VertInOut vert_in) : TARGET\n"
+				 "{\n"
+				 "	float4 rgba = image.Sample(def_sampler, vert_in.uv);\n"
+				 "	return float4(darken(rgba.rgb, amount), rgba.a);\n"
+				 "}\n"
+				 "\n"
+				 "technique Draw\n"
+				 "{\n"
+				 "	pass\n"
+				 "	{\n"
+				 "		vertex_shader = VSDefault(vert_in);\n"
+				 "		pixel_shader  = PSDarken(vert_in);\n"
+				 "	}\n"
+				 "}\n";
+
+static bool has_param(const struct gs_effect_ir_shader *shader, const char *name)
+{
+	for (size_t i = 0; i < shader->params.num; i++) {
+		if (strcmp(shader->params.array[i], name) == 0)
+			return true;
+	}
+
+	return false;
+}
+
+static void assert_ir_equal(const gs_effect_ir_t *a, const gs_effect_ir_t *b)
+{
+	assert_int_equal(a->hash, b->hash);
+	assert_int_equal(a->dependencies.num, b->dependencies.num);
+	assert_int_equal(a->params.num, b->params.num);
+	assert_int_equal(a->techniques.num, b->techniques.num);
+
+	for (size_t i = 0; i < a->params.num; i++) {
+		const struct gs_effect_ir_param *pa = a->params.array + i;
+		const struct gs_effect_ir_param *pb = b->params.array + i;
+
+		assert_string_equal(pa->name, pb->name);
+		assert_int_equal(pa->type, pb->type);
+		assert_int_equal(pa->default_val.num, pb->default_val.num);
+		if (pa->default_val.num)
+			assert_memory_equal(pa->default_val.array, pb->default_val.array, pa->default_val.num);
+		assert_int_equal(pa->annotations.num, pb->annotations.num);
+	}
+
+	for (size_t i = 0; i < a->techniques.num; i++) {
+		const struct gs_effect_ir_technique *ta = a->techniques.array + i;
+		const struct gs_effect_ir_technique *tb = b->techniques.array + i;
+
+		assert_string_equal(ta->name, tb->name);
+		assert_int_equal(ta->passes.num, tb->passes.num);
+
+		for (size_t j = 0; j < ta->passes.num; j++) {
+			assert_string_equal(ta->passes.array[j].vertex.text, tb->passes.array[j].vertex.text);
+			assert_string_equal(ta->passes.array[j].pixel.text, tb->passes.array[j].pixel.text);
+			assert_int_equal(ta->passes.array[j].pixel.params.num, tb->passes.array[j].pixel.params.num);
+		}
+	}
+}
+
+static int setup(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	os_mkdirs(CACHE_DIR "/effects");
+	os_quick_write_utf8_file(CACHE_DIR "/effects/include.effect", include_effect, strlen(include_effect), false);
+	gs_effect_cache_set_path(CACHE_DIR "/cache");
+	return 0;
+}
+
+static int teardown(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	gs_effect_cache_set_path(NULL);
+	return 0;
+}
+
+static void effect_parse_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	char *errors = NULL;
+	gs_effect_ir_t *ir = gs_effect_ir_parse(main_effect, CACHE_DIR "/effects/main.effect", &errors);
+
+	assert_null(errors);
+	assert_non_null(ir);
+
+	assert_int_equal(ir->dependencies.num, 1);
+	assert_int_equal(ir->params.num, 3);
+	assert_string_equal(ir->params.array[1].name, "ViewProj");
+	assert_int_equal(ir->params.array[1].type, GS_SHADER_PARAM_MATRIX4X4);
+	assert_int_equal(ir->params.array[2].annotations.num, 2);
+	assert_true(*(float *)ir->params.array[2].default_val.array == 0.25f);
+
+	assert_int_equal(ir->techniques.num, 1);
+	assert_int_equal(ir->techniques.array[0].passes.num, 1);
+
+	const struct gs_effect_ir_pass *pass = ir->techniques.array[0].passes.array;
+	assert_true(has_param(&pass->vertex, "ViewProj"));
+	assert_false(has_param(&pass->vertex, "image"));
+	assert_true(has_param(&pass->pixel, "image"));
+	assert_true(has_param(&pass->pixel, "amount"));
+	assert_non_null(strstr(pass->pixel.text, "darken"));
+
+	gs_effect_ir_destroy(ir);
+
+	ir = gs_effect_ir_parse("technique Draw { pass {", "broken.effect", &errors);
+	assert_null(ir);
+	assert_non_null(errors);
+	bfree(errors);
+}
+
+static void effect_cache_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	const char *file = CACHE_DIR "/effects/main.effect";
+	gs_effect_ir_t *parsed = gs_effect_ir_parse(main_effect, file, NULL);
+	gs_effect_ir_t *cached;
+
+	assert_non_null(parsed);
+	assert_true(gs_effect_cache_save(parsed));
+
+	cached = gs_effect_cache_load(file, main_effect);
+	assert_non_null(cached);
+	assert_ir_equal(parsed, cached);
+	gs_effect_ir_destroy(cached);
+
+	/* a changed effect is not loaded from the cache */
+	assert_null(gs_effect_cache_load(file, include_effect));
+
+	/* neither is an effect whose includes changed */
+	os_quick_write_utf8_file(CACHE_DIR "/effects/include.effect", "", 0, false);
+	assert_null(gs_effect_cache_load(file, main_effect));
+	os_quick_write_utf8_file(CACHE_DIR "/effects/include.effect", include_effect, strlen(include_effect), false);
+	cached = gs_effect_cache_load(file, main_effect);
+	assert_non_null(cached);
+	gs_effect_ir_destroy(cached);
+
+	/* and without a cache nothing is loaded or saved */
+	gs_effect_cache_set_path(NULL);
+	assert_null(gs_effect_cache_load(file, main_effect));
+	assert_false(gs_effect_cache_save(parsed));
+	gs_effect_cache_set_path(CACHE_DIR "/cache");
+
+	gs_effect_ir_destroy(parsed);
+}
+
+static void effect_cache_corrupt_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	const char *file = CACHE_DIR "/effects/main.effect";
+	gs_effect_ir_t *parsed = gs_effect_ir_parse(main_effect, file, NULL);
+	struct dstr cache_file = {0};
+	os_dir_t *dir;
+	struct os_dirent *ent;
+
+	assert_true(gs_effect_cache_save(parsed));
+	gs_effect_ir_destroy(parsed);
+
+	dir = os_opendir(CACHE_DIR "/cache");
+	assert_non_null(dir);
+	while ((ent = os_readdir(dir)) != NULL) {
+		if (!ent->directory)
+			dstr_printf(&cache_file, "%s/%s", CACHE_DIR "/cache", ent->d_name);
+	}
+	os_closedir(dir);
+	assert_non_null(cache_file.array);
+
+	/* every truncated version of the file must be rejected */
+	char *data = NULL;
+	size_t size = 0;
+	FILE *f = os_fopen(cache_file.array, "rb");
+	assert_non_null(f);
+	size = (size_t)os_fgetsize(f);
+	data = bmalloc(size);
+	assert_int_equal(fread(data, 1, size, f), size);
+	fclose(f);
+
+	for (size_t len = 0; len < size; len += 7) {
+		os_quick_write_utf8_file(cache_file.array, data, len, false);
+		assert_null(gs_effect_cache_load(file, main_effect));
+	}
+
+	bfree(data);
+	dstr_free(&cache_file);
+}
+
+static void effect_cache_benchmark_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	const char *file = CACHE_DIR "/effects/main.effect";
+	uint64_t start;
+
+	start = os_gettime_ns();
+	for (int i = 0; i < BENCH_RUNS; i++) {
+		gs_effect_ir_t *ir = gs_effect_ir_parse(main_effect, file, NULL);
+		gs_effect_cache_save(ir);
+		gs_effect_ir_destroy(ir);
+	}
+	double cold = (double)(os_gettime_ns() - start) / BENCH_RUNS / 1000.0;
+
+	start = os_gettime_ns();
+	for (int i = 0; i < BENCH_RUNS; i++) {
+		gs_effect_ir_t *ir = gs_effect_cache_load(file, main_effect);
+		assert_non_null(ir);
+		gs_effect_ir_destroy(ir);
+	}
+	double warm = (double)(os_gettime_ns() - start) / BENCH_RUNS / 1000.0;
+
+	print_message("effect load cold (parse and save) %.1f us, warm (cache) %.1f us\n", cold, warm);
+}
+
+#ifdef GRAPHICS_MODULE
+#define GRAPHICS_RUNS 5
+
+static void clear_bench_cache(void)
+{
+	struct dstr path = {0};
+	os_dir_t *dir = os_opendir(CACHE_DIR "/bench");
+	struct os_dirent *ent;
+
+	while (dir && (ent = os_readdir(dir)) != NULL) {
+		if (ent->directory)
+			continue;
+
+		dstr_printf(&path, "%s/%s", CACHE_DIR "/bench", ent->d_name);
+		os_unlink(path.array);
+	}
+
+	if (dir)
+		os_closedir(dir);
+	dstr_free(&path);
+}
+
+/* creates every effect libobs ships on a new graphics device and draws the
+ * ones that have a Draw technique, which links their programs.  returns the
+ * time it took in milliseconds, or a negative value without a device */
+static double create_effects(void)
+{
+	graphics_t *graphics = NULL;
+	gs_texrender_t *texrender;
+	struct dstr path = {0};
+	os_dir_t *dir;
+	struct os_dirent *ent;
+	uint64_t start;
+	double time;
+
+	if (gs_create(&graphics, GRAPHICS_MODULE, 0) != GS_SUCCESS)
+		return -1.0;
+
+	gs_enter_context(graphics);
+	texrender = gs_texrender_create(GS_RGBA, GS_ZS_NONE);
+
+	start = os_gettime_ns();
+	dir = os_opendir(EFFECT_DIR);
+	assert_non_null(dir);
+
+	while ((ent = os_readdir(dir)) != NULL) {
+		const char *ext = os_get_path_extension(ent->d_name);
+		gs_effect_t *effect;
+
+		if (ent->directory || !ext || strcmp(ext, ".effect") != 0)
+			continue;
+
+		dstr_printf(&path, "%s/%s", EFFECT_DIR, ent->d_name);
+		effect = gs_effect_create_from_file(path.array, NULL);
+		assert_non_null(effect);
+
+		gs_texrender_reset(texrender);
+		if (gs_effect_get_technique(effect, "Draw") && gs_texrender_begin(texrender, 16, 16)) {
+			while (gs_effect_loop(effect, "Draw"))
+				gs_draw_sprite(NULL, 0, 16, 16);
+			gs_texrender_end(texrender);
+		}
+	}
+
+	os_closedir(dir);
+	time = (double)(os_gettime_ns() - start) / 1000000.0;
+
+	dstr_free(&path);
+	gs_texrender_destroy(texrender);
+	gs_leave_context();
+	gs_destroy(graphics);
+	return time;
+}
+
+static void effect_create_benchmark_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	double cold = 0.0;
+	double warm = 0.0;
+
+	gs_effect_cache_set_path(CACHE_DIR "/bench");
+
+	/* cold starts parse, translate and link everything and fill the cache,
+	 * warm starts create the same effects from it */
+	for (int i = 0; i < GRAPHICS_RUNS; i++) {
+		double time;
+
+		clear_bench_cache();
+		time = create_effects();
+		if (time < 0.0) {
+			gs_effect_cache_set_path(CACHE_DIR "/cache");
+			skip();
+		}
+
+		cold += time;
+	}
+
+	for (int i = 0; i < GRAPHICS_RUNS; i++)
+		warm += create_effects();
+
+	print_message("effect creation cold %.1f ms, warm %.1f ms\n", cold / GRAPHICS_RUNS, warm / GRAPHICS_RUNS);
+
+	clear_bench_cache();
+	gs_effect_cache_set_path(CACHE_DIR "/cache");
+}
+#endif
+
+int main()
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(effect_parse_test),
+		cmocka_unit_test(effect_cache_test),
+		cmocka_unit_test(effect_cache_corrupt_test),
+		cmocka_unit_test(effect_cache_benchmark_test),
+#ifdef GRAPHICS_MODULE
+		cmocka_unit_test(effect_create_benchmark_test),
+#endif
+	};
+
+	return cmocka_run_group_tests(tests, setup, teardown);
+}
@@ -0,0 +1,209 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include <util/bmem.h>
+#include <util/platform.h>
+#include <media-io/format-conversion.h>
+
+/* width is deliberately not a multiple of eight, so that the AVX2 paths also
+ * run their four pixel tail */
+#define TEST_WIDTH 36
+#define TEST_HEIGHT 6
+#define BENCH_WIDTH 1920
+#define BENCH_HEIGHT 1080
+#define BENCH_ITERATIONS 50
+
+static uint8_t *create_pattern(size_t size)
+{
+	uint8_t *data = bmalloc(size);
+	uint32_t seed = 0x12345678;
+
+	for (size_t i = 0; i < size; i++) {
+		seed = seed * 1103515245 + 12345;
+		data[i] = (uint8_t)(seed >> 16);
+	}
+
+	return data;
+}
+
+static uint32_t chroma_sum(const uint8_t *uyvx, uint32_t linesize, uint32_t x, uint32_t y, uint32_t byte)
+{
+	const uint8_t *line0 = uyvx + y * linesize + x * 4;
+	const uint8_t *line1 = line0 + linesize;
+
+	return line0[byte] + line0[byte + 4] + line1[byte] + line1[byte + 4];
+}
+
+static void uyvx_to_420_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	const uint32_t in_linesize = TEST_WIDTH * 4;
+	uint8_t *uyvx = create_pattern(in_linesize * TEST_HEIGHT);
+
+	uint8_t *i420[3] = {bzalloc(TEST_WIDTH * TEST_HEIGHT), bzalloc(TEST_WIDTH * TEST_HEIGHT / 4),
+			    bzalloc(TEST_WIDTH * TEST_HEIGHT / 4)};
+	const uint32_t i420_linesize[3] = {TEST_WIDTH, TEST_WIDTH / 2, TEST_WIDTH / 2};
+	uint8_t *nv12[2] = {bzalloc(TEST_WIDTH * TEST_HEIGHT), bzalloc(TEST_WIDTH * TEST_HEIGHT / 2)};
+	const uint32_t nv12_linesize[2] = {TEST_WIDTH, TEST_WIDTH};
+
+	compress_uyvx_to_i420(uyvx, in_linesize, 0, TEST_HEIGHT, i420, i420_linesize);
+	compress_uyvx_to_nv12(uyvx, in_linesize, 0, TEST_HEIGHT, nv12, nv12_linesize);
+
+	for (uint32_t y = 0; y < TEST_HEIGHT; y++) {
+		for (uint32_t x = 0; x < TEST_WIDTH; x++) {
+			uint8_t lum = uyvx[y * in_linesize + x * 4 + 1];
+			assert_int_equal(i420[0][y * TEST_WIDTH + x], lum);
+			assert_int_equal(nv12[0][y * TEST_WIDTH + x], lum);
+		}
+	}
+
+	for (uint32_t y = 0; y < TEST_HEIGHT; y += 2) {
+		for (uint32_t x = 0; x < TEST_WIDTH; x += 2) {
+			uint8_t u = (uint8_t)(chroma_sum(uyvx, in_linesize, x, y, 0) >> 2);
+			uint8_t v = (uint8_t)(chroma_sum(uyvx, in_linesize, x, y, 2) >> 2);
+
+			assert_int_equal(i420[1][y / 2 * i420_linesize[1] + x / 2], u);
+			assert_int_equal(i420[2][y / 2 * i420_linesize[2] + x / 2], v);
+			assert_int_equal(nv12[1][y / 2 * nv12_linesize[1] + x], u);
+			assert_int_equal(nv12[1][y / 2 * nv12_linesize[1] + x + 1], v);
+		}
+	}
+
+	for (size_t i = 0; i < 3; i++)
+		bfree(i420[i]);
+	for (size_t i = 0; i < 2; i++)
+		bfree(nv12[i]);
+	bfree(uyvx);
+}
+
+static void nv12_to_i444_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	const uint8_t *nv12[2] = {create_pattern(TEST_WIDTH * TEST_HEIGHT),
+				  create_pattern(TEST_WIDTH * TEST_HEIGHT / 2)};
+	const uint32_t nv12_linesize[2] = {TEST_WIDTH, TEST_WIDTH};
+	uint8_t *i444[3] = {bzalloc(TEST_WIDTH * TEST_HEIGHT), bzalloc(TEST_WIDTH * TEST_HEIGHT),
+			    bzalloc(TEST_WIDTH * TEST_HEIGHT)};
+	const uint32_t i444_linesize[3] = {TEST_WIDTH, TEST_WIDTH, TEST_WIDTH};
+
+	convert_nv12_to_i444(nv12, nv12_linesize, 0, TEST_HEIGHT, i444, i444_linesize);
+
+	assert_memory_equal(i444[0], nv12[0], TEST_WIDTH * TEST_HEIGHT);
+
+	for (uint32_t y = 0; y < TEST_HEIGHT; y++) {
+		for (uint32_t x = 0; x < TEST_WIDTH; x++) {
+			const uint8_t *uv = nv12[1] + y / 2 * nv12_linesize[1] + (x & ~1);
+			assert_int_equal(i444[1][y * TEST_WIDTH + x], uv[0]);
+			assert_int_equal(i444[2][y * TEST_WIDTH + x], uv[1]);
+		}
+	}
+
+	for (size_t i = 0; i < 3; i++)
+		bfree(i444[i]);
+	bfree((void *)nv12[0]);
+	bfree((void *)nv12[1]);
+}
+
+static uint8_t clamp_ref(int32_t val)
+{
+	return (uint8_t)(val < 0 ? 0 : (val > 255 ? 255 : val));
+}
+
+static void rgba_to_nv12_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	/* BT.709 partial range */
+	const int32_t cy[3] = {47, 157, 16};
+	const int32_t cu[3] = {-26, -86, 112};
+	const int32_t cv[3] = {112, -102, -10};
+
+	const uint32_t in_linesize = TEST_WIDTH * 4;
+	uint8_t *rgba = create_pattern(in_linesize * TEST_HEIGHT);
+	uint8_t *nv12[2] = {bzalloc(TEST_WIDTH * TEST_HEIGHT), bzalloc(TEST_WIDTH * TEST_HEIGHT / 2)};
+	const uint32_t nv12_linesize[2] = {TEST_WIDTH, TEST_WIDTH};
+
+	convert_rgba_to_nv12(rgba, in_linesize, 0, TEST_HEIGHT, nv12, nv12_linesize, VIDEO_CS_709,
+			     VIDEO_RANGE_PARTIAL);
+
+	for (uint32_t y = 0; y < TEST_HEIGHT; y++) {
+		for (uint32_t x = 0; x < TEST_WIDTH; x++) {
+			const uint8_t *p = rgba + y * in_linesize + x * 4;
+			int32_t lum = ((cy[0] * p[0] + cy[1] * p[1] + cy[2] * p[2] + 128) >> 8) + 16;
+			assert_int_equal(nv12[0][y * TEST_WIDTH + x], clamp_ref(lum));
+		}
+	}
+
+	for (uint32_t y = 0; y < TEST_HEIGHT; y += 2) {
+		for (uint32_t x = 0; x < TEST_WIDTH; x += 2) {
+			int32_t avg[3];
+
+			for (uint32_t c = 0; c < 3; c++)
+				avg[c] = (chroma_sum(rgba, in_linesize, x, y, c) + 2) >> 2;
+
+			int32_t u = ((cu[0] * avg[0] + cu[1] * avg[1] + cu[2] * avg[2] + 128) >> 8) + 128;
+			int32_t v = ((cv[0] * avg[0] + cv[1] * avg[1] + cv[2] * avg[2] + 128) >> 8) + 128;
+
+			assert_int_equal(nv12[1][y / 2 * TEST_WIDTH + x], clamp_ref(u));
+			assert_int_equal(nv12[1][y / 2 * TEST_WIDTH + x + 1], clamp_ref(v));
+		}
+	}
+
+	bfree(nv12[0]);
+	bfree(nv12[1]);
+	bfree(rgba);
+}
+
+/* not a correctness check, prints throughput of the dispatched kernels */
+static void benchmark_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	const uint32_t in_linesize = BENCH_WIDTH * 4;
+	uint8_t *input = create_pattern(in_linesize * BENCH_HEIGHT);
+	uint8_t *planes[3] = {bmalloc(BENCH_WIDTH * BENCH_HEIGHT * 2), bmalloc(BENCH_WIDTH * BENCH_HEIGHT),
+			      bmalloc(BENCH_WIDTH * BENCH_HEIGHT)};
+	const uint32_t linesize_8bit[3] = {BENCH_WIDTH, BENCH_WIDTH, BENCH_WIDTH};
+	const uint8_t *nv12[2] = {input, input + BENCH_WIDTH * BENCH_HEIGHT};
+	uint64_t start;
+
+#define BENCH(name, call)                                                                                 \
+	do {                                                                                              \
+		start = os_gettime_ns();                                                                  \
+		for (int i = 0; i < BENCH_ITERATIONS; i++)                                                \
+			call;                                                                             \
+		print_message("%-24s %8.3f ms/frame\n", name,                                             \
+			      (double)(os_gettime_ns() - start) / 1000000.0 / (double)BENCH_ITERATIONS); \
+	} while (false)
+
+	BENCH("compress_uyvx_to_i420",
+	      compress_uyvx_to_i420(input, in_linesize, 0, BENCH_HEIGHT, planes, linesize_8bit));
+	BENCH("compress_uyvx_to_nv12",
+	      compress_uyvx_to_nv12(input, in_linesize, 0, BENCH_HEIGHT, planes, linesize_8bit));
+	BENCH("convert_nv12_to_i444",
+	      convert_nv12_to_i444(nv12, linesize_8bit, 0, BENCH_HEIGHT, planes, linesize_8bit));
+	BENCH("convert_rgba_to_nv12", convert_rgba_to_nv12(input, in_linesize, 0, BENCH_HEIGHT, planes,
+							   linesize_8bit, VIDEO_CS_709, VIDEO_RANGE_PARTIAL));
+
+#undef BENCH
+
+	for (size_t i = 0; i < 3; i++)
+		bfree(planes[i]);
+	bfree(input);
+}
+
+int main()
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(uyvx_to_420_test),
+		cmocka_unit_test(nv12_to_i444_test),
+		cmocka_unit_test(rgba_to_nv12_test),
+		cmocka_unit_test(benchmark_test),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
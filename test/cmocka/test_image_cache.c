@@ -0,0 +1,532 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include <graphics/image-file.h>
+#include <util/dstr.h>
+#include <util/platform.h>
+#include <util/thread-pool.h>
+
+#define IMAGE_DIR "image_cache_test"
+
+#define GIF_SIZE 16
+#define GIF_FRAMES 8
+#define GIF_FRAME_BYTES (GIF_SIZE * GIF_SIZE * 4)
+#define GIF_DELAY_NS 100000000ULL
+#define GIF_DEFAULT_STREAM_LIMIT (64ULL * 1024ULL * 1024ULL)
+
+static void write_u16(uint8_t *p, uint16_t val)
+{
+	p[0] = (uint8_t)val;
+	p[1] = (uint8_t)(val >> 8);
+}
+
+static void write_u32(uint8_t *p, uint32_t val)
+{
+	write_u16(p, (uint16_t)val);
+	write_u16(p + 2, (uint16_t)(val >> 16));
+}
+
+/* writes an uncompressed 24-bit bmp */
+static void write_bmp(const char *path, uint32_t cx, uint32_t cy)
+{
+	const uint32_t pitch = (cx * 3 + 3) & ~3U;
+	const uint32_t size = 54 + pitch * cy;
+	uint8_t *data = bzalloc(size);
+
+	data[0] = 'B';
+	data[1] = 'M';
+	write_u32(data + 2, size);
+	write_u32(data + 10, 54);
+	write_u32(data + 14, 40);
+	write_u32(data + 18, cx);
+	write_u32(data + 22, cy);
+	write_u16(data + 26, 1);
+	write_u16(data + 28, 24);
+	write_u32(data + 34, pitch * cy);
+
+	for (uint32_t y = 0; y < cy; y++) {
+		for (uint32_t x = 0; x < cx * 3; x++)
+			data[54 + y * pitch + x] = (uint8_t)(x * 40 + y * 20);
+	}
+
+	os_quick_write_utf8_file(path, (const char *)data, size, false);
+	bfree(data);
+}
+
+struct gif_writer {
+	uint8_t *data;
+	size_t size;
+	uint32_t bits;
+	int num_bits;
+};
+
+static void gif_put(struct gif_writer *gif, const void *data, size_t size)
+{
+	memcpy(gif->data + gif->size, data, size);
+	gif->size += size;
+}
+
+static void gif_put_u8(struct gif_writer *gif, uint8_t val)
+{
+	gif_put(gif, &val, 1);
+}
+
+static void gif_put_u16(struct gif_writer *gif, uint16_t val)
+{
+	gif_put_u8(gif, (uint8_t)val);
+	gif_put_u8(gif, (uint8_t)(val >> 8));
+}
+
+static void gif_put_code(struct gif_writer *gif, uint8_t *block, size_t *block_size, uint32_t code)
+{
+	gif->bits |= code << gif->num_bits;
+	gif->num_bits += 9;
+
+	while (gif->num_bits >= 8) {
+		block[(*block_size)++] = (uint8_t)gif->bits;
+		gif->bits >>= 8;
+		gif->num_bits -= 8;
+	}
+}
+
+/* writes an animated gif where frame n is filled with palette color n + 1.
+ * the pixels are stored as 9-bit literal codes with a clear code before the
+ * code size would grow, so no actual compression is needed */
+static void write_gif(const char *path, int frames)
+{
+	const size_t pixels = GIF_SIZE * GIF_SIZE;
+	const size_t codes = pixels + pixels / 250 + 2;
+	struct gif_writer gif = {0};
+	uint8_t *block = bmalloc(codes * 2);
+
+	gif.data = bmalloc(1024 + frames * (codes * 2 + 64));
+
+	gif_put(&gif, "GIF89a", 6);
+	gif_put_u16(&gif, GIF_SIZE);
+	gif_put_u16(&gif, GIF_SIZE);
+	gif_put_u8(&gif, 0xF7);
+	gif_put_u16(&gif, 0);
+
+	for (int i = 0; i < 256; i++) {
+		gif_put_u8(&gif, (uint8_t)i);
+		gif_put_u8(&gif, (uint8_t)(i * 3));
+		gif_put_u8(&gif, (uint8_t)(i * 7));
+	}
+
+	gif_put(&gif, "\x21\xFF\x0BNETSCAPE2.0\x03\x01\x00\x00\x00", 19);
+
+	for (int f = 0; f < frames; f++) {
+		size_t block_size = 0;
+
+		gif_put(&gif, "\x21\xF9\x04\x00", 4);
+		gif_put_u16(&gif, (uint16_t)(GIF_DELAY_NS / 10000000ULL));
+		gif_put_u16(&gif, 0);
+
+		gif_put_u8(&gif, 0x2C);
+		gif_put_u16(&gif, 0);
+		gif_put_u16(&gif, 0);
+		gif_put_u16(&gif, GIF_SIZE);
+		gif_put_u16(&gif, GIF_SIZE);
+		gif_put_u8(&gif, 0);
+		gif_put_u8(&gif, 8);
+
+		gif.bits = 0;
+		gif.num_bits = 0;
+		gif_put_code(&gif, block, &block_size, 256);
+		for (size_t i = 0; i < pixels; i++) {
+			if (i && i % 250 == 0)
+				gif_put_code(&gif, block, &block_size, 256);
+			gif_put_code(&gif, block, &block_size, (uint32_t)f + 1);
+		}
+		gif_put_code(&gif, block, &block_size, 257);
+		if (gif.num_bits)
+			block[block_size++] = (uint8_t)gif.bits;
+
+		for (size_t i = 0; i < block_size; i += 255) {
+			size_t size = block_size - i < 255 ? block_size - i : 255;
+			gif_put_u8(&gif, (uint8_t)size);
+			gif_put(&gif, block + i, size);
+		}
+		gif_put_u8(&gif, 0);
+	}
+
+	gif_put_u8(&gif, 0x3B);
+
+	os_quick_write_utf8_file(path, (const char *)gif.data, gif.size, false);
+	bfree(block);
+	bfree(gif.data);
+}
+
+/* every file the tests write, removed again in teardown */
+static const char *image_files[] = {
+	IMAGE_DIR "/a.bmp", IMAGE_DIR "/b.bmp", IMAGE_DIR "/changed.bmp", IMAGE_DIR "/anim.gif", IMAGE_DIR "/short.gif",
+};
+
+static int setup(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	os_mkdirs(IMAGE_DIR);
+	write_bmp(IMAGE_DIR "/a.bmp", 2, 2);
+	write_bmp(IMAGE_DIR "/b.bmp", 2, 2);
+	write_gif(IMAGE_DIR "/anim.gif", GIF_FRAMES);
+	write_gif(IMAGE_DIR "/short.gif", 2);
+	return 0;
+}
+
+static int teardown(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	gs_image_file_set_decode_pool(NULL);
+	gs_image_file_set_gif_stream_limit(GIF_DEFAULT_STREAM_LIMIT);
+	gs_image_cache_clear();
+
+	for (size_t i = 0; i < sizeof(image_files) / sizeof(image_files[0]); i++)
+		os_unlink(image_files[i]);
+	os_rmdir(IMAGE_DIR);
+	return 0;
+}
+
+static void image_cache_share_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	struct gs_image_cache_stats before, after;
+	gs_image_file5_t first, second, other_alpha;
+
+	gs_image_cache_clear();
+	gs_image_cache_get_stats(&before);
+
+	gs_image_file5_init(&first, IMAGE_DIR "/a.bmp", GS_IMAGE_ALPHA_PREMULTIPLY);
+	gs_image_file5_init(&second, IMAGE_DIR "/a.bmp", GS_IMAGE_ALPHA_PREMULTIPLY);
+	gs_image_file5_init(&other_alpha, IMAGE_DIR "/a.bmp", GS_IMAGE_ALPHA_STRAIGHT);
+
+	assert_true(first.image4.image3.image2.image.loaded);
+	assert_true(second.image4.image3.image2.image.loaded);
+	assert_int_equal(first.image4.image3.image2.image.cx, 2);
+	assert_int_equal(second.image4.image3.image2.image.cy, 2);
+
+	/* the same file with the same alpha mode is decoded once */
+	assert_non_null(first.cache_entry);
+	assert_ptr_equal(first.cache_entry, second.cache_entry);
+	assert_ptr_not_equal(first.cache_entry, other_alpha.cache_entry);
+
+	/* only the image file that decoded it reports the shared image */
+	assert_true(first.image4.image3.image2.mem_usage > 0);
+	assert_int_equal(second.image4.image3.image2.mem_usage, 0);
+
+	gs_image_cache_get_stats(&after);
+	assert_int_equal(after.misses - before.misses, 2);
+	assert_int_equal(after.hits - before.hits, 1);
+	assert_int_equal(after.images, 2);
+	assert_int_equal(after.bytes,
+			 first.image4.image3.image2.mem_usage + other_alpha.image4.image3.image2.mem_usage);
+	assert_int_equal(after.unused_bytes, 0);
+
+	/* released images stay cached until they are evicted */
+	uint64_t first_size = first.image4.image3.image2.mem_usage;
+	gs_image_file5_free(&first);
+	gs_image_file5_free(&second);
+	gs_image_file5_free(&other_alpha);
+	assert_null(first.cache_entry);
+
+	gs_image_cache_get_stats(&after);
+	assert_int_equal(after.images, 2);
+	assert_int_equal(after.unused_bytes, after.bytes);
+
+	gs_image_file5_init(&first, IMAGE_DIR "/a.bmp", GS_IMAGE_ALPHA_PREMULTIPLY);
+	gs_image_cache_get_stats(&after);
+	assert_int_equal(after.hits - before.hits, 2);
+	assert_int_equal(after.unused_bytes, after.bytes - first_size);
+	assert_int_equal(first.image4.image3.image2.mem_usage, 0);
+	gs_image_file5_free(&first);
+
+	gs_image_cache_clear();
+	gs_image_cache_get_stats(&after);
+	assert_int_equal(after.images, 0);
+	assert_int_equal(after.bytes, 0);
+}
+
+static void image_cache_budget_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	struct gs_image_cache_stats before, after;
+	gs_image_file5_t a, b;
+
+	gs_image_cache_clear();
+	gs_image_cache_get_stats(&before);
+
+	gs_image_file5_init(&a, IMAGE_DIR "/a.bmp", GS_IMAGE_ALPHA_PREMULTIPLY);
+	gs_image_file5_init(&b, IMAGE_DIR "/b.bmp", GS_IMAGE_ALPHA_PREMULTIPLY);
+
+	/* images in use are never evicted, even over budget */
+	gs_image_cache_set_budget(a.image4.image3.image2.mem_usage);
+	gs_image_cache_get_stats(&after);
+	assert_int_equal(after.images, 2);
+	assert_int_equal(after.evictions, before.evictions);
+
+	/* the least recently released image goes first */
+	gs_image_file5_free(&a);
+	gs_image_file5_free(&b);
+	gs_image_cache_get_stats(&after);
+	assert_int_equal(after.images, 1);
+	assert_int_equal(after.evictions - before.evictions, 1);
+
+	gs_image_file5_init(&b, IMAGE_DIR "/b.bmp", GS_IMAGE_ALPHA_PREMULTIPLY);
+	gs_image_file5_init(&a, IMAGE_DIR "/a.bmp", GS_IMAGE_ALPHA_PREMULTIPLY);
+	gs_image_cache_get_stats(&after);
+	assert_int_equal(after.hits - before.hits, 1);
+	assert_int_equal(after.misses - before.misses, 3);
+	gs_image_file5_free(&a);
+	gs_image_file5_free(&b);
+
+	gs_image_cache_set_budget(0);
+	gs_image_cache_get_stats(&after);
+	assert_int_equal(after.images, 0);
+	assert_int_equal(after.budget, 0);
+
+	gs_image_cache_set_budget(before.budget);
+}
+
+static void image_cache_invalidate_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	gs_image_file5_t old_image, new_image, missing;
+
+	gs_image_cache_clear();
+
+	write_bmp(IMAGE_DIR "/changed.bmp", 2, 2);
+	gs_image_file5_init(&old_image, IMAGE_DIR "/changed.bmp", GS_IMAGE_ALPHA_PREMULTIPLY);
+
+	/* a changed file is decoded again, users of the old one keep it */
+	write_bmp(IMAGE_DIR "/changed.bmp", 4, 4);
+	gs_image_file5_init(&new_image, IMAGE_DIR "/changed.bmp", GS_IMAGE_ALPHA_PREMULTIPLY);
+	assert_ptr_not_equal(old_image.cache_entry, new_image.cache_entry);
+	assert_int_equal(old_image.image4.image3.image2.image.cx, 2);
+	assert_int_equal(new_image.image4.image3.image2.image.cx, 4);
+
+	/* images that fail to load are not cached */
+	gs_image_file5_init(&missing, IMAGE_DIR "/missing.bmp", GS_IMAGE_ALPHA_PREMULTIPLY);
+	assert_false(missing.image4.image3.image2.image.loaded);
+	assert_null(missing.cache_entry);
+
+	gs_image_file5_free(&old_image);
+	gs_image_file5_free(&new_image);
+	gs_image_file5_free(&missing);
+}
+
+static int stream_frame(gs_image_file5_t *if5)
+{
+	struct gs_image_gif_stream_stats stats;
+
+	assert_true(gs_image_file5_get_stream_stats(if5, &stats));
+	assert_in_range(stats.decoded, 1, stats.window);
+	return stats.frame;
+}
+
+/* updates the image until the decode pool has caught up with 'frame'.  until
+ * then the previous frame has to stay up */
+static void wait_for_frame(gs_image_file5_t *if5, int frame, int prev_frame)
+{
+	uint64_t timeout = os_gettime_ns() + 5000000000ULL;
+
+	for (;;) {
+		gs_image_file5_update_texture(if5);
+
+		int cur = stream_frame(if5);
+		if (cur == frame)
+			return;
+
+		assert_int_equal(cur, prev_frame);
+		assert_true(os_gettime_ns() < timeout);
+		os_sleep_ms(1);
+	}
+}
+
+/* plays 'count' frames starting after 'frame' and checks that each of them is
+ * displayed in order, wrapping around at the end of the animation */
+static int play_frames(gs_image_file5_t *if5, int frame, int count, bool pool)
+{
+	for (int i = 0; i < count; i++) {
+		int next = (frame + 1) % GIF_FRAMES;
+
+		gs_image_file5_tick(if5, GIF_DELAY_NS + 1);
+		assert_int_equal(if5->image4.image3.image2.image.cur_frame, next);
+
+		if (pool) {
+			wait_for_frame(if5, next, frame);
+		} else {
+			gs_image_file5_update_texture(if5);
+			assert_int_equal(stream_frame(if5), next);
+		}
+
+		frame = next;
+	}
+
+	return frame;
+}
+
+static void gif_stream_window_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	struct gs_image_gif_stream_stats stats;
+	gs_image_file5_t full, streamed, tiny;
+
+	gs_image_file_set_decode_pool(NULL);
+	gs_image_file_set_gif_stream_limit(GIF_FRAME_BYTES * 3);
+
+	/* gifs within the limit are decoded up front */
+	gs_image_file5_init(&full, IMAGE_DIR "/short.gif", GS_IMAGE_ALPHA_PREMULTIPLY);
+	assert_true(full.image4.image3.image2.image.loaded);
+	assert_null(full.stream);
+	assert_false(gs_image_file5_get_stream_stats(&full, &stats));
+
+	/* larger ones only keep as many frames as fit in the limit */
+	gs_image_file5_init(&streamed, IMAGE_DIR "/anim.gif", GS_IMAGE_ALPHA_PREMULTIPLY);
+	assert_true(streamed.image4.image3.image2.image.loaded);
+	assert_non_null(streamed.stream);
+	assert_null(streamed.cache_entry);
+	assert_true(gs_image_file5_get_stream_stats(&streamed, &stats));
+	assert_int_equal(stats.window, 3);
+	assert_int_equal(stats.frame, 0);
+	assert_true(streamed.image4.image3.image2.mem_usage < GIF_FRAME_BYTES * GIF_FRAMES);
+
+	/* but never less than two */
+	gs_image_file_set_gif_stream_limit(1);
+	gs_image_file5_init(&tiny, IMAGE_DIR "/anim.gif", GS_IMAGE_ALPHA_PREMULTIPLY);
+	assert_true(gs_image_file5_get_stream_stats(&tiny, &stats));
+	assert_int_equal(stats.window, 2);
+
+	gs_image_file5_free(&full);
+	gs_image_file5_free(&streamed);
+	gs_image_file5_free(&tiny);
+	assert_null(streamed.stream);
+}
+
+static void gif_stream_inline_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	struct gs_image_gif_stream_stats stats;
+	gs_image_file5_t image;
+
+	gs_image_file_set_decode_pool(NULL);
+	gs_image_file_set_gif_stream_limit(GIF_FRAME_BYTES * 3);
+
+	gs_image_file5_init(&image, IMAGE_DIR "/anim.gif", GS_IMAGE_ALPHA_PREMULTIPLY);
+	assert_non_null(image.stream);
+
+	/* without a pool, each frame is decoded when it is needed */
+	play_frames(&image, 0, GIF_FRAMES * 2 + 1, false);
+
+	assert_true(gs_image_file5_get_stream_stats(&image, &stats));
+	assert_false(stats.decoding);
+
+	gs_image_file5_free(&image);
+}
+
+static void gif_stream_pool_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	os_thread_pool_t *pool = os_thread_pool_create("gif stream test", 1);
+	gs_image_file5_t image;
+
+	gs_image_file_set_decode_pool(pool);
+	gs_image_file_set_gif_stream_limit(GIF_FRAME_BYTES * 3);
+
+	gs_image_file5_init(&image, IMAGE_DIR "/anim.gif", GS_IMAGE_ALPHA_PREMULTIPLY);
+	assert_non_null(image.stream);
+
+	play_frames(&image, 0, GIF_FRAMES * 2 + 1, true);
+
+	gs_image_file5_free(&image);
+	gs_image_file_set_decode_pool(NULL);
+	os_thread_pool_destroy(pool);
+}
+
+static void gif_stream_restart_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	os_thread_pool_t *pool = os_thread_pool_create("gif stream test", 1);
+	gs_image_file_t *gif;
+	gs_image_file5_t image;
+	int frame;
+
+	gs_image_file_set_decode_pool(pool);
+	gs_image_file_set_gif_stream_limit(GIF_FRAME_BYTES * 3);
+
+	gs_image_file5_init(&image, IMAGE_DIR "/anim.gif", GS_IMAGE_ALPHA_PREMULTIPLY);
+	gif = &image.image4.image3.image2.image;
+
+	for (int i = 0; i < 4; i++) {
+		frame = play_frames(&image, 0, GIF_FRAMES / 2, true);
+
+		/* the update that showed the last frame queued more frames to
+		 * be decoded, restart right away while the decoder is likely
+		 * still busy.  frame 0 is not in the window anymore, so the
+		 * decoder has to start over and drop what it decoded ahead */
+		gif->cur_frame = 0;
+		gif->cur_time = 0;
+		gif->cur_loop = 0;
+		wait_for_frame(&image, 0, frame);
+
+		/* and playback carries on in order from there */
+		play_frames(&image, 0, GIF_FRAMES, true);
+	}
+
+	gs_image_file5_free(&image);
+	gs_image_file_set_decode_pool(NULL);
+	os_thread_pool_destroy(pool);
+}
+
+static void gif_stream_destroy_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	os_thread_pool_t *pool = os_thread_pool_create("gif stream test", 1);
+	gs_image_file5_t image;
+
+	gs_image_file_set_decode_pool(pool);
+	gs_image_file_set_gif_stream_limit(GIF_FRAME_BYTES * 3);
+
+	/* loading starts decoding right away, freeing the image has to wait
+	 * for or cancel the decode that is in progress */
+	for (int i = 0; i < 50; i++) {
+		gs_image_file5_init(&image, IMAGE_DIR "/anim.gif", GS_IMAGE_ALPHA_PREMULTIPLY);
+		assert_non_null(image.stream);
+
+		if (i % 2) {
+			gs_image_file5_tick(&image, GIF_DELAY_NS + 1);
+			gs_image_file5_update_texture(&image);
+		}
+
+		gs_image_file5_free(&image);
+	}
+
+	gs_image_file_set_decode_pool(NULL);
+	os_thread_pool_destroy(pool);
+}
+
+int main()
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(image_cache_share_test),
+		cmocka_unit_test(image_cache_budget_test),
+		cmocka_unit_test(image_cache_invalidate_test),
+		cmocka_unit_test(gif_stream_window_test),
+		cmocka_unit_test(gif_stream_inline_test),
+		cmocka_unit_test(gif_stream_pool_test),
+		cmocka_unit_test(gif_stream_restart_test),
+		cmocka_unit_test(gif_stream_destroy_test),
+	};
+
+	return cmocka_run_group_tests(tests, setup, teardown);
+}
@@ -0,0 +1,227 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include <util/darray.h>
+#include <util/platform.h>
+#include <obs-output-interleave.h>
+
+#define VIDEO_TRACKS 2
+#define AUDIO_TRACKS 6
+#define TEST_PACKETS 4000
+#define BENCH_WINDOWS 3
+#define BENCH_ITERATIONS 5
+
+/* video at 60 fps and AAC sized audio frames at 48 kHz, with the video
+ * tracks sharing timestamps the way encoder groups produce them */
+static void make_packet(struct encoder_packet *packet, size_t counters[2][AUDIO_TRACKS], int64_t *next_ts[2],
+			size_t serial)
+{
+	int64_t best = INT64_MAX;
+	enum obs_encoder_type type = OBS_ENCODER_VIDEO;
+	size_t track = 0;
+
+	for (size_t i = 0; i < VIDEO_TRACKS; i++) {
+		if (next_ts[0][i] < best) {
+			best = next_ts[0][i];
+			type = OBS_ENCODER_VIDEO;
+			track = i;
+		}
+	}
+	for (size_t i = 0; i < AUDIO_TRACKS; i++) {
+		/* audio tracks are slightly out of phase with each other */
+		if (next_ts[1][i] < best) {
+			best = next_ts[1][i];
+			type = OBS_ENCODER_AUDIO;
+			track = i;
+		}
+	}
+
+	memset(packet, 0, sizeof(*packet));
+	packet->type = type;
+	packet->track_idx = track;
+	packet->dts_usec = best;
+	packet->dts = (int64_t)serial;
+
+	if (type == OBS_ENCODER_VIDEO) {
+		counters[0][track]++;
+		next_ts[0][track] = (int64_t)counters[0][track] * 1000000 / 60;
+	} else {
+		counters[1][track]++;
+		next_ts[1][track] = (int64_t)counters[1][track] * 1024 * 1000000 / 48000 + (int64_t)track * 37;
+	}
+}
+
+static void make_stream(struct encoder_packet *packets, size_t count)
+{
+	size_t counters[2][AUDIO_TRACKS] = {0};
+	int64_t video_ts[AUDIO_TRACKS] = {0};
+	int64_t audio_ts[AUDIO_TRACKS];
+	int64_t *next_ts[2] = {video_ts, audio_ts};
+
+	for (size_t i = 0; i < AUDIO_TRACKS; i++)
+		audio_ts[i] = (int64_t)i * 37;
+
+	for (size_t i = 0; i < count; i++)
+		make_packet(&packets[i], counters, next_ts, i);
+}
+
+/* the sorted array insert the interleaver used before, kept as the
+ * reference order and the benchmark baseline */
+typedef DARRAY(struct encoder_packet) packet_array_t;
+
+static void linear_insert(packet_array_t *array, struct encoder_packet *out)
+{
+	size_t idx;
+	for (idx = 0; idx < array->num; idx++) {
+		struct encoder_packet *cur_packet = array->array + idx;
+
+		if (out->dts_usec == cur_packet->dts_usec && out->type == OBS_ENCODER_VIDEO &&
+		    cur_packet->type == OBS_ENCODER_VIDEO && out->track_idx > cur_packet->track_idx)
+			continue;
+
+		if (out->dts_usec == cur_packet->dts_usec && out->type == OBS_ENCODER_VIDEO) {
+			break;
+		} else if (out->dts_usec < cur_packet->dts_usec) {
+			break;
+		}
+	}
+
+	da_insert(*array, idx, out);
+}
+
+static void order_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	struct encoder_packet *packets = bmalloc(sizeof(*packets) * TEST_PACKETS);
+	struct interleave_queue queue = {0};
+	struct interleave_iter iter;
+	struct encoder_packet *peeked;
+	struct encoder_packet packet;
+	packet_array_t array = {0};
+
+	make_stream(packets, TEST_PACKETS);
+
+	/* deliver each track in order, but the tracks in bursts relative to
+	 * each other, like encoders running on separate threads */
+	for (size_t i = 0; i < TEST_PACKETS; i++) {
+		size_t idx = (i % 7 == 0 && i + 1 < TEST_PACKETS) ? i + 1 : (i % 7 == 1 ? i - 1 : i);
+		interleave_push(&queue, &packets[idx]);
+		linear_insert(&array, &packets[idx]);
+	}
+
+	assert_int_equal(queue.num, array.num);
+
+	interleave_iter_init(&iter);
+	for (size_t i = 0; i < array.num; i++) {
+		peeked = interleave_iter_next(&queue, &iter);
+		assert_non_null(peeked);
+		assert_int_equal(peeked->dts, array.array[i].dts);
+	}
+	assert_null(interleave_iter_next(&queue, &iter));
+
+	for (size_t i = 0; i < array.num; i++) {
+		assert_true(interleave_pop_front(&queue, &packet));
+		assert_int_equal(packet.dts, array.array[i].dts);
+		assert_int_equal(packet.dts_usec, array.array[i].dts_usec);
+	}
+	assert_false(interleave_pop_front(&queue, &packet));
+	assert_int_equal(queue.num, 0);
+
+	interleave_free(&queue);
+	da_free(array);
+	bfree(packets);
+}
+
+static void out_of_order_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	struct interleave_queue queue = {0};
+	struct encoder_packet packet = {0};
+	const int64_t ts[] = {10, 30, 20, 40, 5};
+
+	packet.type = OBS_ENCODER_AUDIO;
+	packet.track_idx = 3;
+
+	for (size_t i = 0; i < sizeof(ts) / sizeof(ts[0]); i++) {
+		packet.dts_usec = ts[i];
+		interleave_push(&queue, &packet);
+	}
+
+	assert_int_equal(interleave_track_last(&queue, MAX_OUTPUT_VIDEO_ENCODERS + 3)->dts_usec, 40);
+
+	const int64_t expected[] = {5, 10, 20, 30, 40};
+	for (size_t i = 0; i < sizeof(expected) / sizeof(expected[0]); i++) {
+		assert_true(interleave_pop_front(&queue, &packet));
+		assert_int_equal(packet.dts_usec, expected[i]);
+	}
+
+	interleave_free(&queue);
+}
+
+/* Keeps a window of packets buffered, as during a reconnect, and then
+ * streams: one packet in, one packet out. */
+static void benchmark_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	const size_t windows[BENCH_WINDOWS] = {64, 1024, 8192};
+	const size_t total = 16384 + windows[BENCH_WINDOWS - 1];
+	struct encoder_packet *packets = bmalloc(sizeof(*packets) * total);
+	struct encoder_packet packet;
+	uint64_t start;
+
+	make_stream(packets, total);
+
+	for (size_t w = 0; w < BENCH_WINDOWS; w++) {
+		const size_t window = windows[w];
+		uint64_t linear_ns = 0;
+		uint64_t merge_ns = 0;
+
+		for (int it = 0; it < BENCH_ITERATIONS; it++) {
+			struct interleave_queue queue = {0};
+			packet_array_t array = {0};
+
+			start = os_gettime_ns();
+			for (size_t i = 0; i < window; i++)
+				linear_insert(&array, &packets[i]);
+			for (size_t i = window; i < total; i++) {
+				linear_insert(&array, &packets[i]);
+				da_erase(array, 0);
+			}
+			linear_ns += os_gettime_ns() - start;
+
+			start = os_gettime_ns();
+			for (size_t i = 0; i < window; i++)
+				interleave_push(&queue, &packets[i]);
+			for (size_t i = window; i < total; i++) {
+				interleave_push(&queue, &packets[i]);
+				interleave_pop_front(&queue, &packet);
+			}
+			merge_ns += os_gettime_ns() - start;
+
+			da_free(array);
+			interleave_free(&queue);
+		}
+
+		print_message("window %5zu: sorted array %8.1f ns/packet, merge queue %8.1f ns/packet\n", window,
+			      (double)linear_ns / (double)(total * BENCH_ITERATIONS),
+			      (double)merge_ns / (double)(total * BENCH_ITERATIONS));
+	}
+
+	bfree(packets);
+}
+
+int main()
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(order_test),
+		cmocka_unit_test(out_of_order_test),
+		cmocka_unit_test(benchmark_test),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,301 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include <obs-internal.h>
+#include <util/platform.h>
+
+/*
+ * obs-source-lazy.c is built in to this test with a core that has no thread
+ * pool, so lazy sources are created and destroyed right away on the ticking
+ * thread.  The hotkeys of the instance are replaced below.
+ */
+
+struct obs_core *obs = NULL;
+
+static size_t hotkey_releases = 0;
+
+void obs_hotkeys_context_release_after(struct obs_context_data *context, size_t num_hotkeys, size_t num_pairs)
+{
+	UNUSED_PARAMETER(context);
+	UNUSED_PARAMETER(num_hotkeys);
+	UNUSED_PARAMETER(num_pairs);
+	hotkey_releases++;
+}
+
+struct counts {
+	int creates;
+	int destroys;
+	int loads;
+	int saves;
+	int shows;
+	int activates;
+	int procs;
+};
+
+static struct counts counts;
+
+static void test_proc(void *data, calldata_t *cd)
+{
+	UNUSED_PARAMETER(data);
+	UNUSED_PARAMETER(cd);
+	counts.procs++;
+}
+
+static void *test_create(obs_data_t *settings, obs_source_t *source)
+{
+	UNUSED_PARAMETER(settings);
+
+	int *data = bzalloc(sizeof(int));
+	proc_handler_add(source->context.procs, "void test_proc()", test_proc, data);
+	counts.creates++;
+	return data;
+}
+
+static void test_destroy(void *data)
+{
+	bfree(data);
+	counts.destroys++;
+}
+
+static void test_load(void *data, obs_data_t *settings)
+{
+	UNUSED_PARAMETER(data);
+	UNUSED_PARAMETER(settings);
+	counts.loads++;
+}
+
+static void test_save(void *data, obs_data_t *settings)
+{
+	UNUSED_PARAMETER(data);
+	UNUSED_PARAMETER(settings);
+	counts.saves++;
+}
+
+static void test_show(void *data)
+{
+	UNUSED_PARAMETER(data);
+	counts.shows++;
+}
+
+static void test_activate(void *data)
+{
+	UNUSED_PARAMETER(data);
+	counts.activates++;
+}
+
+static obs_source_t *create_lazy_source(bool unload)
+{
+	obs_source_t *source = bzalloc(sizeof(*source));
+
+	source->info.create = test_create;
+	source->info.destroy = test_destroy;
+	source->info.load = test_load;
+	source->info.save = test_save;
+	source->info.show = test_show;
+	source->info.activate = test_activate;
+	source->context.name = bstrdup("lazy");
+	source->context.settings = obs_data_create();
+	source->context.procs = proc_handler_create();
+	source->lazy = true;
+	source->lazy_unload = unload;
+	pthread_mutex_init(&source->lazy_mutex, NULL);
+	if (unload)
+		os_event_init(&source->lazy_unloaded, OS_EVENT_TYPE_MANUAL);
+
+	memset(&counts, 0, sizeof(counts));
+	hotkey_releases = 0;
+	return source;
+}
+
+static void destroy_lazy_source(obs_source_t *source)
+{
+	if (source->context.data)
+		test_destroy(source->context.data);
+
+	os_event_destroy(source->lazy_unloaded);
+	pthread_mutex_destroy(&source->lazy_mutex);
+	proc_handler_destroy(source->context.procs);
+	obs_data_release(source->context.settings);
+	bfree(source->context.name);
+	bfree(source);
+}
+
+static int setup(void **state)
+{
+	UNUSED_PARAMETER(state);
+	obs = bzalloc(sizeof(*obs));
+	return 0;
+}
+
+static int teardown(void **state)
+{
+	UNUSED_PARAMETER(state);
+	bfree(obs);
+	obs = NULL;
+	return 0;
+}
+
+static void create_on_tick_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	obs_source_t *source = create_lazy_source(false);
+
+	assert_true(lazy_source_tick(source, false));
+	assert_int_equal(counts.creates, 0);
+	assert_null(source->context.data);
+
+	/* the show/hide code of the tick calls show on the new instance */
+	assert_true(lazy_source_tick(source, true));
+	assert_int_equal(counts.creates, 1);
+	assert_non_null(source->context.data);
+	assert_int_equal(source->lazy_state, OBS_LAZY_LOADED);
+	assert_int_equal(counts.shows, 0);
+	assert_int_equal(counts.loads, 0);
+
+	assert_true(lazy_source_tick(source, true));
+	assert_int_equal(counts.creates, 1);
+
+	destroy_lazy_source(source);
+}
+
+static void preload_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	obs_source_t *source = create_lazy_source(false);
+
+	/* obs_source_load before the source is created is applied once it is */
+	source->lazy_load_pending = true;
+
+	obs_source_preload(source);
+	assert_int_equal(counts.creates, 1);
+	assert_int_equal(counts.loads, 1);
+	assert_non_null(source->context.data);
+
+	obs_source_preload(source);
+	assert_true(lazy_source_tick(source, true));
+	assert_int_equal(counts.creates, 1);
+	assert_int_equal(counts.loads, 1);
+
+	destroy_lazy_source(source);
+}
+
+static void show_activate_replay_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	obs_source_t *source = create_lazy_source(false);
+
+	/* the video tick showed and activated the source while it was not
+	 * created yet, so it has to call show/activate on the new instance */
+	source->showing = true;
+	source->active = true;
+	obs_source_preload(source);
+	assert_int_equal(counts.shows, 0);
+	assert_int_equal(counts.activates, 0);
+
+	assert_true(lazy_source_tick(source, true));
+	assert_int_equal(counts.shows, 1);
+	assert_int_equal(counts.activates, 1);
+
+	assert_true(lazy_source_tick(source, true));
+	assert_int_equal(counts.shows, 1);
+	assert_int_equal(counts.activates, 1);
+
+	/* while the tick can't lock the source, show/activate are left for a
+	 * later tick */
+	pthread_mutex_lock(&source->lazy_mutex);
+	assert_false(lazy_source_tick(source, true));
+	pthread_mutex_unlock(&source->lazy_mutex);
+
+	destroy_lazy_source(source);
+}
+
+static void unload_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	obs_source_t *source = create_lazy_source(true);
+	obs->data.lazy_unload_delay = 1;
+
+	assert_true(lazy_source_tick(source, true));
+	assert_int_equal(counts.creates, 1);
+	assert_true(proc_handler_call(source->context.procs, "test_proc", NULL));
+	assert_int_equal(counts.procs, 1);
+
+	/* the first idle tick only starts counting */
+	assert_true(lazy_source_tick(source, false));
+	assert_int_not_equal(source->lazy_idle_since, 0);
+	assert_int_equal(counts.destroys, 0);
+
+	source->lazy_idle_since = os_gettime_ns() - 2000000000ULL;
+	assert_true(lazy_source_tick(source, false));
+	assert_int_equal(counts.saves, 1);
+	assert_int_equal(counts.destroys, 1);
+	assert_int_equal(hotkey_releases, 1);
+	assert_null(source->context.data);
+	assert_null(source->lazy_unload_data);
+	assert_int_equal(source->lazy_state, OBS_LAZY_UNLOADED);
+
+	/* the procedures of the instance went with it */
+	assert_false(proc_handler_call(source->context.procs, "test_proc", NULL));
+	assert_int_equal(counts.procs, 1);
+
+	assert_true(lazy_source_tick(source, true));
+	assert_int_equal(counts.creates, 2);
+	assert_non_null(source->context.data);
+	assert_true(proc_handler_call(source->context.procs, "test_proc", NULL));
+	assert_int_equal(counts.procs, 2);
+
+	/* a source that is showing is never unloaded */
+	source->showing = true;
+	source->lazy_idle_since = os_gettime_ns() - 2000000000ULL;
+	assert_true(lazy_source_tick(source, false));
+	assert_int_equal(counts.destroys, 1);
+
+	destroy_lazy_source(source);
+}
+
+static void no_unload_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	obs_source_t *source = create_lazy_source(false);
+	obs->data.lazy_unload_delay = 1;
+
+	assert_true(lazy_source_tick(source, true));
+	source->lazy_idle_since = os_gettime_ns() - 2000000000ULL;
+	assert_true(lazy_source_tick(source, false));
+	assert_int_equal(counts.destroys, 0);
+	assert_non_null(source->context.data);
+
+	destroy_lazy_source(source);
+
+	/* nor are sources that allow it while there is no delay */
+	source = create_lazy_source(true);
+	obs->data.lazy_unload_delay = 0;
+
+	assert_true(lazy_source_tick(source, true));
+	assert_true(lazy_source_tick(source, false));
+	assert_true(lazy_source_tick(source, false));
+	assert_int_equal(counts.destroys, 0);
+	assert_int_equal(source->lazy_idle_since, 0);
+
+	destroy_lazy_source(source);
+}
+
+int main()
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(create_on_tick_test),
+		cmocka_unit_test(preload_test),
+		cmocka_unit_test(show_activate_replay_test),
+		cmocka_unit_test(unload_test),
+		cmocka_unit_test(no_unload_test),
+	};
+
+	return cmocka_run_group_tests(tests, setup, teardown);
+}
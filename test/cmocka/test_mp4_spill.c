@@ -0,0 +1,127 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include <util/platform.h>
+
+#include "mp4-spill.h"
+
+#define SPILL_PATH "mp4_spill_test.tables"
+#define SPILL_THRESHOLD 64
+#define BATCHES 20
+#define BATCH_SIZE 37
+
+struct test_chunk {
+	uint32_t samples;
+	uint64_t offset;
+};
+
+static void spill_restore_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	struct mp4_spill_file spill = {0};
+	struct spilled_table spilled_sizes = {0};
+	struct spilled_table spilled_chunks = {0};
+	DARRAY(uint32_t) sizes, expected_sizes;
+	DARRAY(struct test_chunk) chunks, expected_chunks;
+
+	da_init(sizes);
+	da_init(expected_sizes);
+	da_init(chunks);
+	da_init(expected_chunks);
+
+	assert_true(mp4_spill_open(&spill, SPILL_PATH));
+
+	/* two tables with different entry sizes share the file, like the
+	 * tables of a track do, so their ranges end up interleaved */
+	for (uint32_t batch = 0; batch < BATCHES; batch++) {
+		for (uint32_t i = 0; i < BATCH_SIZE; i++) {
+			uint32_t size = batch * 1000 + i;
+			da_push_back(sizes, &size);
+			da_push_back(expected_sizes, &size);
+		}
+
+		struct test_chunk chunk = {batch, (uint64_t)batch << 32 | 0xABCD};
+		da_push_back(chunks, &chunk);
+		da_push_back(expected_chunks, &chunk);
+
+		assert_true(mp4_spill_table(&spill, &spilled_sizes, &sizes.da, sizeof(*sizes.array), SPILL_THRESHOLD));
+		assert_true(mp4_spill_table(&spill, &spilled_chunks, &chunks.da, sizeof(*chunks.array),
+					    SPILL_THRESHOLD));
+
+		/* only the last entry stays behind once a table is spilled */
+		assert_int_equal(sizes.num, 1);
+		assert_int_equal(spilled_sizes.num + sizes.num, expected_sizes.num);
+		assert_int_equal(spilled_chunks.num + chunks.num, expected_chunks.num);
+	}
+
+	assert_true(spilled_chunks.num > 0);
+	assert_true(chunks.num < expected_chunks.num);
+	assert_int_equal(spill.size, (spilled_sizes.num * sizeof(*sizes.array) +
+				      spilled_chunks.num * sizeof(*chunks.array)));
+
+	/* entries added after the last spill are kept after the restored ones */
+	uint32_t last = 0xFFFFFFFF;
+	da_push_back(sizes, &last);
+	da_push_back(expected_sizes, &last);
+
+	assert_true(mp4_restore_table(&spill, &spilled_sizes, &sizes.da, sizeof(*sizes.array)));
+	assert_true(mp4_restore_table(&spill, &spilled_chunks, &chunks.da, sizeof(*chunks.array)));
+	assert_int_equal(spilled_sizes.num, 0);
+	assert_int_equal(spilled_sizes.ranges.num, 0);
+
+	assert_int_equal(sizes.num, expected_sizes.num);
+	assert_memory_equal(sizes.array, expected_sizes.array, sizes.num * sizeof(*sizes.array));
+	assert_int_equal(chunks.num, expected_chunks.num);
+	assert_memory_equal(chunks.array, expected_chunks.array, chunks.num * sizeof(*chunks.array));
+
+	/* restoring again changes nothing */
+	assert_true(mp4_restore_table(&spill, &spilled_sizes, &sizes.da, sizeof(*sizes.array)));
+	assert_int_equal(sizes.num, expected_sizes.num);
+
+	mp4_spill_close(&spill);
+	assert_false(os_file_exists(SPILL_PATH));
+
+	da_free(sizes);
+	da_free(expected_sizes);
+	da_free(chunks);
+	da_free(expected_chunks);
+}
+
+static void spill_threshold_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	struct mp4_spill_file spill = {0};
+	struct spilled_table spilled = {0};
+	DARRAY(uint32_t) table;
+
+	da_init(table);
+	assert_true(mp4_spill_open(&spill, SPILL_PATH));
+
+	/* tables below the threshold stay in memory */
+	for (uint32_t i = 0; i < SPILL_THRESHOLD / sizeof(uint32_t) - 1; i++)
+		da_push_back(table, &i);
+
+	assert_true(mp4_spill_table(&spill, &spilled, &table.da, sizeof(*table.array), SPILL_THRESHOLD));
+	assert_int_equal(spilled.num, 0);
+	assert_int_equal(spill.size, 0);
+
+	assert_true(mp4_restore_table(&spill, &spilled, &table.da, sizeof(*table.array)));
+	assert_int_equal(table.num, SPILL_THRESHOLD / sizeof(uint32_t) - 1);
+
+	mp4_spill_close(&spill);
+	da_free(table);
+}
+
+int main()
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(spill_restore_test),
+		cmocka_unit_test(spill_threshold_test),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,156 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include <obs-nal.h>
+#include <util/bmem.h>
+
+#define TEST_SIZE 160
+
+/* bytewise version of what obs_nal_find_startcode returns: the first start
+ * code that begins more than three bytes before the end, including the
+ * leading zero of a four byte start code, or the end if there is none */
+static const uint8_t *reference_find_startcode(const uint8_t *p, const uint8_t *end)
+{
+	const uint8_t *pos = p;
+
+	for (; end - pos > 3; pos++) {
+		if (pos[0] == 0 && pos[1] == 0 && pos[2] == 1)
+			break;
+	}
+
+	if (end - pos <= 3)
+		return end;
+	if (pos > p && !pos[-1])
+		pos--;
+	return pos;
+}
+
+/* searches from every position of the buffer, which moves every start code
+ * across every offset of the 32 byte blocks the AVX2 scanner checks */
+static void check_all_positions(const uint8_t *data, size_t size)
+{
+	for (size_t start = 0; start <= size; start++) {
+		const uint8_t *expected = reference_find_startcode(data + start, data + size);
+		assert_ptr_equal(obs_nal_find_startcode(data + start, data + size), expected);
+	}
+}
+
+static void put_startcode(uint8_t *data, size_t pos, size_t len)
+{
+	memset(data + pos, 0, len - 1);
+	data[pos + len - 1] = 1;
+}
+
+static void startcode_boundary_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	uint8_t *data = bmalloc(TEST_SIZE);
+
+	for (size_t len = 3; len <= 4; len++) {
+		for (size_t pos = 0; pos + len <= TEST_SIZE; pos++) {
+			memset(data, 0x65, TEST_SIZE);
+			put_startcode(data, pos, len);
+			check_all_positions(data, TEST_SIZE);
+		}
+	}
+
+	/* two start codes straddling the same 32 byte boundary */
+	memset(data, 0x65, TEST_SIZE);
+	put_startcode(data, 30, 3);
+	put_startcode(data, 33, 4);
+	check_all_positions(data, TEST_SIZE);
+
+	bfree(data);
+}
+
+static void startcode_trailing_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	static const uint8_t tails[][5] = {
+		{0},
+		{0, 0},
+		{0, 0, 1},
+		{0, 0, 0, 1},
+		{0, 0, 1, 0x65},
+		{0, 0, 0, 1, 0x65},
+	};
+	static const size_t tail_sizes[] = {1, 2, 3, 4, 4, 5};
+	uint8_t *data = bmalloc(TEST_SIZE);
+
+	/* partial and complete start codes at the very end of buffers of
+	 * every size around the 32 byte blocks */
+	for (size_t i = 0; i < sizeof(tail_sizes) / sizeof(tail_sizes[0]); i++) {
+		for (size_t size = tail_sizes[i]; size <= TEST_SIZE; size++) {
+			memset(data, 0x65, size);
+			memcpy(data + size - tail_sizes[i], tails[i], tail_sizes[i]);
+			check_all_positions(data, size);
+		}
+	}
+
+	bfree(data);
+}
+
+static void startcode_random_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	static const uint8_t values[] = {0, 0, 0, 1, 0x65};
+	const size_t size = 4096;
+	uint8_t *data = bmalloc(size);
+	uint32_t seed = 0x12345678;
+
+	/* mostly zeros, so runs of zeros of any length show up everywhere */
+	for (size_t i = 0; i < size; i++) {
+		seed = seed * 1103515245 + 12345;
+		data[i] = values[(seed >> 16) % sizeof(values)];
+	}
+
+	check_all_positions(data, size);
+	bfree(data);
+}
+
+static void find_units_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	/* the first start code straddles the first 32 byte boundary */
+	uint8_t data[96];
+	struct obs_nal_unit units[4];
+
+	memset(data, 0x65, sizeof(data));
+	put_startcode(data, 29, 4); /* unit at 33 */
+	put_startcode(data, 40, 3); /* unit at 43 */
+	put_startcode(data, 63, 4); /* unit at 67 */
+
+	assert_int_equal(obs_nal_find_units(data, sizeof(data), units, 4), 3);
+	assert_int_equal(units[0].offset, 33);
+	assert_int_equal(units[0].size, 40 - 33);
+	assert_int_equal(units[1].offset, 43);
+	assert_int_equal(units[1].size, 63 - 43);
+	assert_int_equal(units[2].offset, 67);
+	assert_int_equal(units[2].size, sizeof(data) - 67);
+
+	/* the count is returned even if not all units fit */
+	memset(units, 0, sizeof(units));
+	assert_int_equal(obs_nal_find_units(data, sizeof(data), units, 1), 3);
+	assert_int_equal(units[0].offset, 33);
+	assert_int_equal(units[1].offset, 0);
+
+	assert_int_equal(obs_nal_find_units(data, 20, units, 4), 0);
+}
+
+int main()
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(startcode_boundary_test),
+		cmocka_unit_test(startcode_trailing_test),
+		cmocka_unit_test(startcode_random_test),
+		cmocka_unit_test(find_units_test),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
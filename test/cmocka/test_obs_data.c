@@ -0,0 +1,480 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include <float.h>
+#include <limits.h>
+
+#include <obs-data.h>
+#include <util/bmem.h>
+#include <util/platform.h>
+#include <util/uthash.h>
+
+#define TEST_BINARY_FILE "test_obs_data.bin"
+#define TEST_JSON_FILE "test_obs_data.json"
+
+#define BENCH_SOURCES 5000
+#define BENCH_RUNS 5
+#define BENCH_LOOKUPS 1000000
+#define BENCH_APPLIES 100000
+
+static bool data_equal(obs_data_t *a, obs_data_t *b);
+
+static bool array_equal(obs_data_array_t *a, obs_data_array_t *b)
+{
+	size_t count = obs_data_array_count(a);
+	bool equal = count == obs_data_array_count(b);
+
+	for (size_t i = 0; equal && i < count; i++) {
+		obs_data_t *item_a = obs_data_array_item(a, i);
+		obs_data_t *item_b = obs_data_array_item(b, i);
+		equal = data_equal(item_a, item_b);
+		obs_data_release(item_a);
+		obs_data_release(item_b);
+	}
+
+	return equal;
+}
+
+static bool item_equal(obs_data_item_t *a, obs_data_item_t *b)
+{
+	enum obs_data_type type = obs_data_item_gettype(a);
+	bool equal = false;
+
+	if (type != obs_data_item_gettype(b) || strcmp(obs_data_item_get_name(a), obs_data_item_get_name(b)) != 0)
+		return false;
+
+	switch (type) {
+	case OBS_DATA_STRING:
+		return strcmp(obs_data_item_get_string(a), obs_data_item_get_string(b)) == 0;
+	case OBS_DATA_NUMBER:
+		if (obs_data_item_numtype(a) != obs_data_item_numtype(b))
+			return false;
+		if (obs_data_item_numtype(a) == OBS_DATA_NUM_INT)
+			return obs_data_item_get_int(a) == obs_data_item_get_int(b);
+		return memcmp(&(double){obs_data_item_get_double(a)}, &(double){obs_data_item_get_double(b)},
+			      sizeof(double)) == 0;
+	case OBS_DATA_BOOLEAN:
+		return obs_data_item_get_bool(a) == obs_data_item_get_bool(b);
+	case OBS_DATA_OBJECT: {
+		obs_data_t *obj_a = obs_data_item_get_obj(a);
+		obs_data_t *obj_b = obs_data_item_get_obj(b);
+		equal = data_equal(obj_a, obj_b);
+		obs_data_release(obj_a);
+		obs_data_release(obj_b);
+		return equal;
+	}
+	case OBS_DATA_ARRAY: {
+		obs_data_array_t *array_a = obs_data_item_get_array(a);
+		obs_data_array_t *array_b = obs_data_item_get_array(b);
+		equal = array_equal(array_a, array_b);
+		obs_data_array_release(array_a);
+		obs_data_array_release(array_b);
+		return equal;
+	}
+	case OBS_DATA_NULL:
+		return true;
+	}
+
+	return false;
+}
+
+/* compares user values, including their order */
+static bool data_equal(obs_data_t *a, obs_data_t *b)
+{
+	obs_data_item_t *item_a = obs_data_first(a);
+	obs_data_item_t *item_b = obs_data_first(b);
+	bool equal = true;
+
+	for (;;) {
+		while (item_a && !obs_data_item_has_user_value(item_a))
+			obs_data_item_next(&item_a);
+		while (item_b && !obs_data_item_has_user_value(item_b))
+			obs_data_item_next(&item_b);
+
+		if (!item_a || !item_b) {
+			equal = !item_a && !item_b;
+			break;
+		}
+
+		if (!item_equal(item_a, item_b)) {
+			equal = false;
+			break;
+		}
+
+		obs_data_item_next(&item_a);
+		obs_data_item_next(&item_b);
+	}
+
+	obs_data_item_release(&item_a);
+	obs_data_item_release(&item_b);
+	return equal;
+}
+
+static obs_data_t *create_source_data(int idx)
+{
+	obs_data_t *source = obs_data_create();
+	obs_data_t *settings = obs_data_create();
+	obs_data_array_t *filters = obs_data_array_create();
+	char name[64];
+
+	snprintf(name, sizeof(name), "Source %d", idx);
+	obs_data_set_string(source, "name", name);
+	obs_data_set_string(source, "uuid", "0b6a8f1e-2f4c-4f4e-9d7a-3c1e5b2a9f10");
+	obs_data_set_string(source, "id", idx % 2 ? "image_source" : "text_ft2_source");
+	obs_data_set_int(source, "mixers", 255);
+	obs_data_set_double(source, "volume", 1.0 / (idx + 1));
+	obs_data_set_bool(source, "enabled", idx % 3 != 0);
+	obs_data_set_bool(source, "muted", false);
+
+	obs_data_set_string(settings, "file", "/home/user/Pictures/some/rather/long/path/to/an/image.png");
+	obs_data_set_int(settings, "color", 0xFFFFFFFF);
+	obs_data_set_default_int(settings, "opacity", 100);
+
+	for (int i = 0; i < 2; i++) {
+		obs_data_t *filter = obs_data_create();
+		obs_data_t *filter_settings = obs_data_create();
+
+		obs_data_set_string(filter, "name", i ? "Color Correction" : "Crop/Pad");
+		obs_data_set_string(filter, "id", i ? "color_filter_v2" : "crop_filter");
+		obs_data_set_double(filter_settings, "gamma", -0.25 * i);
+		obs_data_set_int(filter_settings, "left", -idx);
+		obs_data_set_obj(filter, "settings", filter_settings);
+		obs_data_array_push_back(filters, filter);
+
+		obs_data_release(filter_settings);
+		obs_data_release(filter);
+	}
+
+	obs_data_set_obj(source, "settings", settings);
+	obs_data_set_array(source, "filters", filters);
+
+	obs_data_array_release(filters);
+	obs_data_release(settings);
+	return source;
+}
+
+static obs_data_t *create_collection(int num_sources)
+{
+	obs_data_t *collection = obs_data_create();
+	obs_data_array_t *sources = obs_data_array_create();
+
+	obs_data_set_string(collection, "name", "Benchmark");
+
+	for (int i = 0; i < num_sources; i++) {
+		obs_data_t *source = create_source_data(i);
+		obs_data_array_push_back(sources, source);
+		obs_data_release(source);
+	}
+
+	obs_data_set_array(collection, "sources", sources);
+	obs_data_array_release(sources);
+	return collection;
+}
+
+static void binary_roundtrip_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	obs_data_t *data = create_collection(3);
+	obs_data_t *empty = obs_data_create();
+
+	obs_data_set_int(data, "min", LLONG_MIN);
+	obs_data_set_int(data, "max", LLONG_MAX);
+	obs_data_set_int(data, "zero", 0);
+	obs_data_set_double(data, "neg_zero", -0.0);
+	obs_data_set_double(data, "tiny", DBL_MIN);
+	obs_data_set_double(data, "huge", -DBL_MAX);
+	obs_data_set_string(data, "empty", "");
+	obs_data_set_string(data, "utf8", "\xE2\x9C\x93 \xF0\x9F\x8E\xA5");
+	obs_data_set_obj(data, "empty_obj", empty);
+	obs_data_set_default_string(data, "default_only", "not saved");
+
+	assert_true(obs_data_save_binary(data, TEST_BINARY_FILE));
+
+	obs_data_t *loaded = obs_data_create_from_binary_file(TEST_BINARY_FILE);
+	assert_non_null(loaded);
+	assert_true(data_equal(data, loaded));
+	assert_false(obs_data_has_user_value(loaded, "default_only"));
+
+	obs_data_release(loaded);
+	obs_data_release(empty);
+	obs_data_release(data);
+	os_unlink(TEST_BINARY_FILE);
+}
+
+static void binary_json_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	obs_data_t *data = create_collection(4);
+	char *json = bstrdup(obs_data_get_json(data));
+
+	assert_true(obs_data_save_binary(data, TEST_BINARY_FILE));
+
+	obs_data_t *loaded = obs_data_create_from_binary_file(TEST_BINARY_FILE);
+	assert_non_null(loaded);
+	assert_string_equal(obs_data_get_json(loaded), json);
+
+	obs_data_release(loaded);
+	obs_data_release(data);
+	bfree(json);
+	os_unlink(TEST_BINARY_FILE);
+}
+
+static void binary_corrupt_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	obs_data_t *data = create_collection(2);
+	assert_true(obs_data_save_binary(data, TEST_BINARY_FILE));
+	obs_data_release(data);
+
+	FILE *file = os_fopen(TEST_BINARY_FILE, "rb");
+	assert_non_null(file);
+	size_t size = (size_t)os_fgetsize(file);
+	uint8_t *buf = bmalloc(size);
+	assert_int_equal(fread(buf, 1, size, file), size);
+	fclose(file);
+	os_unlink(TEST_BINARY_FILE);
+
+	/* every truncation has to be rejected */
+	for (size_t len = 0; len < size; len++)
+		assert_null(obs_data_create_from_binary(buf, len));
+
+	/* flipped bytes may or may not parse, but must not crash */
+	for (size_t i = 0; i < size; i++) {
+		buf[i] ^= 0xFF;
+		obs_data_release(obs_data_create_from_binary(buf, size));
+		buf[i] ^= 0xFF;
+	}
+
+	bfree(buf);
+}
+
+static void key_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	const obs_data_key_t *key = obs_data_key("item 3");
+	assert_ptr_equal(key, obs_data_key("item 3"));
+	assert_string_equal(obs_data_key_name(key), "item 3");
+
+	obs_data_t *data = obs_data_create();
+	char name[32];
+
+	/* grow past the flat layout and make sure nothing gets lost */
+	for (int i = 0; i < 40; i++) {
+		snprintf(name, sizeof(name), "item %d", i);
+		obs_data_set_int(data, name, i);
+
+		for (int j = 0; j <= i; j++) {
+			snprintf(name, sizeof(name), "item %d", j);
+			assert_int_equal(obs_data_get_int_key(data, obs_data_key(name)), j);
+			assert_int_equal(obs_data_get_int(data, name), j);
+		}
+	}
+
+	/* insertion order is kept regardless of the layout */
+	obs_data_item_t *item = obs_data_first(data);
+	for (int i = 0; i < 40; i++, obs_data_item_next(&item)) {
+		snprintf(name, sizeof(name), "item %d", i);
+		assert_string_equal(obs_data_item_get_name(item), name);
+	}
+	assert_null(item);
+
+	obs_data_set_string_key(data, key, "three");
+	assert_string_equal(obs_data_get_string(data, "item 3"), "three");
+	assert_false(obs_data_has_user_value(data, "missing"));
+	assert_int_equal(obs_data_get_int_key(data, obs_data_key("missing")), 0);
+
+	for (int i = 0; i < 40; i++) {
+		snprintf(name, sizeof(name), "item %d", i);
+		obs_data_erase(data, name);
+		assert_null(obs_data_item_bykey(data, obs_data_key(name)));
+	}
+	assert_null(obs_data_first(data));
+
+	/* and shrinks back into the flat layout */
+	obs_data_set_double_key(data, key, 0.5);
+	obs_data_set_bool(data, "bool", true);
+	obs_data_erase(data, "item 3");
+	assert_true(obs_data_get_bool_key(data, obs_data_key("bool")));
+	assert_false(obs_data_has_user_value(data, "item 3"));
+
+	obs_data_release(data);
+}
+
+static double bench_ms(uint64_t start)
+{
+	return (double)(os_gettime_ns() - start) / 1000000.0 / BENCH_RUNS;
+}
+
+static void benchmark_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	obs_data_t *data = create_collection(BENCH_SOURCES);
+	obs_data_t *loaded;
+	uint64_t start;
+
+	start = os_gettime_ns();
+	for (int i = 0; i < BENCH_RUNS; i++)
+		assert_true(obs_data_save_json_pretty_safe(data, TEST_JSON_FILE, "tmp", NULL));
+	double json_save = bench_ms(start);
+
+	start = os_gettime_ns();
+	for (int i = 0; i < BENCH_RUNS; i++) {
+		loaded = obs_data_create_from_json_file(TEST_JSON_FILE);
+		assert_non_null(loaded);
+		obs_data_release(loaded);
+	}
+	double json_load = bench_ms(start);
+
+	start = os_gettime_ns();
+	for (int i = 0; i < BENCH_RUNS; i++)
+		assert_true(obs_data_save_binary_safe(data, TEST_BINARY_FILE, "tmp", NULL));
+	double binary_save = bench_ms(start);
+
+	start = os_gettime_ns();
+	for (int i = 0; i < BENCH_RUNS; i++) {
+		loaded = obs_data_create_from_binary_file(TEST_BINARY_FILE);
+		assert_non_null(loaded);
+		obs_data_release(loaded);
+	}
+	double binary_load = bench_ms(start);
+
+	FILE *file = os_fopen(TEST_JSON_FILE, "rb");
+	int64_t json_size = os_fgetsize(file);
+	fclose(file);
+	file = os_fopen(TEST_BINARY_FILE, "rb");
+	int64_t binary_size = os_fgetsize(file);
+	fclose(file);
+
+	print_message("%d sources, json: %lld KiB, save %.1f ms, load %.1f ms\n", BENCH_SOURCES,
+		      (long long)json_size / 1024, json_save, json_load);
+	print_message("%d sources, binary: %lld KiB, save %.1f ms, load %.1f ms\n", BENCH_SOURCES,
+		      (long long)binary_size / 1024, binary_save, binary_load);
+
+	obs_data_release(data);
+	os_unlink(TEST_JSON_FILE);
+	os_unlink(TEST_BINARY_FILE);
+}
+
+/* the baseline for the lookup benchmark: every object used to keep its items
+ * in a uthash table, each item allocated with its name, and every lookup by
+ * name went through HASH_FIND_STR */
+struct baseline_item {
+	UT_hash_handle hh;
+	long long value;
+	char name[];
+};
+
+static struct baseline_item *baseline_add(struct baseline_item **items, const char *name, long long value)
+{
+	size_t len = strlen(name);
+	struct baseline_item *item = bmalloc(sizeof(*item) + len + 1);
+
+	item->value = value;
+	memcpy(item->name, name, len + 1);
+	HASH_ADD_KEYPTR(hh, *items, item->name, len, item);
+	return item;
+}
+
+static struct baseline_item *baseline_copy(obs_data_t *data)
+{
+	struct baseline_item *items = NULL;
+	obs_data_item_t *item = obs_data_first(data);
+
+	for (; item; obs_data_item_next(&item)) {
+		const char *name = obs_data_item_get_name(item);
+		struct baseline_item *found;
+
+		/* what obs_data_apply did per item, a lookup in the target and
+		 * an insert */
+		HASH_FIND_STR(items, name, found);
+		if (!found)
+			baseline_add(&items, name, obs_data_item_get_int(item));
+	}
+
+	return items;
+}
+
+static void baseline_free(struct baseline_item *items)
+{
+	struct baseline_item *item, *temp;
+
+	HASH_ITER (hh, items, item, temp) {
+		HASH_DEL(items, item);
+		bfree(item);
+	}
+}
+
+static void lookup_benchmark_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	obs_data_t *source = create_source_data(0);
+	obs_data_t *settings = obs_data_get_obj(source, "settings");
+	const obs_data_key_t *key = obs_data_key("mixers");
+	struct baseline_item *baseline = baseline_copy(source);
+	struct baseline_item *found;
+	long long sum = 0;
+	uint64_t start;
+
+	start = os_gettime_ns();
+	for (int i = 0; i < BENCH_LOOKUPS; i++) {
+		HASH_FIND_STR(baseline, "mixers", found);
+		sum += found->value;
+	}
+	double uthash_by_name = (double)(os_gettime_ns() - start) / BENCH_LOOKUPS;
+
+	start = os_gettime_ns();
+	for (int i = 0; i < BENCH_LOOKUPS; i++)
+		sum += obs_data_get_int(source, "mixers");
+	double by_name = (double)(os_gettime_ns() - start) / BENCH_LOOKUPS;
+
+	start = os_gettime_ns();
+	for (int i = 0; i < BENCH_LOOKUPS; i++)
+		sum += obs_data_get_int_key(source, key);
+	double by_key = (double)(os_gettime_ns() - start) / BENCH_LOOKUPS;
+
+	assert_int_equal(sum, 3LL * BENCH_LOOKUPS * 255);
+
+	/* what every obs_source_update does with the new settings */
+	start = os_gettime_ns();
+	for (int i = 0; i < BENCH_APPLIES; i++)
+		baseline_free(baseline_copy(settings));
+	double uthash_apply = (double)(os_gettime_ns() - start) / BENCH_APPLIES;
+
+	start = os_gettime_ns();
+	for (int i = 0; i < BENCH_APPLIES; i++) {
+		obs_data_t *copy = obs_data_create();
+		obs_data_apply(copy, settings);
+		obs_data_release(copy);
+	}
+	double apply = (double)(os_gettime_ns() - start) / BENCH_APPLIES;
+
+	print_message("uthash baseline: lookup by name %.1f ns, copy on apply %.1f ns\n", uthash_by_name,
+		      uthash_apply);
+	print_message("lookup by name %.1f ns, by key %.1f ns, copy on apply %.1f ns\n", by_name, by_key, apply);
+
+	baseline_free(baseline);
+	obs_data_release(settings);
+	obs_data_release(source);
+}
+
+int main()
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(binary_roundtrip_test),
+		cmocka_unit_test(binary_json_test),
+		cmocka_unit_test(binary_corrupt_test),
+		cmocka_unit_test(key_test),
+		cmocka_unit_test(lookup_benchmark_test),
+		cmocka_unit_test(benchmark_test),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
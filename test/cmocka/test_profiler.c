@@ -0,0 +1,194 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include <util/platform.h>
+#include <util/profiler.h>
+#include <util/threading.h>
+
+#define TEST_CALLS 1000
+#define TEST_THREADS 4
+#define BENCH_CALLS 1000000
+
+static const char *root_name = "test_root";
+static const char *child_name = "test_child";
+static const char *grandchild_name = "test_grandchild";
+static const char *thread_root_name = "test_thread_root";
+static const char *overflow_root_name = "test_overflow_root";
+static const char *bench_root_name = "test_bench_root";
+
+struct find_entry {
+	const char *name;
+	profiler_snapshot_entry_t *entry;
+};
+
+static bool find_entry_func(void *context, profiler_snapshot_entry_t *entry)
+{
+	struct find_entry *find = context;
+
+	if (profiler_snapshot_entry_name(entry) != find->name)
+		return true;
+
+	find->entry = entry;
+	return false;
+}
+
+static profiler_snapshot_entry_t *find_root(profiler_snapshot_t *snap, const char *name)
+{
+	struct find_entry find = {name, NULL};
+	profiler_snapshot_enumerate_roots(snap, find_entry_func, &find);
+	return find.entry;
+}
+
+static profiler_snapshot_entry_t *find_child(profiler_snapshot_entry_t *entry, const char *name)
+{
+	struct find_entry find = {name, NULL};
+	profiler_snapshot_enumerate_children(entry, find_entry_func, &find);
+	return find.entry;
+}
+
+static void nested_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	for (int i = 0; i < TEST_CALLS; i++) {
+		profile_start(root_name);
+		profile_start(child_name);
+		profile_start(grandchild_name);
+		profile_end(grandchild_name);
+		profile_end(child_name);
+		profile_start(child_name);
+		profile_end(child_name);
+		profile_end(root_name);
+	}
+
+	profiler_snapshot_t *snap = profile_snapshot_create();
+	profiler_snapshot_entry_t *root = find_root(snap, root_name);
+	assert_non_null(root);
+	assert_int_equal(profiler_snapshot_entry_overall_count(root), TEST_CALLS);
+	assert_int_equal(profiler_snapshot_num_children(root), 1);
+
+	profiler_snapshot_entry_t *child = find_child(root, child_name);
+	assert_non_null(child);
+	assert_int_equal(profiler_snapshot_entry_overall_count(child), TEST_CALLS * 2);
+
+	profiler_snapshot_entry_t *grandchild = find_child(child, grandchild_name);
+	assert_non_null(grandchild);
+	assert_int_equal(profiler_snapshot_entry_overall_count(grandchild), TEST_CALLS);
+
+	profile_snapshot_free(snap);
+}
+
+static void *thread_func(void *data)
+{
+	UNUSED_PARAMETER(data);
+
+	for (int i = 0; i < TEST_CALLS; i++) {
+		profile_start(thread_root_name);
+		profile_start(child_name);
+		profile_end(child_name);
+		profile_end(thread_root_name);
+	}
+
+	return NULL;
+}
+
+static void threads_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	pthread_t threads[TEST_THREADS];
+
+	for (int i = 0; i < TEST_THREADS; i++)
+		assert_int_equal(pthread_create(&threads[i], NULL, thread_func, NULL), 0);
+	for (int i = 0; i < TEST_THREADS; i++)
+		pthread_join(threads[i], NULL);
+
+	profiler_snapshot_t *snap = profile_snapshot_create();
+	profiler_snapshot_entry_t *root = find_root(snap, thread_root_name);
+	assert_non_null(root);
+	assert_int_equal(profiler_snapshot_entry_overall_count(root), TEST_CALLS * TEST_THREADS);
+
+	profiler_snapshot_entry_t *child = find_child(root, child_name);
+	assert_non_null(child);
+	assert_int_equal(profiler_snapshot_entry_overall_count(child), TEST_CALLS * TEST_THREADS);
+
+	profile_snapshot_free(snap);
+}
+
+/* a call with more nested events than a thread can buffer is dropped as a
+ * whole, the calls after it are recorded normally */
+static void overflow_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	profile_start(overflow_root_name);
+	for (int i = 0; i < 100000; i++) {
+		profile_start(child_name);
+		profile_end(child_name);
+	}
+	profile_end(overflow_root_name);
+
+	profile_start(overflow_root_name);
+	profile_start(child_name);
+	profile_end(child_name);
+	profile_end(overflow_root_name);
+
+	profiler_snapshot_t *snap = profile_snapshot_create();
+	profiler_snapshot_entry_t *root = find_root(snap, overflow_root_name);
+	assert_non_null(root);
+	assert_int_equal(profiler_snapshot_entry_overall_count(root), 1);
+
+	profiler_snapshot_entry_t *child = find_child(root, child_name);
+	assert_non_null(child);
+	assert_int_equal(profiler_snapshot_entry_overall_count(child), 1);
+
+	profile_snapshot_free(snap);
+}
+
+static void benchmark_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	uint64_t start = os_gettime_ns();
+	for (int i = 0; i < BENCH_CALLS; i++) {
+		profile_start(bench_root_name);
+		profile_end(bench_root_name);
+	}
+	uint64_t elapsed = os_gettime_ns() - start;
+
+	print_message("profile_start/profile_end: %.1f ns per scope\n", (double)elapsed / BENCH_CALLS);
+
+	profiler_snapshot_t *snap = profile_snapshot_create();
+	profiler_snapshot_entry_t *root = find_root(snap, bench_root_name);
+	assert_non_null(root);
+	assert_int_equal(profiler_snapshot_entry_overall_count(root), BENCH_CALLS);
+	profile_snapshot_free(snap);
+}
+
+static int setup(void **state)
+{
+	UNUSED_PARAMETER(state);
+	profiler_start();
+	return 0;
+}
+
+static int teardown(void **state)
+{
+	UNUSED_PARAMETER(state);
+	profiler_free();
+	return 0;
+}
+
+int main()
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(nested_test),
+		cmocka_unit_test(threads_test),
+		cmocka_unit_test(overflow_test),
+		cmocka_unit_test(benchmark_test),
+	};
+
+	return cmocka_run_group_tests(tests, setup, teardown);
+}
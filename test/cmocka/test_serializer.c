@@ -4,6 +4,8 @@
 #include <cmocka.h>
 
 #include <util/array-serializer.h>
+#include <util/buffered-file-serializer.h>
+#include <util/platform.h>
 
 static void serialize_test(void **state)
 {
@@ -26,10 +28,81 @@ static void serialize_test(void **state)
 	array_output_serializer_free(&output);
 }
 
+#define BUFFERED_TEST_FILE "test_buffered_file_serializer.bin"
+#define BUFFERED_TEST_SIZE (3 * 1048576 + 1234)
+
+static void write_buffered_file(struct serializer *s, uint8_t *expected)
+{
+	uint8_t *data = bmalloc(BUFFERED_TEST_SIZE);
+	for (size_t i = 0; i < BUFFERED_TEST_SIZE; i++)
+		data[i] = (uint8_t)(i * 7 + (i >> 11));
+
+	/* odd sized sequential writes, then a few overwrites in place the way
+	 * the MP4 muxer rewrites its header after the fact */
+	size_t pos = 0;
+	while (pos < BUFFERED_TEST_SIZE) {
+		size_t size = (pos % 5000) + 1;
+		if (size > BUFFERED_TEST_SIZE - pos)
+			size = BUFFERED_TEST_SIZE - pos;
+
+		assert_int_equal(s_write(s, data + pos, size), size);
+		pos += size;
+	}
+	memcpy(expected, data, BUFFERED_TEST_SIZE);
+
+	const size_t overwrites[][2] = {{0, 24}, {4090, 12}, {1048570, 70000}, {BUFFERED_TEST_SIZE - 10, 10}};
+	for (size_t i = 0; i < sizeof(overwrites) / sizeof(overwrites[0]); i++) {
+		size_t offset = overwrites[i][0];
+		size_t size = overwrites[i][1];
+
+		memset(expected + offset, 0xAA + (int)i, size);
+		memset(data, 0xAA + (int)i, size);
+
+		serializer_seek(s, (int64_t)offset, SERIALIZE_SEEK_START);
+		assert_int_equal(s_write(s, data, size), size);
+	}
+
+	bfree(data);
+}
+
+static void check_buffered_file(const uint8_t *expected)
+{
+	FILE *file = os_fopen(BUFFERED_TEST_FILE, "rb");
+	assert_non_null(file);
+
+	uint8_t *data = bmalloc(BUFFERED_TEST_SIZE + 1);
+	assert_int_equal(fread(data, 1, BUFFERED_TEST_SIZE + 1, file), BUFFERED_TEST_SIZE);
+	assert_memory_equal(data, expected, BUFFERED_TEST_SIZE);
+
+	bfree(data);
+	fclose(file);
+	os_unlink(BUFFERED_TEST_FILE);
+}
+
+static void buffered_file_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+	uint8_t *expected = bmalloc(BUFFERED_TEST_SIZE);
+	struct serializer s;
+
+	assert_true(buffered_file_serializer_init(&s, BUFFERED_TEST_FILE, 0, 0));
+	write_buffered_file(&s, expected);
+	buffered_file_serializer_free(&s);
+	check_buffered_file(expected);
+
+	assert_true(buffered_file_serializer_init_direct(&s, BUFFERED_TEST_FILE, 0, 0));
+	write_buffered_file(&s, expected);
+	buffered_file_serializer_free(&s);
+	check_buffered_file(expected);
+
+	bfree(expected);
+}
+
 int main()
 {
 	const struct CMUnitTest tests[] = {
 		cmocka_unit_test(serialize_test),
+		cmocka_unit_test(buffered_file_test),
 	};
 
 	return cmocka_run_group_tests(tests, NULL, NULL);
@@ -0,0 +1,309 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include <callback/signal.h>
+#include <util/platform.h>
+#include <util/threading.h>
+
+#define STRESS_ITERATIONS 2000
+
+struct counter {
+	long count;
+	signal_handler_t *handler;
+};
+
+static void count_cb(void *data, calldata_t *cd)
+{
+	struct counter *counter = data;
+	counter->count += calldata_int(cd, "value");
+}
+
+static void remove_current_cb(void *data, calldata_t *cd)
+{
+	UNUSED_PARAMETER(cd);
+
+	struct counter *counter = data;
+	counter->count++;
+	signal_handler_remove_current();
+}
+
+static void disconnect_self_cb(void *data, calldata_t *cd)
+{
+	UNUSED_PARAMETER(cd);
+
+	struct counter *counter = data;
+	counter->count++;
+	signal_handler_disconnect(counter->handler, "test", disconnect_self_cb, data);
+}
+
+static void global_cb(void *data, const char *signal, calldata_t *cd)
+{
+	UNUSED_PARAMETER(cd);
+
+	struct counter *counter = data;
+	if (strcmp(signal, "test") == 0)
+		counter->count++;
+}
+
+static signal_handler_t *create_handler(void)
+{
+	signal_handler_t *handler = signal_handler_create();
+	assert_non_null(handler);
+	assert_true(signal_handler_add(handler, "void test(int value)"));
+	assert_true(signal_handler_add(handler, "void other()"));
+	assert_false(signal_handler_add(handler, "void test()"));
+	return handler;
+}
+
+static void emit(signal_handler_t *handler, signal_id_t id, long long value)
+{
+	calldata_t cd = {0};
+	calldata_set_int(&cd, "value", value);
+	if (id)
+		signal_handler_signal_id(handler, id, &cd);
+	else
+		signal_handler_signal(handler, "test", &cd);
+	calldata_free(&cd);
+}
+
+static void signal_basic_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	signal_handler_t *handler = create_handler();
+	signal_id_t id = signal_handler_get_id(handler, "test");
+	struct counter counter = {0, handler};
+	struct counter global = {0, handler};
+
+	assert_non_null(id);
+	assert_ptr_equal(id, signal_handler_get_id(handler, "test"));
+	assert_null(signal_handler_get_id(handler, "missing"));
+
+	/* connecting twice does nothing */
+	signal_handler_connect(handler, "test", count_cb, &counter);
+	signal_handler_connect(handler, "test", count_cb, &counter);
+	signal_handler_connect_global(handler, global_cb, &global);
+
+	emit(handler, NULL, 2);
+	emit(handler, id, 3);
+	assert_int_equal(counter.count, 5);
+	assert_int_equal(global.count, 2);
+
+	signal_handler_disconnect(handler, "test", count_cb, &counter);
+	signal_handler_disconnect_global(handler, global_cb, &global);
+	emit(handler, id, 3);
+	assert_int_equal(counter.count, 5);
+	assert_int_equal(global.count, 2);
+
+	signal_handler_destroy(handler);
+}
+
+static void signal_remove_in_callback_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	signal_handler_t *handler = create_handler();
+	struct counter removed = {0, handler};
+	struct counter disconnected = {0, handler};
+	struct counter counter = {0, handler};
+
+	signal_handler_connect(handler, "test", remove_current_cb, &removed);
+	signal_handler_connect(handler, "test", disconnect_self_cb, &disconnected);
+	signal_handler_connect(handler, "test", count_cb, &counter);
+
+	emit(handler, NULL, 1);
+	emit(handler, NULL, 1);
+
+	assert_int_equal(removed.count, 1);
+	assert_int_equal(disconnected.count, 1);
+	assert_int_equal(counter.count, 2);
+
+	/* a reference held by a connection is dropped when it removes itself */
+	signal_handler_connect_ref(handler, "test", remove_current_cb, &removed);
+	emit(handler, NULL, 1);
+	assert_int_equal(removed.count, 2);
+
+	signal_handler_destroy(handler);
+}
+
+struct nested {
+	signal_handler_t *handler;
+	long outer_calls;
+	long inner_calls;
+};
+
+static void nested_outer_cb(void *data, calldata_t *cd);
+
+static void nested_inner_cb(void *data, calldata_t *cd)
+{
+	UNUSED_PARAMETER(cd);
+
+	struct nested *nested = data;
+	nested->inner_calls++;
+	signal_handler_disconnect(nested->handler, "test", nested_outer_cb, data);
+}
+
+static void nested_outer_cb(void *data, calldata_t *cd)
+{
+	UNUSED_PARAMETER(cd);
+
+	struct nested *nested = data;
+	calldata_t other = {0};
+
+	nested->outer_calls++;
+	signal_handler_signal(nested->handler, "other", &other);
+	calldata_free(&other);
+}
+
+/* a callback disconnected from a nested signal while it is still running
+ * further up the same thread must not be waited for */
+static void signal_nested_disconnect_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	struct nested nested = {0};
+
+	nested.handler = create_handler();
+	signal_handler_connect(nested.handler, "test", nested_outer_cb, &nested);
+	signal_handler_connect(nested.handler, "other", nested_inner_cb, &nested);
+
+	emit(nested.handler, NULL, 1);
+	emit(nested.handler, NULL, 1);
+
+	assert_int_equal(nested.outer_calls, 1);
+	assert_int_equal(nested.inner_calls, 1);
+
+	signal_handler_destroy(nested.handler);
+}
+
+struct stress {
+	signal_handler_t *handler;
+	signal_id_t id;
+	volatile bool stop;
+	volatile long connected;
+	volatile long calls_while_disconnected;
+};
+
+static void stress_cb(void *data, calldata_t *cd)
+{
+	UNUSED_PARAMETER(cd);
+
+	struct stress *stress = data;
+	if (!os_atomic_load_long(&stress->connected))
+		os_atomic_inc_long(&stress->calls_while_disconnected);
+}
+
+static void *stress_thread(void *data)
+{
+	struct stress *stress = data;
+
+	while (!os_atomic_load_bool(&stress->stop))
+		emit(stress->handler, stress->id, 1);
+
+	return NULL;
+}
+
+/* once disconnect returns, the callback must never be called again, even
+ * while another thread is emitting the signal */
+static void signal_concurrent_disconnect_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	struct stress stress = {0};
+	pthread_t thread;
+
+	stress.handler = create_handler();
+	stress.id = signal_handler_get_id(stress.handler, "test");
+
+	assert_int_equal(pthread_create(&thread, NULL, stress_thread, &stress), 0);
+
+	for (int i = 0; i < STRESS_ITERATIONS; i++) {
+		os_atomic_store_long(&stress.connected, 1);
+		signal_handler_connect(stress.handler, "test", stress_cb, &stress);
+		signal_handler_disconnect(stress.handler, "test", stress_cb, &stress);
+		os_atomic_store_long(&stress.connected, 0);
+	}
+
+	os_atomic_store_bool(&stress.stop, true);
+	pthread_join(thread, NULL);
+
+	assert_int_equal(stress.calls_while_disconnected, 0);
+	signal_handler_destroy(stress.handler);
+}
+
+struct serial {
+	signal_handler_t *handler;
+	volatile long inside;
+	volatile long overlaps;
+	volatile long calls;
+};
+
+static void serial_global_cb(void *data, const char *signal, calldata_t *cd)
+{
+	UNUSED_PARAMETER(signal);
+	UNUSED_PARAMETER(cd);
+
+	struct serial *serial = data;
+
+	os_atomic_inc_long(&serial->inside);
+
+	/* stay in the callback for a moment so overlapping calls show up */
+	for (int i = 0; i < 100; i++) {
+		if (os_atomic_load_long(&serial->inside) > 1) {
+			os_atomic_inc_long(&serial->overlaps);
+			break;
+		}
+	}
+
+	os_atomic_inc_long(&serial->calls);
+	os_atomic_dec_long(&serial->inside);
+}
+
+static void *serial_thread(void *data)
+{
+	struct serial *serial = data;
+
+	for (int i = 0; i < STRESS_ITERATIONS; i++)
+		emit(serial->handler, NULL, 1);
+
+	return NULL;
+}
+
+/* per-signal callbacks run on every emitting thread at once, but global
+ * callbacks of a handler are still called one at a time */
+static void signal_global_serialized_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	struct serial serial = {0};
+	pthread_t threads[4];
+
+	serial.handler = create_handler();
+	signal_handler_connect_global(serial.handler, serial_global_cb, &serial);
+
+	for (size_t i = 0; i < 4; i++)
+		assert_int_equal(pthread_create(&threads[i], NULL, serial_thread, &serial), 0);
+	for (size_t i = 0; i < 4; i++)
+		pthread_join(threads[i], NULL);
+
+	assert_int_equal(serial.calls, 4 * STRESS_ITERATIONS);
+	assert_int_equal(serial.overlaps, 0);
+
+	signal_handler_disconnect_global(serial.handler, serial_global_cb, &serial);
+	signal_handler_destroy(serial.handler);
+}
+
+int main()
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(signal_basic_test),
+		cmocka_unit_test(signal_remove_in_callback_test),
+		cmocka_unit_test(signal_nested_disconnect_test),
+		cmocka_unit_test(signal_concurrent_disconnect_test),
+		cmocka_unit_test(signal_global_serialized_test),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,203 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include <util/thread-pool.h>
+#include <util/threading.h>
+
+#define NUM_TASKS 1000
+
+struct counter {
+	volatile long count;
+};
+
+static void count_task(void *param)
+{
+	struct counter *counter = param;
+	os_atomic_inc_long(&counter->count);
+}
+
+static void wait_task(void *param)
+{
+	os_event_wait(param);
+}
+
+static void pool_basic_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	os_thread_pool_t *pool = os_thread_pool_create("test pool", 4);
+	os_task_group_t *group = os_task_group_create(pool);
+	struct counter counter = {0};
+	struct os_thread_pool_stats stats;
+
+	assert_non_null(pool);
+	assert_non_null(group);
+	assert_false(os_thread_pool_inside(pool));
+
+	for (int i = 0; i < NUM_TASKS; i++) {
+		enum os_task_priority priority = (enum os_task_priority)(i % 3);
+		assert_true(os_thread_pool_queue(pool, priority, group, count_task, &counter));
+	}
+
+	os_task_group_wait(group);
+	assert_int_equal(counter.count, NUM_TASKS);
+
+	os_thread_pool_get_stats(pool, &stats);
+	assert_int_equal(stats.threads, 4);
+	assert_int_equal(stats.queued, 0);
+	assert_int_equal(stats.tasks, NUM_TASKS);
+	assert_true(stats.max_queued > 0);
+
+	/* tasks without a group still run before the pool goes away */
+	for (int i = 0; i < NUM_TASKS; i++)
+		os_thread_pool_queue(pool, OS_TASK_PRIORITY_NORMAL, NULL, count_task, &counter);
+
+	os_task_group_destroy(group);
+	os_thread_pool_destroy(pool);
+	assert_int_equal(counter.count, NUM_TASKS * 2);
+}
+
+struct nested {
+	os_thread_pool_t *pool;
+	struct counter counter;
+	bool inside;
+};
+
+static void nested_task(void *param)
+{
+	struct nested *nested = param;
+	os_task_group_t *group = os_task_group_create(nested->pool);
+
+	nested->inside = os_thread_pool_inside(nested->pool);
+
+	for (int i = 0; i < 10; i++)
+		os_thread_pool_queue(nested->pool, OS_TASK_PRIORITY_NORMAL, group, count_task, &nested->counter);
+
+	/* with a single worker this only finishes if the waiter helps out */
+	os_task_group_destroy(group);
+}
+
+static void pool_nested_wait_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	struct nested nested = {0};
+	nested.pool = os_thread_pool_create("test pool", 1);
+	os_task_group_t *group = os_task_group_create(nested.pool);
+
+	os_thread_pool_queue(nested.pool, OS_TASK_PRIORITY_NORMAL, group, nested_task, &nested);
+	os_task_group_wait(group);
+
+	assert_true(nested.inside);
+	assert_int_equal(nested.counter.count, 10);
+
+	os_task_group_destroy(group);
+	os_thread_pool_destroy(nested.pool);
+}
+
+static void pool_cancel_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	os_thread_pool_t *pool = os_thread_pool_create("test pool", 1);
+	os_task_group_t *group = os_task_group_create(pool);
+	struct counter counter = {0};
+	struct os_thread_pool_stats stats;
+	os_event_t *blocker;
+
+	os_event_init(&blocker, OS_EVENT_TYPE_MANUAL);
+	os_thread_pool_queue(pool, OS_TASK_PRIORITY_HIGH, NULL, wait_task, blocker);
+
+	for (int i = 0; i < 100; i++)
+		os_thread_pool_queue(pool, OS_TASK_PRIORITY_NORMAL, group, count_task, &counter);
+
+	assert_int_equal(os_task_group_cancel(group), 100);
+	assert_true(os_task_group_cancelled(group));
+	assert_false(os_thread_pool_queue(pool, OS_TASK_PRIORITY_NORMAL, group, count_task, &counter));
+
+	/* nothing is left to wait for */
+	os_task_group_wait(group);
+	os_event_signal(blocker);
+
+	os_task_group_reset(group);
+	assert_true(os_thread_pool_queue(pool, OS_TASK_PRIORITY_NORMAL, group, count_task, &counter));
+	os_task_group_wait(group);
+	assert_int_equal(counter.count, 1);
+
+	os_thread_pool_get_stats(pool, &stats);
+	assert_int_equal(stats.cancelled, 100);
+
+	os_task_group_destroy(group);
+	os_thread_pool_destroy(pool);
+	os_event_destroy(blocker);
+}
+
+struct order {
+	pthread_mutex_t mutex;
+	int next;
+	int ran[6];
+};
+
+struct order_task {
+	struct order *order;
+	int id;
+};
+
+static void order_task(void *param)
+{
+	struct order_task *task = param;
+	struct order *order = task->order;
+
+	pthread_mutex_lock(&order->mutex);
+	order->ran[order->next++] = task->id;
+	pthread_mutex_unlock(&order->mutex);
+}
+
+static void pool_priority_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	os_thread_pool_t *pool = os_thread_pool_create("test pool", 1);
+	os_task_group_t *group = os_task_group_create(pool);
+	struct order order = {0};
+	struct order_task tasks[6];
+	os_event_t *blocker;
+
+	pthread_mutex_init(&order.mutex, NULL);
+	os_event_init(&blocker, OS_EVENT_TYPE_MANUAL);
+	os_thread_pool_queue(pool, OS_TASK_PRIORITY_HIGH, group, wait_task, blocker);
+
+	/* queued lowest first while the only worker is busy */
+	for (int i = 0; i < 6; i++) {
+		enum os_task_priority priority = (enum os_task_priority)(2 - i / 2);
+		tasks[i].order = &order;
+		tasks[i].id = i;
+		os_thread_pool_queue(pool, priority, group, order_task, &tasks[i]);
+	}
+
+	os_event_signal(blocker);
+	os_task_group_wait(group);
+
+	const int expected[6] = {4, 5, 2, 3, 0, 1};
+	for (int i = 0; i < 6; i++)
+		assert_int_equal(order.ran[i], expected[i]);
+
+	os_task_group_destroy(group);
+	os_thread_pool_destroy(pool);
+	os_event_destroy(blocker);
+	pthread_mutex_destroy(&order.mutex);
+}
+
+int main()
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(pool_basic_test),
+		cmocka_unit_test(pool_nested_wait_test),
+		cmocka_unit_test(pool_cancel_test),
+		cmocka_unit_test(pool_priority_test),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}